@@ -0,0 +1,184 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <iomanip>
+
+#include <parquet/arrow/reader.h>
+
+#include <SWParquetReader.h>
+#include <timer.h>
+
+//Use standard Arrow library functions to read Arrow array from Parquet file
+//Only works for Parquet version 1 style files.
+std::shared_ptr<arrow::Array> readArray(std::string hw_input_file_path) {
+  std::shared_ptr<arrow::io::ReadableFile> infile;
+  PARQUET_THROW_NOT_OK(arrow::io::ReadableFile::Open(hw_input_file_path, arrow::default_memory_pool(), &infile));
+
+  std::unique_ptr<parquet::arrow::FileReader> reader;
+  PARQUET_THROW_NOT_OK(parquet::arrow::OpenFile(infile, arrow::default_memory_pool(), &reader));
+
+  std::shared_ptr<arrow::ChunkedArray> carray;
+  PARQUET_THROW_NOT_OK(reader->ReadColumn(0, &carray));
+  std::shared_ptr<arrow::Array> array = carray->chunk(0);
+  return array;
+}
+
+// Aggregate the first num_values values of an array one by one, the sum wrapping around like int64 arithmetic
+template<typename ArrayType>
+ptoa::value_aggregate aggregate_array(const std::shared_ptr<arrow::Array>& array, int64_t num_values) {
+    auto typed_array = std::static_pointer_cast<ArrayType>(array);
+    ptoa::value_aggregate aggregate;
+
+    for(int64_t i=0; i<num_values; i++) {
+        if(typed_array->IsNull(i)) {
+            aggregate.null_count++;
+            continue;
+        }
+        int64_t value = typed_array->Value(i);
+        aggregate.count++;
+        aggregate.sum = (int64_t) ((uint64_t) aggregate.sum + (uint64_t) value);
+        aggregate.min = std::min(aggregate.min, value);
+        aggregate.max = std::max(aggregate.max, value);
+    }
+    return aggregate;
+}
+
+int main(int argc, char **argv) {
+    int num_values;
+    char* hw_input_file_path;
+    char* reference_parquet_file_path;
+    int iterations;
+    bool verify_output;
+
+    Timer t;
+
+    if (argc > 5) {
+      hw_input_file_path = argv[1];
+      reference_parquet_file_path = argv[2];
+      num_values = (uint32_t) std::strtoul(argv[3], nullptr, 10);
+      iterations = (uint32_t) std::strtoul(argv[4], nullptr, 10);
+      if(argv[5][0] == 'y') {
+        verify_output = true;
+      } else if (argv[5][0] == 'n') {
+        verify_output = false;
+      } else {
+        std::cerr << "Invalid argument. Option \"verify\" should be \"y\" or \"n\"" << std::endl;
+        return 1;
+      }
+    } else {
+      std::cerr << "Usage: aggregate parquet_hw_input_file_path reference_parquet_file_path num_values iterations verify(y or n) [threads]" << std::endl;
+      return 1;
+    }
+
+    ptoa::SWParquetReader reader(hw_input_file_path);
+
+    // Optional amount of threads for page parallel decoding
+    if(argc > 6) {
+      reader.set_num_threads(std::strtoul(argv[6], nullptr, 10));
+    }
+
+    // Locate the first column chunk through the footer, aggregating works on INT32 and INT64 columns
+    const ptoa::column_chunk_info* chunk;
+    if(reader.get_column_chunk(0, 0, &chunk) != ptoa::status::OK){
+        return 1;
+    }
+    int64_t file_offset = chunk->data_page_offset;
+    int32_t prim_width;
+
+    if(chunk->type == ptoa::parquet_type::INT32) {
+        prim_width = 32;
+    } else if(chunk->type == ptoa::parquet_type::INT64) {
+        prim_width = 64;
+    } else {
+        std::cerr << "Invalid input file. Aggregating requires an INT32 or INT64 column" << std::endl;
+        return 1;
+    }
+
+    reader.count_pages(file_offset);
+
+    ptoa::value_aggregate aggregate;
+
+    for(int i=0; i<iterations; i++){
+        t.start();
+        aggregate = ptoa::value_aggregate();
+        if(reader.aggregate_prim(prim_width, num_values, file_offset, &aggregate, ptoa::encoding::DELTA) != ptoa::status::OK){
+            return 1;
+        }
+        t.stop();
+        t.record();
+    }
+
+    std::cout << "Aggregated " << num_values << " values" << std::endl;
+    std::cout << "Average time in seconds (aggregate): " << t.average() << std::endl;
+
+    t.clear_history();
+
+    // Decoding the whole chunk and aggregating afterwards, for comparison
+    std::shared_ptr<arrow::PrimitiveArray> array;
+    ptoa::value_aggregate decoded_aggregate;
+
+    for(int i=0; i<iterations; i++){
+        t.start();
+        if(reader.read_prim(prim_width, num_values, file_offset, &array, ptoa::encoding::DELTA) != ptoa::status::OK){
+            return 1;
+        }
+        decoded_aggregate = prim_width == 32 ? aggregate_array<arrow::Int32Array>(array, num_values) : aggregate_array<arrow::Int64Array>(array, num_values);
+        t.stop();
+        t.record();
+    }
+
+    std::cout << "Aggregated " << num_values << " values" << std::endl;
+    std::cout << "Average time in seconds (read, then aggregate): " << t.average() << std::endl;
+
+    if(verify_output) {
+        std::shared_ptr<arrow::Array> correct_array = readArray(std::string(reference_parquet_file_path));
+        ptoa::value_aggregate correct = prim_width == 32 ? aggregate_array<arrow::Int32Array>(correct_array, num_values) : aggregate_array<arrow::Int64Array>(correct_array, num_values);
+
+        std::cout << "COUNT: " << aggregate.count << " NULLS: " << aggregate.null_count << " SUM: " << aggregate.sum;
+        if(aggregate.count > 0) {
+            std::cout << " MIN: " << aggregate.min << " MAX: " << aggregate.max;
+        }
+        std::cout << std::endl;
+
+        // Verify result, min and max are only compared when there are values to take them from
+        int error_count = 0;
+
+        if(aggregate.count != correct.count) {
+          error_count++;
+          std::cout << "COUNT " << aggregate.count << " -> " << correct.count << std::endl;
+        }
+        if(aggregate.null_count != correct.null_count) {
+          error_count++;
+          std::cout << "NULLS " << aggregate.null_count << " -> " << correct.null_count << std::endl;
+        }
+        if(aggregate.sum != correct.sum) {
+          error_count++;
+          std::cout << "SUM " << aggregate.sum << " -> " << correct.sum << std::endl;
+        }
+        if((correct.count > 0) && (aggregate.min != correct.min)) {
+          error_count++;
+          std::cout << "MIN " << aggregate.min << " -> " << correct.min << std::endl;
+        }
+        if((correct.count > 0) && (aggregate.max != correct.max)) {
+          error_count++;
+          std::cout << "MAX " << aggregate.max << " -> " << correct.max << std::endl;
+        }
+
+        if(error_count == 0) {
+          std::cout << "Test passed!" << std::endl;
+        } else {
+          std::cout << "Test failed. Found " << error_count << " errors in the aggregates" << std::endl;
+        }
+    }
+
+}
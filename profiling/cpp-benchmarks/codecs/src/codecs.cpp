@@ -0,0 +1,113 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <cstdlib>
+
+#include <SWParquetReader.h>
+#include <timer.h>
+
+// Reads every INT32, INT64 and BYTE_ARRAY column chunk of a file and reports the read throughput per compression codec,
+// in uncompressed bytes per second. Writing the same data with different codecs gives a comparison of the codecs.
+
+const char* codec_name(ptoa::compression_codec codec) {
+    switch(codec) {
+        case ptoa::compression_codec::UNCOMPRESSED: return "uncompressed";
+        case ptoa::compression_codec::SNAPPY: return "Snappy";
+        case ptoa::compression_codec::ZSTD: return "ZSTD";
+        case ptoa::compression_codec::LZ4_RAW: return "LZ4_RAW";
+        default: return "other";
+    }
+}
+
+struct codec_stats {
+    int32_t chunks;
+    int64_t compressed_bytes;
+    int64_t uncompressed_bytes;
+    double seconds;
+};
+
+int main(int argc, char **argv) {
+    char* parquet_file_path;
+    int iterations;
+
+    if (argc > 2) {
+      parquet_file_path = argv[1];
+      iterations = (uint32_t) std::strtoul(argv[2], nullptr, 10);
+    } else {
+      std::cerr << "Usage: codecs parquet_file_path iterations [threads]" << std::endl;
+      return 1;
+    }
+
+    ptoa::SWParquetReader reader(parquet_file_path);
+
+    // Optional amount of threads for page parallel decoding
+    if(argc > 3) {
+      reader.set_num_threads(std::strtoul(argv[3], nullptr, 10));
+    }
+
+    const ptoa::file_metadata* metadata;
+    if(reader.get_file_metadata(&metadata) != ptoa::status::OK) {
+      return 1;
+    }
+
+    std::map<ptoa::compression_codec, codec_stats> stats;
+
+    for(int32_t row_group=0; row_group<metadata->num_row_groups(); row_group++){
+      for(int32_t column=0; column<metadata->num_columns(); column++){
+        const ptoa::column_chunk_info& chunk = metadata->column_chunk(row_group, column);
+        bool is_string = chunk.type == ptoa::parquet_type::BYTE_ARRAY;
+
+        if((chunk.type != ptoa::parquet_type::INT32) && (chunk.type != ptoa::parquet_type::INT64) && !is_string) {
+          continue;
+        }
+
+        Timer t;
+
+        for(int i=0; i<iterations; i++){
+          std::shared_ptr<arrow::PrimitiveArray> prim_array;
+          std::shared_ptr<arrow::StringArray> string_array;
+
+          t.start();
+          ptoa::status result = is_string ? reader.read_column_string(row_group, column, &string_array) : reader.read_column_prim(row_group, column, &prim_array);
+          t.stop();
+          t.record();
+
+          if(result != ptoa::status::OK) {
+            std::cout << "Test failed. Could not read column " << column << " of row group " << row_group << std::endl;
+            return 1;
+          }
+        }
+
+        codec_stats& codec = stats[chunk.codec];
+        codec.chunks++;
+        codec.compressed_bytes += chunk.total_compressed_size;
+        codec.uncompressed_bytes += chunk.total_uncompressed_size;
+        codec.seconds += t.average();
+      }
+    }
+
+    std::cout << std::setw(14) << "codec" << std::setw(8) << "chunks" << std::setw(10) << "ratio" << std::setw(14) << "MB/s" << std::endl;
+
+    for(auto it = stats.begin(); it != stats.end(); it++){
+      const codec_stats& codec = it->second;
+      std::cout << std::setw(14) << codec_name(it->first) << std::setw(8) << codec.chunks
+                << std::setw(10) << std::fixed << std::setprecision(2) << (double) codec.uncompressed_bytes/codec.compressed_bytes
+                << std::setw(14) << std::setprecision(0) << codec.uncompressed_bytes/codec.seconds/1e6 << std::endl;
+    }
+
+    std::cout << "Test passed!" << std::endl;
+
+    return 0;
+}
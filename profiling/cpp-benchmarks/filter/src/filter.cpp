@@ -0,0 +1,248 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+#include <parquet/arrow/reader.h>
+
+#include <SWParquetReader.h>
+#include <timer.h>
+
+//Use standard Arrow library functions to read Arrow array from Parquet file
+//Only works for Parquet version 1 style files.
+std::shared_ptr<arrow::Array> readArray(std::string hw_input_file_path) {
+  std::shared_ptr<arrow::io::ReadableFile> infile;
+  PARQUET_THROW_NOT_OK(arrow::io::ReadableFile::Open(hw_input_file_path, arrow::default_memory_pool(), &infile));
+
+  std::unique_ptr<parquet::arrow::FileReader> reader;
+  PARQUET_THROW_NOT_OK(parquet::arrow::OpenFile(infile, arrow::default_memory_pool(), &reader));
+
+  std::shared_ptr<arrow::ChunkedArray> carray;
+  PARQUET_THROW_NOT_OK(reader->ReadColumn(0, &carray));
+  std::shared_ptr<arrow::Array> array = carray->chunk(0);
+  return array;
+}
+
+// Scalar evaluation of pred, compared in 64 bits so operands outside the range of the column type need no special care
+bool fulfils(const ptoa::predicate& pred, int64_t value) {
+    switch(pred.op) {
+        case ptoa::predicate_op::LESS:
+            return value < pred.ints[0];
+        case ptoa::predicate_op::LESS_EQUAL:
+            return value <= pred.ints[0];
+        case ptoa::predicate_op::EQUAL:
+            return value == pred.ints[0];
+        case ptoa::predicate_op::BETWEEN:
+            return (value >= pred.ints[0]) && (value <= pred.ints[1]);
+        case ptoa::predicate_op::IN:
+            return std::find(pred.ints.begin(), pred.ints.end(), value) != pred.ints.end();
+    }
+    return false;
+}
+
+// Count the values of a decoded array that fulfil pred, the way a filter after decoding would
+template<typename ArrayType>
+int64_t count_matches(const std::shared_ptr<arrow::PrimitiveArray>& array, const ptoa::predicate& pred) {
+    auto typed_array = std::static_pointer_cast<ArrayType>(array);
+    int64_t matches = 0;
+
+    for(int64_t i=0; i<typed_array->length(); i++) {
+        if(!typed_array->IsNull(i) && fulfils(pred, typed_array->Value(i))) {
+            matches++;
+        }
+    }
+    return matches;
+}
+
+// Compare the selection bitmap, the amount of selected rows and the filtered values with the scalar evaluation of pred on the
+// reference array. Nulls never match. Returns the amount of errors found.
+template<typename ArrayType>
+int verify(const std::shared_ptr<arrow::Array>& reference, int64_t num_values, const ptoa::predicate& pred,
+           const std::shared_ptr<arrow::Buffer>& selection, int64_t num_selected, const std::shared_ptr<arrow::PrimitiveArray>& filtered) {
+    auto correct_array = std::dynamic_pointer_cast<ArrayType>(reference);
+    auto result_array = std::static_pointer_cast<ArrayType>(filtered);
+    int error_count = 0;
+    int64_t num_matches = 0;
+
+    for(int64_t i=0; i<num_values; i++) {
+        bool match = !correct_array->IsNull(i) && fulfils(pred, correct_array->Value(i));
+        bool selected = (selection->data()[i/8] >> (i%8)) & 1;
+
+        if(match != selected) {
+            error_count++;
+            if(error_count<20) {
+                std::cout<<"Row "<<i<<" selected: "<<selected<<" expected: "<<match<<std::endl;
+            }
+        }
+
+        if(match) {
+            if((num_matches < result_array->length()) && (result_array->Value(num_matches) != correct_array->Value(i))) {
+                error_count++;
+                if(error_count<20) {
+                    std::cout<<"Match "<<num_matches<<" (row "<<i<<") "<<result_array->Value(num_matches)<<" -> "<<correct_array->Value(i)<<std::endl;
+                }
+            }
+            num_matches++;
+        }
+    }
+
+    if(num_selected != num_matches) {
+        error_count++;
+        std::cout<<"Selected "<<num_selected<<" rows, expected "<<num_matches<<std::endl;
+    }
+    if(result_array->length() != num_matches) {
+        error_count++;
+        std::cout<<"Filtered "<<result_array->length()<<" values, expected "<<num_matches<<std::endl;
+    }
+
+    return error_count;
+}
+
+int main(int argc, char **argv) {
+    int num_values;
+    char* hw_input_file_path;
+    char* reference_parquet_file_path;
+    int iterations;
+    bool verify_output;
+    ptoa::predicate_op op;
+    std::vector<int64_t> operands;
+
+    Timer t;
+
+    if (argc > 8) {
+      hw_input_file_path = argv[1];
+      reference_parquet_file_path = argv[2];
+      num_values = (uint32_t) std::strtoul(argv[3], nullptr, 10);
+      iterations = (uint32_t) std::strtoul(argv[4], nullptr, 10);
+      if(argv[5][0] == 'y') {
+        verify_output = true;
+      } else if (argv[5][0] == 'n') {
+        verify_output = false;
+      } else {
+        std::cerr << "Invalid argument. Option \"verify\" should be \"y\" or \"n\"" << std::endl;
+        return 1;
+      }
+      if(!strcmp(argv[7], "lt")) {
+        op = ptoa::predicate_op::LESS;
+      } else if (!strcmp(argv[7], "le")) {
+        op = ptoa::predicate_op::LESS_EQUAL;
+      } else if (!strcmp(argv[7], "eq")) {
+        op = ptoa::predicate_op::EQUAL;
+      } else if (!strcmp(argv[7], "between")) {
+        op = ptoa::predicate_op::BETWEEN;
+      } else if (!strcmp(argv[7], "in")) {
+        op = ptoa::predicate_op::IN;
+      } else {
+        std::cerr << "Invalid argument. Option \"op\" should be \"lt\", \"le\", \"eq\", \"between\" or \"in\"" << std::endl;
+        return 1;
+      }
+      for(int i=8; i<argc; i++) {
+        operands.push_back(std::strtoll(argv[i], nullptr, 10));
+      }
+    } else {
+      std::cerr << "Usage: filter parquet_hw_input_file_path reference_parquet_file_path num_values iterations verify(y or n) threads op(lt, le, eq, between or in) operand [operand ...]" << std::endl;
+      return 1;
+    }
+
+    ptoa::SWParquetReader reader(hw_input_file_path);
+    ptoa::predicate pred(op, operands);
+
+    // Amount of threads for page parallel decoding
+    reader.set_num_threads(std::strtoul(argv[6], nullptr, 10));
+
+    // Locate the first column chunk through the footer, filtering works on INT32 and INT64 columns
+    const ptoa::column_chunk_info* chunk;
+    if(reader.get_column_chunk(0, 0, &chunk) != ptoa::status::OK){
+        return 1;
+    }
+    int64_t file_offset = chunk->data_page_offset;
+    int32_t prim_width;
+
+    if(chunk->type == ptoa::parquet_type::INT32) {
+        prim_width = 32;
+    } else if(chunk->type == ptoa::parquet_type::INT64) {
+        prim_width = 64;
+    } else {
+        std::cerr << "Invalid input file. Filtering requires an INT32 or INT64 column" << std::endl;
+        return 1;
+    }
+
+    reader.count_pages(file_offset);
+
+    std::shared_ptr<arrow::Buffer> selection;
+    int64_t num_selected;
+
+    for(int i=0; i<iterations; i++){
+        t.start();
+        if(reader.select_prim(prim_width, num_values, file_offset, pred, &selection, &num_selected, ptoa::encoding::DELTA) != ptoa::status::OK){
+            return 1;
+        }
+        t.stop();
+        t.record();
+    }
+
+    std::cout << "Selected " << num_selected << " of " << num_values << " values" << std::endl;
+    std::cout << "Average time in seconds (select): " << t.average() << std::endl;
+
+    t.clear_history();
+
+    std::shared_ptr<arrow::PrimitiveArray> filtered_array;
+
+    for(int i=0; i<iterations; i++){
+        t.start();
+        if(reader.filter_prim(prim_width, num_values, file_offset, pred, &filtered_array, ptoa::encoding::DELTA) != ptoa::status::OK){
+            return 1;
+        }
+        t.stop();
+        t.record();
+    }
+
+    std::cout << "Filtered " << filtered_array->length() << " of " << num_values << " values" << std::endl;
+    std::cout << "Average time in seconds (filter): " << t.average() << std::endl;
+
+    t.clear_history();
+
+    // Decoding the whole chunk and filtering afterwards, for comparison
+    std::shared_ptr<arrow::PrimitiveArray> array;
+    int64_t num_matches = 0;
+
+    for(int i=0; i<iterations; i++){
+        t.start();
+        if(reader.read_prim(prim_width, num_values, file_offset, &array, ptoa::encoding::DELTA) != ptoa::status::OK){
+            return 1;
+        }
+        num_matches = prim_width == 32 ? count_matches<arrow::Int32Array>(array, pred) : count_matches<arrow::Int64Array>(array, pred);
+        t.stop();
+        t.record();
+    }
+
+    std::cout << "Matched " << num_matches << " of " << num_values << " values" << std::endl;
+    std::cout << "Average time in seconds (read, then filter): " << t.average() << std::endl;
+
+    if(verify_output) {
+        std::shared_ptr<arrow::Array> correct_array = readArray(std::string(reference_parquet_file_path));
+
+        // Verify result
+        int error_count = prim_width == 32
+            ? verify<arrow::Int32Array>(correct_array, num_values, pred, selection, num_selected, filtered_array)
+            : verify<arrow::Int64Array>(correct_array, num_values, pred, selection, num_selected, filtered_array);
+
+        if(error_count == 0) {
+          std::cout << "Test passed!" << std::endl;
+        } else {
+          std::cout << "Test failed. Found " << error_count << " errors in the output Arrow array" << std::endl;
+        }
+    }
+
+}
@@ -0,0 +1,212 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <iomanip>
+
+#include <parquet/arrow/reader.h>
+
+#include <SWParquetReader.h>
+#include <timer.h>
+
+//Use standard Arrow library functions to read Arrow array from Parquet file
+//Only works for Parquet version 1 style files.
+std::shared_ptr<arrow::Array> readArray(std::string hw_input_file_path) {
+  std::shared_ptr<arrow::io::ReadableFile> infile;
+  PARQUET_THROW_NOT_OK(arrow::io::ReadableFile::Open(hw_input_file_path, arrow::default_memory_pool(), &infile));
+
+  std::unique_ptr<parquet::arrow::FileReader> reader;
+  PARQUET_THROW_NOT_OK(parquet::arrow::OpenFile(infile, arrow::default_memory_pool(), &reader));
+
+  std::shared_ptr<arrow::ChunkedArray> carray;
+  PARQUET_THROW_NOT_OK(reader->ReadColumn(0, &carray));
+  std::shared_ptr<arrow::Array> array = carray->chunk(0);
+  return array;
+}
+
+// Bytes every value of the column takes in its Arrow array
+int32_t value_width(const ptoa::column_info& info) {
+    if(info.type == ptoa::parquet_type::INT96) {
+        return 8;
+    } else if(info.decimal_precision > 0) {
+        return 16;
+    }
+    return info.type_length;
+}
+
+// Read the values with the function for the type of the column: INT96 timestamps, DECIMAL or plain FIXED_LEN_BYTE_ARRAY values.
+// The values go to arr_buffer if it is set.
+ptoa::status read_values(ptoa::SWParquetReader& reader, const ptoa::column_info& info, int64_t num_values, int64_t file_offset,
+                         std::shared_ptr<arrow::Array>* array, std::shared_ptr<arrow::Buffer> arr_buffer, ptoa::encoding enc) {
+    ptoa::status status;
+
+    if(info.type == ptoa::parquet_type::INT96) {
+        std::shared_ptr<arrow::PrimitiveArray> timestamp_array;
+        status = arr_buffer ? reader.read_int96_timestamp(num_values, file_offset, &timestamp_array, arr_buffer, enc)
+                            : reader.read_int96_timestamp(num_values, file_offset, &timestamp_array, enc);
+        *array = timestamp_array;
+    } else if(info.decimal_precision > 0) {
+        std::shared_ptr<arrow::Decimal128Array> decimal_array;
+        status = arr_buffer ? reader.read_decimal(info.type_length, info.decimal_precision, info.decimal_scale, num_values, file_offset, &decimal_array, arr_buffer, enc)
+                            : reader.read_decimal(info.type_length, info.decimal_precision, info.decimal_scale, num_values, file_offset, &decimal_array, enc);
+        *array = decimal_array;
+    } else {
+        std::shared_ptr<arrow::FixedSizeBinaryArray> fixed_array;
+        status = arr_buffer ? reader.read_fixed_len(info.type_length, num_values, file_offset, &fixed_array, arr_buffer, enc)
+                            : reader.read_fixed_len(info.type_length, num_values, file_offset, &fixed_array, enc);
+        *array = fixed_array;
+    }
+    return status;
+}
+
+// Compare validity and values with the reference. parquet-cpp reads INT96 as timestamp[ns] and DECIMAL as Decimal128, so all
+// values but timestamps are compared byte for byte. Returns the amount of errors found.
+int verify(const std::shared_ptr<arrow::Array>& result, const std::shared_ptr<arrow::Array>& correct, const ptoa::column_info& info, int64_t num_values) {
+    int error_count = 0;
+
+    for(int64_t i=0; i<num_values; i++) {
+        bool equal;
+
+        if(result->IsNull(i) != correct->IsNull(i)) {
+            equal = false;
+        } else if(correct->IsNull(i)) {
+            equal = true;
+        } else if(info.type == ptoa::parquet_type::INT96) {
+            equal = std::static_pointer_cast<arrow::TimestampArray>(result)->Value(i) == std::static_pointer_cast<arrow::TimestampArray>(correct)->Value(i);
+        } else {
+            equal = std::memcmp(std::static_pointer_cast<arrow::FixedSizeBinaryArray>(result)->GetValue(i),
+                                std::static_pointer_cast<arrow::FixedSizeBinaryArray>(correct)->GetValue(i), value_width(info)) == 0;
+        }
+
+        if(!equal) {
+            error_count++;
+            if(error_count<20) {
+                std::cout<<i<<std::endl;
+            }
+        }
+    }
+
+    return error_count;
+}
+
+int main(int argc, char **argv) {
+    int num_values;
+    char* hw_input_file_path;
+    char* reference_parquet_file_path;
+    int iterations;
+    bool verify_output;
+    ptoa::encoding enc;
+
+    Timer t;
+
+    if (argc > 6) {
+      hw_input_file_path = argv[1];
+      reference_parquet_file_path = argv[2];
+      num_values = (uint32_t) std::strtoul(argv[3], nullptr, 10);
+      iterations = (uint32_t) std::strtoul(argv[4], nullptr, 10);
+      if(argv[5][0] == 'y') {
+        verify_output = true;
+      } else if (argv[5][0] == 'n') {
+        verify_output = false;
+      } else {
+        std::cerr << "Invalid argument. Option \"verify\" should be \"y\" or \"n\"" << std::endl;
+        return 1;
+      }
+      if(!strncmp(argv[6], "plain", 5)) {
+        enc = ptoa::encoding::PLAIN;
+      } else if (!strncmp(argv[6], "dictionary", 10)) {
+        enc = ptoa::encoding::DICTIONARY;
+      } else {
+        std::cerr << "Invalid argument. Option \"encoding\" should be \"plain\" or \"dictionary\"" << std::endl;
+        return 1;
+      }
+    } else {
+      std::cerr << "Usage: fixed parquet_hw_input_file_path reference_parquet_file_path num_values iterations verify(y or n) encoding [threads]" << std::endl;
+      return 1;
+    }
+
+    ptoa::SWParquetReader reader(hw_input_file_path);
+
+    // Optional amount of threads for page parallel decoding
+    if(argc > 7) {
+      reader.set_num_threads(std::strtoul(argv[7], nullptr, 10));
+    }
+
+    // Locate the first column chunk through the footer, the schema tells how to read its values
+    const ptoa::file_metadata* metadata;
+    const ptoa::column_chunk_info* chunk;
+    if((reader.get_file_metadata(&metadata) != ptoa::status::OK) || (reader.get_column_chunk(0, 0, &chunk) != ptoa::status::OK)){
+        return 1;
+    }
+    const ptoa::column_info& info = metadata->columns[0];
+    int64_t file_offset = chunk->data_page_offset;
+
+    if((info.type != ptoa::parquet_type::INT96) && (info.type != ptoa::parquet_type::FIXED_LEN_BYTE_ARRAY)) {
+        std::cerr << "Invalid input file. Fixed width reading requires an INT96 or FIXED_LEN_BYTE_ARRAY column" << std::endl;
+        return 1;
+    }
+
+    reader.count_pages(file_offset);
+
+    std::shared_ptr<arrow::Array> array;
+    std::shared_ptr<arrow::Buffer> arr_buffer;
+
+    for(int i=0; i<iterations; i++){
+        t.start();
+        // Reading the Parquet file. The interesting bit.
+        if(read_values(reader, info, num_values, file_offset, &array, nullptr, enc) != ptoa::status::OK){
+            return 1;
+        }
+        t.stop();
+        t.record();
+    }
+
+    std::cout << "Read " << num_values << " values" << std::endl;
+    std::cout << "Average time in seconds (not pre-allocated): " << t.average() << std::endl;
+
+    t.clear_history();
+
+    // Only relevant for the benchmark with pre-allocated (and memset) buffer
+    arrow::AllocateBuffer((int64_t) num_values*value_width(info), &arr_buffer);
+    std::memset((void*)(arr_buffer->mutable_data()), 0, (int64_t) num_values*value_width(info));
+
+    for(int i=0; i<iterations; i++){
+        t.start();
+        // Reading the Parquet file. The interesting bit.
+        if(read_values(reader, info, num_values, file_offset, &array, arr_buffer, enc) != ptoa::status::OK){
+            return 1;
+        }
+        t.stop();
+        t.record();
+    }
+
+    std::cout << "Read " << num_values << " values" << std::endl;
+    std::cout << "Average time in seconds (pre-allocated): " << t.average() << std::endl;
+
+    if(verify_output) {
+        std::shared_ptr<arrow::Array> correct_array = readArray(std::string(reference_parquet_file_path));
+
+        // Verify result
+        int error_count = verify(array, correct_array, info, num_values);
+
+        if(array->length() != num_values){
+          error_count++;
+        }
+
+        if(error_count == 0) {
+          std::cout << "Test passed!" << std::endl;
+        } else {
+          std::cout << "Test failed. Found " << error_count << " errors in the output Arrow array" << std::endl;
+        }
+    }
+
+}
@@ -0,0 +1,207 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <cstdlib>
+
+#include <SWParquetReader.h>
+#include <PageHeader.h>
+#include <timer.h>
+
+// Decodes all page headers of the column chunk at file_offset over and over and reports the page header throughput.
+// Beforehand every header is decoded by the inline fast path, the generic decoder and the parser the reader used before them,
+// which all have to agree.
+
+// Decodes the zigzag varint at input into decoded_int. Returns its length in bytes.
+static int baseline_decode_varint32(const uint8_t* input, int32_t* decoded_int) {
+    int32_t result = 0;
+    int i;
+
+    for (i = 0; i < 5; i++) {
+        result |= (input[i] & 127) << (7 * i);
+
+        if(!(input[i] & 128)) {
+            break;
+        }
+    }
+
+    *decoded_int = ((result >> 1) & 0x7FFFFFFF) ^ (-(result & 1));
+
+    return i+1;
+}
+
+// Decodes the i32 field at ptr, which has to directly follow the previous field
+static bool baseline_read_field(const uint8_t** ptr, int32_t* value) {
+    if(**ptr != 0x15) {
+        return false;
+    }
+    *ptr += 1 + baseline_decode_varint32(*ptr + 1, value);
+    return true;
+}
+
+// The page header parser of the reader before the table driven decoder, for DATA_PAGE and DATA_PAGE_V2 headers with all fields
+// in id order. It decodes the fields the reader used then into header and leaves the others untouched. It expected the stop
+// fields right after the page type specific fields, an empty Statistics struct in front of them, as writers now put there,
+// is skipped as well.
+static ptoa::status baseline_read_page_header(const uint8_t* data, ptoa::page_header* header) {
+    const uint8_t* ptr = data;
+    int32_t type, crc, encoding, num_nulls, num_rows;
+
+    if(!baseline_read_field(&ptr, &type) || !baseline_read_field(&ptr, &header->uncompressed_size) || !baseline_read_field(&ptr, &header->compressed_size)) {
+        return ptoa::status::FAIL;
+    }
+
+    bool has_crc = baseline_read_field(&ptr, &crc);
+    uint8_t struct_header = *ptr++;
+
+    if(type == (int32_t) ptoa::page_type::DATA_PAGE) {
+        if((struct_header != (has_crc ? 0x1c : 0x2c)) || !baseline_read_field(&ptr, &header->num_values)
+                || !baseline_read_field(&ptr, &encoding) || !baseline_read_field(&ptr, &encoding) || !baseline_read_field(&ptr, &encoding)) {
+            return ptoa::status::FAIL;
+        }
+    } else if(type == (int32_t) ptoa::page_type::DATA_PAGE_V2) {
+        if((struct_header != (has_crc ? 0x4c : 0x5c)) || !baseline_read_field(&ptr, &header->num_values)
+                || !baseline_read_field(&ptr, &num_nulls) || !baseline_read_field(&ptr, &num_rows) || !baseline_read_field(&ptr, &encoding)
+                || !baseline_read_field(&ptr, &header->def_level_length) || !baseline_read_field(&ptr, &header->rep_level_length)) {
+            return ptoa::status::FAIL;
+        }
+        //is_compressed
+        if((*ptr == 0x11) || (*ptr == 0x12)) {
+            ptr++;
+        }
+    } else {
+        return ptoa::status::FAIL;
+    }
+
+    if((ptr[0] == 0x1c) && (ptr[1] == 0x00)) {
+        ptr += 2;
+    }
+
+    //Skip stop bytes
+    ptr += 2;
+
+    header->header_size = ptr - data;
+
+    return ptoa::status::OK;
+}
+
+static bool same_range(const ptoa::byte_range& a, const ptoa::byte_range& b) {
+    return (a.data == b.data) && (!a.data || (a.size == b.size));
+}
+
+// Compares every field of two decoded page headers
+static bool same_header(const ptoa::page_header& a, const ptoa::page_header& b) {
+    return (a.type == b.type) && (a.uncompressed_size == b.uncompressed_size) && (a.compressed_size == b.compressed_size)
+        && (a.num_values == b.num_values) && (a.encoding == b.encoding)
+        && (a.def_level_encoding == b.def_level_encoding) && (a.rep_level_encoding == b.rep_level_encoding)
+        && (a.num_nulls == b.num_nulls) && (a.num_rows == b.num_rows)
+        && (a.def_level_length == b.def_level_length) && (a.rep_level_length == b.rep_level_length)
+        && (a.is_compressed == b.is_compressed) && (a.is_sorted == b.is_sorted) && (a.header_size == b.header_size)
+        && same_range(a.statistics.max, b.statistics.max) && same_range(a.statistics.min, b.statistics.min)
+        && (a.statistics.null_count == b.statistics.null_count)
+        && same_range(a.statistics.max_value, b.statistics.max_value) && same_range(a.statistics.min_value, b.statistics.min_value);
+}
+
+int main(int argc, char **argv) {
+    char* parquet_file_path;
+    int64_t file_offset;
+    int iterations;
+
+    Timer t;
+
+    if (argc > 3) {
+      parquet_file_path = argv[1];
+      file_offset = std::strtoll(argv[2], nullptr, 10);
+      iterations = (uint32_t) std::strtoul(argv[3], nullptr, 10);
+    } else {
+      std::cerr << "Usage: headers parquet_file_path file_offset iterations" << std::endl;
+      return 1;
+    }
+
+    // The page index gives the header locations, the headers themselves are decoded from a copy of the file
+    ptoa::SWParquetReader reader(parquet_file_path);
+    const ptoa::page_index* index;
+
+    if(reader.get_page_index(file_offset, &index) != ptoa::status::OK) {
+      return 1;
+    }
+
+    std::ifstream file(parquet_file_path, std::ios::binary);
+    std::vector<uint8_t> file_data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    const uint8_t* file_end = file_data.data() + file_data.size();
+
+    int32_t num_pages = index->num_pages();
+    int64_t checksum = 0;
+    int64_t num_values = 0;
+    int error_count = 0;
+
+    for(int32_t page=0; page<num_pages; page++){
+      const uint8_t* data = file_data.data() + index->page_offsets[page];
+      ptoa::page_header header, generic_header;
+
+      if((ptoa::read_page_header(data, file_end, &header) != ptoa::status::OK)
+              || (ptoa::read_page_header_generic(data, file_end, &generic_header) != ptoa::status::OK)
+              || !same_header(header, generic_header)) {
+        std::cout << "Page header at file offset " << index->page_offsets[page] << " decodes differently on the fast path and the generic decoder" << std::endl;
+        error_count++;
+        continue;
+      }
+
+      // The baseline parser only knows the fields it decodes, the others are taken over from the fast path. It cannot skip
+      // statistics that hold anything.
+      const ptoa::value_statistics& statistics = header.statistics;
+      bool has_statistics = statistics.max.data || statistics.min.data || (statistics.null_count >= 0) || statistics.max_value.data || statistics.min_value.data;
+      ptoa::page_header baseline_header = header;
+      if(header.is_data_page() && !has_statistics
+              && ((baseline_read_page_header(data, &baseline_header) != ptoa::status::OK) || !same_header(header, baseline_header))) {
+        std::cout << "Page header at file offset " << index->page_offsets[page] << " decodes differently on the fast path and the baseline parser" << std::endl;
+        error_count++;
+      }
+
+      num_values += header.num_values;
+    }
+
+    for(int i=0; i<iterations; i++){
+      t.start();
+      for(int32_t page=0; page<num_pages; page++){
+        ptoa::page_header header;
+        int64_t page_offset = index->page_offsets[page];
+        if(ptoa::read_page_header(file_data.data() + page_offset, file_end, &header) != ptoa::status::OK) {
+          error_count++;
+        }
+        // The pages of a column chunk follow each other directly, as the reader walks them
+        if((page + 1 < num_pages) && (page_offset + header.header_size + header.compressed_size != index->page_offsets[page + 1])) {
+          error_count++;
+        }
+        checksum += header.num_values;
+      }
+      t.stop();
+      t.record();
+    }
+
+    // The page index counts list elements rather than level entries, so the value counts are checked against the decoded headers
+    if((error_count > 0) || (checksum != num_values*iterations)) {
+      std::cout << "Test failed. Page headers did not decode to the page index contents" << std::endl;
+      return 1;
+    }
+
+    std::cout << "Pages: " << num_pages << std::endl;
+    std::cout << "Average time per header: " << std::fixed << std::setprecision(1) << t.average()*1e9/num_pages << " ns" << std::endl;
+    std::cout << "Headers per second: " << std::setprecision(0) << num_pages/t.average() << std::endl;
+    std::cout << "Test passed!" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,176 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <iomanip>
+
+#include <parquet/arrow/reader.h>
+
+#include <SWParquetReader.h>
+#include <timer.h>
+
+//Use standard Arrow library functions to read Arrow array from Parquet file
+//Only works for Parquet version 1 style files.
+std::shared_ptr<arrow::Array> readArray(std::string hw_input_file_path) {
+  std::shared_ptr<arrow::io::ReadableFile> infile;
+  PARQUET_THROW_NOT_OK(arrow::io::ReadableFile::Open(hw_input_file_path, arrow::default_memory_pool(), &infile));
+
+  std::unique_ptr<parquet::arrow::FileReader> reader;
+  PARQUET_THROW_NOT_OK(parquet::arrow::OpenFile(infile, arrow::default_memory_pool(), &reader));
+
+  std::shared_ptr<arrow::ChunkedArray> carray;
+  PARQUET_THROW_NOT_OK(reader->ReadColumn(0, &carray));
+  std::shared_ptr<arrow::Array> array = carray->chunk(0);
+  return array;
+}
+
+template<typename ArrayType>
+bool values_equal(const std::shared_ptr<ArrayType>& result, int64_t i, const std::shared_ptr<ArrayType>& correct, int64_t j) {
+    return result->Value(i) == correct->Value(j);
+}
+
+template<>
+bool values_equal(const std::shared_ptr<arrow::StringArray>& result, int64_t i, const std::shared_ptr<arrow::StringArray>& correct, int64_t j) {
+    return result->GetString(i).compare(correct->GetString(j)) == 0;
+}
+
+// Compare the validity and the length of every list, then the validity and the value of every element of the non-null lists.
+// Offsets are compared as list lengths, so that the reference may start at any offset. Returns the amount of errors found.
+template<typename ArrayType>
+int verify(const std::shared_ptr<arrow::ListArray>& result_array, const std::shared_ptr<arrow::ListArray>& correct_array) {
+    auto result_values = std::static_pointer_cast<ArrayType>(result_array->values());
+    auto correct_values = std::static_pointer_cast<ArrayType>(correct_array->values());
+    int error_count = 0;
+
+    for(int64_t i=0; i<result_array->length(); i++) {
+        int32_t result_length = result_array->value_offset(i+1) - result_array->value_offset(i);
+        int32_t correct_length = correct_array->value_offset(i+1) - correct_array->value_offset(i);
+
+        if(result_array->IsNull(i) != correct_array->IsNull(i)) {
+            error_count++;
+            if(error_count<20) {
+                std::cout<<"List "<<i<<" null: "<<result_array->IsNull(i)<<" expected: "<<correct_array->IsNull(i)<<std::endl;
+            }
+            continue;
+        } else if(correct_array->IsNull(i)) {
+            continue;
+        } else if(result_length != correct_length) {
+            error_count++;
+            if(error_count<20) {
+                std::cout<<"List "<<i<<" length: "<<result_length<<" expected: "<<correct_length<<std::endl;
+            }
+            continue;
+        }
+
+        for(int32_t j=0; j<result_length; j++) {
+            int64_t result_index = result_array->value_offset(i) + j;
+            int64_t correct_index = correct_array->value_offset(i) + j;
+            bool result_null = result_values->IsNull(result_index);
+
+            if((result_null != correct_values->IsNull(correct_index))
+                    || (!result_null && !values_equal<ArrayType>(result_values, result_index, correct_values, correct_index))) {
+                error_count++;
+                if(error_count<20) {
+                    std::cout<<"List "<<i<<" element "<<j<<std::endl;
+                }
+            }
+        }
+    }
+
+    return error_count;
+}
+
+int main(int argc, char **argv) {
+    char* hw_input_file_path;
+    char* reference_parquet_file_path;
+    int iterations;
+    bool verify_output;
+
+    Timer t;
+
+    if (argc > 4) {
+      hw_input_file_path = argv[1];
+      reference_parquet_file_path = argv[2];
+      iterations = (uint32_t) std::strtoul(argv[3], nullptr, 10);
+      if(argv[4][0] == 'y') {
+        verify_output = true;
+      } else if (argv[4][0] == 'n') {
+        verify_output = false;
+      } else {
+        std::cerr << "Invalid argument. Option \"verify\" should be \"y\" or \"n\"" << std::endl;
+        return 1;
+      }
+    } else {
+      std::cerr << "Usage: list parquet_hw_input_file_path reference_parquet_file_path iterations verify(y or n) [threads]" << std::endl;
+      return 1;
+    }
+
+    ptoa::SWParquetReader reader(hw_input_file_path);
+
+    // Optional amount of threads for page parallel decoding
+    if(argc > 5) {
+      reader.set_num_threads(std::strtoul(argv[5], nullptr, 10));
+    }
+
+    // Locate the first column chunk through the footer, its type is that of the list elements
+    const ptoa::column_chunk_info* chunk;
+    if(reader.get_column_chunk(0, 0, &chunk) != ptoa::status::OK){
+        return 1;
+    }
+
+    if((chunk->type != ptoa::parquet_type::INT32) && (chunk->type != ptoa::parquet_type::INT64) && (chunk->type != ptoa::parquet_type::BYTE_ARRAY)) {
+        std::cerr << "Invalid input file. Lists of INT32, INT64 or BYTE_ARRAY values are supported" << std::endl;
+        return 1;
+    }
+
+    reader.count_pages(chunk->data_page_offset);
+
+    std::shared_ptr<arrow::ListArray> result_array;
+
+    for(int i=0; i<iterations; i++){
+        t.start();
+        // Reading the Parquet file. The interesting bit.
+        if(reader.read_column_list(0, 0, &result_array) != ptoa::status::OK){
+            return 1;
+        }
+        t.stop();
+        t.record();
+    }
+
+    std::cout << "Read " << result_array->length() << " lists of " << result_array->values()->length() << " values" << std::endl;
+    std::cout << "Average time in seconds: " << t.average() << std::endl;
+
+    if(verify_output) {
+        auto correct_array = std::dynamic_pointer_cast<arrow::ListArray>(readArray(std::string(reference_parquet_file_path)));
+
+        // Verify result
+        int error_count = 0;
+
+        if(result_array->length() > correct_array->length()){
+          error_count++;
+          std::cout<<"Read "<<result_array->length()<<" lists, the reference holds "<<correct_array->length()<<std::endl;
+        } else if(chunk->type == ptoa::parquet_type::INT32) {
+          error_count = verify<arrow::Int32Array>(result_array, correct_array);
+        } else if(chunk->type == ptoa::parquet_type::INT64) {
+          error_count = verify<arrow::Int64Array>(result_array, correct_array);
+        } else {
+          error_count = verify<arrow::StringArray>(result_array, correct_array);
+        }
+
+        if(error_count == 0) {
+          std::cout << "Test passed!" << std::endl;
+        } else {
+          std::cout << "Test failed. Found " << error_count << " errors in the output Arrow array" << std::endl;
+        }
+    }
+
+}
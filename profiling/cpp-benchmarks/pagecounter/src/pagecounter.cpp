@@ -60,7 +60,21 @@ int main(int argc, char **argv) {
       return 1;
     }
 
-    ptoa::SWParquetReader reader(hw_input_file_path);
-    //reader.inspect_metadata(4);
-    reader.count_pages(4);
+    // Only the page headers are touched, so there is no point in reading the page data from disk
+    ptoa::SWParquetReader reader(hw_input_file_path, ptoa::load_mode::MMAP);
+
+    const ptoa::file_metadata* metadata;
+    if(reader.get_file_metadata(&metadata) != ptoa::status::OK){
+        return 1;
+    }
+
+    // Count the pages of every column chunk in the file
+    for(int32_t rg=0; rg<metadata->num_row_groups(); rg++){
+        for(int32_t col=0; col<metadata->num_columns(); col++){
+            const ptoa::column_chunk_info& chunk = metadata->column_chunk(rg, col);
+            std::cout << "Row group " << rg << ", column " << metadata->columns[col].path << " (" << chunk.num_values << " values)" << std::endl;
+            //reader.inspect_metadata(chunk.data_page_offset);
+            reader.count_pages(chunk.data_page_offset);
+        }
+    }
 }
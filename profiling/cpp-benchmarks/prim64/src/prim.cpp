@@ -67,13 +67,26 @@ int main(int argc, char **argv) {
         return 1;
       }
     } else {
-      std::cerr << "Usage: prim parquet_hw_input_file_path reference_parquet_file_path num_values iterations verify(y or n) encoding" << std::endl;
+      std::cerr << "Usage: prim parquet_hw_input_file_path reference_parquet_file_path num_values iterations verify(y or n) encoding [threads]" << std::endl;
       return 1;
     }
 
     ptoa::SWParquetReader reader(hw_input_file_path);
-    //reader.inspect_metadata(4);
-    reader.count_pages(4);
+
+    // Optional amount of threads for page parallel decoding
+    if(argc > 7) {
+      reader.set_num_threads(std::strtoul(argv[7], nullptr, 10));
+    }
+
+    // Locate the first column chunk through the footer
+    const ptoa::column_chunk_info* chunk;
+    if(reader.get_column_chunk(0, 0, &chunk) != ptoa::status::OK){
+        return 1;
+    }
+    int64_t file_offset = chunk->data_page_offset;
+
+    //reader.inspect_metadata(file_offset);
+    reader.count_pages(file_offset);
 
     std::shared_ptr<arrow::PrimitiveArray> array;
     std::shared_ptr<arrow::Buffer> arr_buffer;
@@ -81,7 +94,7 @@ int main(int argc, char **argv) {
     for(int i=0; i<iterations; i++){
         t.start();
         // Reading the Parquet file. The interesting bit.
-        if(reader.read_prim(PRIM_WIDTH, num_values, 4, &array, enc) != ptoa::status::OK){
+        if(reader.read_prim(PRIM_WIDTH, num_values, file_offset, &array, enc) != ptoa::status::OK){
             return 1;
         }
         t.stop();
@@ -100,7 +113,7 @@ int main(int argc, char **argv) {
     for(int i=0; i<iterations; i++){
         t.start();
         // Reading the Parquet file. The interesting bit.
-        if(reader.read_prim(PRIM_WIDTH, num_values, 4, &array, arr_buffer, enc) != ptoa::status::OK){
+        if(reader.read_prim(PRIM_WIDTH, num_values, file_offset, &array, arr_buffer, enc) != ptoa::status::OK){
             return 1;
         }
         t.stop();
@@ -110,6 +123,25 @@ int main(int argc, char **argv) {
     std::cout << "Read " << num_values << " values" << std::endl;
     std::cout << "Average time in seconds (pre-allocated): " << t.average() << std::endl;
 
+    // Plain pages can be wrapped without copying the values at all
+    if(enc == ptoa::encoding::PLAIN) {
+        std::shared_ptr<arrow::ChunkedArray> chunked_array;
+
+        t.clear_history();
+
+        for(int i=0; i<iterations; i++){
+            t.start();
+            if(reader.read_prim_zero_copy(PRIM_WIDTH, num_values, file_offset, &chunked_array, enc) != ptoa::status::OK){
+                return 1;
+            }
+            t.stop();
+            t.record();
+        }
+
+        std::cout << "Read " << num_values << " values in " << chunked_array->num_chunks() << " chunks" << std::endl;
+        std::cout << "Average time in seconds (zero-copy): " << t.average() << std::endl;
+    }
+
     if(verify_output) {
         #if PRIM_WIDTH == 64
             auto result_array = std::static_pointer_cast<arrow::Int64Array>(array);
@@ -0,0 +1,223 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <immintrin.h>
+
+#include "AggregateKernels.h"
+#include "SimdDispatch.h"
+
+namespace ptoa {
+
+/*
+ * Scalar reference implementations, also used for the values left over by the SIMD ones
+ */
+
+template<typename T>
+static inline void aggregate_values_scalar(const T* values, int32_t n, value_aggregate* aggregate) {
+    uint64_t sum = 0;
+    int64_t min = aggregate->min;
+    int64_t max = aggregate->max;
+
+    for(int32_t i = 0; i < n; i++) {
+        sum += (uint64_t) (int64_t) values[i];
+        min = std::min(min, (int64_t) values[i]);
+        max = std::max(max, (int64_t) values[i]);
+    }
+
+    aggregate->count += n;
+    aggregate->sum = (int64_t) ((uint64_t) aggregate->sum + sum);
+    aggregate->min = min;
+    aggregate->max = max;
+}
+
+static void aggregate_values32_scalar(const int32_t* values, int32_t n, value_aggregate* aggregate) {
+    aggregate_values_scalar(values, n, aggregate);
+}
+
+static void aggregate_values64_scalar(const int64_t* values, int32_t n, value_aggregate* aggregate) {
+    aggregate_values_scalar(values, n, aggregate);
+}
+
+// Fold the lanes of vector sums, minima and maxima into aggregate, together with the values that did not fill a vector
+template<typename T, int32_t lanes>
+static inline void fold_lanes(const int64_t* sums, int32_t sum_lanes, const T* mins, const T* maxs, int32_t count, value_aggregate* aggregate) {
+    if(count == 0) {
+        return;
+    }
+
+    uint64_t sum = 0;
+    for(int32_t k = 0; k < sum_lanes; k++) {
+        sum += (uint64_t) sums[k];
+    }
+
+    int64_t min = aggregate->min;
+    int64_t max = aggregate->max;
+    for(int32_t k = 0; k < lanes; k++) {
+        min = std::min(min, (int64_t) mins[k]);
+        max = std::max(max, (int64_t) maxs[k]);
+    }
+
+    aggregate->count += count;
+    aggregate->sum = (int64_t) ((uint64_t) aggregate->sum + sum);
+    aggregate->min = min;
+    aggregate->max = max;
+}
+
+/*
+ * AVX2 implementations. 32 bit values are summed in 64 bit lanes, so that the sum of a group cannot overflow.
+ * AVX2 has no 64 bit minimum and maximum, those are selected with a compare and a blend.
+ */
+
+__attribute__((target("avx2")))
+static void aggregate_values32_avx2(const int32_t* values, int32_t n, value_aggregate* aggregate) {
+    __m256i sum = _mm256_setzero_si256();
+    __m256i min = _mm256_set1_epi32(INT32_MAX);
+    __m256i max = _mm256_set1_epi32(INT32_MIN);
+    int32_t i = 0;
+
+    for(; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (values + i));
+        min = _mm256_min_epi32(min, v);
+        max = _mm256_max_epi32(max, v);
+        sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+
+    int64_t sums[4];
+    int32_t mins[8];
+    int32_t maxs[8];
+    _mm256_storeu_si256((__m256i*) sums, sum);
+    _mm256_storeu_si256((__m256i*) mins, min);
+    _mm256_storeu_si256((__m256i*) maxs, max);
+    fold_lanes<int32_t, 8>(sums, 4, mins, maxs, i, aggregate);
+
+    aggregate_values_scalar(values + i, n - i, aggregate);
+}
+
+__attribute__((target("avx2")))
+static void aggregate_values64_avx2(const int64_t* values, int32_t n, value_aggregate* aggregate) {
+    __m256i sum = _mm256_setzero_si256();
+    __m256i min = _mm256_set1_epi64x(INT64_MAX);
+    __m256i max = _mm256_set1_epi64x(INT64_MIN);
+    int32_t i = 0;
+
+    for(; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (values + i));
+        min = _mm256_blendv_epi8(min, v, _mm256_cmpgt_epi64(min, v));
+        max = _mm256_blendv_epi8(max, v, _mm256_cmpgt_epi64(v, max));
+        sum = _mm256_add_epi64(sum, v);
+    }
+
+    int64_t sums[4];
+    int64_t mins[4];
+    int64_t maxs[4];
+    _mm256_storeu_si256((__m256i*) sums, sum);
+    _mm256_storeu_si256((__m256i*) mins, min);
+    _mm256_storeu_si256((__m256i*) maxs, max);
+    fold_lanes<int64_t, 4>(sums, 4, mins, maxs, i, aggregate);
+
+    aggregate_values_scalar(values + i, n - i, aggregate);
+}
+
+/*
+ * AVX-512 implementations, with native 64 bit minimum and maximum. The zero masking forms are used throughout, the plain ones
+ * start from an undefined register that GCC warns about. The lanes are folded like those of the AVX2 implementations.
+ */
+
+__attribute__((target("avx512f")))
+static void aggregate_values32_avx512(const int32_t* values, int32_t n, value_aggregate* aggregate) {
+    const __mmask16 all = 0xFFFF;
+    __m512i sum = _mm512_setzero_si512();
+    __m512i min = _mm512_set1_epi32(INT32_MAX);
+    __m512i max = _mm512_set1_epi32(INT32_MIN);
+    int32_t i = 0;
+
+    for(; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_loadu_si512(values + i);
+        min = _mm512_maskz_min_epi32(all, min, v);
+        max = _mm512_maskz_max_epi32(all, max, v);
+        sum = _mm512_add_epi64(sum, _mm512_maskz_cvtepi32_epi64(0xFF, _mm256_loadu_si256((const __m256i*) (values + i))));
+        sum = _mm512_add_epi64(sum, _mm512_maskz_cvtepi32_epi64(0xFF, _mm256_loadu_si256((const __m256i*) (values + i + 8))));
+    }
+
+    int64_t sums[8];
+    int32_t mins[16];
+    int32_t maxs[16];
+    _mm512_storeu_si512(sums, sum);
+    _mm512_storeu_si512(mins, min);
+    _mm512_storeu_si512(maxs, max);
+    fold_lanes<int32_t, 16>(sums, 8, mins, maxs, i, aggregate);
+
+    aggregate_values_scalar(values + i, n - i, aggregate);
+}
+
+__attribute__((target("avx512f")))
+static void aggregate_values64_avx512(const int64_t* values, int32_t n, value_aggregate* aggregate) {
+    const __mmask8 all = 0xFF;
+    __m512i sum = _mm512_setzero_si512();
+    __m512i min = _mm512_set1_epi64(INT64_MAX);
+    __m512i max = _mm512_set1_epi64(INT64_MIN);
+    int32_t i = 0;
+
+    for(; i + 8 <= n; i += 8) {
+        __m512i v = _mm512_loadu_si512(values + i);
+        min = _mm512_maskz_min_epi64(all, min, v);
+        max = _mm512_maskz_max_epi64(all, max, v);
+        sum = _mm512_add_epi64(sum, v);
+    }
+
+    int64_t sums[8];
+    int64_t mins[8];
+    int64_t maxs[8];
+    _mm512_storeu_si512(sums, sum);
+    _mm512_storeu_si512(mins, min);
+    _mm512_storeu_si512(maxs, max);
+    fold_lanes<int64_t, 8>(sums, 8, mins, maxs, i, aggregate);
+
+    aggregate_values_scalar(values + i, n - i, aggregate);
+}
+
+/*
+ * Runtime dispatch
+ */
+
+typedef void (*aggregate_values32_fn)(const int32_t*, int32_t, value_aggregate*);
+typedef void (*aggregate_values64_fn)(const int64_t*, int32_t, value_aggregate*);
+
+static aggregate_values32_fn select_aggregate_values32() {
+    switch(detect_simd_level()) {
+        case simd_level::AVX512: return aggregate_values32_avx512;
+        case simd_level::AVX2: return aggregate_values32_avx2;
+        default: return aggregate_values32_scalar;
+    }
+}
+
+static aggregate_values64_fn select_aggregate_values64() {
+    switch(detect_simd_level()) {
+        case simd_level::AVX512: return aggregate_values64_avx512;
+        case simd_level::AVX2: return aggregate_values64_avx2;
+        default: return aggregate_values64_scalar;
+    }
+}
+
+static const aggregate_values32_fn aggregate_values32_impl = select_aggregate_values32();
+static const aggregate_values64_fn aggregate_values64_impl = select_aggregate_values64();
+
+void aggregate_values32(const int32_t* values, int32_t n, value_aggregate* aggregate) {
+    aggregate_values32_impl(values, n, aggregate);
+}
+
+void aggregate_values64(const int64_t* values, int32_t n, value_aggregate* aggregate) {
+    aggregate_values64_impl(values, n, aggregate);
+}
+
+}
@@ -0,0 +1,51 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+
+/*
+ * SUM, MIN, MAX and COUNT of integer values, accumulated over decoded values a group at a time without storing them anywhere
+ */
+
+namespace ptoa{
+
+// Running aggregates of a column. count excludes nulls, which are counted in null_count. sum wraps around like int64 arithmetic,
+// as Arrow's integer sums do. min and max are only meaningful once count is above 0.
+struct value_aggregate {
+    int64_t count;
+    int64_t null_count;
+    int64_t sum;
+    int64_t min;
+    int64_t max;
+
+    value_aggregate() : count(0), null_count(0), sum(0), min(INT64_MAX), max(INT64_MIN) {}
+
+    // Fold in the aggregates of another part of the column
+    void merge(const value_aggregate& part) {
+        count += part.count;
+        null_count += part.null_count;
+        sum = (int64_t) ((uint64_t) sum + (uint64_t) part.sum);
+        min = std::min(min, part.min);
+        max = std::max(max, part.max);
+    }
+};
+
+// Add the first n (at most 32) of values to aggregate. Values are reduced in vector registers, a vector at a time, the few
+// left over are added one by one. The implementation is picked once at runtime from the CPU features (AVX-512, AVX2 or scalar).
+void aggregate_values32(const int32_t* values, int32_t n, value_aggregate* aggregate);
+void aggregate_values64(const int64_t* values, int32_t n, value_aggregate* aggregate);
+
+}
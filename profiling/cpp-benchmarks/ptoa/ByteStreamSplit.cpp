@@ -0,0 +1,192 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <immintrin.h>
+
+#include "ByteStreamSplit.h"
+#include "SimdDispatch.h"
+
+namespace ptoa {
+
+static void decode32_scalar(const uint8_t* data, int32_t stride, int32_t n, uint8_t* out) {
+    for(int32_t i=0; i<n; i++) {
+        for(int32_t k=0; k<4; k++) {
+            out[i*4 + k] = data[k*stride + i];
+        }
+    }
+}
+
+static void decode64_scalar(const uint8_t* data, int32_t stride, int32_t n, uint8_t* out) {
+    for(int32_t i=0; i<n; i++) {
+        for(int32_t k=0; k<8; k++) {
+            out[i*8 + k] = data[k*stride + i];
+        }
+    }
+}
+
+/*
+ * SSE implementations, 16 values at a time. Interleaving bytes of two streams gives 2 byte pieces of the values,
+ * interleaving those gives 4 byte pieces, and so on.
+ */
+
+static void decode32_sse(const uint8_t* data, int32_t stride, int32_t n, uint8_t* out) {
+    int32_t i = 0;
+
+    for(; i+16<=n; i+=16) {
+        __m128i b0 = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i b1 = _mm_loadu_si128((const __m128i*)(data + stride + i));
+        __m128i b2 = _mm_loadu_si128((const __m128i*)(data + 2*stride + i));
+        __m128i b3 = _mm_loadu_si128((const __m128i*)(data + 3*stride + i));
+
+        __m128i b01_lo = _mm_unpacklo_epi8(b0, b1);
+        __m128i b01_hi = _mm_unpackhi_epi8(b0, b1);
+        __m128i b23_lo = _mm_unpacklo_epi8(b2, b3);
+        __m128i b23_hi = _mm_unpackhi_epi8(b2, b3);
+
+        __m128i* dst = (__m128i*)(out + i*4);
+        _mm_storeu_si128(dst, _mm_unpacklo_epi16(b01_lo, b23_lo));
+        _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(b01_lo, b23_lo));
+        _mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(b01_hi, b23_hi));
+        _mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(b01_hi, b23_hi));
+    }
+
+    for(; i<n; i++) {
+        for(int32_t k=0; k<4; k++) {
+            out[i*4 + k] = data[k*stride + i];
+        }
+    }
+}
+
+static void decode64_sse(const uint8_t* data, int32_t stride, int32_t n, uint8_t* out) {
+    int32_t i = 0;
+
+    for(; i+16<=n; i+=16) {
+        __m128i b01[2], b23[2], b45[2], b67[2];
+        for(int32_t k=0; k<8; k+=2) {
+            __m128i even = _mm_loadu_si128((const __m128i*)(data + k*stride + i));
+            __m128i odd = _mm_loadu_si128((const __m128i*)(data + (k+1)*stride + i));
+            __m128i* pair = k == 0 ? b01 : k == 2 ? b23 : k == 4 ? b45 : b67;
+            pair[0] = _mm_unpacklo_epi8(even, odd);
+            pair[1] = _mm_unpackhi_epi8(even, odd);
+        }
+
+        // Bytes 0-3 and 4-7 of values 4q to 4q+3
+        __m128i* dst = (__m128i*)(out + i*8);
+        for(int32_t q=0; q<4; q++) {
+            __m128i low = (q & 1) ? _mm_unpackhi_epi16(b01[q/2], b23[q/2]) : _mm_unpacklo_epi16(b01[q/2], b23[q/2]);
+            __m128i high = (q & 1) ? _mm_unpackhi_epi16(b45[q/2], b67[q/2]) : _mm_unpacklo_epi16(b45[q/2], b67[q/2]);
+            _mm_storeu_si128(dst + 2*q, _mm_unpacklo_epi32(low, high));
+            _mm_storeu_si128(dst + 2*q + 1, _mm_unpackhi_epi32(low, high));
+        }
+    }
+
+    decode64_scalar(data + i, stride, n - i, out + i*8);
+}
+
+/*
+ * AVX2 implementations, 32 values at a time. The unpack instructions work within 128 bit lanes, so the high lanes
+ * end up holding the values 16 places further on.
+ */
+
+__attribute__((target("avx2")))
+static void decode32_avx2(const uint8_t* data, int32_t stride, int32_t n, uint8_t* out) {
+    int32_t i = 0;
+
+    for(; i+32<=n; i+=32) {
+        __m256i b0 = _mm256_loadu_si256((const __m256i*)(data + i));
+        __m256i b1 = _mm256_loadu_si256((const __m256i*)(data + stride + i));
+        __m256i b2 = _mm256_loadu_si256((const __m256i*)(data + 2*stride + i));
+        __m256i b3 = _mm256_loadu_si256((const __m256i*)(data + 3*stride + i));
+
+        __m256i b01_lo = _mm256_unpacklo_epi8(b0, b1);
+        __m256i b01_hi = _mm256_unpackhi_epi8(b0, b1);
+        __m256i b23_lo = _mm256_unpacklo_epi8(b2, b3);
+        __m256i b23_hi = _mm256_unpackhi_epi8(b2, b3);
+
+        // Values 0-3 | 16-19, 4-7 | 20-23, 8-11 | 24-27 and 12-15 | 28-31
+        __m256i v0 = _mm256_unpacklo_epi16(b01_lo, b23_lo);
+        __m256i v1 = _mm256_unpackhi_epi16(b01_lo, b23_lo);
+        __m256i v2 = _mm256_unpacklo_epi16(b01_hi, b23_hi);
+        __m256i v3 = _mm256_unpackhi_epi16(b01_hi, b23_hi);
+
+        __m256i* dst = (__m256i*)(out + i*4);
+        _mm256_storeu_si256(dst, _mm256_permute2x128_si256(v0, v1, 0x20));
+        _mm256_storeu_si256(dst + 1, _mm256_permute2x128_si256(v2, v3, 0x20));
+        _mm256_storeu_si256(dst + 2, _mm256_permute2x128_si256(v0, v1, 0x31));
+        _mm256_storeu_si256(dst + 3, _mm256_permute2x128_si256(v2, v3, 0x31));
+    }
+
+    decode32_sse(data + i, stride, n - i, out + i*4);
+}
+
+__attribute__((target("avx2")))
+static void decode64_avx2(const uint8_t* data, int32_t stride, int32_t n, uint8_t* out) {
+    int32_t i = 0;
+
+    for(; i+32<=n; i+=32) {
+        __m256i pairs[4][2];
+        for(int32_t k=0; k<8; k+=2) {
+            __m256i even = _mm256_loadu_si256((const __m256i*)(data + k*stride + i));
+            __m256i odd = _mm256_loadu_si256((const __m256i*)(data + (k+1)*stride + i));
+            pairs[k/2][0] = _mm256_unpacklo_epi8(even, odd);
+            pairs[k/2][1] = _mm256_unpackhi_epi8(even, odd);
+        }
+
+        // Bytes 0-3 and 4-7 of values 4q to 4q+3 in the low lanes, of values 16+4q to 16+4q+3 in the high lanes
+        __m128i* dst = (__m128i*)(out + i*8);
+        for(int32_t q=0; q<4; q++) {
+            __m256i low = (q & 1) ? _mm256_unpackhi_epi16(pairs[0][q/2], pairs[1][q/2]) : _mm256_unpacklo_epi16(pairs[0][q/2], pairs[1][q/2]);
+            __m256i high = (q & 1) ? _mm256_unpackhi_epi16(pairs[2][q/2], pairs[3][q/2]) : _mm256_unpacklo_epi16(pairs[2][q/2], pairs[3][q/2]);
+            __m256i first = _mm256_unpacklo_epi32(low, high);
+            __m256i second = _mm256_unpackhi_epi32(low, high);
+            _mm_storeu_si128(dst + 2*q, _mm256_castsi256_si128(first));
+            _mm_storeu_si128(dst + 2*q + 1, _mm256_castsi256_si128(second));
+            _mm_storeu_si128(dst + 8 + 2*q, _mm256_extracti128_si256(first, 1));
+            _mm_storeu_si128(dst + 8 + 2*q + 1, _mm256_extracti128_si256(second, 1));
+        }
+    }
+
+    decode64_sse(data + i, stride, n - i, out + i*8);
+}
+
+typedef void (*decode_fn)(const uint8_t*, int32_t, int32_t, uint8_t*);
+
+static decode_fn select_decode32() {
+    switch(detect_simd_level()) {
+        case simd_level::AVX512:
+        case simd_level::AVX2: return decode32_avx2;
+        case simd_level::SSE4_1: return decode32_sse;
+        default: return decode32_scalar;
+    }
+}
+
+static decode_fn select_decode64() {
+    switch(detect_simd_level()) {
+        case simd_level::AVX512:
+        case simd_level::AVX2: return decode64_avx2;
+        case simd_level::SSE4_1: return decode64_sse;
+        default: return decode64_scalar;
+    }
+}
+
+static const decode_fn decode32_impl = select_decode32();
+static const decode_fn decode64_impl = select_decode64();
+
+void byte_stream_split_decode32(const uint8_t* data, int32_t stride, int32_t n, uint8_t* out) {
+    decode32_impl(data, stride, n, out);
+}
+
+void byte_stream_split_decode64(const uint8_t* data, int32_t stride, int32_t n, uint8_t* out) {
+    decode64_impl(data, stride, n, out);
+}
+
+}
@@ -0,0 +1,30 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * BYTE_STREAM_SPLIT pages of K byte wide values hold K streams, one per byte position. Stream k holds byte k of every value,
+ * so a page of m values is m*K bytes long and stream k starts m*k bytes into it. Decoding is a byte transpose.
+ */
+
+namespace ptoa{
+
+// Decode the first n values of a page of 4 or 8 byte values, whose streams are stride bytes long, into out.
+// The transpose runs 32 (AVX2) or 16 (SSE) values at a time, with the byte interleaving unpack instructions.
+// The implementation is picked once at runtime from the CPU features.
+void byte_stream_split_decode32(const uint8_t* data, int32_t stride, int32_t n, uint8_t* out);
+void byte_stream_split_decode64(const uint8_t* data, int32_t stride, int32_t n, uint8_t* out);
+
+}
@@ -0,0 +1,409 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+#include <algorithm>
+
+#include <immintrin.h>
+
+#include "DefinitionLevels.h"
+#include "RleHybrid.h"
+#include "SimdDispatch.h"
+
+namespace ptoa {
+
+// Appends bits LSB first to a bitmap. Bits are gathered in a 64 bit word that is stored whole once it is full.
+class bitmap_writer {
+  public:
+    bitmap_writer(uint8_t* out, int32_t bit_offset) : out(out), word(0), word_bits(bit_offset), set_bits(0) {}
+
+    // Append the n lowest bits of bits, with n at most 64 and all higher bits zero
+    void append(uint64_t bits, int32_t n) {
+        set_bits += __builtin_popcountll(bits);
+        word |= bits << word_bits;
+        if(word_bits + n >= 64) {
+            std::memcpy(out, &word, 8);
+            out += 8;
+            word = word_bits > 0 ? bits >> (64 - word_bits) : 0;
+            word_bits = word_bits + n - 64;
+        } else {
+            word_bits += n;
+        }
+    }
+
+    // Append n copies of one bit
+    void append_run(bool bit, int64_t n) {
+        uint64_t fill = bit ? ~0ULL : 0;
+
+        // Complete the current word, then write whole words
+        int32_t head = std::min((int64_t)(64 - word_bits), n);
+        append(fill >> (64 - head), head);
+        n -= head;
+
+        if(n >= 64) {
+            std::memset(out, (int) (fill & 0xFF), (n/64)*8);
+            out += (n/64)*8;
+            set_bits += bit ? (n/64)*64 : 0;
+            n %= 64;
+        }
+
+        if(n > 0) {
+            append(fill >> (64 - n), n);
+        }
+    }
+
+    void flush() {
+        std::memcpy(out, &word, 8);
+    }
+
+    int64_t count() const {return set_bits;}
+
+  private:
+    uint8_t* out;
+    uint64_t word;
+    int32_t word_bits;
+    int64_t set_bits;
+};
+
+static inline uint64_t load_bytes(const uint8_t* in, int32_t bytes) {
+    uint64_t value = 0;
+    std::memcpy(&value, in, bytes);
+    return value;
+}
+
+// Append n bits, starting at the first bit of in, 64 at a time
+static inline void append_bits(const uint8_t* in, int32_t n, bitmap_writer* writer) {
+    for(int32_t i = 0; i < n; i += 64) {
+        int32_t bits = std::min(n - i, 64);
+        uint64_t word = load_bytes(in + i/8, (bits + 7)/8);
+        writer->append(bits < 64 ? word & ((1ULL << bits) - 1) : word, bits);
+    }
+}
+
+// Turns runs of levels into validity bits, set for levels equal to max_def_level
+class validity_sink {
+  public:
+    validity_sink(int32_t bit_width, int16_t max_def_level, bitmap_writer* writer) : bit_width(bit_width), max_def_level(max_def_level), writer(writer) {}
+
+    bool rle_run(uint64_t value, int32_t values) {
+        writer->append_run(value == (uint64_t) max_def_level, values);
+        return true;
+    }
+
+    // Bit width 1 levels with a maximum of 1 are the validity bits themselves
+    bool bit_packed_run(const uint8_t* in, int32_t values) {
+        if(bit_width == 1) {
+            append_bits(in, values, writer);
+            return true;
+        }
+
+        uint32_t levels[32];
+
+        for(int32_t i = 0; i < values; i += 32) {
+            int32_t group_values = std::min(values - i, 32);
+            unpack_hybrid_group(in + (i/8)*bit_width, bit_width, group_values, levels);
+
+            uint32_t mask = 0;
+            for(int32_t k = 0; k < 32; k++) {
+                mask |= (uint32_t)(levels[k] == (uint32_t) max_def_level) << k;
+            }
+            writer->append(group_values < 32 ? mask & ((1U << group_values) - 1) : mask, group_values);
+        }
+        return true;
+    }
+
+  private:
+    int32_t bit_width;
+    int16_t max_def_level;
+    bitmap_writer* writer;
+};
+
+status decode_def_levels(const uint8_t* data, int32_t size, int16_t max_def_level, int32_t n, uint8_t* validity, int32_t bit_offset, int32_t* valid_count) {
+    bitmap_writer writer(validity, bit_offset);
+    validity_sink sink(level_bit_width(max_def_level), max_def_level, &writer);
+
+    if(decode_rle_hybrid(data, size, level_bit_width(max_def_level), n, &sink) != status::OK) {
+        return status::FAIL;
+    }
+
+    writer.flush();
+    *valid_count = (int32_t) writer.count();
+
+    return status::OK;
+}
+
+void copy_bits(const uint8_t* in, int32_t n, uint8_t* out, int32_t bit_offset) {
+    bitmap_writer writer(out, bit_offset);
+    append_bits(in, n, &writer);
+    writer.flush();
+}
+
+void scatter_bits_to_valid(const uint8_t* values, const uint8_t* validity, int32_t bit_offset, int32_t n, uint8_t* out) {
+    bitmap_writer writer(out, bit_offset);
+    int32_t j = 0;
+
+    for(int32_t i = 0; i < n; i += 64) {
+        int32_t bits = std::min(n - i, 64);
+        uint64_t word = 0;
+
+        for(int32_t k = 0; k < bits; k++) {
+            int32_t row = bit_offset + i + k;
+            if((validity[row/8] >> (row%8)) & 1) {
+                word |= (uint64_t)((values[j/8] >> (j%8)) & 1) << k;
+                j++;
+            }
+        }
+        writer.append(word, bits);
+    }
+
+    writer.flush();
+}
+
+void merge_validity(const uint8_t* bits, int32_t bit_offset, int32_t n, uint8_t* bitmap) {
+    if(n <= 0) {
+        return;
+    }
+
+    // Bits outside of the n are zero in bits
+    int32_t last_byte = (bit_offset + n - 1)/8;
+
+    __atomic_fetch_or(&bitmap[0], bits[0], __ATOMIC_RELAXED);
+    if(last_byte > 0) {
+        std::memcpy(bitmap + 1, bits + 1, last_byte - 1);
+        __atomic_fetch_or(&bitmap[last_byte], bits[last_byte], __ATOMIC_RELAXED);
+    }
+}
+
+void scatter_offsets_to_valid(int32_t* offsets, const uint8_t* validity, int32_t bit_offset, int32_t n, int32_t valid_count, int32_t prev_offset) {
+    int32_t j = valid_count - 1;
+
+    for(int32_t i = n - 1; i > j; i--) {
+        int32_t bit = bit_offset + i;
+        if((validity[bit/8] >> (bit%8)) & 1) {
+            offsets[i] = offsets[j--];
+        } else {
+            offsets[i] = j >= 0 ? offsets[j] : prev_offset;
+        }
+    }
+}
+
+void scatter_fixed_to_valid(uint8_t* values, int32_t width, const uint8_t* validity, int32_t bit_offset, int32_t n, int32_t valid_count) {
+    int32_t j = valid_count - 1;
+
+    for(int32_t i = n - 1; i > j; i--) {
+        int32_t bit = bit_offset + i;
+        if((validity[bit/8] >> (bit%8)) & 1) {
+            std::memcpy(values + (int64_t) i*width, values + (int64_t) j*width, width);
+            j--;
+        } else {
+            std::memset(values + (int64_t) i*width, 0, width);
+        }
+    }
+}
+
+int32_t count_bits(const uint8_t* bits, int32_t bit_offset, int32_t n) {
+    int32_t count = 0;
+
+    for(int32_t i = 0; i < n; i += 64) {
+        int32_t word_bits = std::min(n - i, 64);
+        int32_t bit = bit_offset + i;
+        // Bytes holding the word_bits bits, which fit in 9 bytes
+        uint64_t word = load_bytes(bits + bit/8, std::min((bit%8 + word_bits + 7)/8, 8)) >> (bit%8);
+        if(bit%8 + word_bits > 64) {
+            word |= (uint64_t) bits[bit/8 + 8] << (64 - bit%8);
+        }
+        count += __builtin_popcountll(word_bits < 64 ? word & ((1ULL << word_bits) - 1) : word);
+    }
+    return count;
+}
+
+/*
+ * Repetition levels
+ */
+
+// Writes one byte per level
+class level_sink {
+  public:
+    level_sink(int32_t bit_width, uint8_t* out) : bit_width(bit_width), out(out) {}
+
+    bool rle_run(uint64_t value, int32_t values) {
+        std::memset(out, (int) value, values);
+        out += values;
+        return true;
+    }
+
+    bool bit_packed_run(const uint8_t* in, int32_t values) {
+        uint32_t levels[32];
+
+        for(int32_t i = 0; i < values; i += 32) {
+            int32_t group_values = std::min(values - i, 32);
+            unpack_hybrid_group(in + (i/8)*bit_width, bit_width, group_values, levels);
+            for(int32_t k = 0; k < group_values; k++) {
+                out[k] = (uint8_t) levels[k];
+            }
+            out += group_values;
+        }
+        return true;
+    }
+
+  private:
+    int32_t bit_width;
+    uint8_t* out;
+};
+
+status decode_levels(const uint8_t* data, int32_t size, int16_t max_level, int32_t n, uint8_t* levels) {
+    if(max_level > 127) {
+        return status::FAIL;
+    }
+
+    level_sink sink(level_bit_width(max_level), levels);
+    return decode_rle_hybrid(data, size, level_bit_width(max_level), n, &sink);
+}
+
+// Bits of up to 64 level entries: entries that start a list, entries that are elements, elements that are valid and entries whose list is valid
+struct level_masks {
+    uint64_t starts;
+    uint64_t elements;
+    uint64_t valid;
+    uint64_t defined;
+};
+
+static inline void scalar_level_masks(const uint8_t* rep_levels, const uint8_t* def_levels, int32_t n, int16_t repeated_def_level, int16_t max_def_level, level_masks* masks) {
+    masks->starts = 0;
+    masks->elements = 0;
+    masks->valid = 0;
+    masks->defined = 0;
+
+    for(int32_t k = 0; k < n; k++) {
+        masks->starts |= (uint64_t)(rep_levels[k] == 0) << k;
+        masks->elements |= (uint64_t)(def_levels[k] >= repeated_def_level) << k;
+        masks->valid |= (uint64_t)(def_levels[k] == max_def_level) << k;
+        masks->defined |= (uint64_t)(def_levels[k] >= repeated_def_level - 1) << k;
+    }
+}
+
+// Bits of the positions of the set bits of mask, taken from value and packed together
+static inline uint64_t extract_bits_scalar(uint64_t value, uint64_t mask) {
+    uint64_t result = 0;
+    for(int32_t k = 0; mask != 0; k++) {
+        uint64_t lowest = mask & (~mask + 1);
+        result |= (uint64_t)((value & lowest) != 0) << k;
+        mask ^= lowest;
+    }
+    return result;
+}
+
+// Write the element offset of every list starting among the entries of masks, one loop iteration per list
+static inline int32_t* write_list_offsets(const level_masks& masks, int32_t element_offset, int32_t* offsets) {
+    uint64_t starts = masks.starts;
+    while(starts != 0) {
+        int32_t entry = __builtin_ctzll(starts);
+        *offsets++ = element_offset + __builtin_popcountll(masks.elements & ((1ULL << entry) - 1));
+        starts &= starts - 1;
+    }
+    return offsets;
+}
+
+static void levels_to_lists_scalar(const uint8_t* rep_levels, const uint8_t* def_levels, int32_t n, int16_t repeated_def_level, int16_t max_def_level,
+                                   int32_t* offsets, uint8_t* list_validity, uint8_t* element_validity, list_counts* counts) {
+    bitmap_writer lists(list_validity, 0);
+    bitmap_writer elements(element_validity, 0);
+    int32_t* offsets_end = offsets;
+    int32_t num_elements = 0;
+
+    for(int32_t i = 0; i < n; i += 64) {
+        int32_t entries = std::min(n - i, 64);
+        level_masks masks;
+        scalar_level_masks(rep_levels + i, def_levels + i, entries, repeated_def_level, max_def_level, &masks);
+
+        offsets_end = write_list_offsets(masks, num_elements, offsets_end);
+        lists.append(extract_bits_scalar(masks.defined, masks.starts), __builtin_popcountll(masks.starts));
+        elements.append(extract_bits_scalar(masks.valid, masks.elements), __builtin_popcountll(masks.elements));
+        num_elements += __builtin_popcountll(masks.elements);
+    }
+
+    lists.flush();
+    elements.flush();
+    counts->num_lists = offsets_end - offsets;
+    counts->num_valid_lists = lists.count();
+    counts->num_elements = num_elements;
+    counts->num_valid_elements = elements.count();
+}
+
+// Compares 32 levels at a time, pext packs the bits of the lists and elements together
+__attribute__((target("avx2,bmi2,popcnt")))
+static void levels_to_lists_avx2(const uint8_t* rep_levels, const uint8_t* def_levels, int32_t n, int16_t repeated_def_level, int16_t max_def_level,
+                                 int32_t* offsets, uint8_t* list_validity, uint8_t* element_validity, list_counts* counts) {
+    bitmap_writer lists(list_validity, 0);
+    bitmap_writer elements(element_validity, 0);
+    int32_t* offsets_end = offsets;
+    int32_t num_elements = 0;
+
+    // Levels are at most 127, so signed compares work. def > level - 1 stands for def >= level.
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i element_level = _mm256_set1_epi8((char)(repeated_def_level - 1));
+    const __m256i list_level = _mm256_set1_epi8((char)(repeated_def_level - 2));
+    const __m256i valid_level = _mm256_set1_epi8((char) max_def_level);
+
+    for(int32_t i = 0; i < n; i += 64) {
+        int32_t entries = std::min(n - i, 64);
+        level_masks masks;
+
+        if(entries == 64) {
+            masks.starts = 0;
+            masks.elements = 0;
+            masks.valid = 0;
+            masks.defined = 0;
+            for(int32_t half = 0; half < 2; half++) {
+                __m256i rep = _mm256_loadu_si256((const __m256i*)(rep_levels + i + 32*half));
+                __m256i def = _mm256_loadu_si256((const __m256i*)(def_levels + i + 32*half));
+                masks.starts |= (uint64_t)(uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(rep, zero)) << (32*half);
+                masks.elements |= (uint64_t)(uint32_t) _mm256_movemask_epi8(_mm256_cmpgt_epi8(def, element_level)) << (32*half);
+                masks.valid |= (uint64_t)(uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(def, valid_level)) << (32*half);
+                masks.defined |= (uint64_t)(uint32_t) _mm256_movemask_epi8(_mm256_cmpgt_epi8(def, list_level)) << (32*half);
+            }
+        } else {
+            scalar_level_masks(rep_levels + i, def_levels + i, entries, repeated_def_level, max_def_level, &masks);
+        }
+
+        offsets_end = write_list_offsets(masks, num_elements, offsets_end);
+        lists.append(_pext_u64(masks.defined, masks.starts), _mm_popcnt_u64(masks.starts));
+        elements.append(_pext_u64(masks.valid, masks.elements), _mm_popcnt_u64(masks.elements));
+        num_elements += _mm_popcnt_u64(masks.elements);
+    }
+
+    lists.flush();
+    elements.flush();
+    counts->num_lists = offsets_end - offsets;
+    counts->num_valid_lists = lists.count();
+    counts->num_elements = num_elements;
+    counts->num_valid_elements = elements.count();
+}
+
+typedef void (*levels_to_lists_fn)(const uint8_t*, const uint8_t*, int32_t, int16_t, int16_t, int32_t*, uint8_t*, uint8_t*, list_counts*);
+
+static levels_to_lists_fn select_levels_to_lists() {
+    switch(detect_simd_level()) {
+        case simd_level::AVX512:
+        case simd_level::AVX2: return __builtin_cpu_supports("bmi2") ? levels_to_lists_avx2 : levels_to_lists_scalar;
+        default: return levels_to_lists_scalar;
+    }
+}
+
+static const levels_to_lists_fn levels_to_lists_impl = select_levels_to_lists();
+
+void levels_to_lists(const uint8_t* rep_levels, const uint8_t* def_levels, int32_t n, int16_t repeated_def_level, int16_t max_def_level,
+                     int32_t* offsets, uint8_t* list_validity, uint8_t* element_validity, list_counts* counts) {
+    levels_to_lists_impl(rep_levels, def_levels, n, repeated_def_level, max_def_level, offsets, list_validity, element_validity, counts);
+}
+
+}
@@ -0,0 +1,108 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "ptoa.h"
+
+/*
+ * Definition levels of flat nullable columns, turned straight into Arrow validity bitmaps (LSB first, set bit means valid).
+ * Pages store only their non-null values, densely. They are decoded to the front of the page's range in the output
+ * and then moved out to the positions of the valid bits.
+ */
+
+namespace ptoa{
+
+// Bytes a validity buffer for n bits starting at bit_offset (0-7) needs, as decode_def_levels stores whole 64 bit words
+inline int64_t validity_buffer_size(int64_t n, int32_t bit_offset) {return ((bit_offset + n)/64 + 1)*8;}
+
+// Bits needed for levels up to max_level
+inline int32_t level_bit_width(int16_t max_level) {return max_level > 0 ? 32 - __builtin_clz((uint32_t) max_level) : 0;}
+
+// Decode the first n RLE/bit-packed hybrid encoded levels in data into validity bits, set for levels equal to max_def_level.
+// Level i goes to bit bit_offset+i of validity, which must hold validity_buffer_size(n, bit_offset) bytes.
+// All other bits of the buffer are cleared. valid_count is set to the amount of set bits.
+// RLE runs are written a 64 bit word at a time and bit-packed runs are unpacked 32 levels at a time with the SIMD kernels,
+// or for a bit width of 1, where the levels already are the validity bits, copied 64 at a time.
+status decode_def_levels(const uint8_t* data, int32_t size, int16_t max_def_level, int32_t n, uint8_t* validity, int32_t bit_offset, int32_t* valid_count);
+
+// Copy n validity bits, decoded by decode_def_levels from bit bit_offset of bits on, into bitmap from bit bit_offset of its
+// first byte on. The first and last byte may be shared with neighbouring pages decoded by other threads, so they are ORed
+// in atomically. The bitmap has to be zeroed beforehand.
+void merge_validity(const uint8_t* bits, int32_t bit_offset, int32_t n, uint8_t* bitmap);
+
+// BOOLEAN values are bitmaps too, the functions below lay them out like decode_def_levels does with validity bits.
+
+// Copy n bits, starting at the first bit of in, to bit bit_offset and up of out, which must hold validity_buffer_size(n, bit_offset)
+// bytes. All other bits of the buffer are cleared.
+void copy_bits(const uint8_t* in, int32_t n, uint8_t* out, int32_t bit_offset);
+
+// Same as copy_bits, with the bits moved out to the positions of the set bits among the n validity bits starting at bit_offset.
+// Bits of nulls are cleared.
+void scatter_bits_to_valid(const uint8_t* values, const uint8_t* validity, int32_t bit_offset, int32_t n, uint8_t* out);
+
+// Move the first valid_count values of values out to the positions of the set bits among the n validity bits starting at
+// bit_offset. Works from back to front, so that it can be done in place, and stops as soon as all remaining values are in
+// place. Positions of nulls are set to null_value.
+template<typename T>
+void scatter_to_valid(T* values, const uint8_t* validity, int32_t bit_offset, int32_t n, int32_t valid_count, T null_value = T()) {
+    int32_t j = valid_count - 1;
+
+    for(int32_t i = n - 1; i > j; i--) {
+        int32_t bit = bit_offset + i;
+        if((validity[bit/8] >> (bit%8)) & 1) {
+            values[i] = values[j--];
+        } else {
+            values[i] = null_value;
+        }
+    }
+}
+
+// Same as scatter_to_valid for values of width bytes. Positions of nulls are zeroed.
+void scatter_fixed_to_valid(uint8_t* values, int32_t width, const uint8_t* validity, int32_t bit_offset, int32_t n, int32_t valid_count);
+
+// Same as scatter_to_valid for the end offsets of strings. Null strings are empty, so they repeat the offset of the
+// string before them, which is prev_offset for the first string.
+void scatter_offsets_to_valid(int32_t* offsets, const uint8_t* validity, int32_t bit_offset, int32_t n, int32_t valid_count, int32_t prev_offset);
+
+// Amount of set bits among the n bits starting at bit bit_offset of bits
+int32_t count_bits(const uint8_t* bits, int32_t bit_offset, int32_t n);
+
+/*
+ * Repetition levels of list columns, with one level of repetition. Every level entry with repetition level 0 starts a list.
+ * The definition level of the first entry of a list tells whether the list is null (below repeated_def_level-1), empty
+ * (repeated_def_level-1) or has elements. Every entry at repeated_def_level or above is an element, which is valid at max_def_level.
+ * Only valid elements have a value in the page.
+ */
+
+// Amounts of lists and elements described by a run of level entries
+struct list_counts {
+    int32_t num_lists;
+    int32_t num_valid_lists;
+    int32_t num_elements;
+    int32_t num_valid_elements;
+};
+
+// Decode the first n RLE/bit-packed hybrid encoded levels in data, up to max_level, into one byte per level
+status decode_levels(const uint8_t* data, int32_t size, int16_t max_level, int32_t n, uint8_t* levels);
+
+// Turn n level entries into the element offset of every list starting among them, counted from the first element, and the validity
+// bits of those lists and of the elements, from the first bit of list_validity and element_validity on. offsets needs room for n offsets,
+// the bitmaps for validity_buffer_size(n, 0) bytes. Masks of 64 entries are built with AVX2 compares, the bits of lists and elements
+// are packed from them with BMI2 pext and list offsets are popcounts of the element mask, without a branch per entry.
+void levels_to_lists(const uint8_t* rep_levels, const uint8_t* def_levels, int32_t n, int16_t repeated_def_level, int16_t max_def_level,
+                     int32_t* offsets, uint8_t* list_validity, uint8_t* element_validity, list_counts* counts);
+
+}
@@ -0,0 +1,399 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+#include <immintrin.h>
+
+#include "DeltaKernels.h"
+#include "SimdDispatch.h"
+#include "LemireBitUnpacking.h"
+#include "SimdBitUnpacking.h"
+
+namespace ptoa {
+
+/*
+ * Scalar reference implementations. Unsigned arithmetic gives the wrap around behaviour without signed overflow.
+ */
+
+static int32_t delta_prefix_sum32_scalar(const uint32_t* deltas, int32_t min_delta, int32_t prev, int32_t* out, int32_t n) {
+    uint32_t value = prev;
+    for(int32_t i=0; i<n; i++) {
+        value += deltas[i] + (uint32_t) min_delta;
+        out[i] = value;
+    }
+    return value;
+}
+
+static int64_t delta_prefix_sum64_scalar(const uint64_t* deltas, int64_t min_delta, int64_t prev, int64_t* out, int32_t n) {
+    uint64_t value = prev;
+    for(int32_t i=0; i<n; i++) {
+        value += deltas[i] + (uint64_t) min_delta;
+        out[i] = value;
+    }
+    return value;
+}
+
+/*
+ * AVX2 implementations. Each vector is prefix summed in register with log2(lanes) shift-and-add steps,
+ * the running total of the previous vectors is carried in a broadcast register.
+ */
+
+// Add min_delta to 8 deltas, prefix sum them onto carry and store the result. Returns the new carry (the last value in every lane).
+__attribute__((target("avx2")))
+static inline __m256i accumulate8_epi32_avx2(__m256i x, __m256i min_delta_vec, __m256i carry, int32_t* out) {
+    x = _mm256_add_epi32(x, min_delta_vec);
+    // Prefix sum within each 128 bit lane
+    x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+    x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+    // Add the total of the lower lane to the upper lane
+    __m256i low_total = _mm256_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+    x = _mm256_add_epi32(x, _mm256_permute2x128_si256(low_total, low_total, 0x08));
+    x = _mm256_add_epi32(x, carry);
+    _mm256_storeu_si256((__m256i*) out, x);
+    return _mm256_permutevar8x32_epi32(x, _mm256_set1_epi32(7));
+}
+
+__attribute__((target("avx2")))
+static int32_t delta_prefix_sum32_avx2(const uint32_t* deltas, int32_t min_delta, int32_t prev, int32_t* out, int32_t n) {
+    const __m256i min_delta_vec = _mm256_set1_epi32(min_delta);
+    __m256i carry = _mm256_set1_epi32(prev);
+    int32_t i = 0;
+
+    for(; i+8<=n; i+=8) {
+        carry = accumulate8_epi32_avx2(_mm256_loadu_si256((const __m256i*)(deltas + i)), min_delta_vec, carry, out + i);
+    }
+
+    return delta_prefix_sum32_scalar(deltas + i, min_delta, _mm256_extract_epi32(carry, 0), out + i, n - i);
+}
+
+// Add min_delta to 4 deltas, prefix sum them onto carry and store the result. Returns the new carry (the last value in every lane).
+__attribute__((target("avx2")))
+static inline __m256i accumulate4_epi64_avx2(__m256i x, __m256i min_delta_vec, __m256i carry, int64_t* out) {
+    x = _mm256_add_epi64(x, min_delta_vec);
+    x = _mm256_add_epi64(x, _mm256_slli_si256(x, 8));
+    __m256i low_total = _mm256_permute4x64_epi64(x, _MM_SHUFFLE(1, 1, 1, 1));
+    x = _mm256_add_epi64(x, _mm256_blend_epi32(_mm256_setzero_si256(), low_total, 0xF0));
+    x = _mm256_add_epi64(x, carry);
+    _mm256_storeu_si256((__m256i*) out, x);
+    return _mm256_permute4x64_epi64(x, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+__attribute__((target("avx2")))
+static int64_t delta_prefix_sum64_avx2(const uint64_t* deltas, int64_t min_delta, int64_t prev, int64_t* out, int32_t n) {
+    const __m256i min_delta_vec = _mm256_set1_epi64x(min_delta);
+    __m256i carry = _mm256_set1_epi64x(prev);
+    int32_t i = 0;
+
+    for(; i+4<=n; i+=4) {
+        carry = accumulate4_epi64_avx2(_mm256_loadu_si256((const __m256i*)(deltas + i)), min_delta_vec, carry, out + i);
+    }
+
+    return delta_prefix_sum64_scalar(deltas + i, min_delta, _mm256_extract_epi64(carry, 0), out + i, n - i);
+}
+
+/*
+ * AVX-512 implementations. valignd/valignq rotate whole vectors across lanes, the zero mask clears the lanes that wrapped around.
+ */
+
+// Add min_delta to 16 deltas, prefix sum them onto carry and store the result. Returns the new carry (the last value in every lane).
+__attribute__((target("avx512f")))
+static inline __m512i accumulate16_epi32_avx512(__m512i x, __m512i min_delta_vec, __m512i carry, int32_t* out) {
+    x = _mm512_add_epi32(x, min_delta_vec);
+    x = _mm512_add_epi32(x, _mm512_maskz_alignr_epi32((__mmask16)(0xFFFF << 1), x, x, 15));
+    x = _mm512_add_epi32(x, _mm512_maskz_alignr_epi32((__mmask16)(0xFFFF << 2), x, x, 14));
+    x = _mm512_add_epi32(x, _mm512_maskz_alignr_epi32((__mmask16)(0xFFFF << 4), x, x, 12));
+    x = _mm512_add_epi32(x, _mm512_maskz_alignr_epi32((__mmask16)(0xFFFF << 8), x, x, 8));
+    x = _mm512_add_epi32(x, carry);
+    _mm512_storeu_si512((void*) out, x);
+    return _mm512_maskz_permutexvar_epi32((__mmask16) 0xFFFF, _mm512_set1_epi32(15), x);
+}
+
+__attribute__((target("avx512f")))
+static int32_t delta_prefix_sum32_avx512(const uint32_t* deltas, int32_t min_delta, int32_t prev, int32_t* out, int32_t n) {
+    const __m512i min_delta_vec = _mm512_set1_epi32(min_delta);
+    __m512i carry = _mm512_set1_epi32(prev);
+    int32_t i = 0;
+
+    for(; i+16<=n; i+=16) {
+        carry = accumulate16_epi32_avx512(_mm512_loadu_si512((const void*)(deltas + i)), min_delta_vec, carry, out + i);
+    }
+
+    if(i > 0) prev = out[i-1];
+    return delta_prefix_sum32_scalar(deltas + i, min_delta, prev, out + i, n - i);
+}
+
+// Add min_delta to 8 deltas, prefix sum them onto carry and store the result. Returns the new carry (the last value in every lane).
+__attribute__((target("avx512f")))
+static inline __m512i accumulate8_epi64_avx512(__m512i x, __m512i min_delta_vec, __m512i carry, int64_t* out) {
+    x = _mm512_add_epi64(x, min_delta_vec);
+    x = _mm512_add_epi64(x, _mm512_maskz_alignr_epi64((__mmask8)(0xFF << 1), x, x, 7));
+    x = _mm512_add_epi64(x, _mm512_maskz_alignr_epi64((__mmask8)(0xFF << 2), x, x, 6));
+    x = _mm512_add_epi64(x, _mm512_maskz_alignr_epi64((__mmask8)(0xFF << 4), x, x, 4));
+    x = _mm512_add_epi64(x, carry);
+    _mm512_storeu_si512((void*) out, x);
+    return _mm512_maskz_permutexvar_epi64((__mmask8) 0xFF, _mm512_set1_epi64(7), x);
+}
+
+__attribute__((target("avx512f")))
+static int64_t delta_prefix_sum64_avx512(const uint64_t* deltas, int64_t min_delta, int64_t prev, int64_t* out, int32_t n) {
+    const __m512i min_delta_vec = _mm512_set1_epi64(min_delta);
+    __m512i carry = _mm512_set1_epi64(prev);
+    int32_t i = 0;
+
+    for(; i+8<=n; i+=8) {
+        carry = accumulate8_epi64_avx512(_mm512_loadu_si512((const void*)(deltas + i)), min_delta_vec, carry, out + i);
+    }
+
+    if(i > 0) prev = out[i-1];
+    return delta_prefix_sum64_scalar(deltas + i, min_delta, prev, out + i, n - i);
+}
+
+/*
+ * Fused miniblock kernels. One instantiation per bit width, like the unrolled functions in LemireBitUnpacking.cpp:
+ * with the bit width known at compile time every shift and word index is a constant, so the compiler fully unrolls
+ * the loop and each delta goes from the packed words straight into the running sum without a scratch array.
+ */
+
+template<uint32_t bit>
+static int32_t fused_delta_unpack32(const uint32_t* __restrict__ in, int32_t min_delta, int32_t prev, int32_t* __restrict__ out) {
+    const uint32_t mask = bit < 32 ? (1U << (bit % 32)) - 1 : ~0U;
+    uint32_t value = prev;
+
+#pragma GCC unroll 32
+    for(uint32_t j=0; j<MINIBLOCK_VALUES; j++) {
+        const uint32_t start = j*bit;
+        const uint32_t word = start/32;
+        const uint32_t shift = start%32;
+        uint32_t delta = 0;
+        if(bit > 0) {
+            delta = in[word] >> shift;
+            // Value straddles two words
+            if(shift + bit > 32) {
+                delta |= in[word+1] << ((32 - shift) % 32);
+            }
+            delta &= mask;
+        }
+        value += delta + (uint32_t) min_delta;
+        out[j] = value;
+    }
+
+    return value;
+}
+
+template<uint32_t bit>
+static int64_t fused_delta_unpack64(const uint64_t* __restrict__ in, int64_t min_delta, int64_t prev, int64_t* __restrict__ out) {
+    const uint64_t mask = bit < 64 ? (1ULL << (bit % 64)) - 1 : ~0ULL;
+    uint64_t value = prev;
+
+#pragma GCC unroll 32
+    for(uint32_t j=0; j<MINIBLOCK_VALUES; j++) {
+        const uint32_t start = j*bit;
+        const uint32_t word = start/64;
+        const uint32_t shift = start%64;
+        uint64_t delta = 0;
+        if(bit > 0) {
+            delta = in[word] >> shift;
+            // Value straddles two words
+            if(shift + bit > 64) {
+                delta |= in[word+1] << ((64 - shift) % 64);
+            }
+            delta &= mask;
+        }
+        value += delta + (uint64_t) min_delta;
+        out[j] = value;
+    }
+
+    return value;
+}
+
+// The same with the SIMD unpacking from SimdBitUnpacking.h, the deltas never leave the vector registers
+template<uint32_t bit>
+__attribute__((target("avx2")))
+static int32_t fused_delta_unpack32_avx2(const uint32_t* __restrict__ in, int32_t min_delta, int32_t prev, int32_t* __restrict__ out) {
+    const uint8_t* bytes = (const uint8_t*) in;
+    const __m256i min_delta_vec = _mm256_set1_epi32(min_delta);
+    __m256i carry = _mm256_set1_epi32(prev);
+
+    carry = accumulate8_epi32_avx2(unpack8_avx2<bit, 0>(bytes), min_delta_vec, carry, out + 0);
+    carry = accumulate8_epi32_avx2(unpack8_avx2<bit, 1>(bytes), min_delta_vec, carry, out + 8);
+    carry = accumulate8_epi32_avx2(unpack8_avx2<bit, 2>(bytes), min_delta_vec, carry, out + 16);
+    carry = accumulate8_epi32_avx2(unpack8_avx2<bit, 3>(bytes), min_delta_vec, carry, out + 24);
+
+    return _mm256_extract_epi32(carry, 0);
+}
+
+template<uint32_t bit>
+__attribute__((target("avx512f")))
+static int32_t fused_delta_unpack32_avx512(const uint32_t* __restrict__ in, int32_t min_delta, int32_t prev, int32_t* __restrict__ out) {
+    const __m512i min_delta_vec = _mm512_set1_epi32(min_delta);
+    __m512i carry = _mm512_set1_epi32(prev);
+    __m512i low_words, high_words;
+    load_miniblock_avx512<bit>((const uint8_t*) in, &low_words, &high_words);
+
+    carry = accumulate16_epi32_avx512(unpack16_avx512<bit, 0>(low_words, high_words), min_delta_vec, carry, out + 0);
+    accumulate16_epi32_avx512(unpack16_avx512<bit, 1>(low_words, high_words), min_delta_vec, carry, out + 16);
+
+    return out[MINIBLOCK_VALUES-1];
+}
+
+template<uint32_t bit>
+__attribute__((target("avx2")))
+static int64_t fused_delta_unpack64_avx2(const uint64_t* __restrict__ in, int64_t min_delta, int64_t prev, int64_t* __restrict__ out) {
+    const uint8_t* bytes = (const uint8_t*) in;
+    const __m256i min_delta_vec = _mm256_set1_epi64x(min_delta);
+    __m256i carry = _mm256_set1_epi64x(prev);
+
+    carry = accumulate4_epi64_avx2(unpack4_64_avx2<bit, 0>(bytes), min_delta_vec, carry, out + 0);
+    carry = accumulate4_epi64_avx2(unpack4_64_avx2<bit, 1>(bytes), min_delta_vec, carry, out + 4);
+    carry = accumulate4_epi64_avx2(unpack4_64_avx2<bit, 2>(bytes), min_delta_vec, carry, out + 8);
+    carry = accumulate4_epi64_avx2(unpack4_64_avx2<bit, 3>(bytes), min_delta_vec, carry, out + 12);
+    carry = accumulate4_epi64_avx2(unpack4_64_avx2<bit, 4>(bytes), min_delta_vec, carry, out + 16);
+    carry = accumulate4_epi64_avx2(unpack4_64_avx2<bit, 5>(bytes), min_delta_vec, carry, out + 20);
+    carry = accumulate4_epi64_avx2(unpack4_64_avx2<bit, 6>(bytes), min_delta_vec, carry, out + 24);
+    carry = accumulate4_epi64_avx2(unpack4_64_avx2<bit, 7>(bytes), min_delta_vec, carry, out + 28);
+
+    return _mm256_extract_epi64(carry, 0);
+}
+
+template<uint32_t bit>
+__attribute__((target("avx512f,avx512bw")))
+static int64_t fused_delta_unpack64_avx512(const uint64_t* __restrict__ in, int64_t min_delta, int64_t prev, int64_t* __restrict__ out) {
+    const uint8_t* bytes = (const uint8_t*) in;
+    const __m512i min_delta_vec = _mm512_set1_epi64(min_delta);
+    __m512i carry = _mm512_set1_epi64(prev);
+
+    carry = accumulate8_epi64_avx512(unpack8_64_avx512<bit, 0>(bytes), min_delta_vec, carry, out + 0);
+    carry = accumulate8_epi64_avx512(unpack8_64_avx512<bit, 1>(bytes), min_delta_vec, carry, out + 8);
+    carry = accumulate8_epi64_avx512(unpack8_64_avx512<bit, 2>(bytes), min_delta_vec, carry, out + 16);
+    accumulate8_epi64_avx512(unpack8_64_avx512<bit, 3>(bytes), min_delta_vec, carry, out + 24);
+
+    return out[MINIBLOCK_VALUES-1];
+}
+
+typedef int32_t (*fused_delta_unpack32_fn)(const uint32_t*, int32_t, int32_t, int32_t*);
+typedef int64_t (*fused_delta_unpack64_fn)(const uint64_t*, int64_t, int64_t, int64_t*);
+
+// Indexed by bit width
+static const fused_delta_unpack32_fn fused_delta_unpack32_scalar_kernels[33] = {
+    SIMD_KERNELS_16(fused_delta_unpack32, 0), SIMD_KERNELS_16(fused_delta_unpack32, 16), fused_delta_unpack32<32>
+};
+
+static const fused_delta_unpack32_fn fused_delta_unpack32_avx2_kernels[33] = {
+    SIMD_KERNELS_16(fused_delta_unpack32_avx2, 0), SIMD_KERNELS_16(fused_delta_unpack32_avx2, 16), fused_delta_unpack32_avx2<32>
+};
+
+static const fused_delta_unpack32_fn fused_delta_unpack32_avx512_kernels[33] = {
+    SIMD_KERNELS_16(fused_delta_unpack32_avx512, 0), SIMD_KERNELS_16(fused_delta_unpack32_avx512, 16), fused_delta_unpack32_avx512<32>
+};
+
+static const fused_delta_unpack64_fn fused_delta_unpack64_scalar_kernels[65] = {
+    SIMD_KERNELS_16(fused_delta_unpack64, 0), SIMD_KERNELS_16(fused_delta_unpack64, 16),
+    SIMD_KERNELS_16(fused_delta_unpack64, 32), SIMD_KERNELS_16(fused_delta_unpack64, 48), fused_delta_unpack64<64>
+};
+
+static const fused_delta_unpack64_fn fused_delta_unpack64_avx2_kernels[65] = {
+    SIMD_KERNELS_16(fused_delta_unpack64_avx2, 0), SIMD_KERNELS_16(fused_delta_unpack64_avx2, 16),
+    SIMD_KERNELS_16(fused_delta_unpack64_avx2, 32), SIMD_KERNELS_16(fused_delta_unpack64_avx2, 48), fused_delta_unpack64_avx2<64>
+};
+
+static const fused_delta_unpack64_fn fused_delta_unpack64_avx512_kernels[65] = {
+    SIMD_KERNELS_16(fused_delta_unpack64_avx512, 0), SIMD_KERNELS_16(fused_delta_unpack64_avx512, 16),
+    SIMD_KERNELS_16(fused_delta_unpack64_avx512, 32), SIMD_KERNELS_16(fused_delta_unpack64_avx512, 48), fused_delta_unpack64_avx512<64>
+};
+
+/*
+ * Runtime dispatch
+ */
+
+typedef int32_t (*delta_prefix_sum32_fn)(const uint32_t*, int32_t, int32_t, int32_t*, int32_t);
+typedef int64_t (*delta_prefix_sum64_fn)(const uint64_t*, int64_t, int64_t, int64_t*, int32_t);
+
+static delta_prefix_sum32_fn select_delta_prefix_sum32() {
+    switch(detect_simd_level()) {
+        case simd_level::AVX512: return delta_prefix_sum32_avx512;
+        case simd_level::AVX2: return delta_prefix_sum32_avx2;
+        default: return delta_prefix_sum32_scalar;
+    }
+}
+
+static delta_prefix_sum64_fn select_delta_prefix_sum64() {
+    switch(detect_simd_level()) {
+        case simd_level::AVX512: return delta_prefix_sum64_avx512;
+        case simd_level::AVX2: return delta_prefix_sum64_avx2;
+        default: return delta_prefix_sum64_scalar;
+    }
+}
+
+static const fused_delta_unpack32_fn* select_fused_delta_unpack32() {
+    switch(detect_simd_level()) {
+        case simd_level::AVX512: return fused_delta_unpack32_avx512_kernels;
+        case simd_level::AVX2: return fused_delta_unpack32_avx2_kernels;
+        default: return fused_delta_unpack32_scalar_kernels;
+    }
+}
+
+static const fused_delta_unpack64_fn* select_fused_delta_unpack64() {
+    switch(detect_simd_level()) {
+        case simd_level::AVX512: return fused_delta_unpack64_avx512_kernels;
+        case simd_level::AVX2: return fused_delta_unpack64_avx2_kernels;
+        default: return fused_delta_unpack64_scalar_kernels;
+    }
+}
+
+static const delta_prefix_sum32_fn delta_prefix_sum32_impl = select_delta_prefix_sum32();
+static const delta_prefix_sum64_fn delta_prefix_sum64_impl = select_delta_prefix_sum64();
+static const fused_delta_unpack32_fn* fused_delta_unpack32_kernels = select_fused_delta_unpack32();
+static const fused_delta_unpack64_fn* fused_delta_unpack64_kernels = select_fused_delta_unpack64();
+
+int32_t delta_prefix_sum32(const uint32_t* deltas, int32_t min_delta, int32_t prev, int32_t* out, int32_t n) {
+    return delta_prefix_sum32_impl(deltas, min_delta, prev, out, n);
+}
+
+int64_t delta_prefix_sum64(const uint64_t* deltas, int64_t min_delta, int64_t prev, int64_t* out, int32_t n) {
+    return delta_prefix_sum64_impl(deltas, min_delta, prev, out, n);
+}
+
+int32_t delta_unpack_miniblock32(const uint8_t* in, uint8_t bit, int32_t min_delta, int32_t prev, int32_t* out, int32_t n) {
+    if(n == MINIBLOCK_VALUES) {
+        return fused_delta_unpack32_kernels[bit]((const uint32_t*) in, min_delta, prev, out);
+    }
+
+    // The last miniblock of a page may be partially filled, the output buffer has no room for the padding values
+    uint32_t unpacked_deltas[MINIBLOCK_VALUES];
+    fastunpack((const uint*) in, unpacked_deltas, bit);
+    return delta_prefix_sum32(unpacked_deltas, min_delta, prev, out, n);
+}
+
+int64_t delta_unpack_miniblock64(const uint8_t* in, uint8_t bit, int64_t min_delta, int64_t prev, int64_t* out, int32_t n) {
+    if(n == MINIBLOCK_VALUES) {
+        return fused_delta_unpack64_kernels[bit]((const uint64_t*) in, min_delta, prev, out);
+    }
+
+    // The last miniblock of a page may be partially filled, the output buffer has no room for the padding values
+    uint64_t unpacked_deltas[MINIBLOCK_VALUES];
+    int64fastunpack((const uint64_t*) in, unpacked_deltas, bit);
+    return delta_prefix_sum64(unpacked_deltas, min_delta, prev, out, n);
+}
+
+int32_t delta_unpack_short_miniblock32(const uint8_t* in, uint8_t bit, int32_t miniblock_values, int32_t min_delta, int32_t prev, int32_t* out, int32_t n) {
+    uint32_t padded_miniblock[MINIBLOCK_VALUES] = {0};
+    std::memcpy(padded_miniblock, in, miniblock_values*bit/8);
+    return delta_unpack_miniblock32((const uint8_t*) padded_miniblock, bit, min_delta, prev, out, n);
+}
+
+int64_t delta_unpack_short_miniblock64(const uint8_t* in, uint8_t bit, int32_t miniblock_values, int64_t min_delta, int64_t prev, int64_t* out, int32_t n) {
+    uint64_t padded_miniblock[MINIBLOCK_VALUES] = {0};
+    std::memcpy(padded_miniblock, in, miniblock_values*bit/8);
+    return delta_unpack_miniblock64((const uint8_t*) padded_miniblock, bit, min_delta, prev, out, n);
+}
+
+}
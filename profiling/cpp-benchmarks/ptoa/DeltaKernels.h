@@ -0,0 +1,72 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+namespace ptoa{
+
+// Number of values in a bit packed miniblock, the unit all unpacking kernels work on
+const int32_t MINIBLOCK_VALUES = 32;
+
+// Delta accumulation: out[i] = prev + (deltas[0] + min_delta) + ... + (deltas[i] + min_delta) for i in [0, n).
+// Returns out[n-1], or prev if n is 0, so that calls can be chained. Arithmetic wraps around like the Parquet writers' does.
+// deltas and out may point to the same array, to accumulate in place.
+// The implementation is picked once at runtime from the CPU features (AVX-512, AVX2 or scalar).
+int32_t delta_prefix_sum32(const uint32_t* deltas, int32_t min_delta, int32_t prev, int32_t* out, int32_t n);
+int64_t delta_prefix_sum64(const uint64_t* deltas, int64_t min_delta, int64_t prev, int64_t* out, int32_t n);
+
+// Unpack a miniblock of bit wide deltas at in and accumulate the first n (at most MINIBLOCK_VALUES) of them like delta_prefix_sum.
+// Full miniblocks go through a fused kernel specialized for the bit width, which never materializes the unpacked deltas.
+int32_t delta_unpack_miniblock32(const uint8_t* in, uint8_t bit, int32_t min_delta, int32_t prev, int32_t* out, int32_t n);
+int64_t delta_unpack_miniblock64(const uint8_t* in, uint8_t bit, int64_t min_delta, int64_t prev, int64_t* out, int32_t n);
+
+// Same as delta_unpack_miniblock for miniblocks of fewer than MINIBLOCK_VALUES values, which are copied to a padded miniblock first
+// so that the kernels do not read past them.
+int32_t delta_unpack_short_miniblock32(const uint8_t* in, uint8_t bit, int32_t miniblock_values, int32_t min_delta, int32_t prev, int32_t* out, int32_t n);
+int64_t delta_unpack_short_miniblock64(const uint8_t* in, uint8_t bit, int32_t miniblock_values, int64_t min_delta, int64_t prev, int64_t* out, int32_t n);
+
+// Unpack a miniblock of miniblock_values (a multiple of 8) bit wide deltas and accumulate the first n of them like delta_prefix_sum.
+// The miniblock is decoded MINIBLOCK_VALUES values at a time. These are inline so that the loop folds away when the caller's
+// miniblock_values is a compile time constant.
+inline int32_t delta_decode_miniblock32(const uint8_t* in, uint8_t bit, int32_t miniblock_values, int32_t min_delta, int32_t prev, int32_t* out, int32_t n) {
+    for(int32_t i = 0; i < n; i += MINIBLOCK_VALUES) {
+        const uint8_t* chunk = in + (i/8)*bit;
+        int32_t chunk_values = n - i < MINIBLOCK_VALUES ? n - i : MINIBLOCK_VALUES;
+
+        if(miniblock_values - i < MINIBLOCK_VALUES) {
+            prev = delta_unpack_short_miniblock32(chunk, bit, miniblock_values - i, min_delta, prev, out + i, chunk_values);
+        } else {
+            prev = delta_unpack_miniblock32(chunk, bit, min_delta, prev, out + i, chunk_values);
+        }
+    }
+
+    return prev;
+}
+
+inline int64_t delta_decode_miniblock64(const uint8_t* in, uint8_t bit, int32_t miniblock_values, int64_t min_delta, int64_t prev, int64_t* out, int32_t n) {
+    for(int32_t i = 0; i < n; i += MINIBLOCK_VALUES) {
+        const uint8_t* chunk = in + (i/8)*bit;
+        int32_t chunk_values = n - i < MINIBLOCK_VALUES ? n - i : MINIBLOCK_VALUES;
+
+        if(miniblock_values - i < MINIBLOCK_VALUES) {
+            prev = delta_unpack_short_miniblock64(chunk, bit, miniblock_values - i, min_delta, prev, out + i, chunk_values);
+        } else {
+            prev = delta_unpack_miniblock64(chunk, bit, min_delta, prev, out + i, chunk_values);
+        }
+    }
+
+    return prev;
+}
+
+}
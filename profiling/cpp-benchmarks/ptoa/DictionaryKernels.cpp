@@ -0,0 +1,268 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+#include <algorithm>
+#include <immintrin.h>
+
+#include "DictionaryKernels.h"
+#include "SimdDispatch.h"
+#include "RleHybrid.h"
+
+namespace ptoa {
+
+/*
+ * Lookups. Scalar references and gathers of 8 (AVX2) or 16 (AVX-512) 32 bit values, or 4 or 8 64 bit values, per instruction.
+ */
+
+static void gather32_scalar(const int32_t* table, const int32_t* indices, int32_t* out, int32_t n) {
+    for(int32_t i=0; i<n; i++) {
+        out[i] = table[indices[i]];
+    }
+}
+
+static void gather64_scalar(const int64_t* table, const int32_t* indices, int64_t* out, int32_t n) {
+    for(int32_t i=0; i<n; i++) {
+        out[i] = table[indices[i]];
+    }
+}
+
+__attribute__((target("avx2")))
+static void gather32_avx2(const int32_t* table, const int32_t* indices, int32_t* out, int32_t n) {
+    int32_t i = 0;
+
+    for(; i+8<=n; i+=8) {
+        __m256i index = _mm256_loadu_si256((const __m256i*)(indices + i));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_i32gather_epi32((const int*) table, index, 4));
+    }
+
+    gather32_scalar(table, indices + i, out + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void gather64_avx2(const int64_t* table, const int32_t* indices, int64_t* out, int32_t n) {
+    int32_t i = 0;
+
+    for(; i+4<=n; i+=4) {
+        __m128i index = _mm_loadu_si128((const __m128i*)(indices + i));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_i32gather_epi64((const long long*) table, index, 8));
+    }
+
+    gather64_scalar(table, indices + i, out + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+static void gather32_avx512(const int32_t* table, const int32_t* indices, int32_t* out, int32_t n) {
+    int32_t i = 0;
+
+    for(; i+16<=n; i+=16) {
+        __m512i index = _mm512_loadu_si512((const void*)(indices + i));
+        _mm512_storeu_si512((void*)(out + i), _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF, index, (const void*) table, 4));
+    }
+
+    gather32_scalar(table, indices + i, out + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+static void gather64_avx512(const int64_t* table, const int32_t* indices, int64_t* out, int32_t n) {
+    int32_t i = 0;
+
+    for(; i+8<=n; i+=8) {
+        __m256i index = _mm256_loadu_si256((const __m256i*)(indices + i));
+        _mm512_storeu_si512((void*)(out + i), _mm512_mask_i32gather_epi64(_mm512_setzero_si512(), 0xFF, index, (const void*) table, 8));
+    }
+
+    gather64_scalar(table, indices + i, out + i, n - i);
+}
+
+typedef void (*gather32_fn)(const int32_t*, const int32_t*, int32_t*, int32_t);
+typedef void (*gather64_fn)(const int64_t*, const int32_t*, int64_t*, int32_t);
+
+static gather32_fn select_gather32() {
+    switch(detect_simd_level()) {
+        case simd_level::AVX512: return gather32_avx512;
+        case simd_level::AVX2: return gather32_avx2;
+        default: return gather32_scalar;
+    }
+}
+
+static gather64_fn select_gather64() {
+    switch(detect_simd_level()) {
+        case simd_level::AVX512: return gather64_avx512;
+        case simd_level::AVX2: return gather64_avx2;
+        default: return gather64_scalar;
+    }
+}
+
+static const gather32_fn gather32_impl = select_gather32();
+static const gather64_fn gather64_impl = select_gather64();
+
+static inline void gather(const int32_t* table, const int32_t* indices, int32_t* out, int32_t n) {gather32_impl(table, indices, out, n);}
+static inline void gather(const int64_t* table, const int32_t* indices, int64_t* out, int32_t n) {gather64_impl(table, indices, out, n);}
+
+void gather32(const int32_t* table, const int32_t* indices, int32_t* out, int32_t n) {
+    gather32_impl(table, indices, out, n);
+}
+
+/*
+ * Run sinks for decode_rle_hybrid
+ */
+
+// Whether all of the n indices are below dictionary_size. Written as a reduction, which the compiler vectorizes.
+static inline bool indices_valid(const uint32_t* indices, int32_t n, int32_t dictionary_size) {
+    uint32_t max_index = 0;
+    for(int32_t k=0; k<n; k++) {
+        max_index = std::max(max_index, indices[k]);
+    }
+    return max_index < (uint32_t) dictionary_size;
+}
+
+// Writes the indices themselves. Full groups are unpacked straight into the output.
+class index_sink {
+  public:
+    index_sink(int32_t bit_width, int32_t dictionary_size, int32_t* out) : bit_width(bit_width), dictionary_size(dictionary_size), out(out) {}
+
+    bool rle_run(uint64_t value, int32_t values) {
+        if(value >= (uint64_t) dictionary_size) {
+            return false;
+        }
+        std::fill(out, out + values, (int32_t) value);
+        out += values;
+        return true;
+    }
+
+    bool bit_packed_run(const uint8_t* in, int32_t values) {
+        uint32_t group[32];
+
+        for(int32_t i = 0; i < values; i += 32) {
+            int32_t group_values = std::min(values - i, 32);
+
+            if(group_values == 32) {
+                fastunpack((const uint*)(in + (i/8)*bit_width), (uint32_t*) out, bit_width);
+            } else {
+                unpack_hybrid_group(in + (i/8)*bit_width, bit_width, group_values, group);
+                std::memcpy(out, group, group_values*sizeof(int32_t));
+            }
+
+            if(!indices_valid((const uint32_t*) out, group_values, dictionary_size)) {
+                return false;
+            }
+            out += group_values;
+        }
+        return true;
+    }
+
+  private:
+    int32_t bit_width;
+    int32_t dictionary_size;
+    int32_t* out;
+};
+
+// Looks the indices up in the dictionary right after unpacking them, while they are still in the L1 cache
+template<typename T>
+class value_sink {
+  public:
+    value_sink(int32_t bit_width, const T* dictionary, int32_t dictionary_size, T* out) : bit_width(bit_width), dictionary(dictionary), dictionary_size(dictionary_size), out(out) {}
+
+    bool rle_run(uint64_t value, int32_t values) {
+        if(value >= (uint64_t) dictionary_size) {
+            return false;
+        }
+        std::fill(out, out + values, dictionary[value]);
+        out += values;
+        return true;
+    }
+
+    bool bit_packed_run(const uint8_t* in, int32_t values) {
+        uint32_t group[32];
+
+        for(int32_t i = 0; i < values; i += 32) {
+            int32_t group_values = std::min(values - i, 32);
+            unpack_hybrid_group(in + (i/8)*bit_width, bit_width, group_values, group);
+
+            if(!indices_valid(group, group_values, dictionary_size)) {
+                return false;
+            }
+            gather(dictionary, (const int32_t*) group, out, group_values);
+            out += group_values;
+        }
+        return true;
+    }
+
+  private:
+    int32_t bit_width;
+    const T* dictionary;
+    int32_t dictionary_size;
+    T* out;
+};
+
+// Bit width of the indices, stored in the byte in front of them, or -1 if that byte is missing or invalid
+static inline int32_t index_bit_width(const uint8_t* data, int32_t size) {
+    return ((size > 0) && (data[0] <= 32)) ? data[0] : -1;
+}
+
+status decode_dictionary_indices(const uint8_t* data, int32_t size, int32_t dictionary_size, int32_t n, int32_t* indices) {
+    int32_t bit_width = index_bit_width(data, size);
+    if(n == 0) {
+        return status::OK;
+    } else if(bit_width < 0) {
+        return status::FAIL;
+    }
+
+    index_sink sink(bit_width, dictionary_size, indices);
+    return decode_rle_hybrid(data + 1, size - 1, bit_width, n, &sink);
+}
+
+status decode_dictionary_values32(const uint8_t* data, int32_t size, const int32_t* dictionary, int32_t dictionary_size, int32_t n, int32_t* out) {
+    int32_t bit_width = index_bit_width(data, size);
+    if(n == 0) {
+        return status::OK;
+    } else if(bit_width < 0) {
+        return status::FAIL;
+    }
+
+    value_sink<int32_t> sink(bit_width, dictionary, dictionary_size, out);
+    return decode_rle_hybrid(data + 1, size - 1, bit_width, n, &sink);
+}
+
+status decode_dictionary_values64(const uint8_t* data, int32_t size, const int64_t* dictionary, int32_t dictionary_size, int32_t n, int64_t* out) {
+    int32_t bit_width = index_bit_width(data, size);
+    if(n == 0) {
+        return status::OK;
+    } else if(bit_width < 0) {
+        return status::FAIL;
+    }
+
+    value_sink<int64_t> sink(bit_width, dictionary, dictionary_size, out);
+    return decode_rle_hybrid(data + 1, size - 1, bit_width, n, &sink);
+}
+
+void copy_dictionary_strings(const uint8_t* chars, const int32_t* dictionary_offsets, const int32_t* indices, int32_t start_offset, const int32_t* end_offsets,
+                             uint8_t* out, const uint8_t* out_end, int32_t n) {
+    int32_t string_start = start_offset;
+
+    for(int32_t i=0; i<n; i++) {
+        const uint8_t* src = chars + dictionary_offsets[indices[i]];
+        uint8_t* dst = out + string_start;
+        int32_t length = end_offsets[i] - string_start;
+
+        // Bytes copied past the string are overwritten by the strings that follow
+        if((length <= 16) && (out_end - dst >= 16)) {
+            std::memcpy(dst, src, 16);
+        } else {
+            std::memcpy(dst, src, length);
+        }
+        string_start = end_offsets[i];
+    }
+}
+
+}
@@ -0,0 +1,45 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "ptoa.h"
+
+/*
+ * Data pages of dictionary encoded column chunks (RLE_DICTIONARY, or PLAIN_DICTIONARY from older writers) start with a byte
+ * holding the bit width of the indices, followed by the indices in the RLE/bit-packed hybrid encoding.
+ * All functions reject indices of dictionary_size or more, so that lookups never read past the dictionary.
+ */
+
+namespace ptoa{
+
+// Decode the first n indices of the data page values at data, which are size bytes long, into indices
+status decode_dictionary_indices(const uint8_t* data, int32_t size, int32_t dictionary_size, int32_t n, int32_t* indices);
+
+// Decode the first n indices of the data page values at data and look them up in dictionary, so out[i] = dictionary[index i].
+// RLE runs are filled with their one value. Bit-packed runs are unpacked 32 indices at a time and looked up with AVX2 or
+// AVX-512 gathers, picked once at runtime from the CPU features.
+status decode_dictionary_values32(const uint8_t* data, int32_t size, const int32_t* dictionary, int32_t dictionary_size, int32_t n, int32_t* out);
+status decode_dictionary_values64(const uint8_t* data, int32_t size, const int64_t* dictionary, int32_t dictionary_size, int32_t n, int64_t* out);
+
+// out[i] = table[indices[i]] for i in [0, n), without bounds checks. indices and out may point to the same array.
+void gather32(const int32_t* table, const int32_t* indices, int32_t* out, int32_t n);
+
+// Copy the characters of n dictionary strings to out, string i being dictionary string indices[i]. It goes from out + start_offset
+// for i = 0, or out + end_offsets[i-1], up to out + end_offsets[i]. chars must be readable up to 16 bytes past the last string,
+// nothing at or past out_end is written. Short strings are copied as one 16 byte move wherever out has room for it.
+void copy_dictionary_strings(const uint8_t* chars, const int32_t* dictionary_offsets, const int32_t* indices, int32_t start_offset, const int32_t* end_offsets,
+                             uint8_t* out, const uint8_t* out_end, int32_t n);
+
+}
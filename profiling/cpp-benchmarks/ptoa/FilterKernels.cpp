@@ -0,0 +1,263 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <immintrin.h>
+
+#include "FilterKernels.h"
+#include "SimdDispatch.h"
+
+namespace ptoa {
+
+// Mask with the first n of 32 bits set
+static inline uint32_t first_bits(int32_t n) {
+    return n >= 32 ? ~0U : (1U << n) - 1;
+}
+
+/*
+ * Scalar reference implementations, without a branch per value
+ */
+
+template<typename T>
+static uint32_t filter_values_scalar(const T* values, int32_t n, const value_filter& filter) {
+    uint32_t mask = 0;
+
+    if(!filter.any_of) {
+        const T lower = (T) filter.lower;
+        const T upper = (T) filter.upper;
+        for(int32_t i = 0; i < n; i++) {
+            mask |= (uint32_t) ((values[i] >= lower) & (values[i] <= upper)) << i;
+        }
+        return mask;
+    }
+
+    for(size_t k = 0; k < filter.operands.size(); k++) {
+        const T operand = (T) filter.operands[k];
+        for(int32_t i = 0; i < n; i++) {
+            mask |= (uint32_t) (values[i] == operand) << i;
+        }
+    }
+    return mask;
+}
+
+static uint32_t filter_values32_scalar(const int32_t* values, int32_t n, const value_filter& filter) {
+    return filter_values_scalar(values, n, filter);
+}
+
+static uint32_t filter_values64_scalar(const int64_t* values, int32_t n, const value_filter& filter) {
+    return filter_values_scalar(values, n, filter);
+}
+
+template<typename T>
+static int32_t compact_values_scalar(const T* values, uint32_t mask, T* out) {
+    int32_t count = 0;
+    while(mask) {
+        out[count++] = values[__builtin_ctz(mask)];
+        mask &= mask - 1;
+    }
+    return count;
+}
+
+static int32_t compact_values32_scalar(const int32_t* values, uint32_t mask, int32_t* out) {
+    return compact_values_scalar(values, mask, out);
+}
+
+static int32_t compact_values64_scalar(const int64_t* values, uint32_t mask, int64_t* out) {
+    return compact_values_scalar(values, mask, out);
+}
+
+/*
+ * AVX2 implementations. A value is in range unless it is below lower or above upper, both are signed greater than compares.
+ * The compare results are packed into mask bits with movemask.
+ */
+
+__attribute__((target("avx2")))
+static uint32_t filter_values32_avx2(const int32_t* values, int32_t n, const value_filter& filter) {
+    uint32_t mask = 0;
+
+    if(!filter.any_of) {
+        const __m256i lower = _mm256_set1_epi32((int32_t) filter.lower);
+        const __m256i upper = _mm256_set1_epi32((int32_t) filter.upper);
+        for(int32_t i = 0; i < 32; i += 8) {
+            __m256i v = _mm256_loadu_si256((const __m256i*) (values + i));
+            __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(lower, v), _mm256_cmpgt_epi32(v, upper));
+            mask |= (uint32_t) (~_mm256_movemask_ps(_mm256_castsi256_ps(outside)) & 0xFF) << i;
+        }
+        return mask & first_bits(n);
+    }
+
+    for(size_t k = 0; k < filter.operands.size(); k++) {
+        const __m256i operand = _mm256_set1_epi32((int32_t) filter.operands[k]);
+        for(int32_t i = 0; i < 32; i += 8) {
+            __m256i v = _mm256_loadu_si256((const __m256i*) (values + i));
+            mask |= (uint32_t) _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, operand))) << i;
+        }
+    }
+    return mask & first_bits(n);
+}
+
+__attribute__((target("avx2")))
+static uint32_t filter_values64_avx2(const int64_t* values, int32_t n, const value_filter& filter) {
+    uint32_t mask = 0;
+
+    if(!filter.any_of) {
+        const __m256i lower = _mm256_set1_epi64x(filter.lower);
+        const __m256i upper = _mm256_set1_epi64x(filter.upper);
+        for(int32_t i = 0; i < 32; i += 4) {
+            __m256i v = _mm256_loadu_si256((const __m256i*) (values + i));
+            __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi64(lower, v), _mm256_cmpgt_epi64(v, upper));
+            mask |= (uint32_t) (~_mm256_movemask_pd(_mm256_castsi256_pd(outside)) & 0xF) << i;
+        }
+        return mask & first_bits(n);
+    }
+
+    for(size_t k = 0; k < filter.operands.size(); k++) {
+        const __m256i operand = _mm256_set1_epi64x(filter.operands[k]);
+        for(int32_t i = 0; i < 32; i += 4) {
+            __m256i v = _mm256_loadu_si256((const __m256i*) (values + i));
+            mask |= (uint32_t) _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, operand))) << i;
+        }
+    }
+    return mask & first_bits(n);
+}
+
+/*
+ * AVX-512 implementations. Compares write mask registers directly, and matching values are picked with compress stores.
+ */
+
+__attribute__((target("avx512f")))
+static uint32_t filter_values32_avx512(const int32_t* values, int32_t n, const value_filter& filter) {
+    uint32_t mask = 0;
+
+    if(!filter.any_of) {
+        const __m512i lower = _mm512_set1_epi32((int32_t) filter.lower);
+        const __m512i upper = _mm512_set1_epi32((int32_t) filter.upper);
+        for(int32_t i = 0; i < 32; i += 16) {
+            __m512i v = _mm512_loadu_si512(values + i);
+            mask |= (uint32_t) _mm512_mask_cmple_epi32_mask(_mm512_cmpge_epi32_mask(v, lower), v, upper) << i;
+        }
+        return mask & first_bits(n);
+    }
+
+    for(size_t k = 0; k < filter.operands.size(); k++) {
+        const __m512i operand = _mm512_set1_epi32((int32_t) filter.operands[k]);
+        for(int32_t i = 0; i < 32; i += 16) {
+            mask |= (uint32_t) _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(values + i), operand) << i;
+        }
+    }
+    return mask & first_bits(n);
+}
+
+__attribute__((target("avx512f")))
+static uint32_t filter_values64_avx512(const int64_t* values, int32_t n, const value_filter& filter) {
+    uint32_t mask = 0;
+
+    if(!filter.any_of) {
+        const __m512i lower = _mm512_set1_epi64(filter.lower);
+        const __m512i upper = _mm512_set1_epi64(filter.upper);
+        for(int32_t i = 0; i < 32; i += 8) {
+            __m512i v = _mm512_loadu_si512(values + i);
+            mask |= (uint32_t) _mm512_mask_cmple_epi64_mask(_mm512_cmpge_epi64_mask(v, lower), v, upper) << i;
+        }
+        return mask & first_bits(n);
+    }
+
+    for(size_t k = 0; k < filter.operands.size(); k++) {
+        const __m512i operand = _mm512_set1_epi64(filter.operands[k]);
+        for(int32_t i = 0; i < 32; i += 8) {
+            mask |= (uint32_t) _mm512_cmpeq_epi64_mask(_mm512_loadu_si512(values + i), operand) << i;
+        }
+    }
+    return mask & first_bits(n);
+}
+
+__attribute__((target("avx512f,popcnt")))
+static int32_t compact_values32_avx512(const int32_t* values, uint32_t mask, int32_t* out) {
+    __mmask16 low = (__mmask16) mask;
+    __mmask16 high = (__mmask16) (mask >> 16);
+    int32_t low_count = __builtin_popcount(low);
+
+    // Compress stores to memory are microcoded on Zen 4, so the values are compressed in a register and all lanes are stored,
+    // which is as fast on Intel. Lanes past the compressed values are overwritten by the next store.
+    _mm512_storeu_si512(out, _mm512_maskz_compress_epi32(low, _mm512_loadu_si512(values)));
+    _mm512_storeu_si512(out + low_count, _mm512_maskz_compress_epi32(high, _mm512_loadu_si512(values + 16)));
+
+    return low_count + __builtin_popcount(high);
+}
+
+__attribute__((target("avx512f,popcnt")))
+static int32_t compact_values64_avx512(const int64_t* values, uint32_t mask, int64_t* out) {
+    int32_t count = 0;
+
+    for(int32_t i = 0; i < 32; i += 8) {
+        __mmask8 part = (__mmask8) (mask >> i);
+        _mm512_storeu_si512(out + count, _mm512_maskz_compress_epi64(part, _mm512_loadu_si512(values + i)));
+        count += __builtin_popcount(part);
+    }
+
+    return count;
+}
+
+/*
+ * Runtime dispatch
+ */
+
+typedef uint32_t (*filter_values32_fn)(const int32_t*, int32_t, const value_filter&);
+typedef uint32_t (*filter_values64_fn)(const int64_t*, int32_t, const value_filter&);
+typedef int32_t (*compact_values32_fn)(const int32_t*, uint32_t, int32_t*);
+typedef int32_t (*compact_values64_fn)(const int64_t*, uint32_t, int64_t*);
+
+static filter_values32_fn select_filter_values32() {
+    switch(detect_simd_level()) {
+        case simd_level::AVX512: return filter_values32_avx512;
+        case simd_level::AVX2: return filter_values32_avx2;
+        default: return filter_values32_scalar;
+    }
+}
+
+static filter_values64_fn select_filter_values64() {
+    switch(detect_simd_level()) {
+        case simd_level::AVX512: return filter_values64_avx512;
+        case simd_level::AVX2: return filter_values64_avx2;
+        default: return filter_values64_scalar;
+    }
+}
+
+static compact_values32_fn select_compact_values32() {
+    return detect_simd_level() == simd_level::AVX512 ? compact_values32_avx512 : compact_values32_scalar;
+}
+
+static compact_values64_fn select_compact_values64() {
+    return detect_simd_level() == simd_level::AVX512 ? compact_values64_avx512 : compact_values64_scalar;
+}
+
+static const filter_values32_fn filter_values32_impl = select_filter_values32();
+static const filter_values64_fn filter_values64_impl = select_filter_values64();
+static const compact_values32_fn compact_values32_impl = select_compact_values32();
+static const compact_values64_fn compact_values64_impl = select_compact_values64();
+
+uint32_t filter_values32(const int32_t* values, int32_t n, const value_filter& filter) {
+    return filter_values32_impl(values, n, filter);
+}
+
+uint32_t filter_values64(const int64_t* values, int32_t n, const value_filter& filter) {
+    return filter_values64_impl(values, n, filter);
+}
+
+int32_t compact_values32(const int32_t* values, uint32_t mask, int32_t* out) {
+    return compact_values32_impl(values, mask, out);
+}
+
+int32_t compact_values64(const int64_t* values, uint32_t mask, int64_t* out) {
+    return compact_values64_impl(values, mask, out);
+}
+
+}
@@ -0,0 +1,48 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+/*
+ * Predicates evaluated on decoded values while they are still in cache, MINIBLOCK_VALUES (32) at a time. A group of values
+ * is compared into a mask with bit i set if value i matches, which either goes to a selection bitmap or picks the
+ * matching values out of the group.
+ */
+
+namespace ptoa{
+
+// A predicate in the form the kernels compare with: values from lower to upper, or values equal to one of operands.
+// For 32 bit values all bounds and operands have to be in the int32 range.
+struct value_filter {
+    bool any_of;
+    int64_t lower;
+    int64_t upper;
+    std::vector<int64_t> operands;
+};
+
+// Mask of the first n (at most 32) of values that match filter. values must be readable for 32 values.
+// Ranges are checked with two SIMD compares per vector, operands with one compare per operand.
+// The implementation is picked once at runtime from the CPU features (AVX-512, AVX2 or scalar).
+uint32_t filter_values32(const int32_t* values, int32_t n, const value_filter& filter);
+uint32_t filter_values64(const int64_t* values, int32_t n, const value_filter& filter);
+
+// Copy the values of the set bits of mask, in order, to out and return their amount. values must be readable for 32 values,
+// out writable for 32 values, whatever the amount copied. AVX-512 compresses in registers and stores whole vectors, otherwise the
+// set bits are walked.
+int32_t compact_values32(const int32_t* values, uint32_t mask, int32_t* out);
+int32_t compact_values64(const int64_t* values, uint32_t mask, int64_t* out);
+
+}
@@ -0,0 +1,175 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+#include <immintrin.h>
+
+#include "FixedWidthKernels.h"
+#include "SimdDispatch.h"
+
+namespace ptoa {
+
+// Julian day of 1970-01-01
+const int64_t JULIAN_DAY_OF_EPOCH = 2440588;
+const int64_t NANOSECONDS_PER_DAY = 86400LL * 1000000000LL;
+
+/*
+ * DECIMAL
+ */
+
+static inline void decimal_to_decimal128_one(const uint8_t* in, int32_t width, uint8_t* out) {
+    // Right align the big-endian value in 16 bytes of its sign, then swap it to little-endian
+    uint8_t padded[16];
+    std::memset(padded, (in[0] & 0x80) ? 0xFF : 0x00, 16);
+    std::memcpy(padded + 16 - width, in, width);
+
+    uint64_t high, low;
+    std::memcpy(&high, padded, 8);
+    std::memcpy(&low, padded + 8, 8);
+    low = __builtin_bswap64(low);
+    high = __builtin_bswap64(high);
+    std::memcpy(out, &low, 8);
+    std::memcpy(out + 8, &high, 8);
+}
+
+static void decimal_to_decimal128_scalar(const uint8_t* in, int32_t width, int32_t n, uint8_t* out) {
+    for(int32_t i=0; i<n; i++) {
+        decimal_to_decimal128_one(in + (int64_t) i*width, width, out + (int64_t) i*16);
+    }
+}
+
+__attribute__((target("ssse3")))
+static void decimal_to_decimal128_sse(const uint8_t* in, int32_t width, int32_t n, uint8_t* out) {
+    if(width != 16) {
+        decimal_to_decimal128_scalar(in, width, n, out);
+        return;
+    }
+
+    const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    for(int32_t i=0; i<n; i++) {
+        __m128i value = _mm_loadu_si128((const __m128i*)(in + (int64_t) i*16));
+        _mm_storeu_si128((__m128i*)(out + (int64_t) i*16), _mm_shuffle_epi8(value, reverse));
+    }
+}
+
+/*
+ * INT96. Nanoseconds since the epoch are (day - JULIAN_DAY_OF_EPOCH)*86400*10^9 + nanoseconds of the day.
+ * The vector versions compute days*86400 with a signed 32x32 bit multiply and multiply that by 10^9 in two 32 bit halves.
+ */
+
+static void int96_to_timestamp_ns_scalar(const uint8_t* in, int32_t n, int64_t* out) {
+    for(int32_t i=0; i<n; i++) {
+        int64_t nanoseconds;
+        int32_t day;
+        std::memcpy(&nanoseconds, in + (int64_t) i*12, 8);
+        std::memcpy(&day, in + (int64_t) i*12 + 8, 4);
+        out[i] = (day - JULIAN_DAY_OF_EPOCH)*NANOSECONDS_PER_DAY + nanoseconds;
+    }
+}
+
+// Each 64 bit lane of days holds a day in its low half. Returns the nanoseconds of the lanes' timestamps.
+__attribute__((target("sse4.1")))
+static inline __m128i int96_combine_sse(__m128i nanoseconds, __m128i days) {
+    __m128i seconds = _mm_mul_epi32(_mm_sub_epi32(days, _mm_set1_epi32(JULIAN_DAY_OF_EPOCH)), _mm_set1_epi32(86400));
+    __m128i billion = _mm_set1_epi32(1000000000);
+    __m128i low = _mm_mul_epu32(seconds, billion);
+    __m128i high = _mm_slli_epi64(_mm_mul_epu32(_mm_srli_epi64(seconds, 32), billion), 32);
+    return _mm_add_epi64(_mm_add_epi64(low, high), nanoseconds);
+}
+
+__attribute__((target("sse4.1")))
+static void int96_to_timestamp_ns_sse(const uint8_t* in, int32_t n, int64_t* out) {
+    int32_t i = 0;
+
+    // 16 byte loads of a 12 byte value read 4 bytes past it, the last value is left to the scalar loop
+    for(; i+3<=n; i+=2) {
+        __m128i v0 = _mm_loadu_si128((const __m128i*)(in + (int64_t) i*12));
+        __m128i v1 = _mm_loadu_si128((const __m128i*)(in + (int64_t) i*12 + 12));
+        __m128i result = int96_combine_sse(_mm_unpacklo_epi64(v0, v1), _mm_unpackhi_epi64(v0, v1));
+        _mm_storeu_si128((__m128i*)(out + i), result);
+    }
+
+    int96_to_timestamp_ns_scalar(in + (int64_t) i*12, n - i, out + i);
+}
+
+__attribute__((target("avx2")))
+static void int96_to_timestamp_ns_avx2(const uint8_t* in, int32_t n, int64_t* out) {
+    int32_t i = 0;
+    const __m256i epoch = _mm256_set1_epi32(JULIAN_DAY_OF_EPOCH);
+    const __m256i seconds_per_day = _mm256_set1_epi32(86400);
+    const __m256i billion = _mm256_set1_epi32(1000000000);
+
+    for(; i+5<=n; i+=4) {
+        const uint8_t* src = in + (int64_t) i*12;
+        __m128i v0 = _mm_loadu_si128((const __m128i*)(src));
+        __m128i v1 = _mm_loadu_si128((const __m128i*)(src + 12));
+        __m128i v2 = _mm_loadu_si128((const __m128i*)(src + 24));
+        __m128i v3 = _mm_loadu_si128((const __m128i*)(src + 36));
+
+        __m256i nanoseconds = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi64(v0, v1)), _mm_unpacklo_epi64(v2, v3), 1);
+        __m256i days = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpackhi_epi64(v0, v1)), _mm_unpackhi_epi64(v2, v3), 1);
+
+        __m256i seconds = _mm256_mul_epi32(_mm256_sub_epi32(days, epoch), seconds_per_day);
+        __m256i low = _mm256_mul_epu32(seconds, billion);
+        __m256i high = _mm256_slli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(seconds, 32), billion), 32);
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_add_epi64(_mm256_add_epi64(low, high), nanoseconds));
+    }
+
+    int96_to_timestamp_ns_sse(in + (int64_t) i*12, n - i, out + i);
+}
+
+typedef void (*decimal_fn)(const uint8_t*, int32_t, int32_t, uint8_t*);
+typedef void (*int96_fn)(const uint8_t*, int32_t, int64_t*);
+
+static decimal_fn select_decimal() {
+    switch(detect_simd_level()) {
+        case simd_level::AVX512:
+        case simd_level::AVX2:
+        case simd_level::SSE4_1: return decimal_to_decimal128_sse;
+        default: return decimal_to_decimal128_scalar;
+    }
+}
+
+static int96_fn select_int96() {
+    switch(detect_simd_level()) {
+        case simd_level::AVX512:
+        case simd_level::AVX2: return int96_to_timestamp_ns_avx2;
+        case simd_level::SSE4_1: return int96_to_timestamp_ns_sse;
+        default: return int96_to_timestamp_ns_scalar;
+    }
+}
+
+static const decimal_fn decimal_impl = select_decimal();
+static const int96_fn int96_impl = select_int96();
+
+void decimal_to_decimal128(const uint8_t* in, int32_t width, int32_t n, uint8_t* out) {
+    decimal_impl(in, width, n, out);
+}
+
+void int96_to_timestamp_ns(const uint8_t* in, int32_t n, int64_t* out) {
+    int96_impl(in, n, out);
+}
+
+void gather_fixed(const uint8_t* table, int32_t width, const int32_t* indices, int32_t n, uint8_t* out) {
+    // Fixed size copies compile to plain moves
+    if(width == 16) {
+        for(int32_t i=0; i<n; i++) {
+            std::memcpy(out + (int64_t) i*16, table + (int64_t) indices[i]*16, 16);
+        }
+    } else {
+        for(int32_t i=0; i<n; i++) {
+            std::memcpy(out + (int64_t) i*width, table + (int64_t) indices[i]*width, width);
+        }
+    }
+}
+
+}
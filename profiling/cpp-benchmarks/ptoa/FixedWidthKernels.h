@@ -0,0 +1,36 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Conversions of FIXED_LEN_BYTE_ARRAY and INT96 values to their Arrow layouts.
+ * DECIMAL values are big-endian two's complement integers of the type length, Arrow stores them as 16 byte little-endian integers.
+ * INT96 timestamps, as written by Hive and Impala, are 8 little-endian bytes of nanoseconds within the day followed by 4 of Julian day.
+ */
+
+namespace ptoa{
+
+// Convert n DECIMAL values of width bytes (1-16) at in to Decimal128 values at out, sign extending them.
+// 16 byte values are byte swapped 16 at a time with SSSE3, picked once at runtime from the CPU features.
+void decimal_to_decimal128(const uint8_t* in, int32_t width, int32_t n, uint8_t* out);
+
+// Convert n INT96 timestamps at in to nanoseconds since the Unix epoch. The days are scaled with 32x32 bit multiplies,
+// 4 (AVX2) or 2 (SSE4.1) values at a time, picked once at runtime from the CPU features.
+void int96_to_timestamp_ns(const uint8_t* in, int32_t n, int64_t* out);
+
+// out[i] = value indices[i] of table, for values of width bytes and i in [0, n), without bounds checks
+void gather_fixed(const uint8_t* table, int32_t width, const int32_t* indices, int32_t n, uint8_t* out);
+
+}
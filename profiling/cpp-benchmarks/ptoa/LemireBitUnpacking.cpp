@@ -67,7 +67,8 @@
 #include <string.h>
 
 #include "LemireBitUnpacking.h"
-#include "SWParquetReader.h"
+#include "SimdBitUnpacking.h"
+#include "DeltaKernels.h"
 
 using namespace std;
 
@@ -2987,11 +2988,11 @@ void __fastunpack16(const uint *  __restrict__ in, uint *  __restrict__  out) {
   }
 }
 
-void fastunpack(const uint *  __restrict__ in, uint *  __restrict__  out, const uint bit) {
+void scalar_fastunpack(const uint *  __restrict__ in, uint *  __restrict__  out, const uint bit) {
 	switch(bit) {
             case 0:
                 // Case 0 added to deal with Parquet's zero width bit packing
-                for(int i=0; i<(BLOCK_SIZE/MINIBLOCKS_IN_BLOCK); i++){
+                for(int i=0; i<ptoa::MINIBLOCK_VALUES; i++){
                     out[i]=0;
                 }
                 break;
@@ -3096,6 +3097,17 @@ void fastunpack(const uint *  __restrict__ in, uint *  __restrict__  out, const
 	}
 }
 
+// SIMD kernels for the CPU we are running on, see SimdBitUnpacking.h
+static const ptoa::unpack32_fn* simd_unpack32_kernels = ptoa::select_simd_unpack32_kernels();
+
+void fastunpack(const uint *  __restrict__ in, uint *  __restrict__  out, const uint bit) {
+	if(simd_unpack32_kernels != nullptr && bit <= 32) {
+		simd_unpack32_kernels[bit](in, out);
+	} else {
+		scalar_fastunpack(in, out, bit);
+	}
+}
+
 __attribute__ ((noinline))
 void fastunpack(const vector<uint> & data, vector<uint> & out, const uint bit) {
 		const uint N = out.size();
@@ -9006,11 +9018,11 @@ void __int64fastunpack64(const uint64_t *  __restrict__ in, uint64_t *  __restri
     *out = *in;
 }
 
-void int64fastunpack(const uint64_t *  __restrict__ in, uint64_t *  __restrict__  out, const uint bit) {
+void scalar_int64fastunpack(const uint64_t *  __restrict__ in, uint64_t *  __restrict__  out, const uint bit) {
     switch(bit) {
             case 0:
                 // Case 0 added to deal with Parquet's zero width bit packing
-                for(int i=0; i<(BLOCK_SIZE/MINIBLOCKS_IN_BLOCK); i++){
+                for(int i=0; i<ptoa::MINIBLOCK_VALUES; i++){
                     out[i]=0;
                 }
                 break;
@@ -9211,3 +9223,13 @@ void int64fastunpack(const uint64_t *  __restrict__ in, uint64_t *  __restrict__
     }
 }
 
+// SIMD kernels for the CPU we are running on, see SimdBitUnpacking.h
+static const ptoa::unpack64_fn* simd_unpack64_kernels = ptoa::select_simd_unpack64_kernels();
+
+void int64fastunpack(const uint64_t *  __restrict__ in, uint64_t *  __restrict__  out, const uint bit) {
+    if(simd_unpack64_kernels != nullptr && bit <= 64) {
+        simd_unpack64_kernels[bit](in, out);
+    } else {
+        scalar_int64fastunpack(in, out, bit);
+    }
+}
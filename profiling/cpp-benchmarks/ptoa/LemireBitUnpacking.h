@@ -1,5 +1,7 @@
 #pragma once
 
 void fastunpack(const uint *  __restrict__ in, uint *  __restrict__  out, const uint bit);
+void scalar_fastunpack(const uint *  __restrict__ in, uint *  __restrict__  out, const uint bit);
 void int64fastunpack(const uint64_t *  __restrict__ in, uint64_t *  __restrict__  out, const uint bit);
+void scalar_int64fastunpack(const uint64_t *  __restrict__ in, uint64_t *  __restrict__  out, const uint bit);
 void fastpack(const uint *  __restrict__ in, uint *  __restrict__  out, const uint bit);
\ No newline at end of file
@@ -0,0 +1,192 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+#include "PageHeader.h"
+#include "ThriftCompact.h"
+
+namespace ptoa {
+
+/*
+ * The generic decoder behind read_page_header. The page header structs are described by tables indexed by Thrift field id,
+ * so decoding a field is a table lookup and a type compare instead of a chain of field id checks. Every field lands in the
+ * flat page_header.
+ */
+
+struct thrift_struct;
+
+// Where a field of a struct is stored in page_header. Fields of another type than expected,
+// which includes every field listed as T_STOP, are skipped. Boolean fields are listed as T_BOOLEAN_TRUE.
+struct thrift_field {
+    uint8_t type;
+    uint8_t offset;
+    const thrift_struct* nested;
+};
+
+struct thrift_struct {
+    const thrift_field* fields;
+    int16_t num_fields;
+};
+
+static_assert(sizeof(page_header) <= 256, "Offsets of page_header fields have to fit in the offset byte of thrift_field");
+
+#define HEADER_FIELD(type, member) {type, offsetof(page_header, member), nullptr}
+#define NESTED_FIELD(nested) {T_STRUCT, 0, &nested}
+#define SKIPPED_FIELD {T_STOP, 0, nullptr}
+#define THRIFT_STRUCT(fields) {fields, sizeof(fields)/sizeof(fields[0])}
+
+static const thrift_field statistics_fields[] = {
+    SKIPPED_FIELD,
+    HEADER_FIELD(T_BINARY, statistics.max),
+    HEADER_FIELD(T_BINARY, statistics.min),
+    HEADER_FIELD(T_I64, statistics.null_count),
+    SKIPPED_FIELD,                                  // distinct_count
+    HEADER_FIELD(T_BINARY, statistics.max_value),
+    HEADER_FIELD(T_BINARY, statistics.min_value)
+};
+
+static const thrift_struct statistics_struct = THRIFT_STRUCT(statistics_fields);
+
+static const thrift_field data_page_header_fields[] = {
+    SKIPPED_FIELD,
+    HEADER_FIELD(T_I32, num_values),
+    HEADER_FIELD(T_I32, encoding),
+    HEADER_FIELD(T_I32, def_level_encoding),
+    HEADER_FIELD(T_I32, rep_level_encoding),
+    NESTED_FIELD(statistics_struct)
+};
+
+static const thrift_field dictionary_page_header_fields[] = {
+    SKIPPED_FIELD,
+    HEADER_FIELD(T_I32, num_values),
+    HEADER_FIELD(T_I32, encoding),
+    HEADER_FIELD(T_BOOLEAN_TRUE, is_sorted)
+};
+
+static const thrift_field data_page_header_v2_fields[] = {
+    SKIPPED_FIELD,
+    HEADER_FIELD(T_I32, num_values),
+    HEADER_FIELD(T_I32, num_nulls),
+    HEADER_FIELD(T_I32, num_rows),
+    HEADER_FIELD(T_I32, encoding),
+    HEADER_FIELD(T_I32, def_level_length),
+    HEADER_FIELD(T_I32, rep_level_length),
+    HEADER_FIELD(T_BOOLEAN_TRUE, is_compressed),
+    NESTED_FIELD(statistics_struct)
+};
+
+static const thrift_struct data_page_header_struct = THRIFT_STRUCT(data_page_header_fields);
+static const thrift_struct dictionary_page_header_struct = THRIFT_STRUCT(dictionary_page_header_fields);
+static const thrift_struct data_page_header_v2_struct = THRIFT_STRUCT(data_page_header_v2_fields);
+
+static const thrift_field page_header_fields[] = {
+    SKIPPED_FIELD,
+    HEADER_FIELD(T_I32, type),
+    HEADER_FIELD(T_I32, uncompressed_size),
+    HEADER_FIELD(T_I32, compressed_size),
+    SKIPPED_FIELD,                                  // crc
+    NESTED_FIELD(data_page_header_struct),
+    SKIPPED_FIELD,                                  // index_page_header, which has no fields
+    NESTED_FIELD(dictionary_page_header_struct),
+    NESTED_FIELD(data_page_header_v2_struct)
+};
+
+static const thrift_struct page_header_struct = THRIFT_STRUCT(page_header_fields);
+
+// Decode the fields of a struct up to its stop field. last_field_id is the id of the field read before, if any.
+static void read_fields(ThriftCompactReader* thrift, const thrift_struct& desc, int16_t last_field_id, uint8_t* out) {
+    int16_t field_id;
+    uint8_t field_type;
+
+    while(thrift->read_field_header(&last_field_id, &field_id, &field_type)) {
+        // Booleans carry their value in the type nibble, both types match a T_BOOLEAN_TRUE entry
+        uint8_t table_type = (field_type == T_BOOLEAN_FALSE) ? (uint8_t) T_BOOLEAN_TRUE : field_type;
+        const thrift_field* field = ((uint16_t) field_id < (uint16_t) desc.num_fields) ? &desc.fields[field_id] : nullptr;
+
+        if(!field || field->type != table_type) {
+            thrift->skip(field_type);
+        } else if(table_type == T_I32) {
+            int32_t value = thrift->read_i32();
+            std::memcpy(out + field->offset, &value, sizeof(value));
+        } else if(table_type == T_I64) {
+            int64_t value = thrift->read_i64();
+            std::memcpy(out + field->offset, &value, sizeof(value));
+        } else if(table_type == T_BINARY) {
+            byte_range value;
+            value.data = thrift->read_binary_bytes(&value.size);
+            std::memcpy(out + field->offset, &value, sizeof(value));
+        } else if(table_type == T_BOOLEAN_TRUE) {
+            bool value = ThriftCompactReader::bool_value(field_type);
+            std::memcpy(out + field->offset, &value, sizeof(value));
+        } else {
+            read_fields(thrift, *field->nested, 0, out);
+        }
+    }
+}
+
+const uint8_t* read_page_statistics(const uint8_t* data, const uint8_t* end, page_header* header) {
+    ThriftCompactReader thrift(data, end);
+    read_fields(&thrift, statistics_struct, 0, (uint8_t*) header);
+
+    return thrift.failed() ? nullptr : thrift.position();
+}
+
+status read_page_header_generic(const uint8_t* data, const uint8_t* end, page_header* header) {
+    header->type = (page_type) -1;
+    header->uncompressed_size = -1;
+    header->compressed_size = -1;
+    header->num_values = -1;
+    header->encoding = parquet_encoding::PLAIN;
+    header->def_level_encoding = parquet_encoding::RLE;
+    header->rep_level_encoding = parquet_encoding::RLE;
+    header->num_nulls = 0;
+    header->num_rows = 0;
+    header->def_level_length = 0;
+    header->rep_level_length = 0;
+    header->is_compressed = true;
+    header->is_sorted = false;
+    header->statistics.max.data = nullptr;
+    header->statistics.min.data = nullptr;
+    header->statistics.null_count = -1;
+    header->statistics.max_value.data = nullptr;
+    header->statistics.min_value.data = nullptr;
+
+    ThriftCompactReader thrift(data, end);
+    read_fields(&thrift, page_header_struct, 0, (uint8_t*) header);
+
+    if(thrift.failed()) {
+        return status::FAIL;
+    }
+
+    // Required fields, which also rejects data that merely happens to parse as a Thrift struct
+    if((header->type < page_type::DATA_PAGE) || (header->type > page_type::DATA_PAGE_V2)
+            || (header->uncompressed_size < 0) || (header->compressed_size < 0)
+            || ((header->type != page_type::INDEX_PAGE) && (header->num_values < 0))
+            || (header->num_nulls < 0) || (header->num_rows < 0)) {
+        return status::FAIL;
+    }
+
+    // The levels are stored uncompressed in front of the values, so they have to fit in both sizes
+    if((header->def_level_length < 0) || (header->rep_level_length < 0)
+            || ((int64_t) header->def_level_length + header->rep_level_length > std::min(header->compressed_size, header->uncompressed_size))) {
+        return status::FAIL;
+    }
+
+    header->header_size = thrift.position() - data;
+
+    return status::OK;
+}
+
+}
@@ -0,0 +1,260 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <cstring>
+#include <algorithm>
+#include <immintrin.h>
+
+#include "ptoa.h"
+#include "ThriftCompact.h"
+
+namespace ptoa{
+
+// Bytes of a binary Thrift field, pointing into the data it was decoded from. data is nullptr if the field is absent.
+struct byte_range {
+    const uint8_t* data;
+    int32_t size;
+};
+
+// Statistics of the values in a page or column chunk, as written by the writer. min and max are the deprecated fields, which
+// writers only fill for types whose order they compare as signed, min_value and max_value follow the logical sort order.
+struct value_statistics {
+    byte_range max;
+    byte_range min;
+    int64_t null_count;                     // -1 if not written
+    byte_range max_value;
+    byte_range min_value;
+
+    // Lower and upper bound of the non-null values, preferring min_value and max_value. Returns false if there are none.
+    bool bounds(parquet_type type, byte_range* lower, byte_range* upper) const {
+        if(min_value.data && max_value.data) {
+            *lower = min_value;
+            *upper = max_value;
+            return true;
+        } else if(min.data && max.data && (type != parquet_type::BYTE_ARRAY) && (type != parquet_type::FIXED_LEN_BYTE_ARRAY)) {
+            *lower = min;
+            *upper = max;
+            return true;
+        }
+        return false;
+    }
+};
+
+// A PageHeader flattened together with the DataPageHeader, DataPageHeaderV2 or DictionaryPageHeader it contains.
+// Fields that do not occur in the header of the page's type keep their default value.
+struct page_header {
+    page_type type;
+    int32_t uncompressed_size;
+    int32_t compressed_size;
+    int32_t num_values;
+    parquet_encoding encoding;
+    parquet_encoding def_level_encoding;    // DATA_PAGE only
+    parquet_encoding rep_level_encoding;    // DATA_PAGE only
+    int32_t num_nulls;                      // DATA_PAGE_V2 only
+    int32_t num_rows;                       // DATA_PAGE_V2 only
+    int32_t def_level_length;               // DATA_PAGE_V2 only, byte length of the uncompressed definition levels
+    int32_t rep_level_length;               // DATA_PAGE_V2 only, byte length of the uncompressed repetition levels
+    bool is_compressed;                     // DATA_PAGE_V2 only
+    value_statistics statistics;            // DATA_PAGE and DATA_PAGE_V2 only
+    bool is_sorted;                         // DICTIONARY_PAGE only
+    int32_t header_size;                    // Bytes taken up by the encoded header, the page data follows it
+
+    bool is_data_page() const {return type == page_type::DATA_PAGE || type == page_type::DATA_PAGE_V2;}
+};
+
+// Decode the PageHeader at data with the table driven decoder, which takes the fields in any order and checks every byte
+// against end. read_page_header leaves all headers it does not recognize to it.
+status read_page_header_generic(const uint8_t* data, const uint8_t* end, page_header* header);
+
+// Decode the fields of the Statistics struct at data into header. Returns where the struct ends, nullptr if it does not end before end.
+const uint8_t* read_page_statistics(const uint8_t* data, const uint8_t* end, page_header* header);
+
+/*
+ * Fast path for headers in the field order all writers use: every field present in id order, so that each field header is
+ * one known byte. It reads without bounds checks or table lookups, the decoded values are checked once at the end. Headers
+ * it does not recognize are decoded again by read_page_header_generic. It is inline because the call alone costs about as much
+ * as the decoding. Headers are rarely in cache, and every load still waiting for one holds back the headers after it, so each
+ * field is taken with a single load rather than byte by byte.
+ */
+
+// Longest header the fast path reads unchecked: the PageHeader fields 1 to 4, a DataPageHeaderV2, an empty Statistics and the stop fields
+#define PAGE_HEADER_FAST_PATH_BYTES 128
+
+// Decode the i32 field that directly follows the previous one. Varints longer than an i32 are left to the generic decoder.
+// All i32 fields the fast path keeps are sizes or counts, so the value is taken as non-negative and the sign bit of the zigzag
+// encoding is or'ed into negative, for the caller to reject negative values once for all fields.
+__attribute__((always_inline)) inline bool read_header_i32(const uint8_t** ptr, int32_t* value, uint32_t* negative) {
+    // The field header and the longest varint are loaded at once, the length is then found in the continuation bits
+    uint64_t bytes;
+    std::memcpy(&bytes, *ptr, sizeof(bytes));
+    if((uint8_t) bytes != (0x10 | T_I32)) {
+        return false;
+    }
+    uint64_t varint = bytes >> 8;
+
+    // The 7 value bits of the bytes are put together with BMI2 pext where it is fast, which it is not on AMD before Zen 3,
+    // else byte by byte as the length is found. The continuation bit of a fifth byte lands above the 32 value bits, with
+    // the bits an i32 does not have.
+    int length = 1;
+#if defined(__BMI2__) && !defined(__znver1__) && !defined(__znver2__)
+    while((varint & (0x80ULL << (8*(length - 1)))) && (length < 5)) {
+        length++;
+    }
+    uint64_t result = _pext_u64(varint, 0xFF7F7F7F7FULL >> (8*(5 - length)));
+#else
+    uint64_t result = varint & 0x7F;
+    while((varint & (0x80ULL << (8*(length - 1)))) && (length < 5)) {
+        result |= ((varint >> (8*length)) & (length < 4 ? 0x7FULL : 0xFFULL)) << (7*length);
+        length++;
+    }
+#endif
+    if(result >> 32) {
+        return false;
+    }
+
+    *value = (int32_t)((uint32_t) result >> 1);
+    *negative |= (uint32_t) result;
+    *ptr += 1 + length;
+    return true;
+}
+
+// Decode the i32 field that directly follows the previous one if it is a non-negative value that fits in one byte, as page
+// types and encodings are. Its varint is then the value times two.
+__attribute__((always_inline)) inline bool read_header_enum(const uint8_t** ptr, int32_t* value) {
+    uint16_t field;
+    std::memcpy(&field, *ptr, sizeof(field));
+    if((field & 0x81FF) != (0x10 | T_I32)) {
+        return false;
+    }
+
+    *value = field >> 9;
+    *ptr += 2;
+    return true;
+}
+
+// Decode the three enum fields of a DataPageHeader that directly follow the previous one, with one load instead of three
+__attribute__((always_inline)) inline bool read_header_enums(const uint8_t** ptr, int32_t* first, int32_t* second, int32_t* third) {
+    uint64_t fields;
+    std::memcpy(&fields, *ptr, sizeof(fields));
+    // Each field is the field header and a varint of one byte with the sign bit clear
+    if((fields & 0x81FF81FF81FFULL) != 0x001500150015ULL) {
+        return false;
+    }
+
+    *first = (fields >> 9) & 0x7F;
+    *second = (fields >> 25) & 0x7F;
+    *third = (fields >> 41) & 0x7F;
+    *ptr += 6;
+    return true;
+}
+
+// Decode the boolean field that directly follows the previous one, if there is one
+__attribute__((always_inline)) inline void read_header_bool(const uint8_t** ptr, bool* value) {
+    if((**ptr == (0x10 | T_BOOLEAN_TRUE)) || (**ptr == (0x10 | T_BOOLEAN_FALSE))) {
+        *value = **ptr == (0x10 | T_BOOLEAN_TRUE);
+        (*ptr)++;
+    }
+}
+
+// Decode the Thrift compact protocol encoded PageHeader at data, which must not extend beyond end.
+// Fields the reader does not use, such as CRCs, are skipped. Statistics point into the header data.
+__attribute__((always_inline)) inline status read_page_header(const uint8_t* data, const uint8_t* end, page_header* header) {
+    // Fields are decoded to locals, which the final check reads without waiting for the stores to page_header
+    const uint8_t* ptr = data;
+    uint32_t negative = 0, crc_negative = 0;
+    int32_t type, uncompressed_size, compressed_size, crc;
+    int32_t num_values, encoding, def_level_encoding = (int32_t) parquet_encoding::RLE, rep_level_encoding = (int32_t) parquet_encoding::RLE;
+    int32_t num_nulls = 0, num_rows = 0, def_level_length = 0, rep_level_length = 0;
+    bool is_compressed = true, is_sorted = false;
+
+    if((end - data < PAGE_HEADER_FAST_PATH_BYTES)
+            || !(read_header_enum(&ptr, &type) && read_header_i32(&ptr, &uncompressed_size, &negative) && read_header_i32(&ptr, &compressed_size, &negative))) {
+        return read_page_header_generic(data, end, header);
+    }
+
+    // The field id of the page type specific struct counts from the crc if there is one, which may well be negative
+    int16_t last_field_id = 3;
+    if(*ptr == (0x10 | T_I32)) {
+        if(!read_header_i32(&ptr, &crc, &crc_negative)) {
+            return read_page_header_generic(data, end, header);
+        }
+        last_field_id = 4;
+    }
+    uint8_t struct_header = *ptr++;
+
+    bool matched = false;
+    if(type == (int32_t) page_type::DATA_PAGE) {
+        matched = (struct_header == (((5 - last_field_id) << 4) | T_STRUCT))
+            && read_header_i32(&ptr, &num_values, &negative) && read_header_enums(&ptr, &encoding, &def_level_encoding, &rep_level_encoding);
+    } else if(type == (int32_t) page_type::DATA_PAGE_V2) {
+        matched = (struct_header == (((8 - last_field_id) << 4) | T_STRUCT))
+            && read_header_i32(&ptr, &num_values, &negative) && read_header_i32(&ptr, &num_nulls, &negative) && read_header_i32(&ptr, &num_rows, &negative)
+            && read_header_enum(&ptr, &encoding) && read_header_i32(&ptr, &def_level_length, &negative) && read_header_i32(&ptr, &rep_level_length, &negative)
+            // The levels are stored uncompressed in front of the values, so they have to fit in both sizes
+            && ((int64_t) def_level_length + rep_level_length <= std::min(compressed_size, uncompressed_size));
+        read_header_bool(&ptr, &is_compressed);
+    } else if(type == (int32_t) page_type::DICTIONARY_PAGE) {
+        matched = (struct_header == (((7 - last_field_id) << 4) | T_STRUCT))
+            && read_header_i32(&ptr, &num_values, &negative) && read_header_enum(&ptr, &encoding);
+        read_header_bool(&ptr, &is_sorted);
+    }
+
+    header->statistics.max.data = nullptr;
+    header->statistics.min.data = nullptr;
+    header->statistics.null_count = -1;
+    header->statistics.max_value.data = nullptr;
+    header->statistics.min_value.data = nullptr;
+
+    // Writers put a Statistics struct in data page headers, which is empty unless they keep statistics. The header then ends with
+    // the empty struct and the stop fields of both structs, which are loaded at once. A dictionary page header does not have
+    // this field, but skipping an empty struct decodes the same.
+    uint32_t tail;
+    std::memcpy(&tail, ptr, sizeof(tail));
+    uint16_t stop_fields = (uint16_t) tail;
+    if(tail == (0x10 | T_STRUCT)) {
+        ptr += 2;
+        stop_fields = 0;
+    } else if(matched && ((uint8_t) tail == (0x10 | T_STRUCT)) && (type != (int32_t) page_type::DICTIONARY_PAGE)) {
+        ptr = read_page_statistics(ptr + 1, end, header);
+        if(!ptr || (end - ptr < 2)) {
+            return read_page_header_generic(data, end, header);
+        }
+        std::memcpy(&stop_fields, ptr, sizeof(stop_fields));
+    }
+
+    // Only the stop fields of both structs may follow, and none of the sizes and counts may be negative
+    if(!matched || (stop_fields != 0) || (negative & 1)) {
+        return read_page_header_generic(data, end, header);
+    }
+
+    header->type = (page_type) type;
+    header->uncompressed_size = uncompressed_size;
+    header->compressed_size = compressed_size;
+    header->num_values = num_values;
+    header->encoding = (parquet_encoding) encoding;
+    header->def_level_encoding = (parquet_encoding) def_level_encoding;
+    header->rep_level_encoding = (parquet_encoding) rep_level_encoding;
+    header->num_nulls = num_nulls;
+    header->num_rows = num_rows;
+    header->def_level_length = def_level_length;
+    header->rep_level_length = rep_level_length;
+    header->is_compressed = is_compressed;
+    header->is_sorted = is_sorted;
+    header->header_size = ptr + 2 - data;
+
+    return status::OK;
+}
+
+}
@@ -0,0 +1,68 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+
+#include "PlainKernels.h"
+
+namespace ptoa {
+
+status scan_plain_lengths(const uint8_t* data, int32_t size, int32_t n, int32_t* lengths, int64_t* chars) {
+    const uint8_t* ptr = data;
+    const uint8_t* end = data + size;
+    int64_t total = 0;
+
+    // Every length depends on where the one before it ends, so this is a plain pointer chase
+    for(int32_t i=0; i<n; i++) {
+        uint32_t length;
+        if(end - ptr < 4) {
+            return status::FAIL;
+        }
+        std::memcpy(&length, ptr, 4);
+        ptr += 4;
+        if(length > (uint64_t)(end - ptr)) {
+            return status::FAIL;
+        }
+        lengths[i] = length;
+        total += length;
+        ptr += length;
+    }
+
+    *chars = total;
+    return status::OK;
+}
+
+void copy_plain_strings(const uint8_t* data, const uint8_t* data_end, int32_t start_offset, const int32_t* end_offsets, int32_t n,
+                        uint8_t* out, const uint8_t* out_end) {
+    const uint8_t* src = data;
+    int32_t string_start = start_offset;
+
+    for(int32_t i=0; i<n; i++) {
+        int32_t length = end_offsets[i] - string_start;
+        uint8_t* dst = out + string_start;
+        src += 4;
+
+        if((length <= 16) && (data_end - src >= 16) && (out_end - dst >= 16)) {
+            std::memcpy(dst, src, 16);
+        } else if((length <= 32) && (data_end - src >= 32) && (out_end - dst >= 32)) {
+            std::memcpy(dst, src, 16);
+            std::memcpy(dst + 16, src + 16, 16);
+        } else {
+            std::memcpy(dst, src, length);
+        }
+
+        src += length;
+        string_start = end_offsets[i];
+    }
+}
+
+}
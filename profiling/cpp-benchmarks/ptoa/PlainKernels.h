@@ -0,0 +1,36 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "ptoa.h"
+
+/*
+ * PLAIN encoded BYTE_ARRAY values are stored back to back, each one a 4 byte little endian length followed by its bytes.
+ */
+
+namespace ptoa{
+
+// Walk the first n values at data, which is size bytes long, and store their lengths. *chars is set to the sum of the lengths.
+// Fails if a length or string runs past the end of the data.
+status scan_plain_lengths(const uint8_t* data, int32_t size, int32_t n, int32_t* lengths, int64_t* chars);
+
+// Copy the bytes of the first n values at data, which ends at data_end, to out. String i goes from out + start_offset for i = 0,
+// or out + end_offsets[i-1], up to out + end_offsets[i]. Nothing at or past out_end is written.
+// Strings of up to 16 or 32 bytes are copied as one or two 16 byte moves wherever data and out have room for it, the bytes
+// moved past a string are overwritten by the strings that follow.
+void copy_plain_strings(const uint8_t* data, const uint8_t* data_end, int32_t start_offset, const int32_t* end_offsets, int32_t n,
+                        uint8_t* out, const uint8_t* out_end);
+
+}
@@ -0,0 +1,102 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <algorithm>
+
+#include "ptoa.h"
+#include "LemireBitUnpacking.h"
+
+/*
+ * RLE/bit-packed hybrid encoding, used for levels and dictionary indices. Every run starts with a varint header.
+ * If its lowest bit is clear, the run repeats one value header>>1 times, stored in (bit_width+7)/8 little endian bytes.
+ * If it is set, the run holds (header>>1)*8 values bit-packed LSB first, the layout the miniblock unpack kernels read.
+ */
+
+namespace ptoa{
+
+// Walk the runs that hold the first n values of the hybrid encoded data, which is size bytes long. For every run either
+// sink->rle_run(value, count) or sink->bit_packed_run(packed, count) is called, with count cut off at the values still missing.
+// Fails on truncated data and on run headers that do not fit in 32 bits, and if a sink call returns false.
+template<typename Sink>
+inline status decode_rle_hybrid(const uint8_t* data, int32_t size, int32_t bit_width, int32_t n, Sink* sink) {
+    const uint8_t* ptr = data;
+    const uint8_t* end = data + size;
+    int32_t decoded = 0;
+
+    while(decoded < n) {
+        uint32_t header = 0;
+        for(int shift = 0; ; shift += 7) {
+            if((ptr >= end) || (shift > 28)) {
+                return status::FAIL;
+            }
+            uint8_t byte = *ptr++;
+            header |= (uint32_t)(byte & 0x7F) << shift;
+            if(!(byte & 0x80)) {
+                break;
+            }
+        }
+
+        if(header & 1) {
+            // Groups of 8 values, the last group is padded
+            int64_t run_values = (int64_t)(header >> 1)*8;
+            int64_t run_bytes = (int64_t)(header >> 1)*bit_width;
+            if(run_bytes > end - ptr) {
+                return status::FAIL;
+            }
+
+            int32_t values = (int32_t) std::min(run_values, (int64_t)(n - decoded));
+            if(!sink->bit_packed_run(ptr, values)) {
+                return status::FAIL;
+            }
+            decoded += values;
+            ptr += run_bytes;
+        } else {
+            int32_t value_bytes = (bit_width + 7)/8;
+            if(value_bytes > end - ptr) {
+                return status::FAIL;
+            }
+
+            uint64_t value = 0;
+            memcpy(&value, ptr, value_bytes);
+
+            int32_t values = (int32_t) std::min((int64_t)(header >> 1), (int64_t)(n - decoded));
+            if(!sink->rle_run(value, values)) {
+                return status::FAIL;
+            }
+            decoded += values;
+            ptr += value_bytes;
+        }
+    }
+
+    return status::OK;
+}
+
+// Unpack values 32*k to 32*k+31 of a bit-packed run, whose packed bytes start at group, into out.
+// Groups of fewer than 32 values end the run and are copied to a padded group first, so that nothing past the run is read.
+inline void unpack_hybrid_group(const uint8_t* group, int32_t bit_width, int32_t values, uint32_t* out) {
+    uint32_t padded[32];
+
+    if(values < 32) {
+        memset(padded, 0, sizeof(padded));
+        memcpy(padded, group, (values*bit_width + 7)/8);
+        group = (const uint8_t*) padded;
+    }
+    fastunpack((const uint*) group, out, bit_width);
+}
+
+}
@@ -18,13 +18,43 @@
 #include <map>
 #include <bitset>
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 #include "SWParquetReader.h"
+#include "DefinitionLevels.h"
 #include "ptoa.h"
 
 namespace ptoa {
 
-// Load Parquet file into memory
-SWParquetReader::SWParquetReader(std::string file_path) {
+// Owns the in-memory copy or the mapping of the Parquet file. Zero-copy arrays are slices of this buffer,
+// so the file data stays valid for as long as any of them is alive, even after the reader itself is destroyed.
+class FileBuffer : public arrow::Buffer {
+  public:
+    FileBuffer(uint8_t* data, int64_t size, bool mapped) : arrow::Buffer(data, size), mapped_(mapped) {}
+    ~FileBuffer() {
+        if(mapped_) {
+            munmap((void*) data(), size());
+        } else {
+            free((void*) data());
+        }
+    }
+
+  private:
+    bool mapped_;
+};
+
+// Load Parquet file into memory, either by copying it into a malloc'd buffer or by memory mapping it
+SWParquetReader::SWParquetReader(std::string file_path, load_mode mode) : parquet_data(nullptr), file_size(0), file_metadata_read(false) {
+    if(mode != load_mode::COPY) {
+        if(map_file(file_path, mode == load_mode::MMAP_POPULATE) == status::OK) {
+            return;
+        }
+        std::cerr << "[WARNING] Could not memory map " << file_path << ", falling back to copying it into memory" << std::endl;
+    }
+
     std::ifstream parquet_file(file_path, std::ios::binary);
     
     parquet_file.seekg(0, parquet_file.end);
@@ -36,183 +66,449 @@ SWParquetReader::SWParquetReader(std::string file_path) {
 
     parquet_file.close();
 
+    file_buffer = std::make_shared<FileBuffer>(parquet_data, file_size, false);
 }
 
-status SWParquetReader::read_prim(int32_t prim_width, int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, encoding enc) {
-    if(enc == encoding::PLAIN){
-        return read_prim_plain(prim_width, num_values, file_offset, prim_array);
-    } else if((enc == encoding::DELTA) && (prim_width == 32)){
+// Map the Parquet file read-only into the address space. Only the pages that are actually touched while decoding are read from disk.
+// With populate set the whole file is faulted in by the kernel before returning, which moves the I/O out of the first read call.
+status SWParquetReader::map_file(std::string file_path, bool populate) {
+    int fd = open(file_path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        return status::FAIL;
+    }
+
+    struct stat file_stat;
+    if((fstat(fd, &file_stat) != 0) || (file_stat.st_size == 0)) {
+        close(fd);
+        return status::FAIL;
+    }
+
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    if(populate) {
+        flags |= MAP_POPULATE;
+    }
+#else
+    (void) populate;
+#endif
+
+    void* mapping = mmap(nullptr, file_stat.st_size, PROT_READ, flags, fd, 0);
+    // The mapping keeps its own reference to the file
+    close(fd);
+
+    if(mapping == MAP_FAILED) {
+        return status::FAIL;
+    }
+
+    // Pages are decoded front to back, so ask for aggressive read-ahead. This is only a hint, failure is harmless.
+    madvise(mapping, file_stat.st_size, MADV_SEQUENTIAL);
+
+    parquet_data = (uint8_t*) mapping;
+    file_size = file_stat.st_size;
+    file_buffer = std::make_shared<FileBuffer>(parquet_data, file_size, true);
+
+    return status::OK;
+}
+
+// Physical type of the integers of prim_width bits that the width based read_prim calls read
+static status integer_type(int32_t prim_width, parquet_type* type) {
+    if(prim_width == 32) {
+        *type = parquet_type::INT32;
+    } else if(prim_width == 64) {
+        *type = parquet_type::INT64;
+    } else {
+        std::cerr << "[ERROR] Unsupported prim width " << prim_width << std::endl;
+        return status::FAIL;
+    }
+    return status::OK;
+}
+
+// Width in bits and Arrow type of the values of the physical types read_prim reads. BOOLEAN values are 1 bit wide.
+status SWParquetReader::prim_type_info(parquet_type type, int32_t* prim_width, std::shared_ptr<arrow::DataType>* arrow_type) {
+    switch(type) {
+        case parquet_type::BOOLEAN: *prim_width = 1; *arrow_type = arrow::boolean(); return status::OK;
+        case parquet_type::INT32: *prim_width = 32; *arrow_type = arrow::int32(); return status::OK;
+        case parquet_type::INT64: *prim_width = 64; *arrow_type = arrow::int64(); return status::OK;
+        case parquet_type::FLOAT: *prim_width = 32; *arrow_type = arrow::float32(); return status::OK;
+        case parquet_type::DOUBLE: *prim_width = 64; *arrow_type = arrow::float64(); return status::OK;
+        default:
+            std::cerr << "[ERROR] Unsupported primitive type " << (int32_t) type << std::endl;
+            return status::FAIL;
+    }
+}
+
+status SWParquetReader::read_prim(int32_t prim_width, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, encoding enc) {
+    parquet_type type;
+    if(integer_type(prim_width, &type) != status::OK) {
+        return status::FAIL;
+    }
+    return read_prim(type, num_values, file_offset, prim_array, enc);
+}
+
+status SWParquetReader::read_prim(int32_t prim_width, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer, encoding enc) {
+    parquet_type type;
+    if(integer_type(prim_width, &type) != status::OK) {
+        return status::FAIL;
+    }
+    return read_prim(type, num_values, file_offset, prim_array, arr_buffer, enc);
+}
+
+status SWParquetReader::read_prim_zero_copy(int32_t prim_width, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::ChunkedArray>* chunked_array, encoding enc) {
+    parquet_type type;
+    if(integer_type(prim_width, &type) != status::OK) {
+        return status::FAIL;
+    }
+    return read_prim_zero_copy(type, num_values, file_offset, chunked_array, enc);
+}
+
+// Read num_values values of physical type INT32, INT64, FLOAT, DOUBLE or BOOLEAN. BOOLEAN columns are read with encoding::PLAIN,
+// which also covers their RLE encoded pages.
+status SWParquetReader::read_prim(parquet_type type, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, encoding enc) {
+    if((type == parquet_type::BOOLEAN) && (enc == encoding::PLAIN)){
+        return read_prim_boolean(num_values, file_offset, prim_array);
+    } else if(type == parquet_type::BOOLEAN){
+        std::cout<<"Unsupported encoding selected, BOOLEAN values are read with PLAIN encoding" << std::endl;
+        return status::FAIL;
+    } else if(enc == encoding::PLAIN){
+        return read_prim_plain(type, num_values, file_offset, prim_array);
+    } else if((enc == encoding::DELTA) && (type == parquet_type::INT32)){
         return read_prim_delta32(num_values, file_offset, prim_array);
-    } else if((enc == encoding::DELTA) && (prim_width == 64)){
+    } else if((enc == encoding::DELTA) && (type == parquet_type::INT64)){
         return read_prim_delta64(num_values, file_offset, prim_array);
+    } else if(enc == encoding::DICTIONARY){
+        return read_prim_dictionary(type, num_values, file_offset, prim_array);
+    } else if(enc == encoding::BYTE_STREAM_SPLIT){
+        return read_prim_byte_stream_split(type, num_values, file_offset, prim_array);
     } else{
         std::cout<<"Unsupported encoding selected" << std::endl;
         return status::FAIL;
     }
 }
 
-status SWParquetReader::read_prim(int32_t prim_width, int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer, encoding enc) {
-    if(enc == encoding::PLAIN){
-        return read_prim_plain(prim_width, num_values, file_offset, prim_array, arr_buffer);
-    } else if((enc == encoding::DELTA) && (prim_width == 32)){
+status SWParquetReader::read_prim(parquet_type type, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer, encoding enc) {
+    if((type == parquet_type::BOOLEAN) && (enc == encoding::PLAIN)){
+        return read_prim_boolean(num_values, file_offset, prim_array, arr_buffer);
+    } else if(type == parquet_type::BOOLEAN){
+        std::cout<<"Unsupported encoding selected, BOOLEAN values are read with PLAIN encoding" << std::endl;
+        return status::FAIL;
+    } else if(enc == encoding::PLAIN){
+        return read_prim_plain(type, num_values, file_offset, prim_array, arr_buffer);
+    } else if((enc == encoding::DELTA) && (type == parquet_type::INT32)){
         return read_prim_delta32(num_values, file_offset, prim_array, arr_buffer);
-    } else if((enc == encoding::DELTA) && (prim_width == 64)){
+    } else if((enc == encoding::DELTA) && (type == parquet_type::INT64)){
         return read_prim_delta64(num_values, file_offset, prim_array, arr_buffer);
+    } else if(enc == encoding::DICTIONARY){
+        return read_prim_dictionary(type, num_values, file_offset, prim_array, arr_buffer);
+    } else if(enc == encoding::BYTE_STREAM_SPLIT){
+        return read_prim_byte_stream_split(type, num_values, file_offset, prim_array, arr_buffer);
     } else{
         std::cout<<"Unsupported encoding selected" << std::endl;
         return status::FAIL;
     }
 }
 
-status SWParquetReader::read_string(int64_t num_strings, int64_t num_chars, int32_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, encoding enc) {
-    if(enc == encoding::DELTA_LENGTH){
+status SWParquetReader::read_prim_zero_copy(parquet_type type, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::ChunkedArray>* chunked_array, encoding enc) {
+    if((enc == encoding::PLAIN) && (type != parquet_type::BOOLEAN)){
+        return read_prim_plain(type, num_values, file_offset, chunked_array);
+    } else{
+        std::cout<<"Unsupported encoding selected, zero-copy reading requires PLAIN encoding of fixed width values" << std::endl;
+        return status::FAIL;
+    }
+}
+
+status SWParquetReader::read_string(int64_t num_strings, int64_t num_chars, int64_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, encoding enc) {
+    if(enc == encoding::PLAIN){
+        return read_string_plain(num_strings, num_chars, file_offset, string_array);
+    } else if(enc == encoding::DELTA_LENGTH){
         return read_string_delta_length(num_strings, num_chars, file_offset, string_array);
+    } else if(enc == encoding::DICTIONARY){
+        return read_string_dictionary(num_strings, num_chars, file_offset, string_array);
+    } else if(enc == encoding::DELTA_BYTE_ARRAY){
+        return read_string_delta_byte_array(num_strings, num_chars, file_offset, string_array);
     } else{
         std::cout<<"Unsupported encoding selected" << std::endl;
         return status::FAIL;
     }
 }
-status SWParquetReader::read_string(int64_t num_strings, int32_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, std::shared_ptr<arrow::Buffer> off_buffer, std::shared_ptr<arrow::Buffer> val_buffer, encoding enc) {
-    if(enc == encoding::DELTA_LENGTH){
+status SWParquetReader::read_string(int64_t num_strings, int64_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, std::shared_ptr<arrow::Buffer> off_buffer, std::shared_ptr<arrow::Buffer> val_buffer, encoding enc) {
+    if(enc == encoding::PLAIN){
+        return read_string_plain(num_strings, file_offset, string_array, off_buffer, val_buffer);
+    } else if(enc == encoding::DELTA_LENGTH){
         return read_string_delta_length(num_strings, file_offset, string_array, off_buffer, val_buffer);
+    } else if(enc == encoding::DICTIONARY){
+        return read_string_dictionary(num_strings, file_offset, string_array, off_buffer, val_buffer);
+    } else if(enc == encoding::DELTA_BYTE_ARRAY){
+        return read_string_delta_byte_array(num_strings, file_offset, string_array, off_buffer, val_buffer);
     } else{
         std::cout<<"Unsupported encoding selected" << std::endl;
         return status::FAIL;
     }
 }
 
+// Read num_lists lists of a column with one level of repetition. The list elements are read like a flat column of type type, with
+// read_prim or read_string and encoding enc. The offsets and validity of the lists were decoded from the levels with the page index.
+status SWParquetReader::read_list(parquet_type type, int64_t num_lists, int64_t file_offset, std::shared_ptr<arrow::ListArray>* list_array, encoding enc) {
+    const page_index* index;
+    std::shared_ptr<arrow::Array> values;
+
+    if(get_page_index(file_offset, &index) != status::OK) {
+        return status::FAIL;
+    }
+
+    if(!index->has_lists()) {
+        std::cerr << "[ERROR] Pages at file offset " << file_offset << " do not hold a column with one level of repetition" << std::endl;
+        return status::FAIL;
+    } else if(index->num_lists() < num_lists) {
+        std::cerr << "[ERROR] Requested " << num_lists << " lists but the pages at file offset " << file_offset << " only hold " << index->num_lists() << std::endl;
+        return status::FAIL;
+    }
+
+    int64_t num_elements = index->list_offsets[num_lists];
 
-// Read a number (set by num_values) of either 32 or 64 bit integers (set by prim_width) into prim_array.
+    if(type == parquet_type::BYTE_ARRAY) {
+        std::shared_ptr<arrow::StringArray> string_array;
+        std::shared_ptr<arrow::Buffer> off_buffer;
+        std::shared_ptr<arrow::Buffer> val_buffer;
+        arrow::AllocateBuffer((num_elements+1)*sizeof(int32_t), &off_buffer);
+
+        // Only DELTA_LENGTH_BYTE_ARRAY strings need a value buffer up front, the pages hold all of their characters
+        if(enc == encoding::DELTA_LENGTH) {
+            int64_t num_chars = 0;
+            for(int32_t page = 0; page < index->pages_for_rows(num_elements); page++) {
+                num_chars += index->values_uncompressed_size(page);
+            }
+            arrow::AllocateBuffer(num_chars, &val_buffer);
+        }
+
+        if(read_string(num_elements, file_offset, &string_array, off_buffer, val_buffer, enc) != status::OK) {
+            return status::FAIL;
+        }
+        values = string_array;
+    } else {
+        std::shared_ptr<arrow::PrimitiveArray> prim_array;
+        if(read_prim(type, num_elements, file_offset, &prim_array, enc) != status::OK) {
+            return status::FAIL;
+        }
+        values = prim_array;
+    }
+
+    std::shared_ptr<arrow::Buffer> off_buffer;
+    arrow::AllocateBuffer((num_lists+1)*sizeof(int32_t), &off_buffer);
+    std::memcpy(off_buffer->mutable_data(), index->list_offsets.data(), (num_lists+1)*sizeof(int32_t));
+
+    std::shared_ptr<arrow::Buffer> null_bitmap;
+    int64_t null_count = 0;
+    if(index->num_null_lists > 0) {
+        null_count = num_lists - count_bits(index->list_validity.data(), 0, num_lists);
+    }
+    if(null_count > 0) {
+        arrow::AllocateBuffer((num_lists+7)/8, &null_bitmap);
+        std::memcpy(null_bitmap->mutable_data(), index->list_validity.data(), (num_lists+7)/8);
+    }
+
+    *list_array = std::make_shared<arrow::ListArray>(arrow::list(values->type()), num_lists, off_buffer, values, null_bitmap, null_count);
+
+    return status::OK;
+}
+
+
+// Decode with num_threads threads from now on. Pages are the unit of work, so only column chunks with many pages profit.
+void SWParquetReader::set_num_threads(int32_t num_threads) {
+    if(num_threads > 1) {
+        thread_pool.reset(new ThreadPool(num_threads));
+    } else {
+        thread_pool.reset();
+    }
+}
+
+// Run decode_page for pages 0 to num_pages-1, spread over the threads of the pool if there is one
+void SWParquetReader::for_each_page(int32_t num_pages, const std::function<void(int64_t)>& decode_page) {
+    if(thread_pool) {
+        thread_pool->parallel_for(num_pages, decode_page);
+    } else {
+        for(int32_t page = 0; page < num_pages; page++) {
+            decode_page(page);
+        }
+    }
+}
+
+// Nullable columns get a zeroed validity bitmap for num_values rows, which pages merge their validity bits into.
+// drop_empty_null_bitmap drops it again if the column turns out to hold no nulls, Arrow arrays without nulls need none.
+void SWParquetReader::allocate_null_bitmap(bool nullable, int64_t num_values, std::shared_ptr<arrow::Buffer>* null_bitmap) {
+    if(nullable) {
+        arrow::AllocateBuffer((num_values+7)/8, null_bitmap);
+        std::memset((*null_bitmap)->mutable_data(), 0, (*null_bitmap)->size());
+    }
+}
+
+void SWParquetReader::drop_empty_null_bitmap(int64_t null_count, std::shared_ptr<arrow::Buffer>* null_bitmap) {
+    if(null_count == 0) {
+        null_bitmap->reset();
+    }
+}
+
+// Read a number (set by num_values) of 32 or 64 bit integers or floating point values (set by type) into prim_array.
 // File_offset is the byte offset in the Parquet file where the first in a contiguous list of Parquet pages is located.
-status SWParquetReader::read_prim_plain(int32_t prim_width, int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array) {
-    uint8_t* page_ptr = parquet_data;
+status SWParquetReader::read_prim_plain(parquet_type type, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array) {
+    int32_t prim_width;
+    std::shared_ptr<arrow::DataType> arrow_type;
     std::shared_ptr<arrow::Buffer> arr_buffer;
+
+    if(prim_type_info(type, &prim_width, &arrow_type) != status::OK) {
+        return status::FAIL;
+    }
     arrow::AllocateBuffer(num_values*prim_width/8, &arr_buffer);
+
+    return read_prim_plain(type, num_values, file_offset, prim_array, arr_buffer);
+}
+
+// Same as read_prim but with a pre-allocated buffer
+status SWParquetReader::read_prim_plain(parquet_type type, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer) {
     uint8_t* arr_buf_ptr = arr_buffer->mutable_data();
+    int32_t prim_width;
+    std::shared_ptr<arrow::DataType> arrow_type;
+    const page_index* index;
 
-    int64_t total_value_counter = 0;
+    if((prim_type_info(type, &prim_width, &arrow_type) != status::OK) || (prim_width == 1)) {
+        std::cerr << "[ERROR] PLAIN values of type " << (int32_t) type << " are not read as fixed width values" << std::endl;
+        return status::FAIL;
+    }
 
-    // Metadata reading variables
-    int32_t uncompressed_size;
-    int32_t compressed_size;
-    int32_t page_num_values;
-    int32_t def_level_length;
-    int32_t rep_level_length;
-    int32_t metadata_size;
+    if(get_page_index(file_offset, num_values, &index) != status::OK) {
+        return status::FAIL;
+    }
+
+    std::shared_ptr<arrow::Buffer> null_bitmap;
+    int64_t null_count = 0;
+    allocate_null_bitmap(index->max_def_level > 0, num_values, &null_bitmap);
 
-    page_ptr += file_offset;
+    int64_t total_value_counter = 0;
 
     // Copy values from Parquet pages until max amount of values is reached
-    while(total_value_counter < num_values){
-        if(read_metadata(page_ptr, &uncompressed_size, &compressed_size, &page_num_values, &def_level_length, &rep_level_length, &metadata_size) != status::OK) {
-            std::cerr << "[ERROR] Corrupted data in Parquet page headers" << std::endl;
-            std::cerr << page_ptr-parquet_data << std::endl;
+    for(int32_t page = 0; total_value_counter < num_values; page++){
+        page_contents contents;
+        const uint8_t* validity_bits;
+        int32_t rows_to_read = std::min((int64_t) index->num_values[page], num_values-total_value_counter);
+        int32_t values_to_read = rows_to_read;
+
+        // Writers fall back from dictionary encoding page by page, the values of every page have to be PLAIN themselves
+        if(index->encodings[page] != parquet_encoding::PLAIN) {
+            std::cerr << "[ERROR] Page at file offset " << index->page_offsets[page] << " uses encoding " << (int32_t) index->encodings[page] << ", PLAIN reading requires PLAIN" << std::endl;
+            return status::FAIL;
+        }
+
+        if(get_page_contents(index, page, &contents) != status::OK) {
             return status::FAIL;
         }
 
-        page_ptr += metadata_size;
+        if(null_bitmap && (decode_page_validity(index, page, contents, total_value_counter, rows_to_read, null_bitmap->mutable_data(), &validity_bits, &values_to_read) != status::OK)) {
+            return status::FAIL;
+        }
     
-        std::memcpy((void*) arr_buf_ptr, (const void*) page_ptr, std::min((int64_t) compressed_size, (num_values-total_value_counter)*prim_width/8));
+        std::memcpy((void*) arr_buf_ptr, (const void*) contents.values, std::min((int64_t) contents.values_size, (int64_t) values_to_read*prim_width/8));
+
+        // Pages only store the values of non-null rows, move them out to their rows
+        if(values_to_read < rows_to_read) {
+            null_count += rows_to_read - values_to_read;
+            if(prim_width == 64) {
+                scatter_to_valid((int64_t*) arr_buf_ptr, validity_bits, total_value_counter % 8, rows_to_read, values_to_read);
+            } else {
+                scatter_to_valid((int32_t*) arr_buf_ptr, validity_bits, total_value_counter % 8, rows_to_read, values_to_read);
+            }
+        }
     
-        page_ptr += compressed_size;
-        arr_buf_ptr += compressed_size;
-        total_value_counter += page_num_values;
+        arr_buf_ptr += (int64_t) rows_to_read*prim_width/8;
+        total_value_counter += index->num_values[page];
 
 
     }
 
-    if(prim_width == 64){
-        *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow::int64(), num_values, arr_buffer);
-    } else if (prim_width == 32) {
-        *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow::int32(), num_values, arr_buffer);
-    } else {
-        std::cerr << "[ERROR] Unsupported prim width " << prim_width << std::endl;
-    }
+    drop_empty_null_bitmap(null_count, &null_bitmap);
+
+    *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow_type, num_values, arr_buffer, null_bitmap, null_count);
 
     return status::OK;
 
 }
 
-// Same as read_prim but with a pre-allocated buffer
-status SWParquetReader::read_prim_plain(int32_t prim_width, int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer) {
-    uint8_t* page_ptr = parquet_data;
-    uint8_t* arr_buf_ptr = arr_buffer->mutable_data();
+// Same as read_prim but without copying. Every page becomes one chunk of chunked_array whose value buffer is a slice of the
+// file buffer. The file data is kept alive by these slices, so the arrays stay valid after the reader is destroyed.
+// Page bodies start at arbitrary byte offsets in the file, so the value buffers are in general not aligned to the value width.
+status SWParquetReader::read_prim_plain(parquet_type type, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::ChunkedArray>* chunked_array) {
+    arrow::ArrayVector chunks;
+    int32_t prim_width;
+    std::shared_ptr<arrow::DataType> arrow_type;
+    const page_index* index;
+
+    if((prim_type_info(type, &prim_width, &arrow_type) != status::OK) || (prim_width == 1)) {
+        std::cerr << "[ERROR] PLAIN values of type " << (int32_t) type << " are not read as fixed width values" << std::endl;
+        return status::FAIL;
+    }
+
+    if(get_page_index(file_offset, num_values, &index) != status::OK) {
+        return status::FAIL;
+    }
+
+    // Pages of nullable columns hold levels in front of the values and skip the values of nulls
+    if(index->max_def_level > 0) {
+        std::cerr << "[ERROR] Column at file offset " << file_offset << " is nullable, zero-copy reading requires a required column" << std::endl;
+        return status::FAIL;
+    }
 
     int64_t total_value_counter = 0;
 
-    // Metadata reading variables
-    int32_t uncompressed_size;
-    int32_t compressed_size;
-    int32_t page_num_values;
-    int32_t def_level_length;
-    int32_t rep_level_length;
-    int32_t metadata_size;
+    // Wrap Parquet pages until max amount of values is reached
+    for(int32_t page = 0; total_value_counter < num_values; page++){
+        int64_t chunk_values = std::min((int64_t) index->num_values[page], num_values-total_value_counter);
 
-    page_ptr += file_offset;
+        if(index->encodings[page] != parquet_encoding::PLAIN) {
+            std::cerr << "[ERROR] Page at file offset " << index->page_offsets[page] << " uses encoding " << (int32_t) index->encodings[page] << ", zero-copy reading requires PLAIN" << std::endl;
+            return status::FAIL;
+        }
 
-    // Copy values from Parquet pages until max amount of values is reached
-    while(total_value_counter < num_values){
-        if(read_metadata(page_ptr, &uncompressed_size, &compressed_size, &page_num_values, &def_level_length, &rep_level_length, &metadata_size) != status::OK) {
-            std::cerr << "[ERROR] Corrupted data in Parquet page headers" << std::endl;
-            std::cerr << page_ptr-parquet_data << std::endl;
+        if(index->values_compressed[page]) {
+            std::cerr << "[ERROR] Page at file offset " << index->page_offsets[page] << " is compressed, zero-copy reading requires uncompressed pages" << std::endl;
             return status::FAIL;
         }
 
-        page_ptr += metadata_size;
-    
-        std::memcpy((void*) arr_buf_ptr, (const void*) page_ptr, std::min((int64_t) compressed_size, (num_values-total_value_counter)*prim_width/8));
-    
-        page_ptr += compressed_size;
-        arr_buf_ptr += compressed_size;
-        total_value_counter += page_num_values;
+        // The page body has to hold the values themselves
+        if((int64_t) index->values_size(page) < chunk_values*prim_width/8) {
+            std::cerr << "[ERROR] Page at file offset " << index->page_offsets[page] << " is too small to hold its values" << std::endl;
+            return status::FAIL;
+        }
 
+        std::shared_ptr<arrow::Buffer> chunk_buffer = arrow::SliceBuffer(file_buffer, index->values_offset(page), chunk_values*prim_width/8);
+        chunks.push_back(std::make_shared<arrow::PrimitiveArray>(arrow_type, chunk_values, chunk_buffer));
 
+        total_value_counter += index->num_values[page];
     }
 
-    if(prim_width == 64){
-        *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow::int64(), num_values, arr_buffer);
-    } else if (prim_width == 32) {
-        *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow::int32(), num_values, arr_buffer);
-    } else {
-        std::cerr << "[ERROR] Unsupported prim width " << prim_width << std::endl;
-    }
+    *chunked_array = std::make_shared<arrow::ChunkedArray>(chunks, arrow_type);
 
     return status::OK;
 
 }
 
 // Count pages and provide information about their sizes starting with the page at file_offset
-status SWParquetReader::count_pages(int32_t file_offset) {
-    uint8_t* page_ptr = parquet_data;
+status SWParquetReader::count_pages(int64_t file_offset) {
+    const page_index* index;
 
-    // Metadata reading variables
-    int32_t uncompressed_size;
-    int32_t compressed_size;
-    int32_t page_num_values;
-    int32_t def_level_length;
-    int32_t rep_level_length;
-    int32_t metadata_size;
-
-    page_ptr += file_offset;
+    if(get_page_index(file_offset, &index) != status::OK) {
+        return status::FAIL;
+    }
 
-    int32_t page_ctr = 0;
+    int32_t page_ctr = index->num_pages();
     int32_t column_chunk_size = 0;
     std::map<int32_t, int32_t> size_map;
     std::map<int32_t, int32_t> value_map;
 
-    // Read Parquet pages until either the end of the file is reached or a non PageHeader Thrift structure.
-    while((uint64_t)(page_ptr-parquet_data) < file_size){
-        if(read_metadata(page_ptr, &uncompressed_size, &compressed_size, &page_num_values, &def_level_length, &rep_level_length, &metadata_size) != status::OK) {
-            break;
-        }
-//		printf("Found page at offset 0x%x (file size 0x%x)\n", page_ptr-parquet_data, file_size);
-//		printf("uncompressed_size %d, compressed_size %d, page_num_values %d, def_level_length 0x%x, rep_level_length 0x%x, metadata_size %d\n",
-//				uncompressed_size,    compressed_size,    page_num_values,    def_level_length,      rep_level_length,      metadata_size);
+    for(int32_t page = 0; page < page_ctr; page++){
+        int32_t compressed_size = index->compressed_sizes[page];
+        int32_t page_num_values = index->num_values[page];
 
-        page_ptr += metadata_size;    
-        page_ptr += compressed_size;
+//		printf("Found page at offset 0x%lx (file size 0x%lx)\n", index->page_offsets[page], file_size);
+//		printf("compressed_size %d, page_num_values %d, metadata_size %d\n", compressed_size, page_num_values, index->header_sizes[page]);
 
-        page_ctr++;
         auto size_it = size_map.find(compressed_size);
         if(size_it != size_map.end()) {
             size_it->second++;
@@ -227,7 +523,7 @@ status SWParquetReader::count_pages(int32_t file_offset) {
             value_map.insert(std::make_pair(page_num_values, 1));
         }
 
-        column_chunk_size += metadata_size + compressed_size;
+        column_chunk_size += index->header_sizes[page] + compressed_size;
     }
 
     //std::cout << "Page sizes: " << std::endl;
@@ -293,303 +589,27 @@ int SWParquetReader::decode_varint64(const uint8_t* input, int64_t* decoded_int,
     return i+1;
 }
 
-status SWParquetReader::inspect_metadata(int32_t file_offset) {
-    // Metadata reading variables
-    int32_t uncompressed_size;
-    int32_t compressed_size;
-    int32_t page_num_values;
-    int32_t def_level_length;
-    int32_t rep_level_length;
-    int32_t metadata_size;
+status SWParquetReader::inspect_metadata(int64_t file_offset) {
+    page_header header;
 
-    if(read_metadata(parquet_data + file_offset, &uncompressed_size, &compressed_size, &page_num_values, &def_level_length, &rep_level_length, &metadata_size) != status::OK) {
+    if((file_offset < 0) || (file_offset >= (int64_t) file_size)
+            || (read_page_header(parquet_data + file_offset, parquet_data + file_size, &header) != status::OK)) {
         std::cerr << "[ERROR] Page header at file offset " << file_offset << " corrupted or missing." << std::endl;
         return status::FAIL;
     }
 
     std::cout << "Page header fields at file offset " << file_offset << ":" << std::endl;
-    std::cout << "    Uncompressed size: " << uncompressed_size << std::endl;
-    std::cout << "    Compressed size: " << compressed_size << std::endl;
-    std::cout << "    Page num values: " << page_num_values << std::endl;
-    std::cout << "    Def level length: " << def_level_length << std::endl;
-    std::cout << "    rep_level_length: " << rep_level_length << std::endl;
-    std::cout << "    metadata_size: " << metadata_size << std::endl;
+    std::cout << "    Page type: " << (int32_t) header.type << std::endl;
+    std::cout << "    Uncompressed size: " << header.uncompressed_size << std::endl;
+    std::cout << "    Compressed size: " << header.compressed_size << std::endl;
+    std::cout << "    Page num values: " << header.num_values << std::endl;
+    std::cout << "    Encoding: " << (int32_t) header.encoding << std::endl;
+    std::cout << "    Def level length: " << header.def_level_length << std::endl;
+    std::cout << "    rep_level_length: " << header.rep_level_length << std::endl;
+    std::cout << "    metadata_size: " << header.header_size << std::endl;
     std::cout << std::endl;
     
     return status::OK;
 }
 
-// Read all relevant fields from the Parquet page header pointed to by uint8_t* metadata.
-status SWParquetReader::read_metadata(const uint8_t* metadata, int32_t* uncompressed_size, int32_t* compressed_size, int32_t* num_values, 
-                                      int32_t* def_level_length, int32_t* rep_level_length, int32_t* metadata_size) {
-
-    const uint8_t* current_byte = metadata;
-
-    // PageType
-    if(*current_byte != 0x15){
-//        std::cerr<<"PageType error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    while((*current_byte & 0x80) != 0 ){
-        current_byte++;
-    }
-
-    current_byte++;
-
-    //Uncompressed page size
-    if(*current_byte != 0x15){
-//        std::cerr<<"uncompressed_size error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    current_byte += decode_varint32(current_byte, uncompressed_size, true);
-
-    //Compressed page size
-    if(*current_byte != 0x15){
-//        std::cerr<<"compressed_size error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    current_byte += decode_varint32(current_byte, compressed_size, true);
-
-    //CRC
-    int data_page_field_header = 0x2c;
-
-    if(*current_byte == 0x15){
-        current_byte++;
-
-        while((*current_byte & 0x80) != 0 ){
-           current_byte++;
-        };
-
-        current_byte++;
-        data_page_field_header = 0x1c;
-    }
-
-    //DataPageHeader
-    if(*current_byte != data_page_field_header){
-//        fprintf(stderr, "datapagev2 error: found 0x%x instead of 0x%x\n", *current_byte, data_page_field_header);
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    //Num values
-    if(*current_byte != 0x15){
-//        std::cerr<<"numval error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    current_byte += decode_varint32(current_byte, num_values, true);
-
-    //Encoding
-    if(*current_byte != 0x15){
-//        std::cerr<<"encoding error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    while((*current_byte & 0x80) != 0 ){
-        current_byte++;
-    }
-
-    current_byte++;
-
-    //Definition level encoding
-    if(*current_byte != 0x15){
-//        std::cerr<<"def_level encoding error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    while((*current_byte & 0x80) != 0 ){
-        current_byte++;
-    }
-
-    current_byte++;
-
-    //Repetition level encoding
-    if(*current_byte != 0x15){
-//        std::cerr<<"enc_level encoding error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    while((*current_byte & 0x80) != 0 ){
-        current_byte++;
-    }
-
-    current_byte++;
-
-    //Skip stop bytes
-    current_byte += 2;
-
-    *metadata_size = current_byte - metadata;
-
-
-    return status::OK;
-
-}
-
-// Read all relevant fields from the Parquet page header pointed to by uint8_t* metadata.
-status SWParquetReader::read_metadata_v2(const uint8_t* metadata, int32_t* uncompressed_size, int32_t* compressed_size, int32_t* num_values,
-                                      int32_t* def_level_length, int32_t* rep_level_length, int32_t* metadata_size) {
-
-    const uint8_t* current_byte = metadata;
-
-    // PageType
-    if(*current_byte != 0x15){
-//        std::cerr<<"PageType error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    while((*current_byte & 0x80) != 0 ){
-        current_byte++;
-    }
-
-    current_byte++;
-
-    //Uncompressed page size
-    if(*current_byte != 0x15){
-//        std::cerr<<"uncompressed_size error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    current_byte += decode_varint32(current_byte, uncompressed_size, true);
-
-    //Compressed page size
-    if(*current_byte != 0x15){
-//        std::cerr<<"compressed_size error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    current_byte += decode_varint32(current_byte, compressed_size, true);
-
-    //CRC
-    int data_page_v2_field_header = 0x5c;
-
-    if(*current_byte == 0x15){
-        current_byte++;
-
-        while((*current_byte & 0x80) != 0 ){
-           current_byte++;
-        };
-
-        current_byte++;
-        data_page_v2_field_header = 0x4c;
-    }
-
-    //DataPageHeaderV2
-    if(*current_byte != data_page_v2_field_header){
-//        std::cerr<<"datapagev2 error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    //Num values
-    if(*current_byte != 0x15){
-//        std::cerr<<"numval error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    current_byte += decode_varint32(current_byte, num_values, true);
-
-    //Num nulls
-    if(*current_byte != 0x15){
-//        std::cerr<<"num_null error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    while((*current_byte & 0x80) != 0 ){
-        current_byte++;
-    }
-
-    current_byte++;
-
-    //Num rows
-    if(*current_byte != 0x15){
-//        std::cerr<<"numrow error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    while((*current_byte & 0x80) != 0 ){
-        current_byte++;
-    }
-
-    current_byte++;
-
-    //Encoding
-    if(*current_byte != 0x15){
-//        std::cerr<<"enc error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    while((*current_byte & 0x80) != 0 ){
-        current_byte++;
-    }
-
-    current_byte++;
-
-    //Def level byte length
-    if(*current_byte != 0x15){
-//        std::cerr<<"def_level_length error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    current_byte += decode_varint32(current_byte, def_level_length, true);
-
-    //rep level byte length
-    if(*current_byte != 0x15){
-//        std::cerr<<"rep_level_length error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    current_byte += decode_varint32(current_byte, rep_level_length, true);
-
-    //is_compressed
-    if((*current_byte == 0x11) || (*current_byte == 0x12)) {
-        current_byte++;
-    }
-
-    //Skip stop bytes
-    current_byte += 2;
-
-    *metadata_size = current_byte - metadata;
-
-
-    return status::OK;
-
-}
-
 }
@@ -15,56 +15,324 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <algorithm>
+
 #include <arrow/api.h>
 #include <arrow/io/api.h>
 #include <parquet/properties.h>
 #include <parquet/types.h>
 
 #include "ptoa.h"
+#include "PageHeader.h"
+#include "ThreadPool.h"
+#include "FilterKernels.h"
+#include "AggregateKernels.h"
 
-#define BLOCK_SIZE 128
-#define MINIBLOCKS_IN_BLOCK 4
+// Upper bound on the miniblock count in a DELTA_BINARY_PACKED header, which sizes the bit width arrays on the stack
+#define MAX_MINIBLOCKS_IN_BLOCK 256
 
 namespace ptoa{
 
+// Leaf column of the file schema
+struct column_info {
+    std::string path;               // Dot separated path in the schema
+    parquet_type type;
+    int32_t type_length;            // Byte width of FIXED_LEN_BYTE_ARRAY columns
+    int32_t decimal_precision;      // 0 if the column is not a DECIMAL
+    int32_t decimal_scale;
+    repetition_type repetition;
+    int16_t max_def_level;
+    int16_t max_rep_level;
+    int16_t repeated_def_level;     // Definition level of the innermost repeated field, 0 for flat columns
+};
+
+// Location and layout of one column chunk, as recorded in the footer
+struct column_chunk_info {
+    int64_t data_page_offset;
+    int64_t dictionary_page_offset; // -1 if the chunk has no dictionary page
+    int64_t total_compressed_size;  // Including page headers and dictionary page
+    int64_t total_uncompressed_size;
+    int64_t num_values;
+    parquet_type type;
+    compression_codec codec;
+    uint32_t encodings;             // Bit set of parquet_encoding values used in the chunk
+    value_statistics statistics;    // Of all values in the chunk, pointing into the footer
+    int64_t column_index_offset;    // Location of the ColumnIndex and OffsetIndex of the chunk, -1 if the writer wrote none
+    int32_t column_index_length;
+    int64_t offset_index_offset;
+    int32_t offset_index_length;
+
+    bool has_encoding(parquet_encoding enc) const {return (encodings >> (int32_t)enc) & 1;}
+    // Offset of the first page in the chunk, which is the dictionary page if there is one
+    int64_t chunk_offset() const {return dictionary_page_offset >= 0 ? dictionary_page_offset : data_page_offset;}
+};
+
+struct row_group_info {
+    int64_t num_rows;
+    int64_t first_row;              // Index of the first row of this row group in the file
+};
+
+// Compact catalog of the FileMetaData footer. Column chunks are stored row group major in one flat vector.
+struct file_metadata {
+    int64_t num_rows;
+    std::vector<column_info> columns;
+    std::vector<row_group_info> row_groups;
+    std::vector<column_chunk_info> column_chunks;
+
+    int32_t num_columns() const {return columns.size();}
+    int32_t num_row_groups() const {return row_groups.size();}
+    const column_chunk_info& column_chunk(int32_t row_group, int32_t column) const {return column_chunks[row_group*columns.size() + column];}
+};
+
+// Location of the dictionary page of a column chunk
+struct dictionary_page_info {
+    int64_t page_offset;                    // File offset of the page header, -1 if the chunk has no dictionary page
+    int32_t header_size;
+    int32_t compressed_size;
+    int32_t uncompressed_size;
+    int32_t num_values;
+
+    dictionary_page_info() : page_offset(-1), header_size(0), compressed_size(0), uncompressed_size(0), num_values(0) {}
+
+    int64_t data_offset() const {return page_offset + header_size;}
+};
+
+// Offsets and sizes of all data pages in a column chunk, built in one pass over the page headers.
+// Stored as struct of arrays so that searches over one field only touch that field.
+struct page_index {
+    std::vector<int64_t> page_offsets;      // File offset of the page header
+    std::vector<int32_t> header_sizes;
+    std::vector<int32_t> compressed_sizes;
+    std::vector<int32_t> uncompressed_sizes;
+    std::vector<page_type> page_types;      // DATA_PAGE or DATA_PAGE_V2
+    std::vector<parquet_encoding> encodings; // Of the values
+    std::vector<int32_t> level_sizes;       // Uncompressed levels in front of the values of version 2 pages, 0 for version 1 pages
+    std::vector<int32_t> def_level_sizes;   // Definition levels, the last part of the levels of version 2 pages
+    std::vector<bool> values_compressed;    // Whether the values have to be decompressed with the codec of the column chunk
+    std::vector<int32_t> num_values;
+    std::vector<int64_t> first_rows;        // Cumulative row count before each page, with the total row count as last element
+    std::vector<value_statistics> statistics; // From the page headers, pointing into them
+    dictionary_page_info dictionary;
+    bool has_nulls;                         // Set if a version 2 page reports nulls, version 1 pages do not tell
+    compression_codec codec;                // Codec of the column chunk
+    int16_t max_def_level;                  // Of the column, 0 (required) if no footer describes the column chunk
+    int16_t max_rep_level;
+    int16_t repeated_def_level;             // Definition level of the innermost repeated field, 0 for flat columns
+
+    // Columns with one level of repetition only, decoded from the levels when the index is built. first_rows and num_values
+    // then count list elements, which are what the values in the pages belong to, so the flat readers read the list elements.
+    std::vector<int32_t> list_offsets;      // Offsets of all lists into the elements, with the element count as last element
+    std::vector<uint8_t> list_validity;     // Validity bitmap of all lists
+    std::vector<uint8_t> element_validity;  // Validity bitmap of all elements
+    int64_t num_null_lists;
+
+    page_index() : has_nulls(false), codec(compression_codec::UNCOMPRESSED), max_def_level(0), max_rep_level(0), repeated_def_level(0), num_null_lists(0) {}
+
+    int32_t num_pages() const {return page_offsets.size();}
+    bool has_dictionary() const {return dictionary.page_offset >= 0;}
+    bool has_lists() const {return !list_offsets.empty();}
+    int64_t num_lists() const {return (int64_t) list_offsets.size() - 1;}
+    bool dictionary_encoded(int32_t page) const {return (encodings[page] == parquet_encoding::RLE_DICTIONARY) || (encodings[page] == parquet_encoding::PLAIN_DICTIONARY);}
+    int64_t total_rows() const {return first_rows.back();}
+    // Offset of the first byte after the page header
+    int64_t page_data_offset(int32_t page) const {return page_offsets[page] + header_sizes[page];}
+    // Offset and size of the encoded values, which follow the levels
+    int64_t values_offset(int32_t page) const {return page_data_offset(page) + level_sizes[page];}
+    int32_t values_size(int32_t page) const {return compressed_sizes[page] - level_sizes[page];}
+    int32_t values_uncompressed_size(int32_t page) const {return uncompressed_sizes[page] - level_sizes[page];}
+    // Offset of the definition levels of version 2 pages, which follow the repetition levels
+    int64_t def_levels_offset(int32_t page) const {return page_data_offset(page) + level_sizes[page] - def_level_sizes[page];}
+    // Amount of pages, counted from the first, that hold the first num_rows rows
+    int32_t pages_for_rows(int64_t num_rows) const {return std::lower_bound(first_rows.begin(), first_rows.end(), num_rows) - first_rows.begin();}
+    // Page holding row row, which has to be below total_rows()
+    int32_t page_for_row(int64_t row) const {return std::upper_bound(first_rows.begin(), first_rows.end(), row) - first_rows.begin() - 1;}
+};
+
+// Parts of a data page, ready to decode. def_levels is nullptr for required columns, rep_levels for columns that are not repeated.
+struct page_contents {
+    const uint8_t* rep_levels;
+    int32_t rep_levels_size;
+    const uint8_t* def_levels;
+    int32_t def_levels_size;
+    const uint8_t* values;
+    int32_t values_size;
+};
+
+// Values of a dictionary page, decoded into Arrow buffers so that they can serve as the dictionary of a DictionaryArray as well
+struct dictionary_values {
+    int32_t num_values;
+    std::shared_ptr<arrow::Buffer> values;  // Fixed width values, or the characters of BYTE_ARRAY values followed by 16 bytes of padding
+    std::shared_ptr<arrow::Buffer> offsets; // BYTE_ARRAY only, num_values+1 offsets into the characters
+    std::vector<int32_t> lengths;           // BYTE_ARRAY only, the string lengths
+
+    dictionary_values() : num_values(0) {}
+};
+
+// Rows first_row to first_row+num_rows-1
+struct row_range {
+    int64_t first_row;
+    int64_t num_rows;
+};
+
+// Condition on the values of an INT32, INT64 or BYTE_ARRAY column, used to skip pages whose statistics rule out a match.
+// Integer predicates hold their operands in ints, string predicates in strings, which compare as unsigned bytes.
+// LESS, LESS_EQUAL and EQUAL take one operand, BETWEEN two, the inclusive bounds, and IN any amount. Nulls never match.
+struct predicate {
+    predicate_op op;
+    bool on_strings;
+    std::vector<int64_t> ints;
+    std::vector<std::string> strings;
+
+    predicate(predicate_op op, std::vector<int64_t> ints) : op(op), on_strings(false), ints(ints) {}
+    predicate(predicate_op op, std::vector<std::string> strings) : op(op), on_strings(true), strings(strings) {}
+
+    size_t num_operands() const {return on_strings ? strings.size() : ints.size();}
+};
+
+// Converts n fixed width values of width bytes at in to their Arrow layout at out
+typedef void (*fixed_converter)(const uint8_t* in, int32_t width, int32_t n, uint8_t* out);
+
+// Block layout of a DELTA_BINARY_PACKED page, as read from its header
+struct delta_geometry {
+    int32_t block_size;
+    int32_t miniblocks_in_block;
+    int32_t total_value_count;
+
+    int32_t miniblock_values() const {return block_size/miniblocks_in_block;}
+};
+
 /**
  * Class that implements as fast as possible Parquet reading functionality equivalent to that of the hardware.
  */
 class SWParquetReader {
   public:
-    SWParquetReader(std::string file_path);
-    ~SWParquetReader(){free(parquet_data);}
-    status read_prim(int32_t prim_width, int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, encoding enc);
-    status read_prim(int32_t prim_width, int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer, encoding enc);
-    status read_string(int64_t num_strings, int64_t num_chars, int32_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, encoding enc);
-    status read_string(int64_t num_strings, int32_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, std::shared_ptr<arrow::Buffer> off_buffer , std::shared_ptr<arrow::Buffer> val_buffer, encoding enc);
-    status inspect_metadata(int32_t file_offset);
-    status count_pages(int32_t file_offset);
+    SWParquetReader(std::string file_path, load_mode mode = load_mode::COPY);
+    SWParquetReader(const SWParquetReader&) = delete;
+    SWParquetReader& operator=(const SWParquetReader&) = delete;
+    status read_prim(int32_t prim_width, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, encoding enc);
+    status read_prim(int32_t prim_width, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer, encoding enc);
+    status read_prim_zero_copy(int32_t prim_width, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::ChunkedArray>* chunked_array, encoding enc);
+    status read_prim(parquet_type type, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, encoding enc);
+    status read_prim(parquet_type type, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer, encoding enc);
+    status read_prim_zero_copy(parquet_type type, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::ChunkedArray>* chunked_array, encoding enc);
+    status read_fixed_len(int32_t type_length, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::FixedSizeBinaryArray>* fixed_array, encoding enc);
+    status read_fixed_len(int32_t type_length, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::FixedSizeBinaryArray>* fixed_array, std::shared_ptr<arrow::Buffer> arr_buffer, encoding enc);
+    status read_decimal(int32_t type_length, int32_t precision, int32_t scale, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::Decimal128Array>* decimal_array, encoding enc);
+    status read_decimal(int32_t type_length, int32_t precision, int32_t scale, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::Decimal128Array>* decimal_array, std::shared_ptr<arrow::Buffer> arr_buffer, encoding enc);
+    status read_int96_timestamp(int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, encoding enc);
+    status read_int96_timestamp(int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer, encoding enc);
+    status read_string(int64_t num_strings, int64_t num_chars, int64_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, encoding enc);
+    status read_string(int64_t num_strings, int64_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, std::shared_ptr<arrow::Buffer> off_buffer , std::shared_ptr<arrow::Buffer> val_buffer, encoding enc);
+    status get_file_metadata(const file_metadata** metadata);
+    status get_column_chunk(int32_t row_group, int32_t column, const column_chunk_info** chunk);
+    status read_column_prim(int32_t row_group, int32_t column, std::shared_ptr<arrow::PrimitiveArray>* prim_array);
+    status read_column_string(int32_t row_group, int32_t column, std::shared_ptr<arrow::StringArray>* string_array);
+    status read_column_fixed_len(int32_t row_group, int32_t column, std::shared_ptr<arrow::FixedSizeBinaryArray>* fixed_array);
+    status read_list(parquet_type type, int64_t num_lists, int64_t file_offset, std::shared_ptr<arrow::ListArray>* list_array, encoding enc);
+    status read_column_list(int32_t row_group, int32_t column, std::shared_ptr<arrow::ListArray>* list_array);
+    status read_rows(parquet_type type, int64_t first_row, int64_t num_rows, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array);
+    status read_column_rows(int32_t column, int64_t first_row, int64_t num_rows, std::shared_ptr<arrow::PrimitiveArray>* prim_array);
+    status read_column_rows(int32_t column, const std::vector<row_range>& ranges, std::shared_ptr<arrow::PrimitiveArray>* prim_array);
+    status select_rows(int32_t column, const predicate& pred, std::vector<row_range>* ranges);
+    status select_prim(int32_t prim_width, int64_t num_values, int64_t file_offset, const predicate& pred, std::shared_ptr<arrow::Buffer>* selection, int64_t* num_selected, encoding enc);
+    status filter_prim(int32_t prim_width, int64_t num_values, int64_t file_offset, const predicate& pred, std::shared_ptr<arrow::PrimitiveArray>* prim_array, encoding enc);
+    status aggregate_prim(int32_t prim_width, int64_t num_values, int64_t file_offset, value_aggregate* aggregate, encoding enc);
+    status aggregate_column(int32_t column, value_aggregate* aggregate);
+    status read_dictionary(parquet_type type, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::DictionaryArray>* dict_array);
+    status read_column_dictionary(int32_t row_group, int32_t column, std::shared_ptr<arrow::DictionaryArray>* dict_array);
+    status inspect_metadata(int64_t file_offset);
+    status count_pages(int64_t file_offset);
+    void set_num_threads(int32_t num_threads);
+    status get_page_index(int64_t file_offset, const page_index** index);
 
   private:
-  	status read_metadata(const uint8_t* metadata, int32_t* uncompressed_size, int32_t* compressed_size, int32_t* num_values, int32_t* def_level_length, int32_t* rep_level_length, int32_t* metadata_size);
-  	status read_metadata_v2(const uint8_t* metadata, int32_t* uncompressed_size, int32_t* compressed_size, int32_t* num_values, int32_t* def_level_length, int32_t* rep_level_length, int32_t* metadata_size);
-    status read_delta_header32(const uint8_t* header, int32_t* first_value, int32_t* header_size);
-    status read_block_header32(const uint8_t* header, int32_t* min_delta, uint8_t* bitwidths, int32_t* header_size);
-    status read_delta_header64(const uint8_t* header, int64_t* first_value, int32_t* header_size);
-    status read_block_header64(const uint8_t* header, int64_t* min_delta, uint8_t* bitwidths, int32_t* header_size);
+    status read_delta_geometry(const uint8_t* header, delta_geometry* geometry, int32_t* geometry_size);
+    status read_delta_header32(const uint8_t* header, delta_geometry* geometry, int32_t* first_value, int32_t* header_size);
+    status read_block_header32(const uint8_t* header, int32_t miniblocks_in_block, int32_t* min_delta, uint8_t* bitwidths, int32_t* header_size);
+    status read_delta_header64(const uint8_t* header, delta_geometry* geometry, int64_t* first_value, int32_t* header_size);
+    status read_block_header64(const uint8_t* header, int32_t miniblocks_in_block, int64_t* min_delta, uint8_t* bitwidths, int32_t* header_size);
 
     
-    status read_prim_plain(int32_t prim_width, int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array);
-    status read_prim_plain(int32_t prim_width, int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer);
-    status read_prim_delta32(int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array);
-    status read_prim_delta32(int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer);
-    status read_prim_delta64(int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array);
-    status read_prim_delta64(int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer);
-    status read_string_delta_length(int64_t num_strings, int64_t num_chars, int32_t file_offset, std::shared_ptr<arrow::StringArray>* string_array);
-    status read_string_delta_length(int64_t num_strings, int32_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, std::shared_ptr<arrow::Buffer> off_buffer, std::shared_ptr<arrow::Buffer> val_buffer);
+    static status prim_type_info(parquet_type type, int32_t* prim_width, std::shared_ptr<arrow::DataType>* arrow_type);
+    status read_prim_plain(parquet_type type, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array);
+    status read_prim_plain(parquet_type type, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer);
+    status read_prim_plain(parquet_type type, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::ChunkedArray>* chunked_array);
+    status read_prim_boolean(int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array);
+    status read_prim_boolean(int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer);
+    status read_prim_byte_stream_split(parquet_type type, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array);
+    status read_prim_byte_stream_split(parquet_type type, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer);
+    status read_prim_delta32(int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array);
+    status read_prim_delta32(int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer);
+    status read_prim_delta64(int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array);
+    status read_prim_delta64(int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer);
+    status decode_delta_page32(const uint8_t* page_data, const uint8_t* data_end, int32_t page_values_to_read, int32_t* arr_buf_ptr);
+    status decode_delta_page64(const uint8_t* page_data, const uint8_t* data_end, int32_t page_values_to_read, int64_t* arr_buf_ptr);
+    template<int32_t miniblocks_in_block, int32_t miniblock_values>
+    status decode_delta_blocks32(const uint8_t* block_ptr, const uint8_t* data_end, const delta_geometry& geometry, int32_t page_values_to_read, int32_t* arr_buf_ptr);
+    template<int32_t miniblocks_in_block, int32_t miniblock_values>
+    status decode_delta_blocks64(const uint8_t* block_ptr, const uint8_t* data_end, const delta_geometry& geometry, int32_t page_values_to_read, int64_t* arr_buf_ptr);
+    status read_string_delta_length(int64_t num_strings, int64_t num_chars, int64_t file_offset, std::shared_ptr<arrow::StringArray>* string_array);
+    status read_string_delta_length(int64_t num_strings, int64_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, std::shared_ptr<arrow::Buffer> off_buffer, std::shared_ptr<arrow::Buffer> val_buffer);
+    status read_string_delta_byte_array(int64_t num_strings, int64_t num_chars, int64_t file_offset, std::shared_ptr<arrow::StringArray>* string_array);
+    status read_string_delta_byte_array(int64_t num_strings, int64_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, std::shared_ptr<arrow::Buffer> off_buffer, std::shared_ptr<arrow::Buffer> val_buffer);
+    status decode_delta_stream32(const uint8_t* data, const uint8_t* data_end, int32_t n, int32_t* out, const uint8_t** stream_end);
+    status filter_delta_pages(int32_t prim_width, int64_t num_values, int64_t file_offset, const value_filter& filter,
+                              uint8_t* selection, std::vector<std::vector<uint8_t>>* page_matches, int64_t* num_matches);
+    status filter_delta_page32(const uint8_t* page_data, const uint8_t* data_end, int32_t n, const value_filter& filter, uint8_t* selection, int32_t* out, int32_t* num_matches);
+    status filter_delta_page64(const uint8_t* page_data, const uint8_t* data_end, int32_t n, const value_filter& filter, uint8_t* selection, int64_t* out, int32_t* num_matches);
+    status aggregate_prim_delta(int32_t prim_width, int64_t num_values, int64_t file_offset, value_aggregate* aggregate);
+    status aggregate_delta_page32(const uint8_t* page_data, const uint8_t* data_end, int32_t n, value_aggregate* aggregate);
+    status aggregate_delta_page64(const uint8_t* page_data, const uint8_t* data_end, int32_t n, value_aggregate* aggregate);
+    status read_string_plain(int64_t num_strings, int64_t num_chars, int64_t file_offset, std::shared_ptr<arrow::StringArray>* string_array);
+    status read_string_plain(int64_t num_strings, int64_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, std::shared_ptr<arrow::Buffer> off_buffer, std::shared_ptr<arrow::Buffer> val_buffer);
+    status read_string_pages(const page_index* index, const dictionary_values* dictionary, int64_t num_strings, std::shared_ptr<arrow::StringArray>* string_array, std::shared_ptr<arrow::Buffer> off_buffer, std::shared_ptr<arrow::Buffer> val_buffer);
+    status read_prim_dictionary(parquet_type type, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array);
+    status read_prim_dictionary(parquet_type type, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer);
+    status read_string_dictionary(int64_t num_strings, int64_t num_chars, int64_t file_offset, std::shared_ptr<arrow::StringArray>* string_array);
+    status read_string_dictionary(int64_t num_strings, int64_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, std::shared_ptr<arrow::Buffer> off_buffer, std::shared_ptr<arrow::Buffer> val_buffer);
+    status read_dictionary_indices(const page_index* index, int32_t dictionary_size, int64_t num_values, int32_t* indices, std::shared_ptr<arrow::Buffer>* null_bitmap, int64_t* null_count);
+    status read_dictionary_page(const page_index* index, int32_t value_width, dictionary_values* dictionary);
+    status decode_rows(const page_index* index, int32_t value_bytes, int64_t first_row, int64_t num_rows, uint8_t* out, uint8_t* validity, int64_t out_row, int64_t* null_count);
+    status read_fixed_pages(const page_index* index, int64_t num_values, int32_t value_width, int32_t out_width, fixed_converter convert, encoding enc,
+                            uint8_t* out, std::shared_ptr<arrow::Buffer>* null_bitmap, int64_t* null_count);
 
 
     int decode_varint32(const uint8_t* input, int32_t* result, bool zigzag);
     int decode_varint64(const uint8_t* input, int64_t* result, bool zigzag);
 
+    status map_file(std::string file_path, bool populate);
+    status read_file_metadata();
+    status build_page_index(int64_t file_offset, page_index* index);
+    status decode_list_levels(page_index* index);
+    status get_page_index(int64_t file_offset, int64_t num_values, const page_index** index);
+    status select_chunk_rows(int32_t row_group, int32_t column, const predicate& pred, std::vector<row_range>* ranges);
+    status get_page_contents(const page_index* index, int32_t page, page_contents* contents);
+    void for_each_page(int32_t num_pages, const std::function<void(int64_t)>& decode_page);
+    static void allocate_null_bitmap(bool nullable, int64_t num_values, std::shared_ptr<arrow::Buffer>* null_bitmap);
+    static void drop_empty_null_bitmap(int64_t null_count, std::shared_ptr<arrow::Buffer>* null_bitmap);
+    status get_dictionary_page_values(const page_index* index, std::vector<uint8_t>* buffer, const uint8_t** values, int32_t* values_size);
+    status decode_page_validity(const page_index* index, int32_t page, const page_contents& contents, int64_t first_row, int32_t num_rows, uint8_t* validity, const uint8_t** bits, int32_t* valid_count);
+    static bool codec_supported(compression_codec codec);
+
   	uint8_t* parquet_data;
   	size_t file_size;
+    // Owns parquet_data and acts as parent buffer for zero-copy arrays
+    std::shared_ptr<arrow::Buffer> file_buffer;
+
+    // Parsed lazily from the footer on first use
+    bool file_metadata_read;
+    file_metadata metadata;
+
+    // Page indices of the column chunks read so far, keyed by the offset of their first page
+    std::map<int64_t, page_index> page_indices;
+
+    // Workers for page parallel decoding, nullptr when decoding single threaded
+    std::unique_ptr<ThreadPool> thread_pool;
 };
 
 }
@@ -0,0 +1,322 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <climits>
+
+#include "SWParquetReader.h"
+#include "DeltaKernels.h"
+#include "AggregateKernels.h"
+#include "DefinitionLevels.h"
+#include "ptoa.h"
+
+namespace ptoa {
+
+// Validity bits of the page a thread aggregates last, only decoded to count the nulls
+static thread_local std::vector<uint8_t> aggregate_validity;
+
+// Add the n values prev + min_delta, prev + 2*min_delta, ..., prev + n*min_delta of a miniblock with bit width 0 to aggregate.
+// Their sum is n*prev + min_delta*n*(n+1)/2 and their minimum and maximum are the first and the last of them, unless the values
+// wrap around on the way. Returns false without adding anything in that case. last is set to the last value.
+static bool aggregate_series32(int32_t prev, int32_t min_delta, int32_t n, value_aggregate* aggregate, int32_t* last) {
+    int64_t first_value = (int64_t) prev + min_delta;
+    int64_t last_value = (int64_t) prev + (int64_t) min_delta*n;
+
+    if((last_value < INT32_MIN) || (last_value > INT32_MAX)) {
+        return false;
+    }
+
+    aggregate->count += n;
+    aggregate->sum = (int64_t) ((uint64_t) aggregate->sum + (uint64_t) ((int64_t) n*prev + (int64_t) min_delta*((int64_t) n*(n+1)/2)));
+    aggregate->min = std::min(aggregate->min, std::min(first_value, last_value));
+    aggregate->max = std::max(aggregate->max, std::max(first_value, last_value));
+    *last = (int32_t) last_value;
+
+    return true;
+}
+
+static bool aggregate_series64(int64_t prev, int64_t min_delta, int32_t n, value_aggregate* aggregate, int64_t* last) {
+    int64_t span;
+    int64_t last_value;
+
+    if(__builtin_mul_overflow(min_delta, (int64_t) n, &span) || __builtin_add_overflow(prev, span, &last_value)) {
+        return false;
+    }
+
+    // Without overflow of the last value none of the others overflows either, the sum wraps around like all sums do
+    int64_t first_value = prev + min_delta;
+    aggregate->count += n;
+    aggregate->sum = (int64_t) ((uint64_t) aggregate->sum + (uint64_t) n*(uint64_t) prev + (uint64_t) min_delta*(uint64_t) ((int64_t) n*(n+1)/2));
+    aggregate->min = std::min(aggregate->min, std::min(first_value, last_value));
+    aggregate->max = std::max(aggregate->max, std::max(first_value, last_value));
+    *last = last_value;
+
+    return true;
+}
+
+// Aggregate the first n values of the DELTA_BINARY_PACKED encoded page at page_data, which must end before data_end.
+// Miniblocks of bit width 0, which constant steps like row numbers and timestamps of fixed intervals compress to, are added in
+// closed form. All others are decoded MINIBLOCK_VALUES values at a time into a buffer on the stack and reduced right away.
+status SWParquetReader::aggregate_delta_page32(const uint8_t* page_data, const uint8_t* data_end, int32_t n, value_aggregate* aggregate){
+    const uint8_t* block_ptr = page_data;
+    delta_geometry geometry;
+    int32_t miniblock_values;
+    int32_t previous_value;
+    int32_t min_delta;
+    uint8_t bitwidths[MAX_MINIBLOCKS_IN_BLOCK];
+    int32_t header_size;
+    int32_t values[MINIBLOCK_VALUES];
+
+    if(read_delta_header32(block_ptr, &geometry, &previous_value, &header_size) != status::OK) {
+        return status::FAIL;
+    }
+    block_ptr += header_size;
+    miniblock_values = geometry.miniblock_values();
+
+    if(n > geometry.total_value_count) {
+        std::cerr << "[ERROR] Delta stream holds " << geometry.total_value_count << " values, " << n << " expected" << std::endl;
+        return status::FAIL;
+    }
+
+    if(n > 0) {
+        values[0] = previous_value;
+        aggregate_values32(values, 1, aggregate);
+    }
+
+    int32_t value_counter = 1;
+    while(value_counter < n) {
+        read_block_header32(block_ptr, geometry.miniblocks_in_block, &min_delta, bitwidths, &header_size);
+        block_ptr += header_size;
+
+        for(int i=0; (i<geometry.miniblocks_in_block) && (value_counter<n); i++) {
+            uint8_t current_bitwidth = bitwidths[i];
+            const uint8_t* next_miniblock = block_ptr + current_bitwidth*(miniblock_values/8);
+            int32_t values_to_aggregate = std::min(miniblock_values, n-value_counter);
+            if((current_bitwidth > 32) || (next_miniblock > data_end)) {
+                std::cerr << "[ERROR] Corrupt DELTA_BINARY_PACKED miniblock" << std::endl;
+                return status::FAIL;
+            }
+
+            if((current_bitwidth == 0) && aggregate_series32(previous_value, min_delta, values_to_aggregate, aggregate, &previous_value)) {
+                value_counter += values_to_aggregate;
+                block_ptr = next_miniblock;
+                continue;
+            }
+
+            for(int32_t j = 0; j < values_to_aggregate; j += MINIBLOCK_VALUES) {
+                const uint8_t* chunk = block_ptr + (j/8)*current_bitwidth;
+                int32_t chunk_values = std::min(MINIBLOCK_VALUES, values_to_aggregate-j);
+
+                if(miniblock_values - j < MINIBLOCK_VALUES) {
+                    previous_value = delta_unpack_short_miniblock32(chunk, current_bitwidth, miniblock_values-j, min_delta, previous_value, values, chunk_values);
+                } else {
+                    previous_value = delta_unpack_miniblock32(chunk, current_bitwidth, min_delta, previous_value, values, chunk_values);
+                }
+                aggregate_values32(values, chunk_values, aggregate);
+            }
+            value_counter += values_to_aggregate;
+            block_ptr = next_miniblock;
+        }
+    }
+
+    return status::OK;
+}
+
+status SWParquetReader::aggregate_delta_page64(const uint8_t* page_data, const uint8_t* data_end, int32_t n, value_aggregate* aggregate){
+    const uint8_t* block_ptr = page_data;
+    delta_geometry geometry;
+    int32_t miniblock_values;
+    int64_t previous_value;
+    int64_t min_delta;
+    uint8_t bitwidths[MAX_MINIBLOCKS_IN_BLOCK];
+    int32_t header_size;
+    int64_t values[MINIBLOCK_VALUES];
+
+    if(read_delta_header64(block_ptr, &geometry, &previous_value, &header_size) != status::OK) {
+        return status::FAIL;
+    }
+    block_ptr += header_size;
+    miniblock_values = geometry.miniblock_values();
+
+    if(n > geometry.total_value_count) {
+        std::cerr << "[ERROR] Delta stream holds " << geometry.total_value_count << " values, " << n << " expected" << std::endl;
+        return status::FAIL;
+    }
+
+    if(n > 0) {
+        values[0] = previous_value;
+        aggregate_values64(values, 1, aggregate);
+    }
+
+    int32_t value_counter = 1;
+    while(value_counter < n) {
+        read_block_header64(block_ptr, geometry.miniblocks_in_block, &min_delta, bitwidths, &header_size);
+        block_ptr += header_size;
+
+        for(int i=0; (i<geometry.miniblocks_in_block) && (value_counter<n); i++) {
+            uint8_t current_bitwidth = bitwidths[i];
+            const uint8_t* next_miniblock = block_ptr + current_bitwidth*(miniblock_values/8);
+            int32_t values_to_aggregate = std::min(miniblock_values, n-value_counter);
+            if((current_bitwidth > 64) || (next_miniblock > data_end)) {
+                std::cerr << "[ERROR] Corrupt DELTA_BINARY_PACKED miniblock" << std::endl;
+                return status::FAIL;
+            }
+
+            if((current_bitwidth == 0) && aggregate_series64(previous_value, min_delta, values_to_aggregate, aggregate, &previous_value)) {
+                value_counter += values_to_aggregate;
+                block_ptr = next_miniblock;
+                continue;
+            }
+
+            for(int32_t j = 0; j < values_to_aggregate; j += MINIBLOCK_VALUES) {
+                const uint8_t* chunk = block_ptr + (j/8)*current_bitwidth;
+                int32_t chunk_values = std::min(MINIBLOCK_VALUES, values_to_aggregate-j);
+
+                if(miniblock_values - j < MINIBLOCK_VALUES) {
+                    previous_value = delta_unpack_short_miniblock64(chunk, current_bitwidth, miniblock_values-j, min_delta, previous_value, values, chunk_values);
+                } else {
+                    previous_value = delta_unpack_miniblock64(chunk, current_bitwidth, min_delta, previous_value, values, chunk_values);
+                }
+                aggregate_values64(values, chunk_values, aggregate);
+            }
+            value_counter += values_to_aggregate;
+            block_ptr = next_miniblock;
+        }
+    }
+
+    return status::OK;
+}
+
+// Aggregate the first num_values values of the DELTA_BINARY_PACKED column chunk at file_offset into aggregate, page parallel.
+// Every page starts with its own first value, so pages are aggregated independently and their aggregates merged afterwards.
+// Nulls are only counted, from the definition levels.
+status SWParquetReader::aggregate_prim_delta(int32_t prim_width, int64_t num_values, int64_t file_offset, value_aggregate* aggregate){
+    const page_index* index;
+
+    if(get_page_index(file_offset, num_values, &index) != status::OK) {
+        return status::FAIL;
+    } else if(index->has_lists()) {
+        std::cerr << "[ERROR] Aggregating values of repeated columns is not supported" << std::endl;
+        return status::FAIL;
+    }
+
+    int32_t num_pages = index->pages_for_rows(num_values);
+    std::vector<value_aggregate> page_aggregates(num_pages);
+    std::atomic<bool> failed(false);
+
+    std::function<void(int64_t)> aggregate_page = [&](int64_t page){
+        int64_t first_row = index->first_rows[page];
+        int32_t page_rows_to_read = std::min((int64_t) index->num_values[page], num_values-first_row);
+        int32_t page_values_to_read = page_rows_to_read;
+
+        // The chunk encodings only tell that some page is delta encoded, pages of any other encoding cannot be aggregated here
+        if(index->encodings[page] != parquet_encoding::DELTA_BINARY_PACKED) {
+            std::cerr << "[ERROR] Page at file offset " << index->page_offsets[page] << " uses encoding " << (int32_t) index->encodings[page] << ", aggregating requires DELTA_BINARY_PACKED" << std::endl;
+            failed = true;
+            return;
+        }
+
+        page_contents contents;
+        if(get_page_contents(index, page, &contents) != status::OK) {
+            failed = true;
+            return;
+        }
+
+        // Only the values of non-null rows are stored in the page
+        if(index->max_def_level > 0) {
+            size_t validity_size = validity_buffer_size(page_rows_to_read, 0);
+            if(aggregate_validity.size() < validity_size) {
+                aggregate_validity.resize(validity_size);
+            }
+            if(decode_def_levels(contents.def_levels, contents.def_levels_size, index->max_def_level, page_rows_to_read, aggregate_validity.data(), 0, &page_values_to_read) != status::OK) {
+                std::cerr << "[ERROR] Corrupt definition levels in page at file offset " << index->page_offsets[page] << std::endl;
+                failed = true;
+                return;
+            }
+        }
+
+        value_aggregate* page_aggregate = &page_aggregates[page];
+        page_aggregate->null_count = page_rows_to_read - page_values_to_read;
+
+        status decoded = prim_width == 32
+            ? aggregate_delta_page32(contents.values, contents.values + contents.values_size, page_values_to_read, page_aggregate)
+            : aggregate_delta_page64(contents.values, contents.values + contents.values_size, page_values_to_read, page_aggregate);
+        if(decoded != status::OK) {
+            failed = true;
+        }
+    };
+
+    for_each_page(num_pages, aggregate_page);
+
+    if(failed) {
+        return status::FAIL;
+    }
+
+    for(const value_aggregate& page_aggregate : page_aggregates) {
+        aggregate->merge(page_aggregate);
+    }
+
+    return status::OK;
+}
+
+// Compute SUM, MIN, MAX and COUNT of the first num_values values of the INT32 or INT64 column chunk at file_offset straight
+// from its pages, without reading the values into an array. The aggregates are added to those already in aggregate, so that
+// the chunks of a column can be aggregated one after the other. Only DELTA_BINARY_PACKED encoded chunks can be aggregated this way.
+status SWParquetReader::aggregate_prim(int32_t prim_width, int64_t num_values, int64_t file_offset, value_aggregate* aggregate, encoding enc) {
+    if((prim_width != 32) && (prim_width != 64)) {
+        std::cerr << "[ERROR] Unsupported prim width " << prim_width << std::endl;
+        return status::FAIL;
+    } else if(enc != encoding::DELTA){
+        std::cout<<"Unsupported encoding selected, aggregating requires DELTA encoding" << std::endl;
+        return status::FAIL;
+    }
+
+    return aggregate_prim_delta(prim_width, num_values, file_offset, aggregate);
+}
+
+// Aggregate all values of an INT32 or INT64 column, over all row groups, into aggregate
+status SWParquetReader::aggregate_column(int32_t column, value_aggregate* aggregate) {
+    const file_metadata* footer;
+    const column_chunk_info* chunk;
+
+    if(get_file_metadata(&footer) != status::OK) {
+        return status::FAIL;
+    }
+
+    *aggregate = value_aggregate();
+
+    for(int32_t row_group = 0; row_group < footer->num_row_groups(); row_group++) {
+        if(get_column_chunk(row_group, column, &chunk) != status::OK) {
+            return status::FAIL;
+        }
+
+        if((chunk->type != parquet_type::INT32) && (chunk->type != parquet_type::INT64)) {
+            std::cerr << "[ERROR] Column " << column << " is not an INT32 or INT64 column" << std::endl;
+            return status::FAIL;
+        } else if(!chunk->has_encoding(parquet_encoding::DELTA_BINARY_PACKED)) {
+            std::cerr << "[ERROR] Column chunk (" << row_group << ", " << column << ") is not DELTA_BINARY_PACKED encoded" << std::endl;
+            return status::FAIL;
+        }
+
+        if(aggregate_prim(chunk->type == parquet_type::INT32 ? 32 : 64, chunk->num_values, chunk->data_page_offset, aggregate, encoding::DELTA) != status::OK) {
+            return status::FAIL;
+        }
+    }
+
+    return status::OK;
+}
+
+}
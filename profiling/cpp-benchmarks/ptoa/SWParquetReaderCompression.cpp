@@ -0,0 +1,200 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include <zstd.h>
+#include <lz4.h>
+
+#include "SWParquetReader.h"
+#include "Snappy.h"
+#include "ptoa.h"
+
+namespace ptoa {
+
+// Slack behind the decompressed values. It lets the Snappy decompressor copy in whole chunks up to the end
+// and covers decoders that load a few bytes past the last value.
+const size_t DECOMPRESSION_BUFFER_PADDING = SNAPPY_OUTPUT_PADDING;
+
+// Initial size of the decompression buffers. Common page sizes fit, so the buffer of a thread, which is reused for
+// every page that thread decodes, normally stays within its core's L2 cache.
+const size_t DECOMPRESSION_BUFFER_SIZE = 1 << 20;
+
+// Everything a thread needs to decompress pages, created on first use and kept until the thread exits, so that
+// neither the output buffer nor the ZSTD context is allocated per page. Being per thread, page parallel decoding
+// needs no locking. Pages are decoded right after they were decompressed, while they are still in the cache,
+// instead of decompressing the whole column chunk first.
+struct decompression_context {
+    std::vector<uint8_t> buffer;
+    ZSTD_DCtx* zstd;
+
+    decompression_context() : zstd(nullptr) {}
+    ~decompression_context() {ZSTD_freeDCtx(zstd);}
+};
+
+static thread_local decompression_context context;
+
+static const char* codec_name(compression_codec codec) {
+    switch(codec) {
+        case compression_codec::SNAPPY: return "Snappy";
+        case compression_codec::ZSTD: return "ZSTD";
+        case compression_codec::LZ4_RAW: return "LZ4";
+        default: return "unknown";
+    }
+}
+
+bool SWParquetReader::codec_supported(compression_codec codec) {
+    return (codec == compression_codec::UNCOMPRESSED) || (codec == compression_codec::SNAPPY)
+        || (codec == compression_codec::ZSTD) || (codec == compression_codec::LZ4_RAW);
+}
+
+// Decompress in into out, which is exactly the uncompressed size given by the page header
+static status decompress(compression_codec codec, const uint8_t* in, int32_t in_size, uint8_t* out, int32_t out_size, size_t out_capacity) {
+    switch(codec) {
+        case compression_codec::SNAPPY:
+            return snappy_decompress(in, in_size, out, out_size, out_capacity);
+        case compression_codec::ZSTD: {
+            if(!context.zstd) {
+                context.zstd = ZSTD_createDCtx();
+                if(!context.zstd) {
+                    return status::FAIL;
+                }
+            }
+            size_t result = ZSTD_decompressDCtx(context.zstd, out, out_capacity, in, in_size);
+            return (!ZSTD_isError(result) && (result == (size_t) out_size)) ? status::OK : status::FAIL;
+        }
+        case compression_codec::LZ4_RAW:
+            return LZ4_decompress_safe((const char*) in, (char*) out, in_size, out_size) == out_size ? status::OK : status::FAIL;
+        default:
+            return status::FAIL;
+    }
+}
+
+// Locate the levels and encoded values of a page. Uncompressed pages are read straight from the file, compressed
+// ones are decompressed into the calling thread's buffer, which stays valid until its next call for a compressed page.
+// Version 1 pages of nullable columns store their definition levels, prefixed with their 4 byte length, in front of the
+// values and compressed together with them, version 2 pages store them uncompressed in front of the compressed part.
+status SWParquetReader::get_page_contents(const page_index* index, int32_t page, page_contents* contents) {
+    const uint8_t* page_data = parquet_data + index->values_offset(page);
+    int32_t page_size = index->values_size(page);
+
+    if(index->values_compressed[page]) {
+        if(!codec_supported(index->codec)) {
+            std::cerr << "[ERROR] Unsupported compression codec " << (int32_t) index->codec << std::endl;
+            return status::FAIL;
+        }
+
+        int32_t uncompressed_size = index->values_uncompressed_size(page);
+
+        size_t buffer_size = std::max(uncompressed_size + DECOMPRESSION_BUFFER_PADDING, DECOMPRESSION_BUFFER_SIZE);
+        if(context.buffer.size() < buffer_size) {
+            context.buffer.resize(buffer_size);
+        }
+
+        if(decompress(index->codec, page_data, page_size, context.buffer.data(), uncompressed_size, context.buffer.size()) != status::OK) {
+            std::cerr << "[ERROR] Corrupt " << codec_name(index->codec) << " data in page at file offset " << index->page_offsets[page] << std::endl;
+            return status::FAIL;
+        }
+
+        page_data = context.buffer.data();
+        page_size = uncompressed_size;
+    }
+
+    contents->rep_levels = nullptr;
+    contents->rep_levels_size = 0;
+    contents->def_levels = nullptr;
+    contents->def_levels_size = 0;
+
+    // Version 1 pages hold the repetition levels in front of the definition levels, both preceded by their length
+    if(index->max_rep_level > 0) {
+        if(index->page_types[page] == page_type::DATA_PAGE_V2) {
+            contents->rep_levels = parquet_data + index->page_data_offset(page);
+            contents->rep_levels_size = index->level_sizes[page] - index->def_level_sizes[page];
+        } else {
+            uint32_t levels_size;
+            if(page_size < 4) {
+                std::cerr << "[ERROR] Page at file offset " << index->page_offsets[page] << " is too small to hold its repetition levels" << std::endl;
+                return status::FAIL;
+            }
+            std::memcpy(&levels_size, page_data, 4);
+            if(levels_size > (uint32_t) (page_size - 4)) {
+                std::cerr << "[ERROR] Page at file offset " << index->page_offsets[page] << " is too small to hold its repetition levels" << std::endl;
+                return status::FAIL;
+            }
+            contents->rep_levels = page_data + 4;
+            contents->rep_levels_size = levels_size;
+            page_data += 4 + levels_size;
+            page_size -= 4 + levels_size;
+        }
+    }
+
+    if(index->max_def_level > 0) {
+        if(index->page_types[page] == page_type::DATA_PAGE_V2) {
+            contents->def_levels = parquet_data + index->def_levels_offset(page);
+            contents->def_levels_size = index->def_level_sizes[page];
+        } else {
+            uint32_t levels_size;
+            if(page_size < 4) {
+                std::cerr << "[ERROR] Page at file offset " << index->page_offsets[page] << " is too small to hold its definition levels" << std::endl;
+                return status::FAIL;
+            }
+            std::memcpy(&levels_size, page_data, 4);
+            if(levels_size > (uint32_t) (page_size - 4)) {
+                std::cerr << "[ERROR] Page at file offset " << index->page_offsets[page] << " is too small to hold its definition levels" << std::endl;
+                return status::FAIL;
+            }
+            contents->def_levels = page_data + 4;
+            contents->def_levels_size = levels_size;
+            page_data += 4 + levels_size;
+            page_size -= 4 + levels_size;
+        }
+    }
+
+    contents->values = page_data;
+    contents->values_size = page_size;
+
+    return status::OK;
+}
+
+// Locate the values of the dictionary page, which are compressed with the codec of the column chunk, if any.
+// Compressed dictionaries are decompressed into buffer instead of the thread's buffer, so that they stay valid while data pages are decoded.
+status SWParquetReader::get_dictionary_page_values(const page_index* index, std::vector<uint8_t>* buffer, const uint8_t** values, int32_t* values_size) {
+    const dictionary_page_info& dictionary = index->dictionary;
+
+    if(index->codec == compression_codec::UNCOMPRESSED) {
+        *values = parquet_data + dictionary.data_offset();
+        *values_size = dictionary.compressed_size;
+        return status::OK;
+    }
+
+    if(!codec_supported(index->codec)) {
+        std::cerr << "[ERROR] Unsupported compression codec " << (int32_t) index->codec << std::endl;
+        return status::FAIL;
+    }
+
+    buffer->resize(dictionary.uncompressed_size + DECOMPRESSION_BUFFER_PADDING);
+
+    if(decompress(index->codec, parquet_data + dictionary.data_offset(), dictionary.compressed_size, buffer->data(), dictionary.uncompressed_size, buffer->size()) != status::OK) {
+        std::cerr << "[ERROR] Corrupt " << codec_name(index->codec) << " data in dictionary page at file offset " << dictionary.page_offset << std::endl;
+        return status::FAIL;
+    }
+
+    *values = buffer->data();
+    *values_size = dictionary.uncompressed_size;
+
+    return status::OK;
+}
+
+}
@@ -16,72 +16,70 @@
 #include <cstring>
 #include <algorithm>
 #include <map>
-#include <cassert>
+#include <atomic>
+#include <functional>
+#include <climits>
 
 #include "SWParquetReader.h"
-#include "LemireBitUnpacking.h"
+#include "DeltaKernels.h"
+#include "DefinitionLevels.h"
 #include "ptoa.h"
 
 namespace ptoa {
 
 
-status SWParquetReader::read_prim_delta32(int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array){
+status SWParquetReader::read_prim_delta32(int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array){
     const int32_t prim_width = 32;
 
     std::shared_ptr<arrow::Buffer> arr_buffer;
     arrow::AllocateBuffer(num_values*prim_width/8, &arr_buffer);
 
-    read_prim_delta32(num_values, file_offset, prim_array, arr_buffer);
-
-    return status::OK;
+    return read_prim_delta32(num_values, file_offset, prim_array, arr_buffer);
 }
 
-status SWParquetReader::read_prim_delta64(int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array){
+status SWParquetReader::read_prim_delta64(int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array){
     const int32_t prim_width = 64;
 
     std::shared_ptr<arrow::Buffer> arr_buffer;
     arrow::AllocateBuffer(num_values*prim_width/8, &arr_buffer);
 
-    read_prim_delta64(num_values, file_offset, prim_array, arr_buffer);
-
-    return status::OK;
+    return read_prim_delta64(num_values, file_offset, prim_array, arr_buffer);
 }
 
-status SWParquetReader::read_string_delta_length(int64_t num_strings, int64_t num_chars, int32_t file_offset, std::shared_ptr<arrow::StringArray>* string_array){
+status SWParquetReader::read_string_delta_length(int64_t num_strings, int64_t num_chars, int64_t file_offset, std::shared_ptr<arrow::StringArray>* string_array){
     std::shared_ptr<arrow::Buffer> off_buffer;
     arrow::AllocateBuffer((num_strings+1)*sizeof(int32_t), &off_buffer);
 
     std::shared_ptr<arrow::Buffer> val_buffer;
     arrow::AllocateBuffer(num_chars, &val_buffer);
 
-    read_string_delta_length(num_strings, file_offset, string_array, off_buffer, val_buffer);
-
-    return status::OK;
+    return read_string_delta_length(num_strings, file_offset, string_array, off_buffer, val_buffer);
 }
 
-status SWParquetReader::read_string_delta_length(int64_t num_strings, int32_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, std::shared_ptr<arrow::Buffer> off_buffer, std::shared_ptr<arrow::Buffer> val_buffer){
-    uint8_t* page_ptr = parquet_data;
+status SWParquetReader::read_string_delta_length(int64_t num_strings, int64_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, std::shared_ptr<arrow::Buffer> off_buffer, std::shared_ptr<arrow::Buffer> val_buffer){
     int32_t* off_buf_ptr = (int32_t*)off_buffer->mutable_data();
     int8_t* val_buf_ptr = (int8_t*)val_buffer->mutable_data();
 
     int32_t total_value_counter = 0;
     int32_t page_value_counter = 0;
 
-    // Metadata reading variables
-    int32_t uncompressed_size;
-    int32_t compressed_size;
+    // Page reading variables
+    const page_index* index;
+    int32_t page = 0;
     int32_t page_num_values;
-    int32_t def_level_length;
-    int32_t rep_level_length;
-    int32_t metadata_size;
+    int32_t page_rows_to_read;
+    page_contents contents;
+    const uint8_t* validity_bits;
+    const uint8_t* page_end;
 
     // Delta/block header reading variables
     int32_t page_values_to_read;
-    uint8_t* block_ptr;
+    const uint8_t* block_ptr;
+    delta_geometry geometry;
+    int32_t miniblock_values;
     int32_t min_delta;
-    uint8_t* bitwidths = (uint8_t*)std::malloc(MINIBLOCKS_IN_BLOCK*sizeof(uint8_t));
+    uint8_t bitwidths[MAX_MINIBLOCKS_IN_BLOCK];
     int32_t header_size;
-    uint32_t* unpacked_deltas = (uint32_t*)std::malloc((BLOCK_SIZE/MINIBLOCKS_IN_BLOCK)*sizeof(uint32_t));
 
     //Keep track of amount of chars to read
     uint32_t chars_to_read;
@@ -97,25 +95,48 @@ status SWParquetReader::read_string_delta_length(int64_t num_strings, int32_t fi
     off_buf_ptr[0] = 0;
     off_buf_ptr++;
 
-    page_ptr += file_offset;
+    if(get_page_index(file_offset, num_strings, &index) != status::OK) {
+        return status::FAIL;
+    }
+
+    std::shared_ptr<arrow::Buffer> null_bitmap;
+    int64_t null_count = 0;
+    allocate_null_bitmap(index->max_def_level > 0, num_strings, &null_bitmap);
 
     // Decode values from Parquet pages until max amount of values is reached
     while(total_value_counter < num_strings){
         page_value_counter = 0;
 
-        // Read page metadata
-        if(read_metadata(page_ptr, &uncompressed_size, &compressed_size, &page_num_values, &def_level_length, &rep_level_length, &metadata_size) != status::OK) {
-            std::cerr << "[ERROR] Corrupted data in Parquet page headers" << std::endl;
-            std::cerr << page_ptr-parquet_data << std::endl;
+        // Look up page in the page index
+        if(get_page_contents(index, page, &contents) != status::OK) {
+            return status::FAIL;
+        }
+        block_ptr = contents.values;
+        page_end = contents.values + contents.values_size;
+        page_rows_to_read = std::min(index->num_values[page], (int32_t)(num_strings-total_value_counter));
+        page_values_to_read = page_rows_to_read;
+
+        if(null_bitmap && (decode_page_validity(index, page, contents, total_value_counter, page_rows_to_read, null_bitmap->mutable_data(), &validity_bits, &page_values_to_read) != status::OK)) {
             return status::FAIL;
         }
-        page_ptr += metadata_size;
-        block_ptr = page_ptr;
-        page_values_to_read = std::min(page_num_values, (int32_t)(num_strings-total_value_counter));
 
-        // Read delta header
-        read_delta_header32(block_ptr, &string_length, &header_size);
+        // Pages holding nothing but nulls have no lengths and no characters
+        if(page_values_to_read == 0) {
+            null_count += page_rows_to_read;
+            scatter_offsets_to_valid(off_buf_ptr, validity_bits, total_value_counter % 8, page_rows_to_read, 0, current_offset);
+            off_buf_ptr += page_rows_to_read;
+            total_value_counter += index->num_values[page];
+            page++;
+            continue;
+        }
+
+        // Read delta header, which holds the amount of lengths in the page, one per non-null string
+        if(read_delta_header32(block_ptr, &geometry, &string_length, &header_size) != status::OK) {
+            return status::FAIL;
+        }
         block_ptr += header_size;
+        miniblock_values = geometry.miniblock_values();
+        page_num_values = geometry.total_value_count;
 
         // Insert first offset of page into the arrow offset buffer
         current_offset = string_length+current_offset;
@@ -126,53 +147,64 @@ status SWParquetReader::read_string_delta_length(int64_t num_strings, int32_t fi
         // Keep on looping through the blocks in the page until exactly page_values_to_read have been processed.
         while(page_value_counter < page_values_to_read){
             // Read block header
-            read_block_header32(block_ptr, &min_delta, bitwidths, &header_size);
+            read_block_header32(block_ptr, geometry.miniblocks_in_block, &min_delta, bitwidths, &header_size);
             block_ptr += header_size;
         
-            for(int i=0; i<MINIBLOCKS_IN_BLOCK; i++){
+            for(int i=0; i<geometry.miniblocks_in_block; i++){
                 uint8_t current_bitwidth = bitwidths[i];
-                fastunpack((uint*) block_ptr, unpacked_deltas, current_bitwidth);
-
-                for(int j=0; j<(BLOCK_SIZE/MINIBLOCKS_IN_BLOCK); j++){
-                    string_length = string_length + unpacked_deltas[j] + min_delta;
-                    current_offset = string_length + current_offset;
-                    off_buf_ptr[page_value_counter] = current_offset;
-                    page_value_counter++;
-
-                    // Nested loops termination condition, all values have been read
-                    if(page_value_counter >= page_values_to_read){
-                        // Set off_buf_ptr to where we start writing the next page
-                        off_buf_ptr += page_value_counter;
-
-                        //Advance block pointer to next block
-                        page_value_counter += (BLOCK_SIZE/MINIBLOCKS_IN_BLOCK) - j - 1;
-                        block_ptr += current_bitwidth*((BLOCK_SIZE/MINIBLOCKS_IN_BLOCK)/8);
-
-                        for(int k=i+1; k<MINIBLOCKS_IN_BLOCK; k++){
-                            // Check if there are more values/lengths in the page that we need to skip
-                            if(page_value_counter>=page_num_values){
-                                break;
-                            }
-                            block_ptr += bitwidths[k]*((BLOCK_SIZE/MINIBLOCKS_IN_BLOCK)/8);
-                            page_value_counter += BLOCK_SIZE/MINIBLOCKS_IN_BLOCK;
+                if(current_bitwidth > 32){
+                    std::cerr << "[ERROR] Invalid bit width " << (int) current_bitwidth << " in DELTA_LENGTH_BYTE_ARRAY lengths" << std::endl;
+                    return status::FAIL;
+                }
+                if(block_ptr + current_bitwidth*(miniblock_values/8) > page_end){
+                    std::cerr << "[ERROR] DELTA_LENGTH_BYTE_ARRAY lengths run past the end of the page" << std::endl;
+                    return status::FAIL;
+                }
+
+                // Lengths are the prefix sum of the deltas, offsets the prefix sum of the lengths, accumulated in place
+                int32_t values_to_decode = std::min(miniblock_values, page_values_to_read-page_value_counter);
+                int32_t* string_lengths = off_buf_ptr+page_value_counter;
+                string_length = delta_decode_miniblock32(block_ptr, current_bitwidth, miniblock_values, min_delta, string_length, string_lengths, values_to_decode);
+                current_offset = delta_prefix_sum32((const uint32_t*) string_lengths, 0, current_offset, string_lengths, values_to_decode);
+                page_value_counter += values_to_decode;
+                block_ptr += current_bitwidth*(miniblock_values/8);
+
+                // Nested loops termination condition, all values have been read
+                if(page_value_counter >= page_values_to_read){
+                    //Advance block pointer to next block
+                    page_value_counter += miniblock_values - values_to_decode;
+
+                    for(int k=i+1; k<geometry.miniblocks_in_block; k++){
+                        // Check if there are more values/lengths in the page that we need to skip
+                        if(page_value_counter>=page_num_values){
+                            break;
                         }
-                        goto end_of_lengths;
+                        block_ptr += bitwidths[k]*(miniblock_values/8);
+                        page_value_counter += miniblock_values;
                     }
+                    goto end_of_lengths;
                 }
-
-                block_ptr += current_bitwidth*((BLOCK_SIZE/MINIBLOCKS_IN_BLOCK)/8);
             }
         }
 
         end_of_lengths:
+        // Pages only store the lengths of non-null strings, move the offsets out to their rows. Null strings are empty.
+        if(page_values_to_read < page_rows_to_read) {
+            null_count += page_rows_to_read - page_values_to_read;
+            scatter_offsets_to_valid(off_buf_ptr, validity_bits, total_value_counter % 8, page_rows_to_read, page_values_to_read, prev_page_final_offset);
+        }
+
+        // Set off_buf_ptr to where we start writing the next page
+        off_buf_ptr += page_rows_to_read;
+
         // If the last block processed was not the last block in the page we need to keep reading bitwidths to find the first character
         while(page_value_counter<page_num_values){
-            read_block_header32(block_ptr, &min_delta, bitwidths, &header_size);
+            read_block_header32(block_ptr, geometry.miniblocks_in_block, &min_delta, bitwidths, &header_size);
             block_ptr += header_size;
 
-            for(int i=0; i<MINIBLOCKS_IN_BLOCK; i++){
-                block_ptr += bitwidths[i]*((BLOCK_SIZE/MINIBLOCKS_IN_BLOCK)/8);
-                page_value_counter += BLOCK_SIZE/MINIBLOCKS_IN_BLOCK;
+            for(int i=0; i<geometry.miniblocks_in_block; i++){
+                block_ptr += bitwidths[i]*(miniblock_values/8);
+                page_value_counter += miniblock_values;
                 if(page_value_counter>=page_num_values){
                     break;
                 }
@@ -181,235 +213,516 @@ status SWParquetReader::read_string_delta_length(int64_t num_strings, int32_t fi
 
         //Copy characters
         chars_to_read = current_offset-prev_page_final_offset;
+        if((block_ptr > page_end) || (chars_to_read > (uint32_t) (page_end - block_ptr))){
+            std::cerr << "[ERROR] DELTA_LENGTH_BYTE_ARRAY characters run past the end of the page" << std::endl;
+            return status::FAIL;
+        }
         std::memcpy((void*) val_buf_ptr, (const void*) block_ptr, chars_to_read);
         val_buf_ptr += chars_to_read;
         prev_page_final_offset = current_offset;
 
         //Prepare for next page
-        page_ptr += compressed_size;
-        total_value_counter += page_num_values;
+        total_value_counter += index->num_values[page];
+        page++;
     }
 
-    *string_array = std::make_shared<arrow::StringArray>(num_strings, off_buffer, val_buffer);
+    drop_empty_null_bitmap(null_count, &null_bitmap);
 
-    free(bitwidths);
-    free(unpacked_deltas);
+    *string_array = std::make_shared<arrow::StringArray>(num_strings, off_buffer, val_buffer, null_bitmap, null_count);
 
     return status::OK;
 }
 
-status SWParquetReader::read_prim_delta32(int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer){
-    uint8_t* page_ptr = parquet_data;
-    int32_t* arr_buf_ptr = (int32_t*)arr_buffer->mutable_data();
+status SWParquetReader::read_string_delta_byte_array(int64_t num_strings, int64_t num_chars, int64_t file_offset, std::shared_ptr<arrow::StringArray>* string_array){
+    std::shared_ptr<arrow::Buffer> off_buffer;
+    arrow::AllocateBuffer((num_strings+1)*sizeof(int32_t), &off_buffer);
 
-    int32_t total_value_counter = 0;
-    int32_t page_value_counter = 0;
+    std::shared_ptr<arrow::Buffer> val_buffer;
+    arrow::AllocateBuffer(num_chars, &val_buffer);
 
-    // Metadata reading variables
-    int32_t uncompressed_size;
-    int32_t compressed_size;
-    int32_t page_num_values;
-    int32_t def_level_length;
-    int32_t rep_level_length;
-    int32_t metadata_size;
+    return read_string_delta_byte_array(num_strings, file_offset, string_array, off_buffer, val_buffer);
+}
 
-    // Delta/block header reading variables
-    int32_t page_values_to_read;
-    uint8_t* block_ptr;
-    int32_t first_value;
-    int32_t min_delta;
-    uint8_t* bitwidths = (uint8_t*)std::malloc(MINIBLOCKS_IN_BLOCK*sizeof(uint8_t));
-    int32_t header_size;
-    uint32_t* unpacked_deltas = (uint32_t*)std::malloc((BLOCK_SIZE/MINIBLOCKS_IN_BLOCK)*sizeof(uint32_t));
+// Read DELTA_BYTE_ARRAY strings. Every page holds a DELTA_BINARY_PACKED stream of prefix lengths, the number of leading bytes
+// shared with the string before it, and the suffixes as DELTA_LENGTH_BYTE_ARRAY. Both length streams are decoded with the
+// delta kernels, the offsets follow from a prefix sum over prefix plus suffix lengths, and every string is then rebuilt in
+// the value buffer from the string written before it and its suffix.
+// Shared prefixes make the strings longer than the pages, so without a val_buffer one is allocated and grown page by page.
+status SWParquetReader::read_string_delta_byte_array(int64_t num_strings, int64_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, std::shared_ptr<arrow::Buffer> off_buffer, std::shared_ptr<arrow::Buffer> val_buffer){
+    int32_t* off_buf_ptr = (int32_t*)off_buffer->mutable_data();
+    const page_index* index;
+    int64_t total_value_counter = 0;
+    int32_t current_offset = 0;
 
-    page_ptr += file_offset;
+    //Write first offset
+    off_buf_ptr[0] = 0;
+    off_buf_ptr++;
 
-    // Decode values from Parquet pages until max amount of values is reached
-    while(total_value_counter < num_values){
-        // Set arr_buf_ptr to where we start writing the current page
-        arr_buf_ptr += page_value_counter;
+    if(get_page_index(file_offset, num_strings, &index) != status::OK) {
+        return status::FAIL;
+    }
 
-        page_value_counter = 0;
+    int32_t num_pages = index->pages_for_rows(num_strings);
+    std::shared_ptr<arrow::ResizableBuffer> growing_buffer;
+    if(!val_buffer) {
+        int64_t page_bytes = 0;
+        for(int32_t page = 0; page < num_pages; page++) {
+            page_bytes += index->uncompressed_sizes[page];
+        }
+        arrow::AllocateResizableBuffer(page_bytes, &growing_buffer);
+        val_buffer = growing_buffer;
+    }
 
-        // Read page metadata
-        if(read_metadata(page_ptr, &uncompressed_size, &compressed_size, &page_num_values, &def_level_length, &rep_level_length, &metadata_size) != status::OK) {
-            std::cerr << "[ERROR] Corrupted data in Parquet page headers" << std::endl;
-            std::cerr << page_ptr-parquet_data << std::endl;
+    std::shared_ptr<arrow::Buffer> null_bitmap;
+    int64_t null_count = 0;
+    allocate_null_bitmap(index->max_def_level > 0, num_strings, &null_bitmap);
+
+    // Prefix lengths of one page at a time, the suffix lengths and then the offsets go straight to the offset buffer
+    std::vector<int32_t> prefix_lengths(num_pages > 0 ? *std::max_element(index->num_values.begin(), index->num_values.begin() + num_pages) : 0);
+
+    for(int32_t page = 0; page < num_pages; page++) {
+        int32_t page_rows_to_read = std::min((int64_t) index->num_values[page], num_strings-total_value_counter);
+        int32_t page_values_to_read = page_rows_to_read;
+        int32_t page_first_offset = current_offset;
+        page_contents contents;
+        const uint8_t* validity_bits;
+
+        if((get_page_contents(index, page, &contents) != status::OK)
+                || (null_bitmap && (decode_page_validity(index, page, contents, total_value_counter, page_rows_to_read, null_bitmap->mutable_data(), &validity_bits, &page_values_to_read) != status::OK))) {
             return status::FAIL;
         }
-        page_ptr += metadata_size;
-        block_ptr = page_ptr;
-        page_values_to_read = std::min(page_num_values, (int32_t)(num_values-total_value_counter));
 
-        // Read delta header
-        read_delta_header32(block_ptr, &first_value, &header_size);
-        block_ptr += header_size;
+        if(page_values_to_read > 0) {
+            const uint8_t* page_end = contents.values + contents.values_size;
+            const uint8_t* suffix_lengths_ptr;
+            const uint8_t* suffix_ptr;
+            int32_t* lengths = off_buf_ptr;
 
-        // Insert first value of page into the arrow buffer
-        arr_buf_ptr[page_value_counter] = first_value;
-        page_value_counter++;
+            if((decode_delta_stream32(contents.values, page_end, page_values_to_read, prefix_lengths.data(), &suffix_lengths_ptr) != status::OK)
+                    || (decode_delta_stream32(suffix_lengths_ptr, page_end, page_values_to_read, lengths, &suffix_ptr) != status::OK)) {
+                std::cerr << "[ERROR] Corrupt DELTA_BYTE_ARRAY lengths in page at file offset " << index->page_offsets[page] << std::endl;
+                return status::FAIL;
+            }
 
-        // Keep on looping through the blocks in the page until exactly page_values_to_read have been processed.
-        while(page_value_counter < page_values_to_read){
-            // Read block header
-            read_block_header32(block_ptr, &min_delta, bitwidths, &header_size);
-            block_ptr += header_size;
-        
-            for(int i=0; i<MINIBLOCKS_IN_BLOCK; i++){
-                uint8_t current_bitwidth = bitwidths[i];
-                fastunpack((uint*) block_ptr, unpacked_deltas, current_bitwidth);
+            // Turn suffix lengths into string lengths. A prefix can only be as long as the string before it, the first
+            // string of a page has none. Flags are collected instead of branching on every string.
+            int32_t previous_length = 0;
+            int64_t suffix_chars = 0;
+            bool invalid = false;
+            for(int32_t i=0; i<page_values_to_read; i++) {
+                int32_t prefix_length = prefix_lengths[i];
+                int32_t suffix_length = lengths[i];
+                invalid |= ((uint32_t) prefix_length > (uint32_t) previous_length) | (suffix_length < 0);
+                suffix_chars += suffix_length;
+                previous_length = (int32_t)((int64_t) prefix_length + suffix_length);
+                lengths[i] = previous_length;
+            }
 
-                for(int j=0; j<(BLOCK_SIZE/MINIBLOCKS_IN_BLOCK); j++){
-                    arr_buf_ptr[page_value_counter] = unpacked_deltas[j] + min_delta + arr_buf_ptr[page_value_counter-1];
-                    page_value_counter++;
+            // Every string is at most as long as all suffixes up to it, so the lengths cannot have wrapped around if the suffixes fit in the page
+            if(invalid || (suffix_chars > page_end - suffix_ptr)) {
+                std::cerr << "[ERROR] Corrupt DELTA_BYTE_ARRAY lengths in page at file offset " << index->page_offsets[page] << std::endl;
+                return status::FAIL;
+            }
 
-                    // Nested loops termination condition
-                    if(page_value_counter >= page_values_to_read){
-                        // Not pretty, but very pragmatic
-                        goto end_of_page;
-                    }
+            int64_t page_chars = 0;
+            for(int32_t i=0; i<page_values_to_read; i++) {
+                page_chars += lengths[i];
+            }
+            if(current_offset + page_chars > INT32_MAX) {
+                std::cerr << "[ERROR] Strings at file offset " << file_offset << " hold more characters than a StringArray can" << std::endl;
+                return status::FAIL;
+            }
+
+            // Grow the value buffer once per page, never per string
+            if(current_offset + page_chars > val_buffer->capacity()) {
+                if(!growing_buffer) {
+                    std::cerr << "[ERROR] Value buffer holds " << val_buffer->capacity() << " characters but the strings at file offset " << file_offset << " need more" << std::endl;
+                    return status::FAIL;
                 }
+                growing_buffer->Resize(std::max(current_offset + page_chars, 2*growing_buffer->capacity()), false);
+            }
 
-                block_ptr += current_bitwidth*((BLOCK_SIZE/MINIBLOCKS_IN_BLOCK)/8);
+            current_offset = delta_prefix_sum32((const uint32_t*) lengths, 0, current_offset, lengths, page_values_to_read);
+
+            // Copy the shared prefix out of the string before, which ends where the new string starts, then the suffix
+            uint8_t* val_buf_ptr = val_buffer->mutable_data();
+            uint8_t* previous_string = val_buf_ptr + page_first_offset;
+            int32_t string_start = page_first_offset;
+            for(int32_t i=0; i<page_values_to_read; i++) {
+                uint8_t* string = val_buf_ptr + string_start;
+                int32_t suffix_length = off_buf_ptr[i] - string_start - prefix_lengths[i];
+
+                std::memcpy(string, previous_string, prefix_lengths[i]);
+                std::memcpy(string + prefix_lengths[i], suffix_ptr, suffix_length);
+                suffix_ptr += suffix_length;
+                previous_string = string;
+                string_start = off_buf_ptr[i];
             }
         }
 
-        end_of_page:
-        page_ptr += compressed_size;
-        total_value_counter += page_num_values;
+        // Pages only store the non-null strings, move the offsets out to their rows. Null strings are empty.
+        if(page_values_to_read < page_rows_to_read) {
+            null_count += page_rows_to_read - page_values_to_read;
+            scatter_offsets_to_valid(off_buf_ptr, validity_bits, total_value_counter % 8, page_rows_to_read, page_values_to_read, page_first_offset);
+        }
+
+        off_buf_ptr += page_rows_to_read;
+        total_value_counter += index->num_values[page];
     }
 
-    *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow::int32(), num_values, arr_buffer);
+    if(growing_buffer) {
+        growing_buffer->Resize(current_offset);
+    }
+
+    drop_empty_null_bitmap(null_count, &null_bitmap);
+
+    *string_array = std::make_shared<arrow::StringArray>(num_strings, off_buffer, val_buffer, null_bitmap, null_count);
 
-    free(bitwidths);
-    free(unpacked_deltas);
     return status::OK;
 }
 
-status SWParquetReader::read_prim_delta64(int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer){
-    uint8_t* page_ptr = parquet_data;
-    int64_t* arr_buf_ptr = (int64_t*)(arr_buffer->mutable_data());
+// Decode the first n values of the DELTA_BINARY_PACKED stream at data, which must end before data_end, into out.
+// The rest of the stream is skipped over to find its end, which is where the data that follows it starts.
+status SWParquetReader::decode_delta_stream32(const uint8_t* data, const uint8_t* data_end, int32_t n, int32_t* out, const uint8_t** stream_end){
+    const uint8_t* block_ptr = data;
+    delta_geometry geometry;
+    int32_t miniblock_values;
+    int32_t previous_value;
+    int32_t min_delta;
+    uint8_t bitwidths[MAX_MINIBLOCKS_IN_BLOCK];
+    int32_t header_size;
 
-    int32_t total_value_counter = 0;
-    int32_t page_value_counter = 0;
+    if(read_delta_header32(block_ptr, &geometry, &previous_value, &header_size) != status::OK) {
+        return status::FAIL;
+    }
+    block_ptr += header_size;
+    miniblock_values = geometry.miniblock_values();
 
-    // Metadata reading variables
-    int32_t uncompressed_size;
-    int32_t compressed_size;
-    int32_t page_num_values;
-    int32_t def_level_length;
-    int32_t rep_level_length;
-    int32_t metadata_size;
+    if(n > geometry.total_value_count) {
+        std::cerr << "[ERROR] Delta stream holds " << geometry.total_value_count << " values, " << n << " expected" << std::endl;
+        return status::FAIL;
+    }
+    if(n > 0) {
+        out[0] = previous_value;
+    }
 
-    // Delta/block header reading variables
-    int32_t page_values_to_read;
-    uint8_t* block_ptr;
-    int64_t first_value;
-    int64_t min_delta;
-    uint8_t* bitwidths = (uint8_t*)std::malloc(MINIBLOCKS_IN_BLOCK*sizeof(uint8_t));
-    int32_t header_size;
-    uint64_t* unpacked_deltas = (uint64_t*)std::malloc((BLOCK_SIZE/MINIBLOCKS_IN_BLOCK)*sizeof(uint64_t));
+    // The first value is in the header, the miniblocks hold the deltas to all others. Miniblocks past the last value have no body.
+    int32_t value_counter = 1;
+    while(value_counter < geometry.total_value_count) {
+        read_block_header32(block_ptr, geometry.miniblocks_in_block, &min_delta, bitwidths, &header_size);
+        block_ptr += header_size;
 
-    page_ptr += file_offset;
+        for(int i=0; (i<geometry.miniblocks_in_block) && (value_counter<geometry.total_value_count); i++) {
+            uint8_t current_bitwidth = bitwidths[i];
+            const uint8_t* next_miniblock = block_ptr + current_bitwidth*(miniblock_values/8);
+            if((current_bitwidth > 32) || (next_miniblock > data_end)) {
+                return status::FAIL;
+            }
 
-    // Decode values from Parquet pages until max amount of values is reached
-    while(total_value_counter < num_values){
+            if(value_counter < n) {
+                int32_t values_to_decode = std::min(miniblock_values, n-value_counter);
+                previous_value = delta_decode_miniblock32(block_ptr, current_bitwidth, miniblock_values, min_delta, previous_value, out+value_counter, values_to_decode);
+            }
+            value_counter += miniblock_values;
+            block_ptr = next_miniblock;
+        }
+    }
 
-        // Set arr_buf_ptr to where we start writing the current page
-        arr_buf_ptr += page_value_counter;
+    *stream_end = block_ptr;
 
-        page_value_counter = 0;
+    return status::OK;
+}
 
-        // Read page metadata
-        if(read_metadata(page_ptr, &uncompressed_size, &compressed_size, &page_num_values, &def_level_length, &rep_level_length, &metadata_size) != status::OK) {
-            std::cerr << "[ERROR] Corrupted data in Parquet page headers" << std::endl;
-            std::cerr << page_ptr-parquet_data << std::endl;
-            return status::FAIL;
+status SWParquetReader::read_prim_delta32(int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer){
+    int32_t* arr_buf_ptr = (int32_t*)arr_buffer->mutable_data();
+    const page_index* index;
+
+    if(get_page_index(file_offset, num_values, &index) != status::OK) {
+        return status::FAIL;
+    }
+
+    std::shared_ptr<arrow::Buffer> null_bitmap;
+    allocate_null_bitmap(index->max_def_level > 0, num_values, &null_bitmap);
+
+    // Every page starts with its own first value, so pages can be decoded independently into their own range of the buffer
+    int32_t num_pages = index->pages_for_rows(num_values);
+    std::atomic<bool> failed(false);
+    std::atomic<int64_t> null_count(0);
+
+    std::function<void(int64_t)> decode_page = [&](int64_t page){
+        int64_t first_row = index->first_rows[page];
+        int32_t page_rows_to_read = std::min((int64_t) index->num_values[page], num_values-first_row);
+        int32_t page_values_to_read = page_rows_to_read;
+
+        page_contents contents;
+        const uint8_t* validity_bits;
+
+        // Compressed pages are decompressed by the thread that decodes them
+        if((get_page_contents(index, page, &contents) != status::OK)
+                || (null_bitmap && (decode_page_validity(index, page, contents, first_row, page_rows_to_read, null_bitmap->mutable_data(), &validity_bits, &page_values_to_read) != status::OK))
+                || (decode_delta_page32(contents.values, contents.values + contents.values_size, page_values_to_read, arr_buf_ptr + first_row) != status::OK)) {
+            failed = true;
+            return;
         }
-        page_ptr += metadata_size;
-        block_ptr = page_ptr;
-        page_values_to_read = std::min(page_num_values, (int32_t)(num_values-total_value_counter));
 
-        // Read delta header
-        read_delta_header64(block_ptr, &first_value, &header_size);
-        block_ptr += header_size;
+        // Pages only store the values of non-null rows, move them out to their rows
+        if(page_values_to_read < page_rows_to_read) {
+            null_count += page_rows_to_read - page_values_to_read;
+            scatter_to_valid(arr_buf_ptr + first_row, validity_bits, first_row % 8, page_rows_to_read, page_values_to_read);
+        }
+    };
 
-        //std::cout<<std::endl;
-        //std::cout<<"Values to read: "<<page_values_to_read<<std::endl;
-        //std::cout<<"Delta header size: "<<header_size<<std::endl;
-        //std::cout<<"First value: "<<first_value<<std::endl;
+    for_each_page(num_pages, decode_page);
 
-        // Insert first value of page into the arrow buffer
-        arr_buf_ptr[page_value_counter] = first_value;
-        page_value_counter++;
+    if(failed) {
+        return status::FAIL;
+    }
 
-        // Keep on looping through the blocks in the page until exactly page_values_to_read have been processed.
-        while(page_value_counter < page_values_to_read){
-            // Read block header
-            read_block_header64(block_ptr, &min_delta, bitwidths, &header_size);
-            block_ptr += header_size;
+    drop_empty_null_bitmap(null_count, &null_bitmap);
 
-            //std::cout<<"Min delta: "<<min_delta<<", block header size: "<<header_size<<std::endl;
-            //for(int z=0; z<4;z++){
-            //    std::cout<<"Bit width "<<z<<": "<<(int)bitwidths[z]<<std::endl;
-            //}
-            //std::cout<<"First byte:  "<<(int)*block_ptr<<std::endl;
-        
-            for(int i=0; i<MINIBLOCKS_IN_BLOCK; i++){
-                uint8_t current_bitwidth = bitwidths[i];
-                int64fastunpack((uint64_t*) block_ptr, unpacked_deltas, current_bitwidth);
+    *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow::int32(), num_values, arr_buffer, null_bitmap, null_count);
 
-                for(int j=0; j<(BLOCK_SIZE/MINIBLOCKS_IN_BLOCK); j++){
-                    arr_buf_ptr[page_value_counter] = unpacked_deltas[j] + min_delta + arr_buf_ptr[page_value_counter-1];
-                    //std::cout<<unpacked_deltas[j] + min_delta + arr_buf_ptr[page_value_counter-1]<<std::endl;
-                    page_value_counter++;
+    return status::OK;
+}
 
-                    // Nested loops termination condition
-                    if(page_value_counter >= page_values_to_read){
-                        // Not pretty, but very pragmatic
-                        goto end_of_page;
-                    }
-                }
+// Decode the first page_values_to_read values of the DELTA_BINARY_PACKED encoded page at page_data, which must end before
+// data_end, into arr_buf_ptr
+status SWParquetReader::decode_delta_page32(const uint8_t* page_data, const uint8_t* data_end, int32_t page_values_to_read, int32_t* arr_buf_ptr){
+    const uint8_t* block_ptr = page_data;
+    delta_geometry geometry;
+    int32_t first_value;
+    int32_t header_size;
 
-                block_ptr += current_bitwidth*((BLOCK_SIZE/MINIBLOCKS_IN_BLOCK)/8);
+    // Read delta header
+    if(read_delta_header32(block_ptr, &geometry, &first_value, &header_size) != status::OK) {
+        return status::FAIL;
+    }
+    block_ptr += header_size;
+
+    // Insert first value of page into the arrow buffer
+    arr_buf_ptr[0] = first_value;
+
+    // The block and miniblock sizes of the common writers get their own instantiation, with the loops over miniblocks
+    // and over the values in a miniblock known at compile time. Any other valid geometry is decoded by the generic one.
+    if(geometry.miniblock_values() == MINIBLOCK_VALUES) {
+        switch(geometry.miniblocks_in_block) {
+            case 4: return decode_delta_blocks32<4, MINIBLOCK_VALUES>(block_ptr, data_end, geometry, page_values_to_read, arr_buf_ptr);   // 128/4
+            case 8: return decode_delta_blocks32<8, MINIBLOCK_VALUES>(block_ptr, data_end, geometry, page_values_to_read, arr_buf_ptr);   // 256/8
+            case 16: return decode_delta_blocks32<16, MINIBLOCK_VALUES>(block_ptr, data_end, geometry, page_values_to_read, arr_buf_ptr); // 512/16
+        }
+    } else if(geometry.block_size == 128 && geometry.miniblocks_in_block == 8) {
+        return decode_delta_blocks32<8, 16>(block_ptr, data_end, geometry, page_values_to_read, arr_buf_ptr);
+    }
+
+    return decode_delta_blocks32<0, 0>(block_ptr, data_end, geometry, page_values_to_read, arr_buf_ptr);
+}
+
+// Decode the blocks following the delta header, the first value is already in arr_buf_ptr[0].
+// Template arguments of 0 take the geometry read from the header instead.
+template<int32_t miniblocks_in_block, int32_t miniblock_values>
+status SWParquetReader::decode_delta_blocks32(const uint8_t* block_ptr, const uint8_t* data_end, const delta_geometry& geometry, int32_t page_values_to_read, int32_t* arr_buf_ptr){
+    const int32_t miniblocks = miniblocks_in_block > 0 ? miniblocks_in_block : geometry.miniblocks_in_block;
+    const int32_t values_per_miniblock = miniblock_values > 0 ? miniblock_values : geometry.miniblock_values();
+    int32_t page_value_counter = 1;
+
+    // Block header reading variables
+    int32_t min_delta;
+    uint8_t bitwidths[MAX_MINIBLOCKS_IN_BLOCK];
+    int32_t header_size;
+
+    // Keep on looping through the blocks in the page until exactly page_values_to_read have been processed.
+    while(page_value_counter < page_values_to_read){
+        // Read block header
+        read_block_header32(block_ptr, miniblocks, &min_delta, bitwidths, &header_size);
+        block_ptr += header_size;
+    
+        for(int i=0; i<miniblocks; i++){
+            uint8_t current_bitwidth = bitwidths[i];
+            if(current_bitwidth > 32){
+                std::cerr << "[ERROR] Invalid bit width " << (int) current_bitwidth << " in DELTA_BINARY_PACKED miniblock" << std::endl;
+                return status::FAIL;
+            }
+            if(block_ptr + current_bitwidth*(values_per_miniblock/8) > data_end){
+                std::cerr << "[ERROR] DELTA_BINARY_PACKED miniblock runs past the end of the page" << std::endl;
+                return status::FAIL;
             }
+
+            // Unpack, add min_delta and accumulate onto the previous value without a scratch array
+            int32_t values_to_decode = std::min(values_per_miniblock, page_values_to_read-page_value_counter);
+            delta_decode_miniblock32(block_ptr, current_bitwidth, values_per_miniblock, min_delta, arr_buf_ptr[page_value_counter-1], arr_buf_ptr+page_value_counter, values_to_decode);
+            page_value_counter += values_to_decode;
+
+            // Nested loops termination condition
+            if(page_value_counter >= page_values_to_read){
+                return status::OK;
+            }
+
+            block_ptr += current_bitwidth*(values_per_miniblock/8);
+        }
+    }
+
+    return status::OK;
+}
+
+status SWParquetReader::read_prim_delta64(int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer){
+    int64_t* arr_buf_ptr = (int64_t*)arr_buffer->mutable_data();
+    const page_index* index;
+
+    if(get_page_index(file_offset, num_values, &index) != status::OK) {
+        return status::FAIL;
+    }
+
+    std::shared_ptr<arrow::Buffer> null_bitmap;
+    allocate_null_bitmap(index->max_def_level > 0, num_values, &null_bitmap);
+
+    // Every page starts with its own first value, so pages can be decoded independently into their own range of the buffer
+    int32_t num_pages = index->pages_for_rows(num_values);
+    std::atomic<bool> failed(false);
+    std::atomic<int64_t> null_count(0);
+
+    std::function<void(int64_t)> decode_page = [&](int64_t page){
+        int64_t first_row = index->first_rows[page];
+        int32_t page_rows_to_read = std::min((int64_t) index->num_values[page], num_values-first_row);
+        int32_t page_values_to_read = page_rows_to_read;
+
+        page_contents contents;
+        const uint8_t* validity_bits;
+
+        // Compressed pages are decompressed by the thread that decodes them
+        if((get_page_contents(index, page, &contents) != status::OK)
+                || (null_bitmap && (decode_page_validity(index, page, contents, first_row, page_rows_to_read, null_bitmap->mutable_data(), &validity_bits, &page_values_to_read) != status::OK))
+                || (decode_delta_page64(contents.values, contents.values + contents.values_size, page_values_to_read, arr_buf_ptr + first_row) != status::OK)) {
+            failed = true;
+            return;
         }
 
-        end_of_page:
-        page_ptr += compressed_size;
-        total_value_counter += page_num_values;
+        // Pages only store the values of non-null rows, move them out to their rows
+        if(page_values_to_read < page_rows_to_read) {
+            null_count += page_rows_to_read - page_values_to_read;
+            scatter_to_valid(arr_buf_ptr + first_row, validity_bits, first_row % 8, page_rows_to_read, page_values_to_read);
+        }
+    };
+
+    for_each_page(num_pages, decode_page);
+
+    if(failed) {
+        return status::FAIL;
+    }
+
+    drop_empty_null_bitmap(null_count, &null_bitmap);
+
+    *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow::int64(), num_values, arr_buffer, null_bitmap, null_count);
+
+    return status::OK;
+}
+
+// Decode the first page_values_to_read values of the DELTA_BINARY_PACKED encoded page at page_data, which must end before
+// data_end, into arr_buf_ptr
+status SWParquetReader::decode_delta_page64(const uint8_t* page_data, const uint8_t* data_end, int32_t page_values_to_read, int64_t* arr_buf_ptr){
+    const uint8_t* block_ptr = page_data;
+    delta_geometry geometry;
+    int64_t first_value;
+    int32_t header_size;
+
+    // Read delta header
+    if(read_delta_header64(block_ptr, &geometry, &first_value, &header_size) != status::OK) {
+        return status::FAIL;
+    }
+    block_ptr += header_size;
+
+    // Insert first value of page into the arrow buffer
+    arr_buf_ptr[0] = first_value;
+
+    // The block and miniblock sizes of the common writers get their own instantiation, with the loops over miniblocks
+    // and over the values in a miniblock known at compile time. Any other valid geometry is decoded by the generic one.
+    if(geometry.miniblock_values() == MINIBLOCK_VALUES) {
+        switch(geometry.miniblocks_in_block) {
+            case 4: return decode_delta_blocks64<4, MINIBLOCK_VALUES>(block_ptr, data_end, geometry, page_values_to_read, arr_buf_ptr);   // 128/4
+            case 8: return decode_delta_blocks64<8, MINIBLOCK_VALUES>(block_ptr, data_end, geometry, page_values_to_read, arr_buf_ptr);   // 256/8
+            case 16: return decode_delta_blocks64<16, MINIBLOCK_VALUES>(block_ptr, data_end, geometry, page_values_to_read, arr_buf_ptr); // 512/16
+        }
+    } else if(geometry.block_size == 128 && geometry.miniblocks_in_block == 8) {
+        return decode_delta_blocks64<8, 16>(block_ptr, data_end, geometry, page_values_to_read, arr_buf_ptr);
     }
 
+    return decode_delta_blocks64<0, 0>(block_ptr, data_end, geometry, page_values_to_read, arr_buf_ptr);
+}
 
-    //std::cout<<"Creating array with capacity "<<arr_buffer->capacity()<<" and size "<< arr_buffer->size()<<std::endl;
-    //for(int l=0; l<200; l++){
-    //    std::cout<<(arr_buf_ptr+page_value_counter-100)[l]<<std::endl;
-    //}
-    *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow::int64(), num_values, arr_buffer);
+// Decode the blocks following the delta header, the first value is already in arr_buf_ptr[0].
+// Template arguments of 0 take the geometry read from the header instead.
+template<int32_t miniblocks_in_block, int32_t miniblock_values>
+status SWParquetReader::decode_delta_blocks64(const uint8_t* block_ptr, const uint8_t* data_end, const delta_geometry& geometry, int32_t page_values_to_read, int64_t* arr_buf_ptr){
+    const int32_t miniblocks = miniblocks_in_block > 0 ? miniblocks_in_block : geometry.miniblocks_in_block;
+    const int32_t values_per_miniblock = miniblock_values > 0 ? miniblock_values : geometry.miniblock_values();
+    int32_t page_value_counter = 1;
 
-    free(bitwidths);
-    free(unpacked_deltas);
+    // Block header reading variables
+    int64_t min_delta;
+    uint8_t bitwidths[MAX_MINIBLOCKS_IN_BLOCK];
+    int32_t header_size;
+
+    // Keep on looping through the blocks in the page until exactly page_values_to_read have been processed.
+    while(page_value_counter < page_values_to_read){
+        // Read block header
+        read_block_header64(block_ptr, miniblocks, &min_delta, bitwidths, &header_size);
+        block_ptr += header_size;
+    
+        for(int i=0; i<miniblocks; i++){
+            uint8_t current_bitwidth = bitwidths[i];
+            if(current_bitwidth > 64){
+                std::cerr << "[ERROR] Invalid bit width " << (int) current_bitwidth << " in DELTA_BINARY_PACKED miniblock" << std::endl;
+                return status::FAIL;
+            }
+            if(block_ptr + current_bitwidth*(values_per_miniblock/8) > data_end){
+                std::cerr << "[ERROR] DELTA_BINARY_PACKED miniblock runs past the end of the page" << std::endl;
+                return status::FAIL;
+            }
+
+            // Unpack, add min_delta and accumulate onto the previous value without a scratch array
+            int32_t values_to_decode = std::min(values_per_miniblock, page_values_to_read-page_value_counter);
+            delta_decode_miniblock64(block_ptr, current_bitwidth, values_per_miniblock, min_delta, arr_buf_ptr[page_value_counter-1], arr_buf_ptr+page_value_counter, values_to_decode);
+            page_value_counter += values_to_decode;
+
+            // Nested loops termination condition
+            if(page_value_counter >= page_values_to_read){
+                return status::OK;
+            }
+
+            block_ptr += current_bitwidth*(values_per_miniblock/8);
+        }
+    }
 
     return status::OK;
 }
 
-status SWParquetReader::read_delta_header32(const uint8_t* header, int32_t* first_value, int32_t* header_size){
+// Read the block size, miniblock count and total value count that start every delta header
+status SWParquetReader::read_delta_geometry(const uint8_t* header, delta_geometry* geometry, int32_t* geometry_size){
     const uint8_t* current_byte = header;
 
-    //Skip block_size
-    assert(BLOCK_SIZE == 128);
-    current_byte += 2;
-
-    //Skip miniblocks in block
-    assert(MINIBLOCKS_IN_BLOCK == 4);
-    current_byte += 1;
+    current_byte += decode_varint32(current_byte, &geometry->block_size, false);
+    current_byte += decode_varint32(current_byte, &geometry->miniblocks_in_block, false);
+    current_byte += decode_varint32(current_byte, &geometry->total_value_count, false);
 
-    //Total value count
-    while((*current_byte & 0x80) != 0 ){
-        current_byte++;
+    // Miniblocks have to be whole bytes for the unpacking, the spec asks for multiples of 32 values but older writers used 8
+    if(geometry->block_size <= 0 || geometry->miniblocks_in_block <= 0 || geometry->miniblocks_in_block > MAX_MINIBLOCKS_IN_BLOCK
+            || geometry->block_size % geometry->miniblocks_in_block != 0 || geometry->miniblock_values() % 8 != 0) {
+        std::cerr << "[ERROR] Unsupported DELTA_BINARY_PACKED block size " << geometry->block_size << " with " << geometry->miniblocks_in_block << " miniblocks" << std::endl;
+        return status::FAIL;
     }
 
-    current_byte++;
+    *geometry_size = current_byte-header;
+
+    return status::OK;
+}
+
+status SWParquetReader::read_delta_header32(const uint8_t* header, delta_geometry* geometry, int32_t* first_value, int32_t* header_size){
+    const uint8_t* current_byte = header;
+    int32_t geometry_size;
+
+    if(read_delta_geometry(current_byte, geometry, &geometry_size) != status::OK) {
+        return status::FAIL;
+    }
+    current_byte += geometry_size;
 
     current_byte += decode_varint32(current_byte, first_value, true);
 
@@ -418,23 +731,14 @@ status SWParquetReader::read_delta_header32(const uint8_t* header, int32_t* firs
     return status::OK;
 }
 
-status SWParquetReader::read_delta_header64(const uint8_t* header, int64_t* first_value, int32_t* header_size){
+status SWParquetReader::read_delta_header64(const uint8_t* header, delta_geometry* geometry, int64_t* first_value, int32_t* header_size){
     const uint8_t* current_byte = header;
+    int32_t geometry_size;
 
-    //Skip block_size
-    assert(BLOCK_SIZE == 128);
-    current_byte += 2;
-
-    //Skip miniblocks in block
-    assert(MINIBLOCKS_IN_BLOCK == 4);
-    current_byte += 1;
-
-    //Total value count
-    while((*current_byte & 0x80) != 0 ){
-        current_byte++;
+    if(read_delta_geometry(current_byte, geometry, &geometry_size) != status::OK) {
+        return status::FAIL;
     }
-
-    current_byte++;
+    current_byte += geometry_size;
 
     current_byte += decode_varint64(current_byte, first_value, true);
 
@@ -443,14 +747,14 @@ status SWParquetReader::read_delta_header64(const uint8_t* header, int64_t* firs
     return status::OK;
 }
 
-status SWParquetReader::read_block_header32(const uint8_t* header, int32_t* min_delta, uint8_t* bitwidths, int32_t* header_size){
+status SWParquetReader::read_block_header32(const uint8_t* header, int32_t miniblocks_in_block, int32_t* min_delta, uint8_t* bitwidths, int32_t* header_size){
     const uint8_t* current_byte = header;
 
     //Min_delta
     current_byte += decode_varint32(current_byte, min_delta, true);
 
     //Bit widths
-    for(int i=0; i<MINIBLOCKS_IN_BLOCK; i++){
+    for(int i=0; i<miniblocks_in_block; i++){
         bitwidths[i] = *current_byte;
         current_byte++;
     }
@@ -461,14 +765,14 @@ status SWParquetReader::read_block_header32(const uint8_t* header, int32_t* min_
 
 }
 
-status SWParquetReader::read_block_header64(const uint8_t* header, int64_t* min_delta, uint8_t* bitwidths, int32_t* header_size){
+status SWParquetReader::read_block_header64(const uint8_t* header, int32_t miniblocks_in_block, int64_t* min_delta, uint8_t* bitwidths, int32_t* header_size){
     const uint8_t* current_byte = header;
 
     //Min_delta
     current_byte += decode_varint64(current_byte, min_delta, true);
 
     //Bit widths
-    for(int i=0; i<MINIBLOCKS_IN_BLOCK; i++){
+    for(int i=0; i<miniblocks_in_block; i++){
         bitwidths[i] = *current_byte;
         current_byte++;
     }
@@ -0,0 +1,310 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+
+#include "SWParquetReader.h"
+#include "DictionaryKernels.h"
+#include "DeltaKernels.h"
+#include "DefinitionLevels.h"
+#include "PlainKernels.h"
+#include "ptoa.h"
+
+namespace ptoa {
+
+// Room behind the characters of dictionary strings, which copy_dictionary_strings reads in 16 byte moves
+const int32_t DICTIONARY_CHARS_PADDING = 16;
+
+// Decode the PLAIN encoded values of the dictionary page of a column chunk. Fixed width values are value_width bytes wide,
+// a value_width of 0 stands for BYTE_ARRAY values, each preceded by its 4 byte length.
+status SWParquetReader::read_dictionary_page(const page_index* index, int32_t value_width, dictionary_values* dictionary) {
+    if(!index->has_dictionary()) {
+        std::cerr << "[ERROR] Column chunk with page at file offset " << index->page_offsets[0] << " has no dictionary page" << std::endl;
+        return status::FAIL;
+    }
+
+    std::vector<uint8_t> buffer;
+    const uint8_t* page_data;
+    int32_t page_size;
+    int32_t num_values = index->dictionary.num_values;
+
+    if(get_dictionary_page_values(index, &buffer, &page_data, &page_size) != status::OK) {
+        return status::FAIL;
+    }
+
+    dictionary->num_values = num_values;
+
+    if(value_width > 0) {
+        if((int64_t) num_values*value_width > page_size) {
+            std::cerr << "[ERROR] Dictionary page at file offset " << index->dictionary.page_offset << " is too small to hold its values" << std::endl;
+            return status::FAIL;
+        }
+        arrow::AllocateBuffer((int64_t) num_values*value_width, &dictionary->values);
+        std::memcpy(dictionary->values->mutable_data(), page_data, (int64_t) num_values*value_width);
+        return status::OK;
+    }
+
+    // The characters take up less room than the page, which also holds their lengths
+    arrow::AllocateBuffer(page_size + DICTIONARY_CHARS_PADDING, &dictionary->values);
+    arrow::AllocateBuffer((int64_t)(num_values+1)*sizeof(int32_t), &dictionary->offsets);
+    dictionary->lengths.resize(num_values);
+
+    uint8_t* chars = dictionary->values->mutable_data();
+    int32_t* offsets = (int32_t*) dictionary->offsets->mutable_data();
+    int64_t total_chars;
+
+    if(scan_plain_lengths(page_data, page_size, num_values, dictionary->lengths.data(), &total_chars) != status::OK) {
+        std::cerr << "[ERROR] Dictionary page at file offset " << index->dictionary.page_offset << " is too small to hold its values" << std::endl;
+        return status::FAIL;
+    }
+
+    offsets[0] = 0;
+    delta_prefix_sum32((const uint32_t*) dictionary->lengths.data(), 0, 0, offsets + 1, num_values);
+    copy_plain_strings(page_data, page_data + page_size, 0, offsets + 1, num_values, chars, chars + total_chars + DICTIONARY_CHARS_PADDING);
+    std::memset(chars + total_chars, 0, DICTIONARY_CHARS_PADDING);
+
+    return status::OK;
+}
+
+// Decode the dictionary indices of the first num_values rows into indices, null rows get index 0.
+// null_bitmap is allocated for nullable columns and reset again if there turn out to be no nulls.
+// Pages are decoded in parallel, every page holds its own run of indices.
+status SWParquetReader::read_dictionary_indices(const page_index* index, int32_t dictionary_size, int64_t num_values, int32_t* indices,
+                                                std::shared_ptr<arrow::Buffer>* null_bitmap, int64_t* null_count) {
+    allocate_null_bitmap(index->max_def_level > 0, num_values, null_bitmap);
+
+    int32_t num_pages = index->pages_for_rows(num_values);
+    std::atomic<bool> failed(false);
+    std::atomic<int64_t> nulls(0);
+
+    std::function<void(int64_t)> decode_page = [&](int64_t page){
+        int64_t first_row = index->first_rows[page];
+        int32_t page_rows_to_read = std::min((int64_t) index->num_values[page], num_values-first_row);
+        int32_t page_values_to_read = page_rows_to_read;
+
+        page_contents contents;
+        const uint8_t* validity_bits;
+
+        if(!index->dictionary_encoded(page)) {
+            std::cerr << "[ERROR] Page at file offset " << index->page_offsets[page] << " is not dictionary encoded but uses encoding " << (int32_t) index->encodings[page] << std::endl;
+            failed = true;
+            return;
+        }
+
+        if((get_page_contents(index, page, &contents) != status::OK)
+                || (*null_bitmap && (decode_page_validity(index, page, contents, first_row, page_rows_to_read, (*null_bitmap)->mutable_data(), &validity_bits, &page_values_to_read) != status::OK))) {
+            failed = true;
+            return;
+        }
+
+        if(decode_dictionary_indices(contents.values, contents.values_size, dictionary_size, page_values_to_read, indices + first_row) != status::OK) {
+            std::cerr << "[ERROR] Corrupt dictionary indices in page at file offset " << index->page_offsets[page] << std::endl;
+            failed = true;
+            return;
+        }
+
+        if(page_values_to_read < page_rows_to_read) {
+            nulls += page_rows_to_read - page_values_to_read;
+            scatter_to_valid(indices + first_row, validity_bits, first_row % 8, page_rows_to_read, page_values_to_read);
+        }
+    };
+
+    for_each_page(num_pages, decode_page);
+
+    if(failed) {
+        return status::FAIL;
+    }
+
+    *null_count = nulls;
+    drop_empty_null_bitmap(*null_count, null_bitmap);
+
+    return status::OK;
+}
+
+status SWParquetReader::read_prim_dictionary(parquet_type type, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array){
+    int32_t prim_width;
+    std::shared_ptr<arrow::DataType> arrow_type;
+    std::shared_ptr<arrow::Buffer> arr_buffer;
+
+    if(prim_type_info(type, &prim_width, &arrow_type) != status::OK) {
+        return status::FAIL;
+    }
+    arrow::AllocateBuffer(num_values*prim_width/8, &arr_buffer);
+
+    return read_prim_dictionary(type, num_values, file_offset, prim_array, arr_buffer);
+}
+
+// Read dictionary encoded 32 or 64 bit values. Indices are looked up right after unpacking, the values go straight to arr_buffer.
+// Writers fall back to PLAIN pages once the dictionary grows too large, those pages are copied as they are.
+status SWParquetReader::read_prim_dictionary(parquet_type type, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer){
+    uint8_t* arr_buf_ptr = arr_buffer->mutable_data();
+    int32_t prim_width;
+    std::shared_ptr<arrow::DataType> arrow_type;
+    const page_index* index;
+    dictionary_values dictionary;
+
+    // Floating point values are looked up by their bit patterns
+    if((prim_type_info(type, &prim_width, &arrow_type) != status::OK) || (prim_width == 1)) {
+        std::cerr << "[ERROR] Dictionary encoded values of type " << (int32_t) type << " are not supported" << std::endl;
+        return status::FAIL;
+    }
+    const int32_t value_bytes = prim_width/8;
+
+    if((get_page_index(file_offset, num_values, &index) != status::OK)
+            || (read_dictionary_page(index, value_bytes, &dictionary) != status::OK)) {
+        return status::FAIL;
+    }
+
+    std::shared_ptr<arrow::Buffer> null_bitmap;
+    allocate_null_bitmap(index->max_def_level > 0, num_values, &null_bitmap);
+
+    // Every page is decoded independently into its own range of the buffer
+    int32_t num_pages = index->pages_for_rows(num_values);
+    std::atomic<bool> failed(false);
+    std::atomic<int64_t> null_count(0);
+
+    std::function<void(int64_t)> decode_page = [&](int64_t page){
+        int64_t first_row = index->first_rows[page];
+        int32_t page_rows_to_read = std::min((int64_t) index->num_values[page], num_values-first_row);
+        int32_t page_values_to_read = page_rows_to_read;
+        uint8_t* page_out = arr_buf_ptr + first_row*value_bytes;
+
+        page_contents contents;
+        const uint8_t* validity_bits;
+
+        if((get_page_contents(index, page, &contents) != status::OK)
+                || (null_bitmap && (decode_page_validity(index, page, contents, first_row, page_rows_to_read, null_bitmap->mutable_data(), &validity_bits, &page_values_to_read) != status::OK))) {
+            failed = true;
+            return;
+        }
+
+        status decoded = status::FAIL;
+        if(index->encodings[page] == parquet_encoding::PLAIN) {
+            if((int64_t) contents.values_size >= (int64_t) page_values_to_read*value_bytes) {
+                std::memcpy(page_out, contents.values, (int64_t) page_values_to_read*value_bytes);
+                decoded = status::OK;
+            }
+        } else if(!index->dictionary_encoded(page)) {
+            std::cerr << "[ERROR] Page at file offset " << index->page_offsets[page] << " uses unsupported encoding " << (int32_t) index->encodings[page] << std::endl;
+            failed = true;
+            return;
+        } else if(prim_width == 64) {
+            decoded = decode_dictionary_values64(contents.values, contents.values_size, (const int64_t*) dictionary.values->data(), dictionary.num_values, page_values_to_read, (int64_t*) page_out);
+        } else {
+            decoded = decode_dictionary_values32(contents.values, contents.values_size, (const int32_t*) dictionary.values->data(), dictionary.num_values, page_values_to_read, (int32_t*) page_out);
+        }
+
+        if(decoded != status::OK) {
+            std::cerr << "[ERROR] Corrupt values in page at file offset " << index->page_offsets[page] << std::endl;
+            failed = true;
+            return;
+        }
+
+        // Pages only store the values of non-null rows, move them out to their rows
+        if(page_values_to_read < page_rows_to_read) {
+            null_count += page_rows_to_read - page_values_to_read;
+            if(prim_width == 64) {
+                scatter_to_valid((int64_t*) page_out, validity_bits, first_row % 8, page_rows_to_read, page_values_to_read);
+            } else {
+                scatter_to_valid((int32_t*) page_out, validity_bits, first_row % 8, page_rows_to_read, page_values_to_read);
+            }
+        }
+    };
+
+    for_each_page(num_pages, decode_page);
+
+    if(failed) {
+        return status::FAIL;
+    }
+
+    drop_empty_null_bitmap(null_count, &null_bitmap);
+
+    *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow_type, num_values, arr_buffer, null_bitmap, null_count);
+
+    return status::OK;
+}
+
+status SWParquetReader::read_string_dictionary(int64_t num_strings, int64_t num_chars, int64_t file_offset, std::shared_ptr<arrow::StringArray>* string_array){
+    std::shared_ptr<arrow::Buffer> off_buffer;
+    arrow::AllocateBuffer((num_strings+1)*sizeof(int32_t), &off_buffer);
+
+    std::shared_ptr<arrow::Buffer> val_buffer;
+    arrow::AllocateBuffer(num_chars, &val_buffer);
+
+    return read_string_dictionary(num_strings, file_offset, string_array, off_buffer, val_buffer);
+}
+
+// Read dictionary encoded strings. Pages are read like PLAIN ones, with the lengths gathered from the dictionary string lengths
+// and the characters copied from the dictionary. PLAIN pages that writers fall back to are read as they are.
+status SWParquetReader::read_string_dictionary(int64_t num_strings, int64_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, std::shared_ptr<arrow::Buffer> off_buffer, std::shared_ptr<arrow::Buffer> val_buffer){
+    const page_index* index;
+    dictionary_values dictionary;
+
+    if((get_page_index(file_offset, num_strings, &index) != status::OK)
+            || (read_dictionary_page(index, 0, &dictionary) != status::OK)) {
+        return status::FAIL;
+    }
+
+    return read_string_pages(index, &dictionary, num_strings, string_array, off_buffer, val_buffer);
+}
+
+// Read dictionary encoded values as a DictionaryArray of int32 indices, without looking them up.
+// The dictionary is the decoded dictionary page, so it is the same for every read of the column chunk.
+status SWParquetReader::read_dictionary(parquet_type type, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::DictionaryArray>* dict_array) {
+    const page_index* index;
+    dictionary_values dictionary;
+    std::shared_ptr<arrow::DataType> value_type;
+    int32_t value_width;
+
+    if((type == parquet_type::INT32) || (type == parquet_type::INT64) || (type == parquet_type::FLOAT) || (type == parquet_type::DOUBLE)) {
+        prim_type_info(type, &value_width, &value_type);
+        value_width /= 8;
+    } else if(type == parquet_type::BYTE_ARRAY) {
+        value_type = arrow::utf8();
+        value_width = 0;
+    } else {
+        std::cerr << "[ERROR] Unsupported dictionary value type " << (int32_t) type << std::endl;
+        return status::FAIL;
+    }
+
+    if((get_page_index(file_offset, num_values, &index) != status::OK)
+            || (read_dictionary_page(index, value_width, &dictionary) != status::OK)) {
+        return status::FAIL;
+    }
+
+    std::shared_ptr<arrow::Buffer> idx_buffer;
+    std::shared_ptr<arrow::Buffer> null_bitmap;
+    int64_t null_count;
+    arrow::AllocateBuffer(num_values*sizeof(int32_t), &idx_buffer);
+
+    if(read_dictionary_indices(index, dictionary.num_values, num_values, (int32_t*) idx_buffer->mutable_data(), &null_bitmap, &null_count) != status::OK) {
+        return status::FAIL;
+    }
+
+    std::shared_ptr<arrow::Array> dictionary_array;
+    if(value_width > 0) {
+        dictionary_array = std::make_shared<arrow::PrimitiveArray>(value_type, dictionary.num_values, dictionary.values);
+    } else {
+        dictionary_array = std::make_shared<arrow::StringArray>(dictionary.num_values, dictionary.offsets, dictionary.values);
+    }
+
+    std::shared_ptr<arrow::Array> indices = std::make_shared<arrow::PrimitiveArray>(arrow::int32(), num_values, idx_buffer, null_bitmap, null_count);
+    *dict_array = std::make_shared<arrow::DictionaryArray>(arrow::dictionary(arrow::int32(), value_type), indices, dictionary_array);
+
+    return status::OK;
+}
+
+}
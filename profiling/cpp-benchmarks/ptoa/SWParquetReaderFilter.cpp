@@ -0,0 +1,403 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <climits>
+
+#include "SWParquetReader.h"
+#include "DeltaKernels.h"
+#include "FilterKernels.h"
+#include "DefinitionLevels.h"
+#include "ptoa.h"
+
+namespace ptoa {
+
+// Validity bits, match bits per value and per row, and matching values of the page a thread filters last
+static thread_local std::vector<uint8_t> filter_validity;
+static thread_local std::vector<uint8_t> filter_bits;
+static thread_local std::vector<uint8_t> filter_row_bits;
+static thread_local std::vector<uint8_t> filter_matches;
+
+// Bring pred into the form of a value_filter for values of prim_width bits. can_match is cleared if no value of that width
+// fulfils it, e.g. LESS than the smallest value or EQUAL to a value outside the int32 range for 32 bit values.
+static status make_value_filter(const predicate& pred, int32_t prim_width, value_filter* filter, bool* can_match) {
+    size_t num_operands = pred.num_operands();
+    const int64_t min_value = prim_width == 32 ? INT32_MIN : INT64_MIN;
+    const int64_t max_value = prim_width == 32 ? INT32_MAX : INT64_MAX;
+
+    if((prim_width != 32) && (prim_width != 64)) {
+        std::cerr << "[ERROR] Unsupported prim width " << prim_width << std::endl;
+        return status::FAIL;
+    } else if(pred.on_strings) {
+        std::cerr << "[ERROR] Filtering integer values needs a predicate with integer operands" << std::endl;
+        return status::FAIL;
+    } else if(((pred.op == predicate_op::BETWEEN) && (num_operands != 2)) || ((pred.op != predicate_op::BETWEEN) && (pred.op != predicate_op::IN) && (num_operands != 1))) {
+        std::cerr << "[ERROR] Predicate has the wrong amount of operands, " << num_operands << std::endl;
+        return status::FAIL;
+    }
+
+    filter->any_of = pred.op == predicate_op::IN;
+    filter->lower = INT64_MIN;
+    filter->upper = INT64_MAX;
+    filter->operands.clear();
+    *can_match = true;
+
+    switch(pred.op) {
+        case predicate_op::LESS:
+            // Nothing is less than the smallest value, everything else is at most one below the operand
+            *can_match = pred.ints[0] != INT64_MIN;
+            filter->upper = pred.ints[0] - (*can_match ? 1 : 0);
+            break;
+        case predicate_op::LESS_EQUAL:
+            filter->upper = pred.ints[0];
+            break;
+        case predicate_op::EQUAL:
+            filter->lower = pred.ints[0];
+            filter->upper = pred.ints[0];
+            break;
+        case predicate_op::BETWEEN:
+            filter->lower = pred.ints[0];
+            filter->upper = pred.ints[1];
+            break;
+        case predicate_op::IN:
+            // Operands that values of this width cannot take are left out, as are duplicates
+            for(int64_t operand : pred.ints) {
+                if((operand >= min_value) && (operand <= max_value)) {
+                    filter->operands.push_back(operand);
+                }
+            }
+            std::sort(filter->operands.begin(), filter->operands.end());
+            filter->operands.erase(std::unique(filter->operands.begin(), filter->operands.end()), filter->operands.end());
+            *can_match = !filter->operands.empty();
+            return status::OK;
+    }
+
+    // Clamp the range to the values of this width
+    *can_match = *can_match && (filter->lower <= filter->upper) && (filter->lower <= max_value) && (filter->upper >= min_value);
+    filter->lower = std::max(filter->lower, min_value);
+    filter->upper = std::min(filter->upper, max_value);
+
+    return status::OK;
+}
+
+// OR the 32 bits of mask into bits from bit pos on, bits must hold 8 bytes from byte pos/8 on
+static inline void or_bits(uint8_t* bits, int32_t pos, uint32_t mask) {
+    uint64_t word;
+    std::memcpy(&word, bits + pos/8, 8);
+    word |= (uint64_t) mask << (pos%8);
+    std::memcpy(bits + pos/8, &word, 8);
+}
+
+// Bytes the match bits of n values take, with room for or_bits to write 8 bytes at the last of them
+static inline size_t match_bits_size(int32_t n) {
+    return (n + 7)/8 + 8;
+}
+
+// Mark the values of a page that fulfil filter in selection, which must hold match_bits_size(n) zeroed bytes, and copy them to out.
+// Values are compared in groups of MINIBLOCK_VALUES right after they are decoded into a buffer on the stack, so the page is
+// never decoded to memory as a whole. Miniblocks of other sizes are split into or padded to groups of MINIBLOCK_VALUES.
+// Without out only the bits are set. num_matches is set to the amount of matching values.
+status SWParquetReader::filter_delta_page32(const uint8_t* page_data, const uint8_t* data_end, int32_t n, const value_filter& filter, uint8_t* selection, int32_t* out, int32_t* num_matches){
+    const uint8_t* block_ptr = page_data;
+    delta_geometry geometry;
+    int32_t miniblock_values;
+    int32_t previous_value;
+    int32_t min_delta;
+    uint8_t bitwidths[MAX_MINIBLOCKS_IN_BLOCK];
+    int32_t header_size;
+    int32_t values[MINIBLOCK_VALUES] = {0};
+    int32_t matches = 0;
+
+    if(read_delta_header32(block_ptr, &geometry, &previous_value, &header_size) != status::OK) {
+        return status::FAIL;
+    }
+    block_ptr += header_size;
+    miniblock_values = geometry.miniblock_values();
+
+    if(n > geometry.total_value_count) {
+        std::cerr << "[ERROR] Delta stream holds " << geometry.total_value_count << " values, " << n << " expected" << std::endl;
+        return status::FAIL;
+    }
+
+    if(n > 0) {
+        values[0] = previous_value;
+        uint32_t mask = filter_values32(values, 1, filter);
+        selection[0] |= (uint8_t) mask;
+        matches += out ? compact_values32(values, mask, out) : mask;
+    }
+
+    int32_t value_counter = 1;
+    while(value_counter < n) {
+        read_block_header32(block_ptr, geometry.miniblocks_in_block, &min_delta, bitwidths, &header_size);
+        block_ptr += header_size;
+
+        for(int i=0; (i<geometry.miniblocks_in_block) && (value_counter<n); i++) {
+            uint8_t current_bitwidth = bitwidths[i];
+            const uint8_t* next_miniblock = block_ptr + current_bitwidth*(miniblock_values/8);
+            if((current_bitwidth > 32) || (next_miniblock > data_end)) {
+                std::cerr << "[ERROR] Corrupt DELTA_BINARY_PACKED miniblock" << std::endl;
+                return status::FAIL;
+            }
+
+            for(int32_t j = 0; (j < miniblock_values) && (value_counter < n); j += MINIBLOCK_VALUES) {
+                const uint8_t* chunk = block_ptr + (j/8)*current_bitwidth;
+                int32_t chunk_values = std::min(std::min(MINIBLOCK_VALUES, miniblock_values-j), n-value_counter);
+
+                if(miniblock_values - j < MINIBLOCK_VALUES) {
+                    previous_value = delta_unpack_short_miniblock32(chunk, current_bitwidth, miniblock_values-j, min_delta, previous_value, values, chunk_values);
+                } else {
+                    previous_value = delta_unpack_miniblock32(chunk, current_bitwidth, min_delta, previous_value, values, chunk_values);
+                }
+
+                uint32_t mask = filter_values32(values, chunk_values, filter);
+                if(mask) {
+                    or_bits(selection, value_counter, mask);
+                    matches += out ? compact_values32(values, mask, out+matches) : __builtin_popcount(mask);
+                }
+                value_counter += chunk_values;
+            }
+            block_ptr = next_miniblock;
+        }
+    }
+
+    *num_matches = matches;
+
+    return status::OK;
+}
+
+status SWParquetReader::filter_delta_page64(const uint8_t* page_data, const uint8_t* data_end, int32_t n, const value_filter& filter, uint8_t* selection, int64_t* out, int32_t* num_matches){
+    const uint8_t* block_ptr = page_data;
+    delta_geometry geometry;
+    int32_t miniblock_values;
+    int64_t previous_value;
+    int64_t min_delta;
+    uint8_t bitwidths[MAX_MINIBLOCKS_IN_BLOCK];
+    int32_t header_size;
+    int64_t values[MINIBLOCK_VALUES] = {0};
+    int32_t matches = 0;
+
+    if(read_delta_header64(block_ptr, &geometry, &previous_value, &header_size) != status::OK) {
+        return status::FAIL;
+    }
+    block_ptr += header_size;
+    miniblock_values = geometry.miniblock_values();
+
+    if(n > geometry.total_value_count) {
+        std::cerr << "[ERROR] Delta stream holds " << geometry.total_value_count << " values, " << n << " expected" << std::endl;
+        return status::FAIL;
+    }
+
+    if(n > 0) {
+        values[0] = previous_value;
+        uint32_t mask = filter_values64(values, 1, filter);
+        selection[0] |= (uint8_t) mask;
+        matches += out ? compact_values64(values, mask, out) : mask;
+    }
+
+    int32_t value_counter = 1;
+    while(value_counter < n) {
+        read_block_header64(block_ptr, geometry.miniblocks_in_block, &min_delta, bitwidths, &header_size);
+        block_ptr += header_size;
+
+        for(int i=0; (i<geometry.miniblocks_in_block) && (value_counter<n); i++) {
+            uint8_t current_bitwidth = bitwidths[i];
+            const uint8_t* next_miniblock = block_ptr + current_bitwidth*(miniblock_values/8);
+            if((current_bitwidth > 64) || (next_miniblock > data_end)) {
+                std::cerr << "[ERROR] Corrupt DELTA_BINARY_PACKED miniblock" << std::endl;
+                return status::FAIL;
+            }
+
+            for(int32_t j = 0; (j < miniblock_values) && (value_counter < n); j += MINIBLOCK_VALUES) {
+                const uint8_t* chunk = block_ptr + (j/8)*current_bitwidth;
+                int32_t chunk_values = std::min(std::min(MINIBLOCK_VALUES, miniblock_values-j), n-value_counter);
+
+                if(miniblock_values - j < MINIBLOCK_VALUES) {
+                    previous_value = delta_unpack_short_miniblock64(chunk, current_bitwidth, miniblock_values-j, min_delta, previous_value, values, chunk_values);
+                } else {
+                    previous_value = delta_unpack_miniblock64(chunk, current_bitwidth, min_delta, previous_value, values, chunk_values);
+                }
+
+                uint32_t mask = filter_values64(values, chunk_values, filter);
+                if(mask) {
+                    or_bits(selection, value_counter, mask);
+                    matches += out ? compact_values64(values, mask, out+matches) : __builtin_popcount(mask);
+                }
+                value_counter += chunk_values;
+            }
+            block_ptr = next_miniblock;
+        }
+    }
+
+    *num_matches = matches;
+
+    return status::OK;
+}
+
+// Filter the first num_values rows of the DELTA_BINARY_PACKED column chunk at file_offset, page parallel. The rows that match are
+// set in selection, which must hold (num_values+7)/8 zeroed bytes, if given. The matching values of every page go to
+// page_matches, if given, in the order of the pages. Nulls never match.
+status SWParquetReader::filter_delta_pages(int32_t prim_width, int64_t num_values, int64_t file_offset, const value_filter& filter,
+                                           uint8_t* selection, std::vector<std::vector<uint8_t>>* page_matches, int64_t* num_matches){
+    const page_index* index;
+
+    if(get_page_index(file_offset, num_values, &index) != status::OK) {
+        return status::FAIL;
+    } else if(index->has_lists()) {
+        std::cerr << "[ERROR] Filtering values of repeated columns is not supported" << std::endl;
+        return status::FAIL;
+    }
+
+    int32_t num_pages = index->pages_for_rows(num_values);
+    std::atomic<bool> failed(false);
+    std::atomic<int64_t> matches(0);
+
+    if(page_matches) {
+        page_matches->assign(num_pages, std::vector<uint8_t>());
+    }
+
+    std::function<void(int64_t)> filter_page = [&](int64_t page){
+        int64_t first_row = index->first_rows[page];
+        int32_t page_rows_to_read = std::min((int64_t) index->num_values[page], num_values-first_row);
+        int32_t page_values_to_read = page_rows_to_read;
+        int32_t bit_offset = first_row % 8;
+        int32_t page_matches_found;
+
+        // Chunks can mix encodings, e.g. when a writer falls back from a dictionary, only delta pages can be filtered here
+        if(index->encodings[page] != parquet_encoding::DELTA_BINARY_PACKED) {
+            std::cerr << "[ERROR] Page at file offset " << index->page_offsets[page] << " uses encoding " << (int32_t) index->encodings[page] << ", filtering requires DELTA_BINARY_PACKED" << std::endl;
+            failed = true;
+            return;
+        }
+
+        page_contents contents;
+        if(get_page_contents(index, page, &contents) != status::OK) {
+            failed = true;
+            return;
+        }
+
+        // Only the values of non-null rows are stored in the page
+        if(index->max_def_level > 0) {
+            size_t validity_size = validity_buffer_size(page_rows_to_read, bit_offset);
+            if(filter_validity.size() < validity_size) {
+                filter_validity.resize(validity_size);
+            }
+            if(decode_def_levels(contents.def_levels, contents.def_levels_size, index->max_def_level, page_rows_to_read, filter_validity.data(), bit_offset, &page_values_to_read) != status::OK) {
+                std::cerr << "[ERROR] Corrupt definition levels in page at file offset " << index->page_offsets[page] << std::endl;
+                failed = true;
+                return;
+            }
+        }
+
+        filter_bits.assign(match_bits_size(page_values_to_read), 0);
+        uint8_t* out = nullptr;
+        if(page_matches) {
+            // Every compaction of up to 32 values may write 32 values
+            filter_matches.resize((size_t) (page_values_to_read + MINIBLOCK_VALUES)*prim_width/8);
+            out = filter_matches.data();
+        }
+
+        status decoded = prim_width == 32
+            ? filter_delta_page32(contents.values, contents.values + contents.values_size, page_values_to_read, filter, filter_bits.data(), (int32_t*) out, &page_matches_found)
+            : filter_delta_page64(contents.values, contents.values + contents.values_size, page_values_to_read, filter, filter_bits.data(), (int64_t*) out, &page_matches_found);
+        if(decoded != status::OK) {
+            failed = true;
+            return;
+        }
+
+        matches += page_matches_found;
+        if(page_matches) {
+            (*page_matches)[page].assign(out, out + (size_t) page_matches_found*prim_width/8);
+        }
+
+        // The match bits are per stored value, move them out to the rows of the page
+        if(selection && (page_matches_found > 0)) {
+            filter_row_bits.resize(validity_buffer_size(page_rows_to_read, bit_offset));
+            if(page_values_to_read < page_rows_to_read) {
+                scatter_bits_to_valid(filter_bits.data(), filter_validity.data(), bit_offset, page_rows_to_read, filter_row_bits.data());
+            } else {
+                copy_bits(filter_bits.data(), page_rows_to_read, filter_row_bits.data(), bit_offset);
+            }
+            merge_validity(filter_row_bits.data(), bit_offset, page_rows_to_read, selection + first_row/8);
+        }
+    };
+
+    for_each_page(num_pages, filter_page);
+
+    if(failed) {
+        return status::FAIL;
+    }
+
+    *num_matches = matches;
+
+    return status::OK;
+}
+
+// Find the rows among the first num_values of the column chunk at file_offset whose values fulfil pred, while decoding them.
+// selection gets a bitmap with a set bit for every matching row, num_selected the amount of them. Only DELTA_BINARY_PACKED
+// encoded INT32 and INT64 chunks can be filtered this way.
+status SWParquetReader::select_prim(int32_t prim_width, int64_t num_values, int64_t file_offset, const predicate& pred, std::shared_ptr<arrow::Buffer>* selection, int64_t* num_selected, encoding enc) {
+    value_filter filter;
+    bool can_match;
+
+    if(enc != encoding::DELTA){
+        std::cout<<"Unsupported encoding selected, filtered decoding requires DELTA encoding" << std::endl;
+        return status::FAIL;
+    } else if(make_value_filter(pred, prim_width, &filter, &can_match) != status::OK) {
+        return status::FAIL;
+    }
+
+    arrow::AllocateBuffer((num_values+7)/8, selection);
+    std::memset((*selection)->mutable_data(), 0, (*selection)->size());
+    *num_selected = 0;
+
+    if(!can_match) {
+        return status::OK;
+    }
+
+    return filter_delta_pages(prim_width, num_values, file_offset, filter, (*selection)->mutable_data(), nullptr, num_selected);
+}
+
+// Read only the values among the first num_values of the column chunk at file_offset that fulfil pred, into an array without nulls.
+// The values are compared while they are decoded and only the matching ones are stored, so the chunk is never materialized.
+status SWParquetReader::filter_prim(int32_t prim_width, int64_t num_values, int64_t file_offset, const predicate& pred, std::shared_ptr<arrow::PrimitiveArray>* prim_array, encoding enc) {
+    value_filter filter;
+    bool can_match;
+    std::vector<std::vector<uint8_t>> page_matches;
+    int64_t num_matches = 0;
+
+    if(enc != encoding::DELTA){
+        std::cout<<"Unsupported encoding selected, filtered decoding requires DELTA encoding" << std::endl;
+        return status::FAIL;
+    } else if((make_value_filter(pred, prim_width, &filter, &can_match) != status::OK)
+            || (can_match && (filter_delta_pages(prim_width, num_values, file_offset, filter, nullptr, &page_matches, &num_matches) != status::OK))) {
+        return status::FAIL;
+    }
+
+    std::shared_ptr<arrow::Buffer> arr_buffer;
+    arrow::AllocateBuffer(num_matches*prim_width/8, &arr_buffer);
+
+    uint8_t* arr_buf_ptr = arr_buffer->mutable_data();
+    for(const std::vector<uint8_t>& matches : page_matches) {
+        std::memcpy(arr_buf_ptr, matches.data(), matches.size());
+        arr_buf_ptr += matches.size();
+    }
+
+    *prim_array = std::make_shared<arrow::PrimitiveArray>(prim_width == 32 ? arrow::int32() : arrow::int64(), num_matches, arr_buffer);
+
+    return status::OK;
+}
+
+}
@@ -0,0 +1,210 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+
+#include "SWParquetReader.h"
+#include "FixedWidthKernels.h"
+#include "DictionaryKernels.h"
+#include "DefinitionLevels.h"
+#include "ptoa.h"
+
+namespace ptoa {
+
+// Indices of the dictionary encoded page a thread decodes last
+static thread_local std::vector<int32_t> dictionary_indices;
+
+static void copy_values(const uint8_t* in, int32_t width, int32_t n, uint8_t* out) {
+    std::memcpy(out, in, (int64_t) n*width);
+}
+
+static void convert_int96(const uint8_t* in, int32_t width, int32_t n, uint8_t* out) {
+    (void) width;
+    int96_to_timestamp_ns(in, n, (int64_t*) out);
+}
+
+status SWParquetReader::read_fixed_len(int32_t type_length, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::FixedSizeBinaryArray>* fixed_array, encoding enc) {
+    std::shared_ptr<arrow::Buffer> arr_buffer;
+    arrow::AllocateBuffer(num_values*type_length, &arr_buffer);
+
+    return read_fixed_len(type_length, num_values, file_offset, fixed_array, arr_buffer, enc);
+}
+
+// Read a number (set by num_values) of FIXED_LEN_BYTE_ARRAY values of type_length bytes into fixed_array, with a pre-allocated buffer
+status SWParquetReader::read_fixed_len(int32_t type_length, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::FixedSizeBinaryArray>* fixed_array, std::shared_ptr<arrow::Buffer> arr_buffer, encoding enc) {
+    const page_index* index;
+    std::shared_ptr<arrow::Buffer> null_bitmap;
+    int64_t null_count = 0;
+
+    if(type_length <= 0) {
+        std::cerr << "[ERROR] Unsupported type length " << type_length << std::endl;
+        return status::FAIL;
+    }
+
+    if((get_page_index(file_offset, num_values, &index) != status::OK)
+            || (read_fixed_pages(index, num_values, type_length, type_length, copy_values, enc, arr_buffer->mutable_data(), &null_bitmap, &null_count) != status::OK)) {
+        return status::FAIL;
+    }
+
+    *fixed_array = std::make_shared<arrow::FixedSizeBinaryArray>(arrow::fixed_size_binary(type_length), num_values, arr_buffer, null_bitmap, null_count);
+
+    return status::OK;
+}
+
+status SWParquetReader::read_decimal(int32_t type_length, int32_t precision, int32_t scale, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::Decimal128Array>* decimal_array, encoding enc) {
+    std::shared_ptr<arrow::Buffer> arr_buffer;
+    arrow::AllocateBuffer(num_values*16, &arr_buffer);
+
+    return read_decimal(type_length, precision, scale, num_values, file_offset, decimal_array, arr_buffer, enc);
+}
+
+// Read FIXED_LEN_BYTE_ARRAY DECIMAL values of type_length bytes into decimal_array, with a pre-allocated buffer of 16 bytes per value.
+// Dictionaries are converted once, their values are then copied as they are.
+status SWParquetReader::read_decimal(int32_t type_length, int32_t precision, int32_t scale, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::Decimal128Array>* decimal_array, std::shared_ptr<arrow::Buffer> arr_buffer, encoding enc) {
+    const page_index* index;
+    std::shared_ptr<arrow::Buffer> null_bitmap;
+    int64_t null_count = 0;
+
+    if((type_length <= 0) || (type_length > 16) || (precision <= 0) || (precision > 38)) {
+        std::cerr << "[ERROR] Unsupported DECIMAL(" << precision << ", " << scale << ") of type length " << type_length << std::endl;
+        return status::FAIL;
+    }
+
+    if((get_page_index(file_offset, num_values, &index) != status::OK)
+            || (read_fixed_pages(index, num_values, type_length, 16, decimal_to_decimal128, enc, arr_buffer->mutable_data(), &null_bitmap, &null_count) != status::OK)) {
+        return status::FAIL;
+    }
+
+    *decimal_array = std::make_shared<arrow::Decimal128Array>(arrow::decimal(precision, scale), num_values, arr_buffer, null_bitmap, null_count);
+
+    return status::OK;
+}
+
+status SWParquetReader::read_int96_timestamp(int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, encoding enc) {
+    std::shared_ptr<arrow::Buffer> arr_buffer;
+    arrow::AllocateBuffer(num_values*sizeof(int64_t), &arr_buffer);
+
+    return read_int96_timestamp(num_values, file_offset, prim_array, arr_buffer, enc);
+}
+
+// Read INT96 timestamps into prim_array as nanosecond timestamps, with a pre-allocated buffer of 8 bytes per value.
+// Dictionaries are converted once, dictionary encoded pages are then decoded like those of INT64 columns.
+status SWParquetReader::read_int96_timestamp(int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer, encoding enc) {
+    const page_index* index;
+    std::shared_ptr<arrow::Buffer> null_bitmap;
+    int64_t null_count = 0;
+
+    if((get_page_index(file_offset, num_values, &index) != status::OK)
+            || (read_fixed_pages(index, num_values, 12, sizeof(int64_t), convert_int96, enc, arr_buffer->mutable_data(), &null_bitmap, &null_count) != status::OK)) {
+        return status::FAIL;
+    }
+
+    *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow::timestamp(arrow::TimeUnit::NANO), num_values, arr_buffer, null_bitmap, null_count);
+
+    return status::OK;
+}
+
+// Decode the first num_values rows of PLAIN or dictionary encoded values of value_width bytes into out, converted to out_width
+// bytes each by convert. With encoding::DICTIONARY the dictionary page is converted up front and PLAIN pages that writers
+// fall back to are read as well. Null rows are zeroed, null_bitmap and null_count are set like read_dictionary_indices does.
+status SWParquetReader::read_fixed_pages(const page_index* index, int64_t num_values, int32_t value_width, int32_t out_width, fixed_converter convert, encoding enc,
+                                         uint8_t* out, std::shared_ptr<arrow::Buffer>* null_bitmap, int64_t* null_count) {
+    dictionary_values dictionary;
+    std::vector<uint8_t> converted_dictionary;
+
+    if(enc == encoding::DICTIONARY) {
+        if(read_dictionary_page(index, value_width, &dictionary) != status::OK) {
+            return status::FAIL;
+        }
+        converted_dictionary.resize((int64_t) dictionary.num_values*out_width);
+        convert(dictionary.values->data(), value_width, dictionary.num_values, converted_dictionary.data());
+    } else if(enc != encoding::PLAIN) {
+        std::cout<<"Unsupported encoding selected, fixed width values are read with PLAIN or DICTIONARY encoding" << std::endl;
+        return status::FAIL;
+    }
+
+    allocate_null_bitmap(index->max_def_level > 0, num_values, null_bitmap);
+
+    int32_t num_pages = index->pages_for_rows(num_values);
+    std::atomic<bool> failed(false);
+    std::atomic<int64_t> nulls(0);
+
+    std::function<void(int64_t)> decode_page = [&](int64_t page){
+        int64_t first_row = index->first_rows[page];
+        int32_t page_rows_to_read = std::min((int64_t) index->num_values[page], num_values-first_row);
+        int32_t page_values_to_read = page_rows_to_read;
+        uint8_t* page_out = out + first_row*out_width;
+
+        page_contents contents;
+        const uint8_t* validity_bits;
+
+        if((get_page_contents(index, page, &contents) != status::OK)
+                || (*null_bitmap && (decode_page_validity(index, page, contents, first_row, page_rows_to_read, (*null_bitmap)->mutable_data(), &validity_bits, &page_values_to_read) != status::OK))) {
+            failed = true;
+            return;
+        }
+
+        status decoded = status::FAIL;
+        if(index->encodings[page] == parquet_encoding::PLAIN) {
+            if((int64_t) contents.values_size >= (int64_t) page_values_to_read*value_width) {
+                convert(contents.values, value_width, page_values_to_read, page_out);
+                decoded = status::OK;
+            }
+        } else if(!index->dictionary_encoded(page) || (enc != encoding::DICTIONARY)) {
+            std::cerr << "[ERROR] Page at file offset " << index->page_offsets[page] << " uses unsupported encoding " << (int32_t) index->encodings[page] << std::endl;
+            failed = true;
+            return;
+        } else if(out_width == sizeof(int64_t)) {
+            decoded = decode_dictionary_values64(contents.values, contents.values_size, (const int64_t*) converted_dictionary.data(), dictionary.num_values, page_values_to_read, (int64_t*) page_out);
+        } else {
+            if(dictionary_indices.size() < (size_t) page_values_to_read) {
+                dictionary_indices.resize(page_values_to_read);
+            }
+            decoded = decode_dictionary_indices(contents.values, contents.values_size, dictionary.num_values, page_values_to_read, dictionary_indices.data());
+            if(decoded == status::OK) {
+                gather_fixed(converted_dictionary.data(), out_width, dictionary_indices.data(), page_values_to_read, page_out);
+            }
+        }
+
+        if(decoded != status::OK) {
+            std::cerr << "[ERROR] Corrupt values in page at file offset " << index->page_offsets[page] << std::endl;
+            failed = true;
+            return;
+        }
+
+        if(page_values_to_read < page_rows_to_read) {
+            nulls += page_rows_to_read - page_values_to_read;
+            if(out_width == sizeof(int64_t)) {
+                scatter_to_valid((int64_t*) page_out, validity_bits, first_row % 8, page_rows_to_read, page_values_to_read);
+            } else {
+                scatter_fixed_to_valid(page_out, out_width, validity_bits, first_row % 8, page_rows_to_read, page_values_to_read);
+            }
+        }
+    };
+
+    for_each_page(num_pages, decode_page);
+
+    if(failed) {
+        return status::FAIL;
+    }
+
+    *null_count = nulls;
+    drop_empty_null_bitmap(*null_count, null_bitmap);
+
+    return status::OK;
+}
+
+}
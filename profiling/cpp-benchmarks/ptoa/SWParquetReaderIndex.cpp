@@ -0,0 +1,198 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+#include "SWParquetReader.h"
+#include "ptoa.h"
+
+namespace ptoa {
+
+static void record_dictionary_page(int64_t page_offset, const page_header& header, page_index* index) {
+    index->dictionary.page_offset = page_offset;
+    index->dictionary.header_size = header.header_size;
+    index->dictionary.compressed_size = header.compressed_size;
+    index->dictionary.uncompressed_size = header.uncompressed_size;
+    index->dictionary.num_values = header.num_values;
+}
+
+// Walk the page headers starting at file_offset once and record where every page is.
+// If the footer describes a column chunk starting at file_offset, the walk stops at the end of that chunk.
+// Otherwise it continues until the end of the file or the first structure that is not a page header. With a footer, the pages
+// found have to hold all values of the chunk, a header that does not parse before that is corrupt.
+// Index pages are stepped over, data pages of either version are recorded, and so is the dictionary page. A dictionary
+// page in front of file_offset is found through the footer, which lets callers start at the first data page.
+// Without a footer the codec and column are unknown, the pages are taken to be uncompressed and to hold a required column.
+status SWParquetReader::build_page_index(int64_t file_offset, page_index* index) {
+    int64_t end_offset = file_size;
+    int64_t dictionary_offset = -1;
+    int64_t chunk_num_values = -1;
+    compression_codec codec = compression_codec::UNCOMPRESSED;
+
+    // Only consult the footer if there is one, files containing nothing but pages are fine as well
+    if(file_metadata_read || ((file_size >= 12) && (std::memcmp(parquet_data + file_size - 4, "PAR1", 4) == 0))) {
+        const file_metadata* footer_metadata;
+        if(get_file_metadata(&footer_metadata) == status::OK) {
+            for(size_t i = 0; i < footer_metadata->column_chunks.size(); i++) {
+                const column_chunk_info& chunk = footer_metadata->column_chunks[i];
+                if((chunk.data_page_offset == file_offset) || (chunk.chunk_offset() == file_offset)) {
+                    const column_info& column = footer_metadata->columns[i % footer_metadata->num_columns()];
+                    end_offset = std::min(end_offset, chunk.chunk_offset() + chunk.total_compressed_size);
+                    codec = chunk.codec;
+                    dictionary_offset = chunk.dictionary_page_offset;
+                    chunk_num_values = chunk.num_values;
+                    index->max_def_level = column.max_def_level;
+                    index->max_rep_level = column.max_rep_level;
+                    index->repeated_def_level = column.repeated_def_level;
+                    break;
+                }
+            }
+        }
+    }
+
+    page_header header;
+    int64_t page_offset = file_offset;
+    int64_t row_counter = 0;
+
+    index->first_rows.push_back(0);
+    index->codec = codec;
+
+    // Some writers record a dictionary page offset of 0 for chunks without one, so only a dictionary page counts
+    if((dictionary_offset >= 0) && (dictionary_offset < file_offset)
+            && (read_page_header(parquet_data + dictionary_offset, parquet_data + end_offset, &header) == status::OK)
+            && (header.type == page_type::DICTIONARY_PAGE)
+            && (dictionary_offset + header.header_size + header.compressed_size <= file_offset)) {
+        record_dictionary_page(dictionary_offset, header, index);
+    }
+
+    while(page_offset < end_offset){
+        if(read_page_header(parquet_data + page_offset, parquet_data + end_offset, &header) != status::OK) {
+            break;
+        }
+
+        if(page_offset + header.header_size + header.compressed_size > (int64_t) file_size) {
+            std::cerr << "[ERROR] Page at file offset " << page_offset << " extends beyond the end of the file" << std::endl;
+            return status::FAIL;
+        }
+
+        // Dictionary and index pages hold no rows
+        if(!header.is_data_page()) {
+            if((header.type == page_type::DICTIONARY_PAGE) && !index->has_dictionary()) {
+                record_dictionary_page(page_offset, header, index);
+            }
+            page_offset += header.header_size + header.compressed_size;
+            continue;
+        }
+
+        // Version 2 pages store their levels uncompressed in front of the values and may leave the values uncompressed as well
+        bool values_compressed = codec != compression_codec::UNCOMPRESSED;
+        if(header.type == page_type::DATA_PAGE_V2) {
+            values_compressed = values_compressed && header.is_compressed;
+            index->has_nulls = index->has_nulls || (header.num_nulls > 0);
+        } else if((index->max_def_level > 0) && (header.def_level_encoding != parquet_encoding::RLE)) {
+            std::cerr << "[ERROR] Page at file offset " << page_offset << " uses unsupported definition level encoding " << (int32_t) header.def_level_encoding << std::endl;
+            return status::FAIL;
+        } else if((index->max_rep_level > 0) && (header.rep_level_encoding != parquet_encoding::RLE)) {
+            std::cerr << "[ERROR] Page at file offset " << page_offset << " uses unsupported repetition level encoding " << (int32_t) header.rep_level_encoding << std::endl;
+            return status::FAIL;
+        }
+
+        row_counter += header.num_values;
+
+        index->page_offsets.push_back(page_offset);
+        index->header_sizes.push_back(header.header_size);
+        index->compressed_sizes.push_back(header.compressed_size);
+        index->uncompressed_sizes.push_back(header.uncompressed_size);
+        index->page_types.push_back(header.type);
+        index->encodings.push_back(header.encoding);
+        index->level_sizes.push_back(header.def_level_length + header.rep_level_length);
+        index->def_level_sizes.push_back(header.def_level_length);
+        index->values_compressed.push_back(values_compressed);
+        index->num_values.push_back(header.num_values);
+        index->first_rows.push_back(row_counter);
+        index->statistics.push_back(header.statistics);
+
+        page_offset += header.header_size + header.compressed_size;
+    }
+
+    if(index->num_pages() == 0) {
+        std::cerr << "[ERROR] No Parquet page header found at file offset " << file_offset << std::endl;
+        return status::FAIL;
+    }
+
+    if(row_counter < chunk_num_values) {
+        std::cerr << "[ERROR] Pages at file offset " << file_offset << " hold " << row_counter << " of the " << chunk_num_values << " values of their column chunk, no page header could be read at file offset " << page_offset << std::endl;
+        return status::FAIL;
+    }
+
+    // The values of list columns belong to the list elements, which are only known from the levels
+    if((index->max_rep_level == 1) && (decode_list_levels(index) != status::OK)) {
+        return status::FAIL;
+    }
+
+    return status::OK;
+}
+
+// Returns the page index of the column chunk starting at file_offset, building it on first access
+status SWParquetReader::get_page_index(int64_t file_offset, const page_index** index) {
+    auto index_it = page_indices.find(file_offset);
+
+    if(index_it == page_indices.end()) {
+        page_index new_index;
+        if(build_page_index(file_offset, &new_index) != status::OK) {
+            return status::FAIL;
+        }
+        index_it = page_indices.insert(std::make_pair(file_offset, std::move(new_index))).first;
+    }
+
+    *index = &index_it->second;
+
+    return status::OK;
+}
+
+// Same as above, but additionally checks that the column chunk holds at least num_values values
+// and that the pages holding them can be decoded, which rules out nested lists, nulls in columns that are
+// required according to the footer and codecs without a decompressor
+status SWParquetReader::get_page_index(int64_t file_offset, int64_t num_values, const page_index** index) {
+    if(get_page_index(file_offset, index) != status::OK) {
+        return status::FAIL;
+    }
+
+    if((*index)->total_rows() < num_values) {
+        std::cerr << "[ERROR] Requested " << num_values << " values but the pages at file offset " << file_offset << " only hold " << (*index)->total_rows() << std::endl;
+        return status::FAIL;
+    }
+
+    if((*index)->max_rep_level > 1) {
+        std::cerr << "[ERROR] Pages at file offset " << file_offset << " hold a column nested in more than one list, which is not supported" << std::endl;
+        return status::FAIL;
+    }
+
+    if((*index)->has_nulls && ((*index)->max_def_level == 0)) {
+        std::cerr << "[ERROR] Pages at file offset " << file_offset << " contain nulls but do not belong to a nullable column" << std::endl;
+        return status::FAIL;
+    }
+
+    int32_t num_pages = (*index)->pages_for_rows(num_values);
+    for(int32_t page = 0; page < num_pages; page++) {
+        if((*index)->values_compressed[page] && !codec_supported((*index)->codec)) {
+            std::cerr << "[ERROR] Page at file offset " << (*index)->page_offsets[page] << " is compressed with unsupported codec " << (int32_t) (*index)->codec << std::endl;
+            return status::FAIL;
+        }
+    }
+
+    return status::OK;
+}
+
+}
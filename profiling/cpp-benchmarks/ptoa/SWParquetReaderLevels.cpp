@@ -0,0 +1,164 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <functional>
+#include <climits>
+
+#include "SWParquetReader.h"
+#include "DefinitionLevels.h"
+#include "ptoa.h"
+
+namespace ptoa {
+
+// Validity bits of the page a thread decodes last, laid out at the bit offset the page has in the output bitmap
+static thread_local std::vector<uint8_t> page_validity;
+
+// Decode the definition levels of the first num_rows rows of a page, which go to rows first_row and up of the output,
+// into validity, the zeroed validity bitmap of the whole output. Pages can be decoded by different threads at the same time.
+// bits is set to a copy of the page's validity bits, from bit first_row%8 on, that stays valid until the thread's next call.
+status SWParquetReader::decode_page_validity(const page_index* index, int32_t page, const page_contents& contents, int64_t first_row, int32_t num_rows, uint8_t* validity, const uint8_t** bits, int32_t* valid_count) {
+    int32_t bit_offset = first_row % 8;
+
+    // The validity of list elements is decoded along with the lists. The first and last byte also hold bits of neighbouring
+    // elements, merging those sets no bits that their own pages do not set as well.
+    if(index->has_lists()) {
+        *bits = index->element_validity.data() + first_row/8;
+        *valid_count = count_bits(*bits, bit_offset, num_rows);
+        merge_validity(*bits, bit_offset, num_rows, validity + first_row/8);
+        return status::OK;
+    }
+
+    size_t buffer_size = validity_buffer_size(num_rows, bit_offset);
+    if(page_validity.size() < buffer_size) {
+        page_validity.resize(buffer_size);
+    }
+
+    if(decode_def_levels(contents.def_levels, contents.def_levels_size, index->max_def_level, num_rows, page_validity.data(), bit_offset, valid_count) != status::OK) {
+        std::cerr << "[ERROR] Corrupt definition levels in page at file offset " << index->page_offsets[page] << std::endl;
+        return status::FAIL;
+    }
+
+    merge_validity(page_validity.data(), bit_offset, num_rows, validity + first_row/8);
+    *bits = page_validity.data();
+
+    return status::OK;
+}
+
+// Lists, elements and their validity bits of one page, before the pages are put together
+struct page_lists {
+    std::vector<int32_t> offsets;
+    std::vector<uint8_t> list_validity;
+    std::vector<uint8_t> element_validity;
+    list_counts counts;
+};
+
+// Levels of the page a thread decodes last, one byte per level entry
+static thread_local std::vector<uint8_t> page_rep_levels;
+static thread_local std::vector<uint8_t> page_def_levels;
+
+// Appends n bits, from the first bit of bits on, to bitmap at bit bit_offset, through the validity bits buffer of the thread
+static void append_page_bits(const uint8_t* bits, int64_t bit_offset, int32_t n, uint8_t* bitmap) {
+    size_t buffer_size = validity_buffer_size(n, bit_offset % 8);
+    if(page_validity.size() < buffer_size) {
+        page_validity.resize(buffer_size);
+    }
+    copy_bits(bits, n, page_validity.data(), bit_offset % 8);
+    merge_validity(page_validity.data(), bit_offset % 8, n, bitmap + bit_offset/8);
+}
+
+// Decode the repetition and definition levels of all pages of a column with one level of repetition into the list offsets
+// and the validity bitmaps of the lists and elements. Pages are decoded in parallel, then put together at their offsets.
+// first_rows and num_values are changed to count the elements of the pages, lists may span pages.
+status SWParquetReader::decode_list_levels(page_index* index) {
+    int32_t num_pages = index->num_pages();
+    std::vector<page_lists> pages(num_pages);
+    std::atomic<bool> failed(false);
+
+    std::function<void(int64_t)> decode_page = [&](int64_t page){
+        int32_t num_levels = index->num_values[page];
+        page_contents contents;
+
+        if(get_page_contents(index, page, &contents) != status::OK) {
+            failed = true;
+            return;
+        }
+
+        if(page_rep_levels.size() < (size_t) num_levels) {
+            page_rep_levels.resize(num_levels);
+            page_def_levels.resize(num_levels);
+        }
+
+        if((decode_levels(contents.rep_levels, contents.rep_levels_size, index->max_rep_level, num_levels, page_rep_levels.data()) != status::OK)
+                || (decode_levels(contents.def_levels, contents.def_levels_size, index->max_def_level, num_levels, page_def_levels.data()) != status::OK)) {
+            std::cerr << "[ERROR] Corrupt levels in page at file offset " << index->page_offsets[page] << std::endl;
+            failed = true;
+            return;
+        }
+
+        page_lists& lists = pages[page];
+        lists.offsets.resize(num_levels);
+        lists.list_validity.resize(validity_buffer_size(num_levels, 0));
+        lists.element_validity.resize(validity_buffer_size(num_levels, 0));
+        levels_to_lists(page_rep_levels.data(), page_def_levels.data(), num_levels, index->repeated_def_level, index->max_def_level,
+                        lists.offsets.data(), lists.list_validity.data(), lists.element_validity.data(), &lists.counts);
+    };
+
+    for_each_page(num_pages, decode_page);
+
+    if(failed) {
+        return status::FAIL;
+    }
+
+    // Lists and elements in front of every page
+    std::vector<int64_t> first_lists(num_pages + 1, 0);
+    int64_t num_valid_lists = 0;
+    for(int32_t page = 0; page < num_pages; page++) {
+        first_lists[page+1] = first_lists[page] + pages[page].counts.num_lists;
+        index->first_rows[page+1] = index->first_rows[page] + pages[page].counts.num_elements;
+        index->num_values[page] = pages[page].counts.num_elements;
+        num_valid_lists += pages[page].counts.num_valid_lists;
+    }
+
+    int64_t num_lists = first_lists[num_pages];
+    int64_t num_elements = index->total_rows();
+    if(num_elements > INT32_MAX) {
+        std::cerr << "[ERROR] Column chunk with page at file offset " << index->page_offsets[0] << " holds more list elements than Arrow lists can address" << std::endl;
+        return status::FAIL;
+    }
+
+    index->list_offsets.resize(num_lists + 1);
+    index->list_validity.assign((num_lists+7)/8, 0);
+    index->element_validity.assign((num_elements+7)/8, 0);
+    index->num_null_lists = num_lists - num_valid_lists;
+    index->list_offsets[num_lists] = num_elements;
+
+    std::function<void(int64_t)> place_page = [&](int64_t page){
+        const page_lists& lists = pages[page];
+        int32_t* offsets = index->list_offsets.data() + first_lists[page];
+        int32_t first_element = index->first_rows[page];
+
+        for(int32_t i = 0; i < lists.counts.num_lists; i++) {
+            offsets[i] = lists.offsets[i] + first_element;
+        }
+        append_page_bits(lists.list_validity.data(), first_lists[page], lists.counts.num_lists, index->list_validity.data());
+        append_page_bits(lists.element_validity.data(), first_element, lists.counts.num_elements, index->element_validity.data());
+    };
+
+    for_each_page(num_pages, place_page);
+
+    return status::OK;
+}
+
+}
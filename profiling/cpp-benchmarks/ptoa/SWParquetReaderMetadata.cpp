@@ -0,0 +1,538 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+#include "SWParquetReader.h"
+#include "ThriftCompact.h"
+#include "ptoa.h"
+
+namespace ptoa {
+
+// Schema element as it appears in the flattened, depth first schema list of the footer
+struct schema_element {
+    std::string name;
+    parquet_type type;
+    int32_t type_length;
+    repetition_type repetition;
+    int32_t num_children;
+    int32_t converted_type;         // -1 if not set
+    int32_t scale;
+    int32_t precision;
+};
+
+// DECIMAL in the ConvertedType enum of parquet.thrift
+const int32_t CONVERTED_TYPE_DECIMAL = 5;
+
+static void read_schema_element(ThriftCompactReader* thrift, schema_element* element) {
+    element->type = parquet_type::INT32;
+    element->type_length = 0;
+    element->repetition = repetition_type::REQUIRED;
+    element->num_children = 0;
+    element->converted_type = -1;
+    element->scale = 0;
+    element->precision = 0;
+
+    int16_t last_field_id = 0;
+    int16_t field_id;
+    uint8_t field_type;
+
+    while(thrift->read_field_header(&last_field_id, &field_id, &field_type)) {
+        if(field_id == 1 && field_type == T_I32) {
+            element->type = (parquet_type) thrift->read_i32();
+        } else if(field_id == 2 && field_type == T_I32) {
+            element->type_length = thrift->read_i32();
+        } else if(field_id == 3 && field_type == T_I32) {
+            element->repetition = (repetition_type) thrift->read_i32();
+        } else if(field_id == 4 && field_type == T_BINARY) {
+            element->name = thrift->read_binary();
+        } else if(field_id == 5 && field_type == T_I32) {
+            element->num_children = thrift->read_i32();
+        } else if(field_id == 6 && field_type == T_I32) {
+            element->converted_type = thrift->read_i32();
+        } else if(field_id == 7 && field_type == T_I32) {
+            element->scale = thrift->read_i32();
+        } else if(field_id == 8 && field_type == T_I32) {
+            element->precision = thrift->read_i32();
+        } else {
+            thrift->skip(field_type);
+        }
+    }
+}
+
+static void read_statistics(ThriftCompactReader* thrift, value_statistics* statistics) {
+    int16_t last_field_id = 0;
+    int16_t field_id;
+    uint8_t field_type;
+
+    while(thrift->read_field_header(&last_field_id, &field_id, &field_type)) {
+        if(field_id == 1 && field_type == T_BINARY) {
+            statistics->max.data = thrift->read_binary_bytes(&statistics->max.size);
+        } else if(field_id == 2 && field_type == T_BINARY) {
+            statistics->min.data = thrift->read_binary_bytes(&statistics->min.size);
+        } else if(field_id == 3 && field_type == T_I64) {
+            statistics->null_count = thrift->read_i64();
+        } else if(field_id == 5 && field_type == T_BINARY) {
+            statistics->max_value.data = thrift->read_binary_bytes(&statistics->max_value.size);
+        } else if(field_id == 6 && field_type == T_BINARY) {
+            statistics->min_value.data = thrift->read_binary_bytes(&statistics->min_value.size);
+        } else {
+            thrift->skip(field_type);
+        }
+    }
+}
+
+static void read_column_metadata(ThriftCompactReader* thrift, column_chunk_info* chunk) {
+    int16_t last_field_id = 0;
+    int16_t field_id;
+    uint8_t field_type;
+
+    while(thrift->read_field_header(&last_field_id, &field_id, &field_type)) {
+        if(field_id == 1 && field_type == T_I32) {
+            chunk->type = (parquet_type) thrift->read_i32();
+        } else if(field_id == 2 && field_type == T_LIST) {
+            uint8_t element_type;
+            uint32_t size = thrift->read_list_header(&element_type);
+            for(uint32_t i=0; i<size && !thrift->failed(); i++) {
+                int32_t enc = thrift->read_i32();
+                if(enc >= 0 && enc < 32) {
+                    chunk->encodings |= 1u << enc;
+                }
+            }
+        } else if(field_id == 4 && field_type == T_I32) {
+            chunk->codec = (compression_codec) thrift->read_i32();
+        } else if(field_id == 5 && field_type == T_I64) {
+            chunk->num_values = thrift->read_i64();
+        } else if(field_id == 6 && field_type == T_I64) {
+            chunk->total_uncompressed_size = thrift->read_i64();
+        } else if(field_id == 7 && field_type == T_I64) {
+            chunk->total_compressed_size = thrift->read_i64();
+        } else if(field_id == 9 && field_type == T_I64) {
+            chunk->data_page_offset = thrift->read_i64();
+        } else if(field_id == 11 && field_type == T_I64) {
+            chunk->dictionary_page_offset = thrift->read_i64();
+        } else if(field_id == 12 && field_type == T_STRUCT) {
+            read_statistics(thrift, &chunk->statistics);
+        } else {
+            thrift->skip(field_type);
+        }
+    }
+}
+
+// Returns false for column chunks that live in another file, which is not supported
+static bool read_column_chunk(ThriftCompactReader* thrift, column_chunk_info* chunk) {
+    bool local = true;
+
+    chunk->data_page_offset = -1;
+    chunk->dictionary_page_offset = -1;
+    chunk->total_compressed_size = 0;
+    chunk->total_uncompressed_size = 0;
+    chunk->num_values = 0;
+    chunk->type = parquet_type::INT32;
+    chunk->codec = compression_codec::UNCOMPRESSED;
+    chunk->encodings = 0;
+    chunk->statistics.max.data = nullptr;
+    chunk->statistics.min.data = nullptr;
+    chunk->statistics.null_count = -1;
+    chunk->statistics.max_value.data = nullptr;
+    chunk->statistics.min_value.data = nullptr;
+    chunk->column_index_offset = -1;
+    chunk->column_index_length = 0;
+    chunk->offset_index_offset = -1;
+    chunk->offset_index_length = 0;
+
+    int16_t last_field_id = 0;
+    int16_t field_id;
+    uint8_t field_type;
+
+    while(thrift->read_field_header(&last_field_id, &field_id, &field_type)) {
+        if(field_id == 1 && field_type == T_BINARY) {
+            local = thrift->read_binary().empty();
+        } else if(field_id == 3 && field_type == T_STRUCT) {
+            read_column_metadata(thrift, chunk);
+        } else if(field_id == 4 && field_type == T_I64) {
+            chunk->offset_index_offset = thrift->read_i64();
+        } else if(field_id == 5 && field_type == T_I32) {
+            chunk->offset_index_length = thrift->read_i32();
+        } else if(field_id == 6 && field_type == T_I64) {
+            chunk->column_index_offset = thrift->read_i64();
+        } else if(field_id == 7 && field_type == T_I32) {
+            chunk->column_index_length = thrift->read_i32();
+        } else {
+            thrift->skip(field_type);
+        }
+    }
+
+    return local;
+}
+
+static status read_row_group(ThriftCompactReader* thrift, file_metadata* metadata, row_group_info* row_group) {
+    size_t first_chunk = metadata->column_chunks.size();
+
+    row_group->num_rows = 0;
+
+    int16_t last_field_id = 0;
+    int16_t field_id;
+    uint8_t field_type;
+
+    while(thrift->read_field_header(&last_field_id, &field_id, &field_type)) {
+        if(field_id == 1 && field_type == T_LIST) {
+            uint8_t element_type;
+            uint32_t size = thrift->read_list_header(&element_type);
+            if(size != metadata->columns.size()) {
+                std::cerr << "[ERROR] Row group has " << size << " column chunks but the schema has " << metadata->columns.size() << " columns" << std::endl;
+                return status::FAIL;
+            }
+            for(uint32_t i=0; i<size && !thrift->failed(); i++) {
+                column_chunk_info chunk;
+                if(!read_column_chunk(thrift, &chunk)) {
+                    std::cerr << "[ERROR] Column chunks stored in external files are not supported" << std::endl;
+                    return status::FAIL;
+                }
+                metadata->column_chunks.push_back(chunk);
+            }
+        } else if(field_id == 3 && field_type == T_I64) {
+            row_group->num_rows = thrift->read_i64();
+        } else {
+            thrift->skip(field_type);
+        }
+    }
+
+    if(metadata->column_chunks.size() != first_chunk + metadata->columns.size()) {
+        return status::FAIL;
+    }
+
+    return status::OK;
+}
+
+// Walks the depth first schema list starting at element index and appends all leaves to columns
+static status flatten_schema(const std::vector<schema_element>& schema, size_t* index, std::string path, int16_t def_level, int16_t rep_level,
+                             int16_t repeated_def_level, std::vector<column_info>* columns) {
+    if(*index >= schema.size()) {
+        return status::FAIL;
+    }
+
+    const schema_element& element = schema[*index];
+    (*index)++;
+
+    if(element.repetition == repetition_type::OPTIONAL) {
+        def_level++;
+    } else if(element.repetition == repetition_type::REPEATED) {
+        def_level++;
+        rep_level++;
+        repeated_def_level = def_level;
+    }
+
+    if(element.num_children == 0) {
+        column_info column;
+        column.path = path + element.name;
+        column.type = element.type;
+        column.type_length = element.type_length;
+        column.decimal_precision = element.converted_type == CONVERTED_TYPE_DECIMAL ? element.precision : 0;
+        column.decimal_scale = element.converted_type == CONVERTED_TYPE_DECIMAL ? element.scale : 0;
+        column.repetition = element.repetition;
+        column.max_def_level = def_level;
+        column.max_rep_level = rep_level;
+        column.repeated_def_level = repeated_def_level;
+        columns->push_back(column);
+        return status::OK;
+    }
+
+    for(int32_t i=0; i<element.num_children; i++) {
+        if(flatten_schema(schema, index, path + element.name + ".", def_level, rep_level, repeated_def_level, columns) != status::OK) {
+            return status::FAIL;
+        }
+    }
+
+    return status::OK;
+}
+
+// Parse the FileMetaData footer at the end of the file into the in-memory catalog
+status SWParquetReader::read_file_metadata() {
+    // File layout ends with: footer, 4 byte little endian footer length, "PAR1"
+    if((file_size < 12) || (std::memcmp(parquet_data + file_size - 4, "PAR1", 4) != 0)) {
+        std::cerr << "[ERROR] File does not end with a Parquet footer" << std::endl;
+        return status::FAIL;
+    }
+
+    uint32_t footer_size;
+    std::memcpy(&footer_size, parquet_data + file_size - 8, sizeof(footer_size));
+
+    if(footer_size > file_size - 12) {
+        std::cerr << "[ERROR] Parquet footer size " << footer_size << " exceeds file size" << std::endl;
+        return status::FAIL;
+    }
+
+    const uint8_t* footer = parquet_data + file_size - 8 - footer_size;
+    ThriftCompactReader thrift(footer, footer + footer_size);
+    std::vector<schema_element> schema;
+    std::vector<row_group_info> row_groups;
+
+    metadata.num_rows = 0;
+    metadata.columns.clear();
+    metadata.row_groups.clear();
+    metadata.column_chunks.clear();
+
+    int16_t last_field_id = 0;
+    int16_t field_id;
+    uint8_t field_type;
+
+    while(thrift.read_field_header(&last_field_id, &field_id, &field_type)) {
+        if(field_id == 2 && field_type == T_LIST) {
+            uint8_t element_type;
+            uint32_t size = thrift.read_list_header(&element_type);
+            schema.resize(std::min(size, footer_size));
+            for(uint32_t i=0; i<schema.size() && !thrift.failed(); i++) {
+                read_schema_element(&thrift, &schema[i]);
+            }
+
+            // The first element is the root of the schema, its name is not part of the column paths
+            size_t index = 1;
+            for(int32_t i=0; i<(schema.empty() ? 0 : schema[0].num_children); i++) {
+                if(flatten_schema(schema, &index, "", 0, 0, 0, &metadata.columns) != status::OK) {
+                    std::cerr << "[ERROR] Malformed schema in Parquet footer" << std::endl;
+                    return status::FAIL;
+                }
+            }
+        } else if(field_id == 3 && field_type == T_I64) {
+            metadata.num_rows = thrift.read_i64();
+        } else if(field_id == 4 && field_type == T_LIST) {
+            // The schema precedes the row groups, so the amount of columns per row group is known here
+            uint8_t element_type;
+            uint32_t size = thrift.read_list_header(&element_type);
+            int64_t first_row = 0;
+            for(uint32_t i=0; i<size && !thrift.failed(); i++) {
+                row_group_info row_group;
+                if(read_row_group(&thrift, &metadata, &row_group) != status::OK) {
+                    std::cerr << "[ERROR] Malformed row group " << i << " in Parquet footer" << std::endl;
+                    return status::FAIL;
+                }
+                row_group.first_row = first_row;
+                first_row += row_group.num_rows;
+                metadata.row_groups.push_back(row_group);
+            }
+        } else {
+            thrift.skip(field_type);
+        }
+    }
+
+    if(thrift.failed()) {
+        std::cerr << "[ERROR] Corrupted data in Parquet footer" << std::endl;
+        return status::FAIL;
+    }
+
+    return status::OK;
+}
+
+status SWParquetReader::get_file_metadata(const file_metadata** footer_metadata) {
+    if(!file_metadata_read) {
+        if(read_file_metadata() != status::OK) {
+            return status::FAIL;
+        }
+        file_metadata_read = true;
+    }
+
+    *footer_metadata = &metadata;
+
+    return status::OK;
+}
+
+status SWParquetReader::get_column_chunk(int32_t row_group, int32_t column, const column_chunk_info** chunk) {
+    const file_metadata* footer_metadata;
+
+    if(get_file_metadata(&footer_metadata) != status::OK) {
+        return status::FAIL;
+    }
+
+    if((row_group < 0) || (row_group >= footer_metadata->num_row_groups()) || (column < 0) || (column >= footer_metadata->num_columns())) {
+        std::cerr << "[ERROR] Column chunk (" << row_group << ", " << column << ") does not exist" << std::endl;
+        return status::FAIL;
+    }
+
+    *chunk = &footer_metadata->column_chunk(row_group, column);
+
+    return status::OK;
+}
+
+// Read a complete column chunk, with value width, value count and encoding taken from the footer
+status SWParquetReader::read_column_prim(int32_t row_group, int32_t column, std::shared_ptr<arrow::PrimitiveArray>* prim_array) {
+    const column_chunk_info* chunk;
+    int32_t prim_width;
+    std::shared_ptr<arrow::DataType> arrow_type;
+
+    if(get_column_chunk(row_group, column, &chunk) != status::OK) {
+        return status::FAIL;
+    }
+
+    // INT96 timestamps come out as 64 bit nanosecond timestamps
+    if(chunk->type == parquet_type::INT96) {
+        if(chunk->has_encoding(parquet_encoding::RLE_DICTIONARY) || chunk->has_encoding(parquet_encoding::PLAIN_DICTIONARY)) {
+            return read_int96_timestamp(chunk->num_values, chunk->data_page_offset, prim_array, encoding::DICTIONARY);
+        }
+        return read_int96_timestamp(chunk->num_values, chunk->data_page_offset, prim_array, encoding::PLAIN);
+    }
+
+    if(prim_type_info(chunk->type, &prim_width, &arrow_type) != status::OK) {
+        std::cerr << "[ERROR] Column " << column << " is not a BOOLEAN, INT32, INT64, INT96, FLOAT or DOUBLE column" << std::endl;
+        return status::FAIL;
+    }
+
+    // RLE shows up for the levels of any chunk, BOOLEAN pages of either encoding are read as encoding::PLAIN
+    if(chunk->type == parquet_type::BOOLEAN) {
+        return read_prim(chunk->type, chunk->num_values, chunk->data_page_offset, prim_array, encoding::PLAIN);
+    }
+
+    // Dictionary encoded chunks also list PLAIN, for the dictionary page and for pages written after the dictionary grew too large
+    if(chunk->has_encoding(parquet_encoding::BYTE_STREAM_SPLIT)) {
+        return read_prim(chunk->type, chunk->num_values, chunk->data_page_offset, prim_array, encoding::BYTE_STREAM_SPLIT);
+    } else if(chunk->has_encoding(parquet_encoding::DELTA_BINARY_PACKED)) {
+        return read_prim(chunk->type, chunk->num_values, chunk->data_page_offset, prim_array, encoding::DELTA);
+    } else if(chunk->has_encoding(parquet_encoding::RLE_DICTIONARY) || chunk->has_encoding(parquet_encoding::PLAIN_DICTIONARY)) {
+        return read_prim(chunk->type, chunk->num_values, chunk->data_page_offset, prim_array, encoding::DICTIONARY);
+    } else if(chunk->has_encoding(parquet_encoding::PLAIN)) {
+        return read_prim(chunk->type, chunk->num_values, chunk->data_page_offset, prim_array, encoding::PLAIN);
+    }
+
+    std::cerr << "[ERROR] Column " << column << " does not use a supported encoding" << std::endl;
+    return status::FAIL;
+}
+
+// Read a complete FIXED_LEN_BYTE_ARRAY column chunk. DECIMAL columns are read into a Decimal128Array.
+status SWParquetReader::read_column_fixed_len(int32_t row_group, int32_t column, std::shared_ptr<arrow::FixedSizeBinaryArray>* fixed_array) {
+    const column_chunk_info* chunk;
+    encoding enc;
+
+    if(get_column_chunk(row_group, column, &chunk) != status::OK) {
+        return status::FAIL;
+    }
+
+    if(chunk->type != parquet_type::FIXED_LEN_BYTE_ARRAY) {
+        std::cerr << "[ERROR] Column " << column << " is not a FIXED_LEN_BYTE_ARRAY column" << std::endl;
+        return status::FAIL;
+    }
+
+    if(chunk->has_encoding(parquet_encoding::RLE_DICTIONARY) || chunk->has_encoding(parquet_encoding::PLAIN_DICTIONARY)) {
+        enc = encoding::DICTIONARY;
+    } else if(chunk->has_encoding(parquet_encoding::PLAIN)) {
+        enc = encoding::PLAIN;
+    } else {
+        std::cerr << "[ERROR] Column " << column << " does not use a supported encoding" << std::endl;
+        return status::FAIL;
+    }
+
+    const column_info& info = metadata.columns[column];
+    if(info.decimal_precision > 0) {
+        std::shared_ptr<arrow::Decimal128Array> decimal_array;
+        if(read_decimal(info.type_length, info.decimal_precision, info.decimal_scale, chunk->num_values, chunk->data_page_offset, &decimal_array, enc) != status::OK) {
+            return status::FAIL;
+        }
+        *fixed_array = decimal_array;
+        return status::OK;
+    }
+
+    return read_fixed_len(info.type_length, chunk->num_values, chunk->data_page_offset, fixed_array, enc);
+}
+
+// Read a complete list column chunk, one list per row of the row group. Only lists of primitive values or strings
+// that are not nested any further are supported.
+status SWParquetReader::read_column_list(int32_t row_group, int32_t column, std::shared_ptr<arrow::ListArray>* list_array) {
+    const column_chunk_info* chunk;
+    encoding enc;
+
+    if(get_column_chunk(row_group, column, &chunk) != status::OK) {
+        return status::FAIL;
+    }
+
+    if(metadata.columns[column].max_rep_level != 1) {
+        std::cerr << "[ERROR] Column " << column << " is not nested in exactly one list" << std::endl;
+        return status::FAIL;
+    }
+
+    // Same choice of encoding as for flat columns
+    if((chunk->type == parquet_type::BYTE_ARRAY) && chunk->has_encoding(parquet_encoding::DELTA_LENGTH_BYTE_ARRAY)) {
+        enc = encoding::DELTA_LENGTH;
+    } else if((chunk->type == parquet_type::BYTE_ARRAY) && chunk->has_encoding(parquet_encoding::DELTA_BYTE_ARRAY)) {
+        enc = encoding::DELTA_BYTE_ARRAY;
+    } else if(chunk->type == parquet_type::BOOLEAN) {
+        enc = encoding::PLAIN;
+    } else if(chunk->has_encoding(parquet_encoding::BYTE_STREAM_SPLIT)) {
+        enc = encoding::BYTE_STREAM_SPLIT;
+    } else if(chunk->has_encoding(parquet_encoding::DELTA_BINARY_PACKED)) {
+        enc = encoding::DELTA;
+    } else if(chunk->has_encoding(parquet_encoding::RLE_DICTIONARY) || chunk->has_encoding(parquet_encoding::PLAIN_DICTIONARY)) {
+        enc = encoding::DICTIONARY;
+    } else if(chunk->has_encoding(parquet_encoding::PLAIN)) {
+        enc = encoding::PLAIN;
+    } else {
+        std::cerr << "[ERROR] Column " << column << " does not use a supported encoding" << std::endl;
+        return status::FAIL;
+    }
+
+    return read_list(chunk->type, metadata.row_groups[row_group].num_rows, chunk->data_page_offset, list_array, enc);
+}
+
+// Read a complete string column chunk. The exact amount of characters is not known up front,
+// so the value buffer is sized with the uncompressed size of the chunk, which is an upper bound.
+// Dictionary encoded strings can take up far more room than their pages, their value buffer is sized after decoding the indices.
+// DELTA_BYTE_ARRAY strings share prefixes that are stored once, their value buffer grows while the pages are decoded.
+// PLAIN strings are scanned once to size their value buffer exactly.
+status SWParquetReader::read_column_string(int32_t row_group, int32_t column, std::shared_ptr<arrow::StringArray>* string_array) {
+    const column_chunk_info* chunk;
+
+    if(get_column_chunk(row_group, column, &chunk) != status::OK) {
+        return status::FAIL;
+    }
+
+    if(chunk->type != parquet_type::BYTE_ARRAY) {
+        std::cerr << "[ERROR] Column " << column << " is not a BYTE_ARRAY column" << std::endl;
+        return status::FAIL;
+    }
+
+    if(chunk->has_encoding(parquet_encoding::DELTA_LENGTH_BYTE_ARRAY)) {
+        return read_string(chunk->num_values, chunk->total_uncompressed_size, chunk->data_page_offset, string_array, encoding::DELTA_LENGTH);
+    } else if(chunk->has_encoding(parquet_encoding::DELTA_BYTE_ARRAY)) {
+        std::shared_ptr<arrow::Buffer> off_buffer;
+        arrow::AllocateBuffer((chunk->num_values+1)*sizeof(int32_t), &off_buffer);
+        return read_string(chunk->num_values, chunk->data_page_offset, string_array, off_buffer, nullptr, encoding::DELTA_BYTE_ARRAY);
+    } else if(chunk->has_encoding(parquet_encoding::RLE_DICTIONARY) || chunk->has_encoding(parquet_encoding::PLAIN_DICTIONARY)) {
+        std::shared_ptr<arrow::Buffer> off_buffer;
+        arrow::AllocateBuffer((chunk->num_values+1)*sizeof(int32_t), &off_buffer);
+        return read_string(chunk->num_values, chunk->data_page_offset, string_array, off_buffer, nullptr, encoding::DICTIONARY);
+    } else if(chunk->has_encoding(parquet_encoding::PLAIN)) {
+        std::shared_ptr<arrow::Buffer> off_buffer;
+        arrow::AllocateBuffer((chunk->num_values+1)*sizeof(int32_t), &off_buffer);
+        return read_string(chunk->num_values, chunk->data_page_offset, string_array, off_buffer, nullptr, encoding::PLAIN);
+    }
+
+    std::cerr << "[ERROR] Column " << column << " does not use a supported encoding" << std::endl;
+    return status::FAIL;
+}
+
+// Read a complete dictionary encoded column chunk as indices into its dictionary page
+status SWParquetReader::read_column_dictionary(int32_t row_group, int32_t column, std::shared_ptr<arrow::DictionaryArray>* dict_array) {
+    const column_chunk_info* chunk;
+
+    if(get_column_chunk(row_group, column, &chunk) != status::OK) {
+        return status::FAIL;
+    }
+
+    if(!chunk->has_encoding(parquet_encoding::RLE_DICTIONARY) && !chunk->has_encoding(parquet_encoding::PLAIN_DICTIONARY)) {
+        std::cerr << "[ERROR] Column " << column << " is not dictionary encoded" << std::endl;
+        return status::FAIL;
+    }
+
+    return read_dictionary(chunk->type, chunk->num_values, chunk->data_page_offset, dict_array);
+}
+
+}
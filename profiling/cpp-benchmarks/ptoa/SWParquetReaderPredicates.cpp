@@ -0,0 +1,255 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+#include "SWParquetReader.h"
+#include "ThriftCompact.h"
+#include "ptoa.h"
+
+namespace ptoa {
+
+// ColumnIndex of a column chunk, with one entry per data page. The bounds point into the file.
+struct column_index {
+    std::vector<bool> null_pages;
+    std::vector<byte_range> min_values;
+    std::vector<byte_range> max_values;
+};
+
+static void read_binary_list(ThriftCompactReader* thrift, std::vector<byte_range>* values) {
+    uint8_t element_type;
+    uint32_t size = thrift->read_list_header(&element_type);
+    for(uint32_t i=0; i<size && !thrift->failed(); i++) {
+        byte_range value;
+        value.data = thrift->read_binary_bytes(&value.size);
+        values->push_back(value);
+    }
+}
+
+static void read_column_index(ThriftCompactReader* thrift, column_index* index) {
+    int16_t last_field_id = 0;
+    int16_t field_id;
+    uint8_t field_type;
+
+    while(thrift->read_field_header(&last_field_id, &field_id, &field_type)) {
+        if(field_id == 1 && field_type == T_LIST) {
+            // Booleans in lists take up a byte each
+            uint8_t element_type;
+            uint32_t size = thrift->read_list_header(&element_type);
+            for(uint32_t i=0; i<size && !thrift->failed(); i++) {
+                index->null_pages.push_back(thrift->read_byte() == T_BOOLEAN_TRUE);
+            }
+        } else if(field_id == 2 && field_type == T_LIST) {
+            read_binary_list(thrift, &index->min_values);
+        } else if(field_id == 3 && field_type == T_LIST) {
+            read_binary_list(thrift, &index->max_values);
+        } else {
+            thrift->skip(field_type);
+        }
+    }
+}
+
+// Collects the first_row_index of every PageLocation of an OffsetIndex
+static void read_offset_index(ThriftCompactReader* thrift, std::vector<int64_t>* first_rows) {
+    int16_t last_field_id = 0;
+    int16_t field_id;
+    uint8_t field_type;
+
+    while(thrift->read_field_header(&last_field_id, &field_id, &field_type)) {
+        if(field_id == 1 && field_type == T_LIST) {
+            uint8_t element_type;
+            uint32_t size = thrift->read_list_header(&element_type);
+            for(uint32_t i=0; i<size && !thrift->failed(); i++) {
+                int16_t location_last_field_id = 0;
+                int64_t first_row = -1;
+                while(thrift->read_field_header(&location_last_field_id, &field_id, &field_type)) {
+                    if(field_id == 3 && field_type == T_I64) {
+                        first_row = thrift->read_i64();
+                    } else {
+                        thrift->skip(field_type);
+                    }
+                }
+                first_rows->push_back(first_row);
+            }
+        } else {
+            thrift->skip(field_type);
+        }
+    }
+}
+
+// Integer statistics are stored PLAIN encoded, 4 bytes for INT32 and 8 for INT64
+static bool decode_bound(parquet_type type, byte_range bound, int64_t* value) {
+    if((type == parquet_type::INT32) && (bound.size == 4)) {
+        int32_t value32;
+        std::memcpy(&value32, bound.data, 4);
+        *value = value32;
+        return true;
+    } else if((type == parquet_type::INT64) && (bound.size == 8)) {
+        std::memcpy(value, bound.data, 8);
+        return true;
+    }
+    return false;
+}
+
+// Whether some value from lower to upper can fulfil op with operands. The operands of IN are sorted.
+template<typename T>
+static bool range_may_match(predicate_op op, const std::vector<T>& operands, const T& lower, const T& upper) {
+    switch(op) {
+        case predicate_op::LESS: return lower < operands[0];
+        case predicate_op::LESS_EQUAL: return !(operands[0] < lower);
+        case predicate_op::EQUAL: return !(operands[0] < lower) && !(upper < operands[0]);
+        case predicate_op::BETWEEN: return !(operands[1] < lower) && !(upper < operands[0]);
+        case predicate_op::IN: {
+            typename std::vector<T>::const_iterator operand = std::lower_bound(operands.begin(), operands.end(), lower);
+            return (operand != operands.end()) && !(upper < *operand);
+        }
+    }
+    return true;
+}
+
+// Bounds that cannot be decoded do not rule anything out. Strings compare as unsigned bytes, as std::string does.
+static bool bounds_may_match(const predicate& pred, parquet_type type, byte_range lower, byte_range upper) {
+    if(pred.on_strings) {
+        return range_may_match(pred.op, pred.strings, std::string((const char*) lower.data, lower.size), std::string((const char*) upper.data, upper.size));
+    }
+
+    int64_t lower_value;
+    int64_t upper_value;
+    if(!decode_bound(type, lower, &lower_value) || !decode_bound(type, upper, &upper_value)) {
+        return true;
+    }
+    return range_may_match(pred.op, pred.ints, lower_value, upper_value);
+}
+
+// Pages and chunks with nothing but nulls never match, without statistics anything may match
+static bool statistics_may_match(const predicate& pred, parquet_type type, const value_statistics& statistics, int64_t num_values) {
+    byte_range lower;
+    byte_range upper;
+
+    if((statistics.null_count >= 0) && (statistics.null_count >= num_values)) {
+        return false;
+    } else if(!statistics.bounds(type, &lower, &upper)) {
+        return true;
+    }
+    return bounds_may_match(pred, type, lower, upper);
+}
+
+// Append a range of rows, joined with the range before it if they touch
+static void add_rows(std::vector<row_range>* ranges, int64_t first_row, int64_t num_rows) {
+    if(num_rows <= 0) {
+        return;
+    } else if(!ranges->empty() && (ranges->back().first_row + ranges->back().num_rows == first_row)) {
+        ranges->back().num_rows += num_rows;
+    } else {
+        row_range range;
+        range.first_row = first_row;
+        range.num_rows = num_rows;
+        ranges->push_back(range);
+    }
+}
+
+// Find the rows of a column, counted over the whole file, that may fulfil pred. Row groups are ruled out by the statistics of
+// their column chunk, pages by the ColumnIndex of the chunk or, if the writer wrote none, by the statistics in their headers.
+// None of this touches page data, so the pages that are ruled out are never decompressed. The rows of the remaining pages
+// are returned as ascending ranges, which read_column_rows reads. The values in them still have to be checked against pred.
+status SWParquetReader::select_rows(int32_t column, const predicate& pred, std::vector<row_range>* ranges) {
+    const column_chunk_info* chunk;
+
+    if(get_column_chunk(0, column, &chunk) != status::OK) {
+        return status::FAIL;
+    }
+
+    parquet_type type = metadata.columns[column].type;
+    size_t num_operands = pred.num_operands();
+
+    if(metadata.columns[column].max_rep_level > 0) {
+        std::cerr << "[ERROR] Predicates on repeated columns are not supported" << std::endl;
+        return status::FAIL;
+    } else if((type != parquet_type::INT32) && (type != parquet_type::INT64) && (type != parquet_type::BYTE_ARRAY)) {
+        std::cerr << "[ERROR] Predicates on values of type " << (int32_t) type << " are not supported" << std::endl;
+        return status::FAIL;
+    } else if(pred.on_strings != (type == parquet_type::BYTE_ARRAY)) {
+        std::cerr << "[ERROR] Operands of the predicate do not match the type of column " << column << std::endl;
+        return status::FAIL;
+    } else if(((pred.op == predicate_op::BETWEEN) && (num_operands != 2)) || ((pred.op != predicate_op::BETWEEN) && (pred.op != predicate_op::IN) && (num_operands != 1))) {
+        std::cerr << "[ERROR] Predicate has the wrong amount of operands, " << num_operands << std::endl;
+        return status::FAIL;
+    }
+
+    // IN looks up the bounds among the sorted operands
+    predicate sorted_pred = pred;
+    std::sort(sorted_pred.ints.begin(), sorted_pred.ints.end());
+    std::sort(sorted_pred.strings.begin(), sorted_pred.strings.end());
+
+    ranges->clear();
+    for(int32_t row_group = 0; row_group < metadata.num_row_groups(); row_group++) {
+        if(select_chunk_rows(row_group, column, sorted_pred, ranges) != status::OK) {
+            return status::FAIL;
+        }
+    }
+
+    return status::OK;
+}
+
+status SWParquetReader::select_chunk_rows(int32_t row_group, int32_t column, const predicate& pred, std::vector<row_range>* ranges) {
+    const column_chunk_info& chunk = metadata.column_chunk(row_group, column);
+    const row_group_info& group = metadata.row_groups[row_group];
+
+    if((group.num_rows == 0) || !statistics_may_match(pred, chunk.type, chunk.statistics, chunk.num_values)) {
+        return status::OK;
+    }
+
+    // The ColumnIndex and the OffsetIndex are only used together, the OffsetIndex tells where the rows of the pages start
+    if((chunk.column_index_offset >= 0) && (chunk.offset_index_offset >= 0)
+            && (chunk.column_index_offset + chunk.column_index_length <= (int64_t) file_size)
+            && (chunk.offset_index_offset + chunk.offset_index_length <= (int64_t) file_size)) {
+        column_index index;
+        std::vector<int64_t> first_rows;
+
+        ThriftCompactReader column_index_thrift(parquet_data + chunk.column_index_offset, parquet_data + chunk.column_index_offset + chunk.column_index_length);
+        ThriftCompactReader offset_index_thrift(parquet_data + chunk.offset_index_offset, parquet_data + chunk.offset_index_offset + chunk.offset_index_length);
+        read_column_index(&column_index_thrift, &index);
+        read_offset_index(&offset_index_thrift, &first_rows);
+
+        size_t num_pages = first_rows.size();
+        first_rows.push_back(group.num_rows);
+        if(!column_index_thrift.failed() && !offset_index_thrift.failed() && (num_pages > 0) && (first_rows[0] == 0)
+                && std::is_sorted(first_rows.begin(), first_rows.end())
+                && (index.null_pages.size() == num_pages) && (index.min_values.size() == num_pages) && (index.max_values.size() == num_pages)) {
+            for(size_t page = 0; page < num_pages; page++) {
+                if(!index.null_pages[page] && bounds_may_match(pred, chunk.type, index.min_values[page], index.max_values[page])) {
+                    add_rows(ranges, group.first_row + first_rows[page], first_rows[page+1] - first_rows[page]);
+                }
+            }
+            return status::OK;
+        }
+
+        std::cerr << "[WARNING] Ignoring malformed page index of column chunk (" << row_group << ", " << column << ")" << std::endl;
+    }
+
+    const page_index* index;
+    if(get_page_index(chunk.data_page_offset, &index) != status::OK) {
+        return status::FAIL;
+    }
+
+    for(int32_t page = 0; page < index->num_pages(); page++) {
+        if(statistics_may_match(pred, chunk.type, index->statistics[page], index->num_values[page])) {
+            add_rows(ranges, group.first_row + index->first_rows[page], index->num_values[page]);
+        }
+    }
+
+    return status::OK;
+}
+
+}
@@ -0,0 +1,228 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+
+#include "SWParquetReader.h"
+#include "ByteStreamSplit.h"
+#include "DefinitionLevels.h"
+#include "ptoa.h"
+
+namespace ptoa {
+
+// Bits of the page a thread decodes last. RLE encoded values are decoded into rle_values, page_bits holds
+// the page's bits at the bit offset the page has in the output bitmap.
+static thread_local std::vector<uint8_t> rle_values;
+static thread_local std::vector<uint8_t> page_bits;
+
+static inline uint8_t* reserve(std::vector<uint8_t>* buffer, size_t size) {
+    if(buffer->size() < size) {
+        buffer->resize(size);
+    }
+    return buffer->data();
+}
+
+status SWParquetReader::read_prim_boolean(int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array){
+    std::shared_ptr<arrow::Buffer> arr_buffer;
+    arrow::AllocateBuffer((num_values+7)/8, &arr_buffer);
+
+    return read_prim_boolean(num_values, file_offset, prim_array, arr_buffer);
+}
+
+// Read BOOLEAN values into a bitmap. PLAIN pages already hold the values as bitmap, RLE pages (written to version 2 pages)
+// hold them as RLE/bit-packed hybrid with bit width 1, like definition levels. The bits of every page are put at the bit
+// offset of the page in arr_buffer and ORed in, so pages can be decoded in parallel.
+status SWParquetReader::read_prim_boolean(int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer){
+    uint8_t* arr_buf_ptr = arr_buffer->mutable_data();
+    const page_index* index;
+
+    if(get_page_index(file_offset, num_values, &index) != status::OK) {
+        return status::FAIL;
+    }
+
+    std::memset(arr_buf_ptr, 0, (num_values+7)/8);
+
+    std::shared_ptr<arrow::Buffer> null_bitmap;
+    allocate_null_bitmap(index->max_def_level > 0, num_values, &null_bitmap);
+
+    int32_t num_pages = index->pages_for_rows(num_values);
+    std::atomic<bool> failed(false);
+    std::atomic<int64_t> null_count(0);
+
+    std::function<void(int64_t)> decode_page = [&](int64_t page){
+        int64_t first_row = index->first_rows[page];
+        int32_t page_rows_to_read = std::min((int64_t) index->num_values[page], num_values-first_row);
+        int32_t page_values_to_read = page_rows_to_read;
+        int32_t bit_offset = first_row % 8;
+
+        page_contents contents;
+        const uint8_t* validity_bits;
+
+        if((get_page_contents(index, page, &contents) != status::OK)
+                || (null_bitmap && (decode_page_validity(index, page, contents, first_row, page_rows_to_read, null_bitmap->mutable_data(), &validity_bits, &page_values_to_read) != status::OK))) {
+            failed = true;
+            return;
+        }
+
+        // Dense value bits, from the first bit on
+        const uint8_t* values = nullptr;
+        if(index->encodings[page] == parquet_encoding::PLAIN) {
+            if(contents.values_size >= (page_values_to_read+7)/8) {
+                values = contents.values;
+            }
+        } else if(index->encodings[page] == parquet_encoding::RLE) {
+            // The hybrid data is preceded by its 4 byte length
+            uint32_t rle_size;
+            int32_t valid_count;
+            if(contents.values_size >= 4) {
+                std::memcpy(&rle_size, contents.values, 4);
+                rle_size = std::min(rle_size, (uint32_t) (contents.values_size - 4));
+                uint8_t* decoded = reserve(&rle_values, validity_buffer_size(page_values_to_read, 0));
+                if(decode_def_levels(contents.values + 4, rle_size, 1, page_values_to_read, decoded, 0, &valid_count) == status::OK) {
+                    values = decoded;
+                }
+            }
+        } else {
+            std::cerr << "[ERROR] Page at file offset " << index->page_offsets[page] << " uses unsupported encoding " << (int32_t) index->encodings[page] << std::endl;
+            failed = true;
+            return;
+        }
+
+        if(values == nullptr) {
+            std::cerr << "[ERROR] Corrupt values in page at file offset " << index->page_offsets[page] << std::endl;
+            failed = true;
+            return;
+        }
+
+        uint8_t* bits = reserve(&page_bits, validity_buffer_size(page_rows_to_read, bit_offset));
+        if(page_values_to_read < page_rows_to_read) {
+            null_count += page_rows_to_read - page_values_to_read;
+            scatter_bits_to_valid(values, validity_bits, bit_offset, page_rows_to_read, bits);
+        } else {
+            copy_bits(values, page_rows_to_read, bits, bit_offset);
+        }
+        merge_validity(bits, bit_offset, page_rows_to_read, arr_buf_ptr + first_row/8);
+    };
+
+    for_each_page(num_pages, decode_page);
+
+    if(failed) {
+        return status::FAIL;
+    }
+
+    drop_empty_null_bitmap(null_count, &null_bitmap);
+
+    *prim_array = std::make_shared<arrow::BooleanArray>(num_values, arr_buffer, null_bitmap, null_count);
+
+    return status::OK;
+}
+
+status SWParquetReader::read_prim_byte_stream_split(parquet_type type, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array){
+    int32_t prim_width;
+    std::shared_ptr<arrow::DataType> arrow_type;
+    std::shared_ptr<arrow::Buffer> arr_buffer;
+
+    if(prim_type_info(type, &prim_width, &arrow_type) != status::OK) {
+        return status::FAIL;
+    }
+    arrow::AllocateBuffer(num_values*prim_width/8, &arr_buffer);
+
+    return read_prim_byte_stream_split(type, num_values, file_offset, prim_array, arr_buffer);
+}
+
+// Read BYTE_STREAM_SPLIT encoded 32 or 64 bit values. The byte streams of every page are transposed straight into arr_buffer.
+status SWParquetReader::read_prim_byte_stream_split(parquet_type type, int64_t num_values, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer){
+    uint8_t* arr_buf_ptr = arr_buffer->mutable_data();
+    int32_t prim_width;
+    std::shared_ptr<arrow::DataType> arrow_type;
+    const page_index* index;
+
+    if((prim_type_info(type, &prim_width, &arrow_type) != status::OK) || (prim_width == 1)) {
+        std::cerr << "[ERROR] BYTE_STREAM_SPLIT encoded values of type " << (int32_t) type << " are not supported" << std::endl;
+        return status::FAIL;
+    }
+    const int32_t value_bytes = prim_width/8;
+
+    if(get_page_index(file_offset, num_values, &index) != status::OK) {
+        return status::FAIL;
+    }
+
+    std::shared_ptr<arrow::Buffer> null_bitmap;
+    allocate_null_bitmap(index->max_def_level > 0, num_values, &null_bitmap);
+
+    int32_t num_pages = index->pages_for_rows(num_values);
+    std::atomic<bool> failed(false);
+    std::atomic<int64_t> null_count(0);
+
+    std::function<void(int64_t)> decode_page = [&](int64_t page){
+        int64_t first_row = index->first_rows[page];
+        int32_t page_rows_to_read = std::min((int64_t) index->num_values[page], num_values-first_row);
+        int32_t page_values_to_read = page_rows_to_read;
+        uint8_t* page_out = arr_buf_ptr + first_row*value_bytes;
+
+        page_contents contents;
+        const uint8_t* validity_bits;
+
+        if((get_page_contents(index, page, &contents) != status::OK)
+                || (null_bitmap && (decode_page_validity(index, page, contents, first_row, page_rows_to_read, null_bitmap->mutable_data(), &validity_bits, &page_values_to_read) != status::OK))) {
+            failed = true;
+            return;
+        }
+
+        if(index->encodings[page] != parquet_encoding::BYTE_STREAM_SPLIT) {
+            std::cerr << "[ERROR] Page at file offset " << index->page_offsets[page] << " uses unsupported encoding " << (int32_t) index->encodings[page] << std::endl;
+            failed = true;
+            return;
+        }
+
+        // The streams are as long as the page has values
+        int32_t stride = contents.values_size / value_bytes;
+        if((contents.values_size % value_bytes != 0) || (page_values_to_read > stride)) {
+            std::cerr << "[ERROR] Corrupt values in page at file offset " << index->page_offsets[page] << std::endl;
+            failed = true;
+            return;
+        }
+
+        if(prim_width == 64) {
+            byte_stream_split_decode64(contents.values, stride, page_values_to_read, page_out);
+        } else {
+            byte_stream_split_decode32(contents.values, stride, page_values_to_read, page_out);
+        }
+
+        if(page_values_to_read < page_rows_to_read) {
+            null_count += page_rows_to_read - page_values_to_read;
+            if(prim_width == 64) {
+                scatter_to_valid((int64_t*) page_out, validity_bits, first_row % 8, page_rows_to_read, page_values_to_read);
+            } else {
+                scatter_to_valid((int32_t*) page_out, validity_bits, first_row % 8, page_rows_to_read, page_values_to_read);
+            }
+        }
+    };
+
+    for_each_page(num_pages, decode_page);
+
+    if(failed) {
+        return status::FAIL;
+    }
+
+    drop_empty_null_bitmap(null_count, &null_bitmap);
+
+    *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow_type, num_values, arr_buffer, null_bitmap, null_count);
+
+    return status::OK;
+}
+
+}
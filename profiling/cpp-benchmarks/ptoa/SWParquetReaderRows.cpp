@@ -0,0 +1,300 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+
+#include "SWParquetReader.h"
+#include "ByteStreamSplit.h"
+#include "DictionaryKernels.h"
+#include "DefinitionLevels.h"
+#include "ptoa.h"
+
+namespace ptoa {
+
+// Validity bits, delta decoded values and dictionary indices of the page a thread decodes last. They cover the page
+// from its first row up to the last requested one, the rows in front of the range are only decoded to be skipped.
+static thread_local std::vector<uint8_t> row_validity;
+static thread_local std::vector<uint8_t> row_values;
+static thread_local std::vector<int32_t> row_indices;
+
+template<typename T>
+static inline T* reserve(std::vector<T>* buffer, size_t size) {
+    if(buffer->size() < size) {
+        buffer->resize(size);
+    }
+    return buffer->data();
+}
+
+// Read rows first_row to first_row+num_rows-1 of the column chunk at file_offset, holding values of physical type INT32, INT64,
+// FLOAT or DOUBLE. Only the pages holding those rows are decompressed and decoded, see decode_rows.
+status SWParquetReader::read_rows(parquet_type type, int64_t first_row, int64_t num_rows, int64_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array) {
+    int32_t prim_width;
+    std::shared_ptr<arrow::DataType> arrow_type;
+    const page_index* index;
+
+    if((prim_type_info(type, &prim_width, &arrow_type) != status::OK) || (prim_width == 1)) {
+        std::cerr << "[ERROR] Reading row ranges of values of type " << (int32_t) type << " is not supported" << std::endl;
+        return status::FAIL;
+    }
+
+    if((first_row < 0) || (num_rows < 0)) {
+        std::cerr << "[ERROR] Invalid row range of " << num_rows << " rows from row " << first_row << std::endl;
+        return status::FAIL;
+    }
+
+    if(get_page_index(file_offset, first_row + num_rows, &index) != status::OK) {
+        return status::FAIL;
+    }
+
+    std::shared_ptr<arrow::Buffer> arr_buffer;
+    arrow::AllocateBuffer(num_rows*prim_width/8, &arr_buffer);
+
+    std::shared_ptr<arrow::Buffer> null_bitmap;
+    allocate_null_bitmap(index->max_def_level > 0, num_rows, &null_bitmap);
+
+    int64_t null_count = 0;
+    if(decode_rows(index, prim_width/8, first_row, num_rows, arr_buffer->mutable_data(), null_bitmap ? null_bitmap->mutable_data() : nullptr, 0, &null_count) != status::OK) {
+        return status::FAIL;
+    }
+
+    drop_empty_null_bitmap(null_count, &null_bitmap);
+
+    *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow_type, num_rows, arr_buffer, null_bitmap, null_count);
+
+    return status::OK;
+}
+
+// Read rows first_row to first_row+num_rows-1 of a column, counted over the whole file
+status SWParquetReader::read_column_rows(int32_t column, int64_t first_row, int64_t num_rows, std::shared_ptr<arrow::PrimitiveArray>* prim_array) {
+    std::vector<row_range> ranges(1);
+    ranges[0].first_row = first_row;
+    ranges[0].num_rows = num_rows;
+
+    return read_column_rows(column, ranges, prim_array);
+}
+
+// Read the rows of all ranges of a column, counted over the whole file, one after the other into one array. The row groups
+// holding a range are found by binary search over their first rows, each of them contributes its part of the range.
+status SWParquetReader::read_column_rows(int32_t column, const std::vector<row_range>& ranges, std::shared_ptr<arrow::PrimitiveArray>* prim_array) {
+    const column_chunk_info* chunk;
+    int32_t prim_width;
+    std::shared_ptr<arrow::DataType> arrow_type;
+
+    if((get_column_chunk(0, column, &chunk) != status::OK)
+            || (prim_type_info(chunk->type, &prim_width, &arrow_type) != status::OK)) {
+        return status::FAIL;
+    }
+
+    if(prim_width == 1) {
+        std::cerr << "[ERROR] Reading row ranges of values of type " << (int32_t) chunk->type << " is not supported" << std::endl;
+        return status::FAIL;
+    }
+
+    int64_t num_rows = 0;
+    for(const row_range& range : ranges) {
+        if((range.first_row < 0) || (range.num_rows < 0) || (range.first_row + range.num_rows > metadata.num_rows)) {
+            std::cerr << "[ERROR] Row range of " << range.num_rows << " rows from row " << range.first_row << " is not within the " << metadata.num_rows << " rows of the file" << std::endl;
+            return status::FAIL;
+        }
+        num_rows += range.num_rows;
+    }
+
+    std::shared_ptr<arrow::Buffer> arr_buffer;
+    arrow::AllocateBuffer(num_rows*prim_width/8, &arr_buffer);
+
+    std::shared_ptr<arrow::Buffer> null_bitmap;
+    allocate_null_bitmap(metadata.columns[column].max_def_level > 0, num_rows, &null_bitmap);
+
+    const std::vector<row_group_info>& row_groups = metadata.row_groups;
+    int64_t out_row = 0;
+    int64_t null_count = 0;
+
+    for(const row_range& range : ranges) {
+        int32_t row_group = std::upper_bound(row_groups.begin(), row_groups.end(), range.first_row,
+                                             [](int64_t row, const row_group_info& group){return row < group.first_row;}) - row_groups.begin() - 1;
+
+        for(int64_t row = range.first_row; row < range.first_row + range.num_rows; row_group++) {
+            const page_index* index;
+            int64_t chunk_first_row = row - row_groups[row_group].first_row;
+            int64_t chunk_rows = std::min(row_groups[row_group].num_rows - chunk_first_row, range.first_row + range.num_rows - row);
+            if(chunk_rows == 0) {
+                continue;
+            }
+
+            if((get_column_chunk(row_group, column, &chunk) != status::OK)
+                    || (get_page_index(chunk->data_page_offset, chunk_first_row + chunk_rows, &index) != status::OK)
+                    || (decode_rows(index, prim_width/8, chunk_first_row, chunk_rows, arr_buffer->mutable_data(), null_bitmap ? null_bitmap->mutable_data() : nullptr, out_row, &null_count) != status::OK)) {
+                return status::FAIL;
+            }
+            row += chunk_rows;
+            out_row += chunk_rows;
+        }
+    }
+
+    drop_empty_null_bitmap(null_count, &null_bitmap);
+
+    *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow_type, num_rows, arr_buffer, null_bitmap, null_count);
+
+    return status::OK;
+}
+
+// Decode rows first_row to first_row+num_rows-1 of a column chunk of value_bytes wide values to rows out_row and up of out,
+// with their validity bits going to the zeroed bitmap validity if it is not nullptr. null_count is increased by the nulls found.
+// The pages holding the first and the last row are found by binary search over the first rows of the pages. Of the first page,
+// the definition levels in front of the range are decoded to know how many values to skip. PLAIN and BYTE_STREAM_SPLIT values
+// are then read from the first requested value on. Dictionary indices, whose runs can only be found by walking them, and delta
+// encoded values, which depend on all values before them, are decoded from the start of the page up to the last requested value.
+status SWParquetReader::decode_rows(const page_index* index, int32_t value_bytes, int64_t first_row, int64_t num_rows, uint8_t* out, uint8_t* validity, int64_t out_row, int64_t* null_count) {
+    if(num_rows == 0) {
+        return status::OK;
+    } else if(index->has_lists()) {
+        std::cerr << "[ERROR] Reading row ranges of list columns is not supported" << std::endl;
+        return status::FAIL;
+    }
+
+    int32_t first_page = index->page_for_row(first_row);
+    int32_t end_page = index->pages_for_rows(first_row + num_rows);
+
+    dictionary_values dictionary;
+    for(int32_t page = first_page; page < end_page; page++) {
+        if(index->dictionary_encoded(page)) {
+            if(read_dictionary_page(index, value_bytes, &dictionary) != status::OK) {
+                return status::FAIL;
+            }
+            break;
+        }
+    }
+
+    std::atomic<bool> failed(false);
+    std::atomic<int64_t> page_null_count(0);
+
+    std::function<void(int64_t)> decode_page = [&](int64_t page){
+        int64_t page_first_row = index->first_rows[page];
+        int64_t range_first_row = std::max(first_row, page_first_row);
+        int32_t skip_rows = range_first_row - page_first_row;
+        int32_t rows = std::min(first_row + num_rows, index->first_rows[page+1]) - range_first_row;
+        int64_t row = out_row + (range_first_row - first_row);
+        uint8_t* page_out = out + row*value_bytes;
+
+        int32_t skip_values = skip_rows;
+        int32_t values = rows;
+        const uint8_t* validity_bits = nullptr;
+
+        page_contents contents;
+        if(get_page_contents(index, page, &contents) != status::OK) {
+            failed = true;
+            return;
+        }
+
+        // The levels of the skipped rows are decoded in front of the requested ones, at a bit offset that puts the
+        // requested ones at the bit offset they have in the output bitmap
+        if(validity) {
+            int32_t bit_offset = (int32_t) (((row - skip_rows) % 8 + 8) % 8);
+            uint8_t* bits = reserve(&row_validity, validity_buffer_size(skip_rows + rows, bit_offset));
+            int32_t valid_count;
+
+            if(decode_def_levels(contents.def_levels, contents.def_levels_size, index->max_def_level, skip_rows + rows, bits, bit_offset, &valid_count) != status::OK) {
+                std::cerr << "[ERROR] Corrupt definition levels in page at file offset " << index->page_offsets[page] << std::endl;
+                failed = true;
+                return;
+            }
+
+            // The first byte also holds bits of skipped rows, which merge_validity would OR into the rows in front of the range.
+            // Bits behind the last requested row are cleared by decode_def_levels.
+            uint8_t* range_bits = bits + (bit_offset + skip_rows)/8;
+            range_bits[0] &= (uint8_t) (0xFF << (row % 8));
+            validity_bits = range_bits;
+            values = count_bits(validity_bits, row % 8, rows);
+            skip_values = valid_count - values;
+            merge_validity(validity_bits, row % 8, rows, validity + row/8);
+        }
+
+        status decoded = status::FAIL;
+        if(index->encodings[page] == parquet_encoding::PLAIN) {
+            if((int64_t) contents.values_size >= (int64_t) (skip_values + values)*value_bytes) {
+                std::memcpy(page_out, contents.values + (int64_t) skip_values*value_bytes, (int64_t) values*value_bytes);
+                decoded = status::OK;
+            }
+        } else if(index->encodings[page] == parquet_encoding::BYTE_STREAM_SPLIT) {
+            // Every byte stream starts with the skipped values
+            int32_t stride = contents.values_size / value_bytes;
+            if((contents.values_size % value_bytes == 0) && (skip_values + values <= stride)) {
+                if(value_bytes == 8) {
+                    byte_stream_split_decode64(contents.values + skip_values, stride, values, page_out);
+                } else {
+                    byte_stream_split_decode32(contents.values + skip_values, stride, values, page_out);
+                }
+                decoded = status::OK;
+            }
+        } else if(index->dictionary_encoded(page)) {
+            int32_t* indices = reserve(&row_indices, skip_values + values);
+            decoded = decode_dictionary_indices(contents.values, contents.values_size, dictionary.num_values, skip_values + values, indices);
+            if((decoded == status::OK) && (value_bytes == 8)) {
+                const int64_t* table = (const int64_t*) dictionary.values->data();
+                for(int32_t i = 0; i < values; i++) {
+                    ((int64_t*) page_out)[i] = table[indices[skip_values + i]];
+                }
+            } else if(decoded == status::OK) {
+                gather32((const int32_t*) dictionary.values->data(), indices + skip_values, (int32_t*) page_out, values);
+            }
+        } else if(index->encodings[page] == parquet_encoding::DELTA_BINARY_PACKED) {
+            // Without skipped values the page decodes straight into the output
+            uint8_t* delta_out = skip_values > 0 ? reserve(&row_values, (size_t) (skip_values + values)*value_bytes) : page_out;
+            if(skip_values + values == 0) {
+                decoded = status::OK;
+            } else if(value_bytes == 8) {
+                decoded = decode_delta_page64(contents.values, contents.values + contents.values_size, skip_values + values, (int64_t*) delta_out);
+            } else {
+                decoded = decode_delta_page32(contents.values, contents.values + contents.values_size, skip_values + values, (int32_t*) delta_out);
+            }
+            if((decoded == status::OK) && (skip_values > 0)) {
+                std::memcpy(page_out, delta_out + (int64_t) skip_values*value_bytes, (int64_t) values*value_bytes);
+            }
+        } else {
+            std::cerr << "[ERROR] Page at file offset " << index->page_offsets[page] << " uses unsupported encoding " << (int32_t) index->encodings[page] << std::endl;
+            failed = true;
+            return;
+        }
+
+        if(decoded != status::OK) {
+            std::cerr << "[ERROR] Corrupt values in page at file offset " << index->page_offsets[page] << std::endl;
+            failed = true;
+            return;
+        }
+
+        // Pages only store the values of non-null rows, move them out to their rows
+        if(values < rows) {
+            page_null_count += rows - values;
+            if(value_bytes == 8) {
+                scatter_to_valid((int64_t*) page_out, validity_bits, row % 8, rows, values);
+            } else {
+                scatter_to_valid((int32_t*) page_out, validity_bits, row % 8, rows, values);
+            }
+        }
+    };
+
+    for_each_page(end_page - first_page, [&](int64_t i){decode_page(first_page + i);});
+
+    if(failed) {
+        return status::FAIL;
+    }
+
+    *null_count += page_null_count;
+
+    return status::OK;
+}
+
+}
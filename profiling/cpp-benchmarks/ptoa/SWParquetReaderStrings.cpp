@@ -0,0 +1,209 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <cstring>
+#include <climits>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+
+#include "SWParquetReader.h"
+#include "PlainKernels.h"
+#include "DictionaryKernels.h"
+#include "DeltaKernels.h"
+#include "DefinitionLevels.h"
+#include "ptoa.h"
+
+namespace ptoa {
+
+status SWParquetReader::read_string_plain(int64_t num_strings, int64_t num_chars, int64_t file_offset, std::shared_ptr<arrow::StringArray>* string_array){
+    std::shared_ptr<arrow::Buffer> off_buffer;
+    arrow::AllocateBuffer((num_strings+1)*sizeof(int32_t), &off_buffer);
+
+    std::shared_ptr<arrow::Buffer> val_buffer;
+    arrow::AllocateBuffer(num_chars, &val_buffer);
+
+    return read_string_plain(num_strings, file_offset, string_array, off_buffer, val_buffer);
+}
+
+// Read PLAIN encoded strings. Without a val_buffer one is allocated with the exact number of characters.
+status SWParquetReader::read_string_plain(int64_t num_strings, int64_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, std::shared_ptr<arrow::Buffer> off_buffer, std::shared_ptr<arrow::Buffer> val_buffer){
+    const page_index* index;
+
+    if(get_page_index(file_offset, num_strings, &index) != status::OK) {
+        return status::FAIL;
+    }
+
+    return read_string_pages(index, nullptr, num_strings, string_array, off_buffer, val_buffer);
+}
+
+// Read the first num_strings strings of PLAIN pages, or of dictionary encoded pages if a dictionary is given. Every page is read
+// in two steps. Its lengths are collected into the offset buffer first, and once the offset the page starts at is known they are
+// turned into offsets with a prefix sum and the characters are copied.
+// With a val_buffer both steps run page after page, while the page is still in the cache. Without one all pages are scanned
+// first, in parallel, the value buffer is allocated with the exact number of characters, and then all pages are copied in
+// parallel. Compressed PLAIN pages are decompressed a second time for the copy.
+status SWParquetReader::read_string_pages(const page_index* index, const dictionary_values* dictionary, int64_t num_strings, std::shared_ptr<arrow::StringArray>* string_array, std::shared_ptr<arrow::Buffer> off_buffer, std::shared_ptr<arrow::Buffer> val_buffer){
+    int32_t* off_buf_ptr = (int32_t*) off_buffer->mutable_data();
+    int32_t num_pages = index->pages_for_rows(num_strings);
+    bool two_pass = !val_buffer;
+
+    //Write first offset
+    off_buf_ptr[0] = 0;
+
+    std::shared_ptr<arrow::Buffer> null_bitmap;
+    allocate_null_bitmap(index->max_def_level > 0, num_strings, &null_bitmap);
+
+    // Non-null strings and characters of every page, the indices of dictionary encoded pages are kept for the copy
+    std::vector<int32_t> page_values(num_pages);
+    std::vector<int64_t> page_chars(num_pages);
+    std::vector<int32_t> indices(dictionary ? num_strings : 0);
+    std::atomic<int64_t> null_count(0);
+
+    // Collect the lengths of the non-null strings of a page, densely, into the offset buffer from the page's first row on
+    auto scan_page = [&](int32_t page, page_contents* contents) -> bool {
+        int64_t first_row = index->first_rows[page];
+        int32_t page_rows_to_read = std::min((int64_t) index->num_values[page], num_strings-first_row);
+        int32_t page_values_to_read = page_rows_to_read;
+        int32_t* lengths = off_buf_ptr + 1 + first_row;
+        const uint8_t* validity_bits;
+
+        if((get_page_contents(index, page, contents) != status::OK)
+                || (null_bitmap && (decode_page_validity(index, page, *contents, first_row, page_rows_to_read, null_bitmap->mutable_data(), &validity_bits, &page_values_to_read) != status::OK))) {
+            return false;
+        }
+
+        if(index->encodings[page] == parquet_encoding::PLAIN) {
+            if(scan_plain_lengths(contents->values, contents->values_size, page_values_to_read, lengths, &page_chars[page]) != status::OK) {
+                std::cerr << "[ERROR] Page at file offset " << index->page_offsets[page] << " is too small to hold its strings" << std::endl;
+                return false;
+            }
+        } else if(dictionary && index->dictionary_encoded(page)) {
+            int32_t* page_indices = indices.data() + first_row;
+            if(decode_dictionary_indices(contents->values, contents->values_size, dictionary->num_values, page_values_to_read, page_indices) != status::OK) {
+                std::cerr << "[ERROR] Corrupt dictionary indices in page at file offset " << index->page_offsets[page] << std::endl;
+                return false;
+            }
+
+            int64_t chars = 0;
+            gather32(dictionary->lengths.data(), page_indices, lengths, page_values_to_read);
+            for(int32_t i=0; i<page_values_to_read; i++) {
+                chars += lengths[i];
+            }
+            page_chars[page] = chars;
+        } else {
+            std::cerr << "[ERROR] Page at file offset " << index->page_offsets[page] << " uses unsupported encoding " << (int32_t) index->encodings[page] << std::endl;
+            return false;
+        }
+
+        page_values[page] = page_values_to_read;
+        null_count += page_rows_to_read - page_values_to_read;
+        return true;
+    };
+
+    // Turn the lengths of a page into offsets from page_start on and copy its characters. Copies never write past the
+    // page's last string, so pages can be copied in parallel.
+    auto copy_page = [&](int32_t page, const page_contents& contents, int32_t page_start) {
+        int64_t first_row = index->first_rows[page];
+        int32_t page_rows_to_read = std::min((int64_t) index->num_values[page], num_strings-first_row);
+        int32_t page_values_to_read = page_values[page];
+        int32_t* end_offsets = off_buf_ptr + 1 + first_row;
+        uint8_t* val_buf_ptr = val_buffer->mutable_data();
+
+        int32_t page_end = delta_prefix_sum32((const uint32_t*) end_offsets, 0, page_start, end_offsets, page_values_to_read);
+
+        if(index->encodings[page] == parquet_encoding::PLAIN) {
+            copy_plain_strings(contents.values, contents.values + contents.values_size, page_start, end_offsets, page_values_to_read, val_buf_ptr, val_buf_ptr + page_end);
+        } else {
+            copy_dictionary_strings(dictionary->values->data(), (const int32_t*) dictionary->offsets->data(), indices.data() + first_row,
+                                    page_start, end_offsets, val_buf_ptr, val_buf_ptr + page_end, page_values_to_read);
+        }
+
+        // Pages only store the non-null strings, move the offsets out to their rows. Null strings are empty.
+        if(page_values_to_read < page_rows_to_read) {
+            scatter_offsets_to_valid(end_offsets, null_bitmap->data() + first_row/8, first_row % 8, page_rows_to_read, page_values_to_read, page_start);
+        }
+    };
+
+    if(!two_pass) {
+        int64_t current_offset = 0;
+
+        for(int32_t page = 0; page < num_pages; page++) {
+            page_contents contents;
+            if(!scan_page(page, &contents)) {
+                return status::FAIL;
+            }
+
+            if((current_offset + page_chars[page] > val_buffer->capacity()) || (current_offset + page_chars[page] > INT32_MAX)) {
+                std::cerr << "[ERROR] Value buffer holds " << val_buffer->capacity() << " characters but the strings at file offset " << index->page_offsets[0] << " need more" << std::endl;
+                return status::FAIL;
+            }
+
+            copy_page(page, contents, current_offset);
+            current_offset += page_chars[page];
+        }
+    } else {
+        std::atomic<bool> failed(false);
+
+        std::function<void(int64_t)> scan = [&](int64_t page){
+            page_contents contents;
+            if(!scan_page(page, &contents)) {
+                failed = true;
+            }
+        };
+
+        for_each_page(num_pages, scan);
+
+        if(failed) {
+            return status::FAIL;
+        }
+
+        // Where every page starts in the value buffer
+        std::vector<int32_t> page_starts(num_pages);
+        int64_t total_chars = 0;
+        for(int32_t page = 0; page < num_pages; page++) {
+            page_starts[page] = total_chars;
+            total_chars += page_chars[page];
+            if(total_chars > INT32_MAX) {
+                std::cerr << "[ERROR] Strings at file offset " << index->page_offsets[0] << " hold more characters than a StringArray can" << std::endl;
+                return status::FAIL;
+            }
+        }
+
+        arrow::AllocateBuffer(total_chars, &val_buffer);
+
+        // Dictionary encoded pages were reduced to their indices, only PLAIN pages are needed again
+        std::function<void(int64_t)> copy = [&](int64_t page){
+            page_contents contents;
+            if((index->encodings[page] == parquet_encoding::PLAIN) && (get_page_contents(index, page, &contents) != status::OK)) {
+                failed = true;
+                return;
+            }
+            copy_page(page, contents, page_starts[page]);
+        };
+
+        for_each_page(num_pages, copy);
+
+        if(failed) {
+            return status::FAIL;
+        }
+    }
+
+    drop_empty_null_bitmap(null_count, &null_bitmap);
+
+    *string_array = std::make_shared<arrow::StringArray>(num_strings, off_buffer, val_buffer, null_bitmap, null_count);
+
+    return status::OK;
+}
+
+}
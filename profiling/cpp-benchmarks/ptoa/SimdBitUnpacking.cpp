@@ -0,0 +1,130 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+
+#include "SimdBitUnpacking.h"
+#include "SimdDispatch.h"
+#include "LemireBitUnpacking.h"
+
+namespace ptoa {
+
+template<uint32_t bit>
+static void unpack32_scalar(const uint32_t* __restrict__ in, uint32_t* __restrict__ out) {
+    scalar_fastunpack(in, out, bit);
+}
+
+template<uint32_t bit>
+__attribute__((target("sse4.1")))
+static void unpack32_sse41(const uint32_t* __restrict__ in, uint32_t* __restrict__ out) {
+    const uint8_t* bytes = (const uint8_t*) in;
+
+    _mm_storeu_si128((__m128i*)(out + 0), unpack4_sse41<bit, 0>(bytes));
+    _mm_storeu_si128((__m128i*)(out + 4), unpack4_sse41<bit, 1>(bytes));
+    _mm_storeu_si128((__m128i*)(out + 8), unpack4_sse41<bit, 2>(bytes));
+    _mm_storeu_si128((__m128i*)(out + 12), unpack4_sse41<bit, 3>(bytes));
+    _mm_storeu_si128((__m128i*)(out + 16), unpack4_sse41<bit, 4>(bytes));
+    _mm_storeu_si128((__m128i*)(out + 20), unpack4_sse41<bit, 5>(bytes));
+    _mm_storeu_si128((__m128i*)(out + 24), unpack4_sse41<bit, 6>(bytes));
+    _mm_storeu_si128((__m128i*)(out + 28), unpack4_sse41<bit, 7>(bytes));
+}
+
+template<uint32_t bit>
+__attribute__((target("avx2")))
+static void unpack32_avx2(const uint32_t* __restrict__ in, uint32_t* __restrict__ out) {
+    const uint8_t* bytes = (const uint8_t*) in;
+
+    _mm256_storeu_si256((__m256i*)(out + 0), unpack8_avx2<bit, 0>(bytes));
+    _mm256_storeu_si256((__m256i*)(out + 8), unpack8_avx2<bit, 1>(bytes));
+    _mm256_storeu_si256((__m256i*)(out + 16), unpack8_avx2<bit, 2>(bytes));
+    _mm256_storeu_si256((__m256i*)(out + 24), unpack8_avx2<bit, 3>(bytes));
+}
+
+template<uint32_t bit>
+__attribute__((target("avx512f")))
+static void unpack32_avx512(const uint32_t* __restrict__ in, uint32_t* __restrict__ out) {
+    __m512i low_words, high_words;
+    load_miniblock_avx512<bit>((const uint8_t*) in, &low_words, &high_words);
+
+    _mm512_storeu_si512((void*)(out + 0), unpack16_avx512<bit, 0>(low_words, high_words));
+    _mm512_storeu_si512((void*)(out + 16), unpack16_avx512<bit, 1>(low_words, high_words));
+}
+
+// Values wider than SSE41_MAX_BIT_WIDTH do not fit the multiply based shift, those widths stay scalar
+static const unpack32_fn unpack32_sse41_kernels[33] = {
+    SIMD_KERNELS_16(unpack32_sse41, 0), SIMD_KERNELS_4(unpack32_sse41, 16), SIMD_KERNELS_4(unpack32_sse41, 20),
+    unpack32_sse41<24>, unpack32_sse41<25>,
+    unpack32_scalar<26>, unpack32_scalar<27>, SIMD_KERNELS_4(unpack32_scalar, 28), unpack32_scalar<32>
+};
+
+static const unpack32_fn unpack32_avx2_kernels[33] = {
+    SIMD_KERNELS_16(unpack32_avx2, 0), SIMD_KERNELS_16(unpack32_avx2, 16), unpack32_avx2<32>
+};
+
+static const unpack32_fn unpack32_avx512_kernels[33] = {
+    SIMD_KERNELS_16(unpack32_avx512, 0), SIMD_KERNELS_16(unpack32_avx512, 16), unpack32_avx512<32>
+};
+
+template<uint32_t bit>
+__attribute__((target("avx2")))
+static void unpack64_avx2(const uint64_t* __restrict__ in, uint64_t* __restrict__ out) {
+    const uint8_t* bytes = (const uint8_t*) in;
+
+    _mm256_storeu_si256((__m256i*)(out + 0), unpack4_64_avx2<bit, 0>(bytes));
+    _mm256_storeu_si256((__m256i*)(out + 4), unpack4_64_avx2<bit, 1>(bytes));
+    _mm256_storeu_si256((__m256i*)(out + 8), unpack4_64_avx2<bit, 2>(bytes));
+    _mm256_storeu_si256((__m256i*)(out + 12), unpack4_64_avx2<bit, 3>(bytes));
+    _mm256_storeu_si256((__m256i*)(out + 16), unpack4_64_avx2<bit, 4>(bytes));
+    _mm256_storeu_si256((__m256i*)(out + 20), unpack4_64_avx2<bit, 5>(bytes));
+    _mm256_storeu_si256((__m256i*)(out + 24), unpack4_64_avx2<bit, 6>(bytes));
+    _mm256_storeu_si256((__m256i*)(out + 28), unpack4_64_avx2<bit, 7>(bytes));
+}
+
+template<uint32_t bit>
+__attribute__((target("avx512f,avx512bw")))
+static void unpack64_avx512(const uint64_t* __restrict__ in, uint64_t* __restrict__ out) {
+    const uint8_t* bytes = (const uint8_t*) in;
+
+    _mm512_storeu_si512((void*)(out + 0), unpack8_64_avx512<bit, 0>(bytes));
+    _mm512_storeu_si512((void*)(out + 8), unpack8_64_avx512<bit, 1>(bytes));
+    _mm512_storeu_si512((void*)(out + 16), unpack8_64_avx512<bit, 2>(bytes));
+    _mm512_storeu_si512((void*)(out + 24), unpack8_64_avx512<bit, 3>(bytes));
+}
+
+static const unpack64_fn unpack64_avx2_kernels[65] = {
+    SIMD_KERNELS_16(unpack64_avx2, 0), SIMD_KERNELS_16(unpack64_avx2, 16),
+    SIMD_KERNELS_16(unpack64_avx2, 32), SIMD_KERNELS_16(unpack64_avx2, 48), unpack64_avx2<64>
+};
+
+static const unpack64_fn unpack64_avx512_kernels[65] = {
+    SIMD_KERNELS_16(unpack64_avx512, 0), SIMD_KERNELS_16(unpack64_avx512, 16),
+    SIMD_KERNELS_16(unpack64_avx512, 32), SIMD_KERNELS_16(unpack64_avx512, 48), unpack64_avx512<64>
+};
+
+const unpack32_fn* select_simd_unpack32_kernels() {
+    switch(detect_simd_level()) {
+        case simd_level::AVX512: return unpack32_avx512_kernels;
+        case simd_level::AVX2: return unpack32_avx2_kernels;
+        case simd_level::SSE4_1: return unpack32_sse41_kernels;
+        default: return nullptr;
+    }
+}
+
+const unpack64_fn* select_simd_unpack64_kernels() {
+    switch(detect_simd_level()) {
+        case simd_level::AVX512: return unpack64_avx512_kernels;
+        case simd_level::AVX2: return unpack64_avx2_kernels;
+        default: return nullptr;
+    }
+}
+
+}
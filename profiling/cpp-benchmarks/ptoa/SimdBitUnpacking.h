@@ -0,0 +1,262 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <immintrin.h>
+
+/*
+ * SIMD unpacking of 32 value miniblocks of bit wide, LSB first packed values (the Parquet bit packing layout),
+ * into 32 bit (widths 0-32) or 64 bit (widths 0-64) values.
+ * Every kernel is a template on the bit width so that all byte offsets, shuffle indices and shift amounts are
+ * compile time constants. A miniblock of bit wide values is exactly 4*bit bytes long and the kernels never read
+ * outside of it: loads near the end of the miniblock are moved back, miniblocks shorter than a vector are loaded
+ * whole with partial or masked loads.
+ */
+
+namespace ptoa{
+
+// Byte that holds the first bit of value j, and the position of that bit within the byte
+constexpr uint32_t packed_byte(uint32_t bit, uint32_t j) { return j*bit/8; }
+constexpr uint32_t packed_shift(uint32_t bit, uint32_t j) { return j*bit%8; }
+
+constexpr uint32_t value_mask32(uint32_t bit) { return bit >= 32 ? ~0U : (1U << bit) - 1; }
+constexpr uint64_t value_mask64(uint32_t bit) { return bit >= 64 ? ~0ULL : (1ULL << bit) - 1; }
+
+/*
+ * SSE4.1, 4 values per vector. pshufb gathers the 4 bytes holding each value into its lane. There is no variable shift,
+ * so the values are aligned with a multiply by 2^(7-shift) followed by a constant shift right by 7. This leaves room for
+ * values of at most 25 bits, wider values use the scalar unpacking.
+ */
+
+const uint32_t SSE41_MAX_BIT_WIDTH = 25;
+
+// First byte loaded for group (values 4*group..4*group+3), moved back if a 16 byte load would run past the miniblock.
+// Miniblocks shorter than 16 bytes are loaded whole.
+constexpr uint32_t sse41_load_byte(uint32_t bit, uint32_t group) {
+    return 4*bit < 16 ? 0 : (packed_byte(bit, 4*group) > 4*bit - 16 ? 4*bit - 16 : packed_byte(bit, 4*group));
+}
+
+// Shuffle index of byte t of lane in group. Bytes past the loaded 16 are never part of the value and are zeroed.
+constexpr int8_t sse41_shuffle(uint32_t bit, uint32_t group, uint32_t lane, uint32_t t) {
+    return packed_byte(bit, 4*group+lane) + t - sse41_load_byte(bit, group) < 16 ?
+        (int8_t)(packed_byte(bit, 4*group+lane) + t - sse41_load_byte(bit, group)) : (int8_t) 0x80;
+}
+
+constexpr int32_t sse41_multiplier(uint32_t bit, uint32_t group, uint32_t lane) {
+    return 1 << (7 - packed_shift(bit, 4*group+lane));
+}
+
+#define PTOA_SSE41_SHUFFLE_LANE(lane) \
+    sse41_shuffle(bit, group, lane, 0), sse41_shuffle(bit, group, lane, 1), sse41_shuffle(bit, group, lane, 2), sse41_shuffle(bit, group, lane, 3)
+
+template<uint32_t bit>
+__attribute__((target("sse4.1")))
+inline __m128i load_short_miniblock_sse41(const uint8_t* in) {
+    int32_t word;
+    switch(bit) {
+        case 0:
+            return _mm_setzero_si128();
+        case 1:
+            memcpy(&word, in, 4);
+            return _mm_cvtsi32_si128(word);
+        case 2:
+            return _mm_loadl_epi64((const __m128i*) in);
+        default:
+            memcpy(&word, in + 8, 4);
+            return _mm_insert_epi32(_mm_loadl_epi64((const __m128i*) in), word, 2);
+    }
+}
+
+template<uint32_t bit, uint32_t group>
+__attribute__((target("sse4.1")))
+inline __m128i unpack4_sse41(const uint8_t* in) {
+    static_assert(bit <= SSE41_MAX_BIT_WIDTH, "Value does not fit in the 4 byte window");
+
+    const __m128i bytes = 4*bit < 16 ? load_short_miniblock_sse41<bit>(in) : _mm_loadu_si128((const __m128i*)(in + sse41_load_byte(bit, group)));
+    __m128i x = _mm_shuffle_epi8(bytes, _mm_setr_epi8(PTOA_SSE41_SHUFFLE_LANE(0), PTOA_SSE41_SHUFFLE_LANE(1),
+                                                      PTOA_SSE41_SHUFFLE_LANE(2), PTOA_SSE41_SHUFFLE_LANE(3)));
+    x = _mm_mullo_epi32(x, _mm_setr_epi32(sse41_multiplier(bit, group, 0), sse41_multiplier(bit, group, 1),
+                                          sse41_multiplier(bit, group, 2), sse41_multiplier(bit, group, 3)));
+    x = _mm_srli_epi32(x, 7);
+    return _mm_and_si128(x, _mm_set1_epi32(value_mask32(bit)));
+}
+
+#undef PTOA_SSE41_SHUFFLE_LANE
+
+/*
+ * AVX2, 8 values per vector. The 8 values of a group take exactly bit bytes, so one 32 byte load holds all of them.
+ * Each lane picks the two 32 bit words its value straddles with vpermd and combines them with variable shifts.
+ */
+
+// First byte loaded for group (values 8*group..8*group+7), moved back if a 32 byte load would run past the miniblock.
+// Miniblocks shorter than 32 bytes are loaded whole.
+constexpr uint32_t avx2_load_byte(uint32_t bit, uint32_t group) {
+    return 4*bit < 32 ? 0 : (group*bit > 4*bit - 32 ? 4*bit - 32 : group*bit);
+}
+
+constexpr int32_t avx2_load_mask(uint32_t bit, uint32_t word) { return word < bit ? -1 : 0; }
+
+constexpr uint32_t avx2_start_bit(uint32_t bit, uint32_t group, uint32_t lane) {
+    return 8*(group*bit - avx2_load_byte(bit, group)) + lane*bit;
+}
+
+constexpr int32_t avx2_word(uint32_t bit, uint32_t group, uint32_t lane) { return avx2_start_bit(bit, group, lane)/32; }
+constexpr int32_t avx2_next_word(uint32_t bit, uint32_t group, uint32_t lane) { return (avx2_start_bit(bit, group, lane)/32 + 1) % 8; }
+constexpr int32_t avx2_shift(uint32_t bit, uint32_t group, uint32_t lane) { return avx2_start_bit(bit, group, lane)%32; }
+
+#define PTOA_AVX2_LANES(fn) \
+    fn(bit, group, 0), fn(bit, group, 1), fn(bit, group, 2), fn(bit, group, 3), \
+    fn(bit, group, 4), fn(bit, group, 5), fn(bit, group, 6), fn(bit, group, 7)
+
+template<uint32_t bit, uint32_t group>
+__attribute__((target("avx2")))
+inline __m256i unpack8_avx2(const uint8_t* in) {
+    const __m256i words = 4*bit < 32 ?
+        _mm256_maskload_epi32((const int*) in, _mm256_setr_epi32(avx2_load_mask(bit, 0), avx2_load_mask(bit, 1), avx2_load_mask(bit, 2), avx2_load_mask(bit, 3),
+                                                                 avx2_load_mask(bit, 4), avx2_load_mask(bit, 5), avx2_load_mask(bit, 6), avx2_load_mask(bit, 7))) :
+        _mm256_loadu_si256((const __m256i*)(in + avx2_load_byte(bit, group)));
+    const __m256i shift = _mm256_setr_epi32(PTOA_AVX2_LANES(avx2_shift));
+    const __m256i lo = _mm256_permutevar8x32_epi32(words, _mm256_setr_epi32(PTOA_AVX2_LANES(avx2_word)));
+    const __m256i hi = _mm256_permutevar8x32_epi32(words, _mm256_setr_epi32(PTOA_AVX2_LANES(avx2_next_word)));
+    // Shifting by 32 yields zero, which covers values that do not straddle a word boundary
+    __m256i x = _mm256_or_si256(_mm256_srlv_epi32(lo, shift), _mm256_sllv_epi32(hi, _mm256_sub_epi32(_mm256_set1_epi32(32), shift)));
+    return _mm256_and_si256(x, _mm256_set1_epi32(value_mask32(bit)));
+}
+
+#undef PTOA_AVX2_LANES
+
+/*
+ * AVX-512, 16 values per vector. The whole miniblock (at most 32 words) is loaded into two registers with masked loads,
+ * vpermt2d picks the two words each value straddles from either register.
+ */
+
+template<uint32_t bit>
+__attribute__((target("avx512f")))
+inline void load_miniblock_avx512(const uint8_t* in, __m512i* low_words, __m512i* high_words) {
+    *low_words = _mm512_maskz_loadu_epi32((__mmask16)((1U << (bit < 16 ? bit : 16)) - 1), in);
+    *high_words = _mm512_maskz_loadu_epi32((__mmask16)((1U << (bit > 16 ? bit - 16 : 0)) - 1), in + 64);
+}
+
+constexpr int32_t avx512_word(uint32_t bit, uint32_t group, uint32_t lane) { return (16*group + lane)*bit/32; }
+constexpr int32_t avx512_next_word(uint32_t bit, uint32_t group, uint32_t lane) { return ((16*group + lane)*bit/32 + 1) % 32; }
+constexpr int32_t avx512_shift(uint32_t bit, uint32_t group, uint32_t lane) { return (16*group + lane)*bit%32; }
+
+// Highest lane first, _mm512_setr_epi32 is a macro in some compilers and cannot take these as arguments
+#define PTOA_AVX512_LANES(fn) \
+    fn(bit, group, 15), fn(bit, group, 14), fn(bit, group, 13), fn(bit, group, 12), \
+    fn(bit, group, 11), fn(bit, group, 10), fn(bit, group, 9), fn(bit, group, 8), \
+    fn(bit, group, 7), fn(bit, group, 6), fn(bit, group, 5), fn(bit, group, 4), \
+    fn(bit, group, 3), fn(bit, group, 2), fn(bit, group, 1), fn(bit, group, 0)
+
+template<uint32_t bit, uint32_t group>
+__attribute__((target("avx512f")))
+inline __m512i unpack16_avx512(__m512i low_words, __m512i high_words) {
+    const __m512i shift = _mm512_set_epi32(PTOA_AVX512_LANES(avx512_shift));
+    const __m512i lo = _mm512_permutex2var_epi32(low_words, _mm512_set_epi32(PTOA_AVX512_LANES(avx512_word)), high_words);
+    const __m512i hi = _mm512_permutex2var_epi32(low_words, _mm512_set_epi32(PTOA_AVX512_LANES(avx512_next_word)), high_words);
+    // Shifting by 32 yields zero, which covers values that do not straddle a word boundary.
+    // The zero masked forms with all lanes enabled are the same instructions, they avoid false uninitialized warnings in GCC's headers.
+    const __mmask16 all = 0xFFFF;
+    __m512i x = _mm512_or_si512(_mm512_maskz_srlv_epi32(all, lo, shift), _mm512_maskz_sllv_epi32(all, hi, _mm512_sub_epi32(_mm512_set1_epi32(32), shift)));
+    return _mm512_and_si512(x, _mm512_set1_epi32(value_mask32(bit)));
+}
+
+#undef PTOA_AVX512_LANES
+
+/*
+ * 64 bit values, AVX2 with 4 values per vector. A group of 4 values takes bit/2 bytes, one 32 byte load holds all of them.
+ * Lanes pick the two 64 bit words their value straddles with vpermd on pairs of 32 bit indices.
+ */
+
+// First byte loaded for group (values 4*group..4*group+3), moved back if a 32 byte load would run past the miniblock.
+// Miniblocks shorter than 32 bytes are loaded whole.
+constexpr uint32_t avx2_64_load_byte(uint32_t bit, uint32_t group) {
+    return 4*bit < 32 ? 0 : (4*group*bit/8 > 4*bit - 32 ? 4*bit - 32 : 4*group*bit/8);
+}
+
+constexpr uint32_t avx2_64_start_bit(uint32_t bit, uint32_t group, uint32_t lane) {
+    return (4*group + lane)*bit - 8*avx2_64_load_byte(bit, group);
+}
+
+// 32 bit permutation indices of the low (half 0) and high (half 1) part of the word that holds the start of the value
+constexpr int32_t avx2_64_word(uint32_t bit, uint32_t group, uint32_t lane, uint32_t half) {
+    return 2*(avx2_64_start_bit(bit, group, lane)/64) + half;
+}
+constexpr int32_t avx2_64_next_word(uint32_t bit, uint32_t group, uint32_t lane, uint32_t half) {
+    return 2*((avx2_64_start_bit(bit, group, lane)/64 + 1) % 4) + half;
+}
+constexpr int64_t avx2_64_shift(uint32_t bit, uint32_t group, uint32_t lane) { return avx2_64_start_bit(bit, group, lane)%64; }
+
+#define PTOA_AVX2_64_LANE_WORDS(fn, lane) fn(bit, group, lane, 0), fn(bit, group, lane, 1)
+#define PTOA_AVX2_64_WORDS(fn) \
+    PTOA_AVX2_64_LANE_WORDS(fn, 0), PTOA_AVX2_64_LANE_WORDS(fn, 1), PTOA_AVX2_64_LANE_WORDS(fn, 2), PTOA_AVX2_64_LANE_WORDS(fn, 3)
+
+template<uint32_t bit, uint32_t group>
+__attribute__((target("avx2")))
+inline __m256i unpack4_64_avx2(const uint8_t* in) {
+    const __m256i words = 4*bit < 32 ?
+        _mm256_maskload_epi32((const int*) in, _mm256_setr_epi32(avx2_load_mask(bit, 0), avx2_load_mask(bit, 1), avx2_load_mask(bit, 2), avx2_load_mask(bit, 3),
+                                                                 avx2_load_mask(bit, 4), avx2_load_mask(bit, 5), avx2_load_mask(bit, 6), avx2_load_mask(bit, 7))) :
+        _mm256_loadu_si256((const __m256i*)(in + avx2_64_load_byte(bit, group)));
+    const __m256i shift = _mm256_setr_epi64x(avx2_64_shift(bit, group, 0), avx2_64_shift(bit, group, 1), avx2_64_shift(bit, group, 2), avx2_64_shift(bit, group, 3));
+    const __m256i lo = _mm256_permutevar8x32_epi32(words, _mm256_setr_epi32(PTOA_AVX2_64_WORDS(avx2_64_word)));
+    const __m256i hi = _mm256_permutevar8x32_epi32(words, _mm256_setr_epi32(PTOA_AVX2_64_WORDS(avx2_64_next_word)));
+    // Shifting by 64 yields zero, which covers values that do not straddle a word boundary
+    __m256i x = _mm256_or_si256(_mm256_srlv_epi64(lo, shift), _mm256_sllv_epi64(hi, _mm256_sub_epi64(_mm256_set1_epi64x(64), shift)));
+    return _mm256_and_si256(x, _mm256_set1_epi64x(value_mask64(bit)));
+}
+
+#undef PTOA_AVX2_64_WORDS
+#undef PTOA_AVX2_64_LANE_WORDS
+
+/*
+ * 64 bit values, AVX-512 with 8 values per vector. A group of 8 values takes exactly bit bytes starting at a byte boundary,
+ * a byte masked load reads exactly those bytes. vpermq picks the two words each value straddles.
+ */
+
+constexpr uint64_t avx512_64_load_mask(uint32_t bit) { return bit >= 64 ? ~0ULL : (1ULL << bit) - 1; }
+
+constexpr int64_t avx512_64_word(uint32_t bit, uint32_t lane) { return lane*bit/64; }
+constexpr int64_t avx512_64_next_word(uint32_t bit, uint32_t lane) { return (lane*bit/64 + 1) % 8; }
+constexpr int64_t avx512_64_shift(uint32_t bit, uint32_t lane) { return lane*bit%64; }
+
+// Highest lane first, _mm512_setr_epi64 is a macro in some compilers and cannot take these as arguments
+#define PTOA_AVX512_64_LANES(fn) \
+    fn(bit, 7), fn(bit, 6), fn(bit, 5), fn(bit, 4), fn(bit, 3), fn(bit, 2), fn(bit, 1), fn(bit, 0)
+
+template<uint32_t bit, uint32_t group>
+__attribute__((target("avx512f,avx512bw")))
+inline __m512i unpack8_64_avx512(const uint8_t* in) {
+    const __m512i words = _mm512_maskz_loadu_epi8((__mmask64) avx512_64_load_mask(bit), in + group*bit);
+    const __m512i shift = _mm512_set_epi64(PTOA_AVX512_64_LANES(avx512_64_shift));
+    // The zero masked forms with all lanes enabled are the same instructions, they avoid false uninitialized warnings in GCC's headers
+    const __mmask8 all = 0xFF;
+    const __m512i lo = _mm512_maskz_permutexvar_epi64(all, _mm512_set_epi64(PTOA_AVX512_64_LANES(avx512_64_word)), words);
+    const __m512i hi = _mm512_maskz_permutexvar_epi64(all, _mm512_set_epi64(PTOA_AVX512_64_LANES(avx512_64_next_word)), words);
+    // Shifting by 64 yields zero, which covers values that do not straddle a word boundary
+    __m512i x = _mm512_or_si512(_mm512_maskz_srlv_epi64(all, lo, shift), _mm512_maskz_sllv_epi64(all, hi, _mm512_sub_epi64(_mm512_set1_epi64(64), shift)));
+    return _mm512_and_si512(x, _mm512_set1_epi64(value_mask64(bit)));
+}
+
+#undef PTOA_AVX512_64_LANES
+
+// Kernel tables indexed by bit width (0-32 and 0-64), as selected for the CPU we are running on.
+// Return null if the CPU has no SIMD level with kernels for the value width.
+typedef void (*unpack32_fn)(const uint32_t* __restrict__ in, uint32_t* __restrict__ out);
+typedef void (*unpack64_fn)(const uint64_t* __restrict__ in, uint64_t* __restrict__ out);
+const unpack32_fn* select_simd_unpack32_kernels();
+const unpack64_fn* select_simd_unpack64_kernels();
+
+}
@@ -0,0 +1,69 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace ptoa{
+
+// Instruction set extensions the decoding kernels are specialized for, in increasing order
+enum simd_level {
+	SCALAR = 0,
+	SSE4_1 = 1,
+	AVX2 = 2,
+	AVX512 = 3
+};
+
+// Highest SIMD level supported by the CPU we are running on. Detected once, the result is cached.
+// Setting the environment variable PTOA_SIMD to scalar, sse4.1 or avx2 caps the level, which is useful to benchmark kernels against each other.
+inline simd_level detect_simd_level() {
+    static const simd_level level = []{
+        simd_level detected = simd_level::SCALAR;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        // Kernels may be selected from static initializers, before the runtime initialized the CPU model
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+            detected = simd_level::AVX512;
+        } else if(__builtin_cpu_supports("avx2")) {
+            detected = simd_level::AVX2;
+        } else if(__builtin_cpu_supports("sse4.1")) {
+            detected = simd_level::SSE4_1;
+        }
+#endif
+
+        const char* cap = getenv("PTOA_SIMD");
+        if(cap != nullptr) {
+            simd_level max_level = simd_level::AVX512;
+            if(strcmp(cap, "scalar") == 0) {
+                max_level = simd_level::SCALAR;
+            } else if(strcmp(cap, "sse4.1") == 0) {
+                max_level = simd_level::SSE4_1;
+            } else if(strcmp(cap, "avx2") == 0) {
+                max_level = simd_level::AVX2;
+            }
+            detected = detected < max_level ? detected : max_level;
+        }
+
+        return detected;
+    }();
+
+    return level;
+}
+
+// Kernel tables indexed by bit width are written out with these, fn is a template on the bit width
+#define SIMD_KERNELS_4(fn, b) fn<b>, fn<b+1>, fn<b+2>, fn<b+3>
+#define SIMD_KERNELS_16(fn, b) SIMD_KERNELS_4(fn, b), SIMD_KERNELS_4(fn, b+4), SIMD_KERNELS_4(fn, b+8), SIMD_KERNELS_4(fn, b+12)
+
+}
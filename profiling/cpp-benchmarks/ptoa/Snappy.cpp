@@ -0,0 +1,161 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+
+#include "Snappy.h"
+
+namespace ptoa {
+
+// A block starts with its uncompressed length as a varint of at most 32 bits. Returns the varint length, 0 if invalid.
+static size_t read_preamble(const uint8_t* in, size_t in_size, size_t* length) {
+    uint32_t result = 0;
+
+    for(size_t i = 0; (i < 5) && (i < in_size); i++) {
+        result |= (uint32_t)(in[i] & 0x7F) << (7*i);
+        if(!(in[i] & 0x80)) {
+            *length = result;
+            return i+1;
+        }
+    }
+
+    return 0;
+}
+
+static inline void copy8(uint8_t* dst, const uint8_t* src) {
+    uint64_t chunk;
+    std::memcpy(&chunk, src, 8);
+    std::memcpy(dst, &chunk, 8);
+}
+
+static inline uint32_t load_le(const uint8_t* in, size_t bytes) {
+    uint32_t value = 0;
+    for(size_t i = 0; i < bytes; i++) {
+        value |= (uint32_t) in[i] << (8*i);
+    }
+    return value;
+}
+
+/*
+ * Every element is a literal or a copy of earlier output. Short literals (at most 16 bytes, which is most of them)
+ * are copied with a single 16 byte move and copies with 8 byte moves, both overshooting into the slack behind the
+ * output. Copies whose source overlaps their destination by less than 8 bytes repeat a short pattern, which is first
+ * widened to 8 bytes by doubling it. Close to the end of the output, where there is no slack, bytes are copied one at a time.
+ */
+status snappy_decompress(const uint8_t* in, size_t in_size, uint8_t* out, size_t out_size, size_t out_capacity) {
+    const uint8_t* ip = in;
+    const uint8_t* in_end = in + in_size;
+    uint8_t* op = out;
+    uint8_t* out_end = out + out_size;
+    uint8_t* capacity_end = out + out_capacity;
+    size_t length;
+
+    size_t preamble_size = read_preamble(in, in_size, &length);
+    if((preamble_size == 0) || (length != out_size) || (out_capacity < out_size)) {
+        return status::FAIL;
+    }
+    ip += preamble_size;
+
+    while(ip < in_end) {
+        uint8_t tag = *ip++;
+
+        if((tag & 3) == 0) {
+            size_t literal_length = (tag >> 2) + 1;
+
+            if((literal_length <= 16) && (in_end - ip >= 16) && (capacity_end - op >= 16)) {
+                if((size_t)(out_end - op) < literal_length) {
+                    return status::FAIL;
+                }
+                copy8(op, ip);
+                copy8(op + 8, ip + 8);
+                op += literal_length;
+                ip += literal_length;
+                continue;
+            }
+
+            // Lengths above 60 are stored in the 1 to 4 bytes following the tag
+            if(literal_length > 60) {
+                size_t length_bytes = literal_length - 60;
+                if((size_t)(in_end - ip) < length_bytes) {
+                    return status::FAIL;
+                }
+                literal_length = (size_t) load_le(ip, length_bytes) + 1;
+                ip += length_bytes;
+            }
+
+            if(((size_t)(in_end - ip) < literal_length) || ((size_t)(out_end - op) < literal_length)) {
+                return status::FAIL;
+            }
+            std::memcpy(op, ip, literal_length);
+            op += literal_length;
+            ip += literal_length;
+            continue;
+        }
+
+        size_t copy_length;
+        size_t offset;
+
+        switch(tag & 3) {
+            case 1:
+                if(ip >= in_end) {
+                    return status::FAIL;
+                }
+                copy_length = ((tag >> 2) & 7) + 4;
+                offset = ((size_t)(tag >> 5) << 8) | *ip++;
+                break;
+            case 2:
+                if(in_end - ip < 2) {
+                    return status::FAIL;
+                }
+                copy_length = (tag >> 2) + 1;
+                offset = load_le(ip, 2);
+                ip += 2;
+                break;
+            default:
+                if(in_end - ip < 4) {
+                    return status::FAIL;
+                }
+                copy_length = (tag >> 2) + 1;
+                offset = load_le(ip, 4);
+                ip += 4;
+        }
+
+        if((offset == 0) || (offset > (size_t)(op - out)) || (copy_length > (size_t)(out_end - op))) {
+            return status::FAIL;
+        }
+
+        const uint8_t* src = op - offset;
+        uint8_t* copy_end = op + copy_length;
+
+        // Copies are at most 64 bytes, the pattern widening below writes at most 8 bytes past its end as well
+        if((size_t)(capacity_end - op) >= SNAPPY_OUTPUT_PADDING) {
+            while(op - src < 8) {
+                copy8(op, src);
+                op += op - src;
+            }
+            while(op < copy_end) {
+                copy8(op, src);
+                op += 8;
+                src += 8;
+            }
+            op = copy_end;
+        } else {
+            while(op < copy_end) {
+                *op++ = *src++;
+            }
+        }
+    }
+
+    return op == out_end ? status::OK : status::FAIL;
+}
+
+}
@@ -0,0 +1,36 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ptoa.h"
+
+/*
+ * Decompression of raw Snappy blocks, the format Parquet stores SNAPPY compressed pages in (without the framing format).
+ * All reads and writes are bounds checked, corrupt input fails instead of running past either buffer.
+ */
+
+namespace ptoa{
+
+// Bytes of slack after the uncompressed data that snappy_decompress needs to take its fast paths up to the end of the output.
+// Copies of up to 64 bytes are done in 8 byte moves that, after widening short patterns, run up to 16 bytes past the copy.
+// With less slack it still works, but falls back to byte wise copies close to the end of the output.
+const size_t SNAPPY_OUTPUT_PADDING = 64 + 16;
+
+// Decompress the block at in into out. out_size has to be the uncompressed length of the block,
+// out_capacity at least out_size; anything between the two may be overwritten.
+status snappy_decompress(const uint8_t* in, size_t in_size, uint8_t* out, size_t out_size, size_t out_capacity);
+
+}
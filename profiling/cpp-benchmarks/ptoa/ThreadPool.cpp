@@ -0,0 +1,96 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ThreadPool.h"
+
+namespace ptoa {
+
+ThreadPool::ThreadPool(int32_t num_threads) : current_task(nullptr), current_num_tasks(0), next_task(0), generation(0), active_workers(0), shutdown(false) {
+    for(int32_t i=1; i<num_threads; i++) {
+        workers.push_back(std::thread(&ThreadPool::worker_loop, this));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        shutdown = true;
+    }
+    work_available.notify_all();
+
+    for(auto& worker : workers) {
+        worker.join();
+    }
+}
+
+// Grab tasks until none are left
+void ThreadPool::run_tasks() {
+    while(true) {
+        int64_t task = next_task.fetch_add(1);
+        if(task >= current_num_tasks) {
+            return;
+        }
+        (*current_task)(task);
+    }
+}
+
+void ThreadPool::worker_loop() {
+    uint64_t seen_generation = 0;
+
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work_available.wait(lock, [&]{return shutdown || (generation != seen_generation);});
+            if(shutdown) {
+                return;
+            }
+            seen_generation = generation;
+        }
+
+        run_tasks();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            active_workers--;
+        }
+        work_done.notify_one();
+    }
+}
+
+void ThreadPool::parallel_for(int64_t num_tasks, const std::function<void(int64_t)>& task) {
+    if(workers.empty() || num_tasks <= 1) {
+        for(int64_t i=0; i<num_tasks; i++) {
+            task(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current_task = &task;
+        current_num_tasks = num_tasks;
+        next_task = 0;
+        active_workers = workers.size();
+        generation++;
+    }
+    work_available.notify_all();
+
+    // The calling thread works along instead of just waiting
+    run_tasks();
+
+    // Wait for all workers, including those that woke up too late to get a task, so the next loop starts from a clean state
+    std::unique_lock<std::mutex> lock(mutex);
+    work_done.wait(lock, [&]{return active_workers == 0;});
+    current_task = nullptr;
+}
+
+}
@@ -0,0 +1,63 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ptoa{
+
+/**
+ * Fixed size pool of worker threads for data parallel loops.
+ * Workers are started once and sleep between loops, so the pool can be reused across many read calls without thread creation cost.
+ */
+class ThreadPool {
+  public:
+    // num_threads includes the calling thread, so num_threads-1 workers are started
+    ThreadPool(int32_t num_threads);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Runs task(i) for all i in [0, num_tasks) on the workers and the calling thread. Tasks are handed out one at a time
+    // in increasing order, so tasks of uneven cost are balanced automatically. Returns when all tasks are done.
+    void parallel_for(int64_t num_tasks, const std::function<void(int64_t)>& task);
+
+    int32_t num_threads() const {return workers.size() + 1;}
+
+  private:
+    void worker_loop();
+    void run_tasks();
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable work_done;
+
+    // State of the current loop, protected by mutex except for the atomics
+    const std::function<void(int64_t)>* current_task;
+    int64_t current_num_tasks;
+    std::atomic<int64_t> next_task;
+    uint64_t generation;
+    int32_t active_workers;
+    bool shutdown;
+};
+
+}
@@ -0,0 +1,235 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <climits>
+#include <string>
+
+namespace ptoa{
+
+// Thrift compact protocol type ids as they appear in the low nibble of field headers
+enum thrift_type {
+	T_STOP = 0,
+	T_BOOLEAN_TRUE = 1,
+	T_BOOLEAN_FALSE = 2,
+	T_BYTE = 3,
+	T_I16 = 4,
+	T_I32 = 5,
+	T_I64 = 6,
+	T_DOUBLE = 7,
+	T_BINARY = 8,
+	T_LIST = 9,
+	T_SET = 10,
+	T_MAP = 11,
+	T_STRUCT = 12
+};
+
+/**
+ * Bounds checked cursor over a Thrift compact protocol encoded structure.
+ * Only decoding is supported. Errors are sticky: once the cursor ran past the end or found malformed data,
+ * every read returns zero and failed() returns true, so callers can check once after parsing a whole structure.
+ */
+class ThriftCompactReader {
+  public:
+    ThriftCompactReader(const uint8_t* data, const uint8_t* end) : ptr(data), end(end), error(false) {}
+
+    bool failed() const {return error;}
+    const uint8_t* position() const {return ptr;}
+
+    uint8_t read_byte() {
+        if(ptr >= end) {
+            error = true;
+            return 0;
+        }
+        return *ptr++;
+    }
+
+    uint64_t read_varint() {
+        uint64_t result = 0;
+
+        // Without per byte bounds checks if even the longest varint ends before end
+        if(end - ptr >= 10) {
+            for(int shift = 0; shift < 64; shift += 7) {
+                uint8_t byte = *ptr++;
+                result |= (uint64_t)(byte & 0x7F) << shift;
+                if(!(byte & 0x80)) {
+                    return result;
+                }
+            }
+            error = true;
+            return 0;
+        }
+
+        for(int shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = read_byte();
+            result |= (uint64_t)(byte & 0x7F) << shift;
+            if(!(byte & 0x80)) {
+                return result;
+            }
+        }
+        error = true;
+        return 0;
+    }
+
+    int32_t read_i32() {
+        uint32_t value = (uint32_t) read_varint();
+        return (int32_t)((value >> 1) ^ -(value & 1));
+    }
+
+    int64_t read_i64() {
+        uint64_t value = read_varint();
+        return (int64_t)((value >> 1) ^ -(value & 1));
+    }
+
+    std::string read_binary() {
+        uint64_t length = read_varint();
+        if(error || length > (uint64_t)(end - ptr)) {
+            error = true;
+            return std::string();
+        }
+        std::string result((const char*) ptr, length);
+        ptr += length;
+        return result;
+    }
+
+    // Same as read_binary without copying the bytes. Returns where they start in the data and sets size.
+    const uint8_t* read_binary_bytes(int32_t* size) {
+        uint64_t length = read_varint();
+        if(error || length > (uint64_t)(end - ptr) || length > INT32_MAX) {
+            error = true;
+            *size = 0;
+            return nullptr;
+        }
+        const uint8_t* result = ptr;
+        *size = (int32_t) length;
+        ptr += length;
+        return result;
+    }
+
+    // Reads a field header. Returns false on the stop field that terminates a struct.
+    // last_field_id holds the id of the previous field in the same struct and is updated, because ids are delta encoded.
+    bool read_field_header(int16_t* last_field_id, int16_t* field_id, uint8_t* type) {
+        uint8_t byte = read_byte();
+        *type = byte & 0x0F;
+        if(*type == T_STOP || error) {
+            return false;
+        }
+        if(byte >> 4) {
+            *field_id = *last_field_id + (byte >> 4);
+        } else {
+            *field_id = (int16_t) read_i32();
+        }
+        *last_field_id = *field_id;
+        return true;
+    }
+
+    // Reads a list or set header and returns the element count
+    uint32_t read_list_header(uint8_t* element_type) {
+        uint8_t byte = read_byte();
+        *element_type = byte & 0x0F;
+        uint32_t size = byte >> 4;
+        if(size == 15) {
+            size = (uint32_t) read_varint();
+        }
+        return size;
+    }
+
+    // Booleans are stored in the type nibble of their field header
+    static bool bool_value(uint8_t type) {return type == T_BOOLEAN_TRUE;}
+
+    // Skips over a value of the given type, including nested containers and structs
+    void skip(uint8_t type, int depth = 0) {
+        // Guard against maliciously deep nesting
+        if(depth > 32) {
+            error = true;
+            return;
+        }
+
+        switch(type) {
+            case T_BOOLEAN_TRUE:
+            case T_BOOLEAN_FALSE:
+                break;
+            case T_BYTE:
+                read_byte();
+                break;
+            case T_I16:
+            case T_I32:
+            case T_I64:
+                read_varint();
+                break;
+            case T_DOUBLE:
+                advance(8);
+                break;
+            case T_BINARY:
+                advance(read_varint());
+                break;
+            case T_LIST:
+            case T_SET: {
+                uint8_t element_type;
+                uint32_t size = read_list_header(&element_type);
+                for(uint32_t i=0; i<size && !error; i++) {
+                    skip_element(element_type, depth+1);
+                }
+                break;
+            }
+            case T_MAP: {
+                uint32_t size = (uint32_t) read_varint();
+                if(size == 0) {
+                    break;
+                }
+                uint8_t types = read_byte();
+                for(uint32_t i=0; i<size && !error; i++) {
+                    skip_element(types >> 4, depth+1);
+                    skip_element(types & 0x0F, depth+1);
+                }
+                break;
+            }
+            case T_STRUCT: {
+                int16_t last_field_id = 0;
+                int16_t field_id;
+                uint8_t field_type;
+                while(read_field_header(&last_field_id, &field_id, &field_type)) {
+                    skip(field_type, depth+1);
+                }
+                break;
+            }
+            default:
+                error = true;
+        }
+    }
+
+  private:
+    // Booleans inside containers take up a full byte instead of living in a field header
+    void skip_element(uint8_t type, int depth) {
+        if(type == T_BOOLEAN_TRUE || type == T_BOOLEAN_FALSE) {
+            read_byte();
+        } else {
+            skip(type, depth);
+        }
+    }
+
+    void advance(uint64_t bytes) {
+        if(error || bytes > (uint64_t)(end - ptr)) {
+            error = true;
+            return;
+        }
+        ptr += bytes;
+    }
+
+    const uint8_t* ptr;
+    const uint8_t* end;
+    bool error;
+};
+
+}
@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <stdint.h>
+
 #define PTOA_OK 0
 #define PTOA_FAIL 1
 
@@ -25,7 +27,80 @@ enum status {
 enum encoding{
 	PLAIN,
 	DELTA,
-	DELTA_LENGTH
+	DELTA_LENGTH,
+	DICTIONARY,
+	DELTA_BYTE_ARRAY,
+	BYTE_STREAM_SPLIT
+};
+
+// How SWParquetReader brings the Parquet file into memory.
+// COPY reads the whole file into a malloc'd buffer up front. MMAP maps the file and lets the kernel
+// fault pages in on first access. MMAP_POPULATE additionally pre-faults the whole mapping at construction.
+enum load_mode{
+	COPY,
+	MMAP,
+	MMAP_POPULATE
+};
+
+// Comparisons a predicate makes of the column values with its operands
+enum class predicate_op : int32_t {
+	LESS,
+	LESS_EQUAL,
+	EQUAL,
+	BETWEEN,
+	IN
+};
+
+// Parquet physical types, numbered as in parquet.thrift
+enum class parquet_type : int32_t {
+	BOOLEAN = 0,
+	INT32 = 1,
+	INT64 = 2,
+	INT96 = 3,
+	FLOAT = 4,
+	DOUBLE = 5,
+	BYTE_ARRAY = 6,
+	FIXED_LEN_BYTE_ARRAY = 7
+};
+
+// Parquet encodings, numbered as in parquet.thrift
+enum class parquet_encoding : int32_t {
+	PLAIN = 0,
+	PLAIN_DICTIONARY = 2,
+	RLE = 3,
+	BIT_PACKED = 4,
+	DELTA_BINARY_PACKED = 5,
+	DELTA_LENGTH_BYTE_ARRAY = 6,
+	DELTA_BYTE_ARRAY = 7,
+	RLE_DICTIONARY = 8,
+	BYTE_STREAM_SPLIT = 9
+};
+
+// Parquet compression codecs, numbered as in parquet.thrift
+enum class compression_codec : int32_t {
+	UNCOMPRESSED = 0,
+	SNAPPY = 1,
+	GZIP = 2,
+	LZO = 3,
+	BROTLI = 4,
+	LZ4 = 5,
+	ZSTD = 6,
+	LZ4_RAW = 7
+};
+
+// Parquet page types, numbered as in parquet.thrift
+enum class page_type : int32_t {
+	DATA_PAGE = 0,
+	INDEX_PAGE = 1,
+	DICTIONARY_PAGE = 2,
+	DATA_PAGE_V2 = 3
+};
+
+// Field repetition, numbered as in parquet.thrift
+enum class repetition_type : int32_t {
+	REQUIRED = 0,
+	OPTIONAL = 1,
+	REPEATED = 2
 };
 
-}
\ No newline at end of file
+}
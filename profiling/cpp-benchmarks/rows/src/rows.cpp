@@ -0,0 +1,196 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <iomanip>
+
+#include <arrow/array/concatenate.h>
+#include <parquet/arrow/reader.h>
+
+#include <SWParquetReader.h>
+#include <timer.h>
+
+//Use standard Arrow library functions to read Arrow array from Parquet file
+//Only works for Parquet version 1 style files.
+std::shared_ptr<arrow::Array> readArray(std::string hw_input_file_path) {
+  std::shared_ptr<arrow::io::ReadableFile> infile;
+  PARQUET_THROW_NOT_OK(arrow::io::ReadableFile::Open(hw_input_file_path, arrow::default_memory_pool(), &infile));
+
+  std::unique_ptr<parquet::arrow::FileReader> reader;
+  PARQUET_THROW_NOT_OK(parquet::arrow::OpenFile(infile, arrow::default_memory_pool(), &reader));
+
+  std::shared_ptr<arrow::ChunkedArray> carray;
+  PARQUET_THROW_NOT_OK(reader->ReadColumn(0, &carray));
+  // Every row group can be a chunk of its own, the rows read are compared with the rows of the whole file
+  std::shared_ptr<arrow::Array> array;
+  PARQUET_THROW_NOT_OK(arrow::Concatenate(carray->chunks(), arrow::default_memory_pool(), &array));
+  return array;
+}
+
+// Compare validity and values of the rows read with the rows of the ranges in the reference, one range after the other.
+// Returns the amount of errors found.
+template<typename ArrayType>
+int verify(const std::shared_ptr<arrow::PrimitiveArray>& result, const std::shared_ptr<arrow::Array>& correct, const std::vector<ptoa::row_range>& ranges) {
+    auto result_array = std::static_pointer_cast<ArrayType>(result);
+    auto correct_array = std::static_pointer_cast<ArrayType>(correct);
+    int error_count = 0;
+    int64_t row = 0;
+
+    for(const ptoa::row_range& r : ranges) {
+        for(int64_t i=r.first_row; (i<r.first_row+r.num_rows) && (row<result_array->length()); i++, row++) {
+            bool result_null = result_array->IsNull(row);
+
+            if((result_null != correct_array->IsNull(i)) || (!result_null && (result_array->Value(row) != correct_array->Value(i)))) {
+                error_count++;
+                if(error_count<20) {
+                    std::cout<<i<<std::endl;
+                }
+            }
+        }
+    }
+
+    if(row != result_array->length()) {
+        error_count++;
+        std::cout<<"Read "<<result_array->length()<<" rows, the ranges hold "<<row<<std::endl;
+    }
+
+    return error_count;
+}
+
+// Compare the rows read for the ranges with the reference, for the type of the column. Returns the amount of errors found.
+int verify(const std::shared_ptr<arrow::PrimitiveArray>& result, const std::shared_ptr<arrow::Array>& correct, ptoa::parquet_type type, const std::vector<ptoa::row_range>& ranges) {
+    if(type == ptoa::parquet_type::INT32) {
+        return verify<arrow::Int32Array>(result, correct, ranges);
+    } else if(type == ptoa::parquet_type::INT64) {
+        return verify<arrow::Int64Array>(result, correct, ranges);
+    } else if(type == ptoa::parquet_type::FLOAT) {
+        return verify<arrow::FloatArray>(result, correct, ranges);
+    }
+    return verify<arrow::DoubleArray>(result, correct, ranges);
+}
+
+// Ranges that start in the middle of pages and, one range after the other, at output rows that are not a multiple of eight:
+// the requested rows cut into eight pieces with a few rows left out around each, and a range across every row group boundary.
+std::vector<ptoa::row_range> scattered_ranges(const ptoa::file_metadata& metadata, int64_t first_row, int64_t num_rows) {
+    std::vector<ptoa::row_range> ranges;
+    int64_t piece = num_rows/8;
+
+    for(int64_t i=0; (piece > 16) && (i<8); i++) {
+        ranges.push_back({first_row + i*piece + 3, piece - 5 - i});
+    }
+
+    for(const ptoa::row_group_info& group : metadata.row_groups) {
+        if((group.first_row >= 13) && (group.first_row + 14 <= metadata.num_rows)) {
+            ranges.push_back({group.first_row - 13, 27});
+        }
+    }
+
+    return ranges;
+}
+
+int main(int argc, char **argv) {
+    int64_t first_row;
+    int64_t num_rows;
+    char* hw_input_file_path;
+    char* reference_parquet_file_path;
+    int iterations;
+    bool verify_output;
+
+    Timer t;
+
+    if (argc > 6) {
+      hw_input_file_path = argv[1];
+      reference_parquet_file_path = argv[2];
+      first_row = std::strtoll(argv[3], nullptr, 10);
+      num_rows = std::strtoll(argv[4], nullptr, 10);
+      iterations = (uint32_t) std::strtoul(argv[5], nullptr, 10);
+      if(argv[6][0] == 'y') {
+        verify_output = true;
+      } else if (argv[6][0] == 'n') {
+        verify_output = false;
+      } else {
+        std::cerr << "Invalid argument. Option \"verify\" should be \"y\" or \"n\"" << std::endl;
+        return 1;
+      }
+    } else {
+      std::cerr << "Usage: rows parquet_hw_input_file_path reference_parquet_file_path first_row num_rows iterations verify(y or n) [threads]" << std::endl;
+      return 1;
+    }
+
+    ptoa::SWParquetReader reader(hw_input_file_path);
+
+    // Optional amount of threads for page parallel decoding
+    if(argc > 7) {
+      reader.set_num_threads(std::strtoul(argv[7], nullptr, 10));
+    }
+
+    // Locate the first column chunk through the footer, rows are counted over all row groups of the column
+    const ptoa::file_metadata* metadata;
+    const ptoa::column_chunk_info* chunk;
+    if((reader.get_file_metadata(&metadata) != ptoa::status::OK) || (reader.get_column_chunk(0, 0, &chunk) != ptoa::status::OK)){
+        return 1;
+    }
+
+    if((chunk->type != ptoa::parquet_type::INT32) && (chunk->type != ptoa::parquet_type::INT64)
+            && (chunk->type != ptoa::parquet_type::FLOAT) && (chunk->type != ptoa::parquet_type::DOUBLE)) {
+        std::cerr << "Invalid input file. Reading row ranges requires an INT32, INT64, FLOAT or DOUBLE column" << std::endl;
+        return 1;
+    }
+
+    reader.count_pages(chunk->data_page_offset);
+
+    std::shared_ptr<arrow::PrimitiveArray> array;
+
+    for(int i=0; i<iterations; i++){
+        t.start();
+        // Reading the Parquet file. The interesting bit.
+        if(reader.read_column_rows(0, first_row, num_rows, &array) != ptoa::status::OK){
+            return 1;
+        }
+        t.stop();
+        t.record();
+    }
+
+    std::cout << "Read rows " << first_row << " to " << first_row+num_rows-1 << std::endl;
+    std::cout << "Average time in seconds: " << t.average() << std::endl;
+
+    std::vector<ptoa::row_range> ranges = scattered_ranges(*metadata, first_row, num_rows);
+    std::shared_ptr<arrow::PrimitiveArray> ranges_array;
+
+    t.clear_history();
+
+    for(int i=0; i<iterations; i++){
+        t.start();
+        if(reader.read_column_rows(0, ranges, &ranges_array) != ptoa::status::OK){
+            return 1;
+        }
+        t.stop();
+        t.record();
+    }
+
+    std::cout << "Read " << ranges_array->length() << " rows in " << ranges.size() << " ranges" << std::endl;
+    std::cout << "Average time in seconds (ranges): " << t.average() << std::endl;
+
+    if(verify_output) {
+        std::shared_ptr<arrow::Array> correct_array = readArray(std::string(reference_parquet_file_path));
+
+        // Verify result
+        int error_count = verify(array, correct_array, chunk->type, {{first_row, num_rows}}) + verify(ranges_array, correct_array, chunk->type, ranges);
+
+        if(error_count == 0) {
+          std::cout << "Test passed!" << std::endl;
+        } else {
+          std::cout << "Test failed. Found " << error_count << " errors in the output Arrow array" << std::endl;
+        }
+    }
+
+}
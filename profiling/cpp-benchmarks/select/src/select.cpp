@@ -0,0 +1,257 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+#include <arrow/array/concatenate.h>
+#include <parquet/arrow/reader.h>
+
+#include <SWParquetReader.h>
+#include <timer.h>
+
+//Use standard Arrow library functions to read Arrow array from Parquet file
+//Only works for Parquet version 1 style files.
+std::shared_ptr<arrow::Array> readArray(std::string hw_input_file_path) {
+  std::shared_ptr<arrow::io::ReadableFile> infile;
+  PARQUET_THROW_NOT_OK(arrow::io::ReadableFile::Open(hw_input_file_path, arrow::default_memory_pool(), &infile));
+
+  std::unique_ptr<parquet::arrow::FileReader> reader;
+  PARQUET_THROW_NOT_OK(parquet::arrow::OpenFile(infile, arrow::default_memory_pool(), &reader));
+
+  std::shared_ptr<arrow::ChunkedArray> carray;
+  PARQUET_THROW_NOT_OK(reader->ReadColumn(0, &carray));
+  // Every row group can be a chunk of its own, selected rows are numbered over the whole file
+  std::shared_ptr<arrow::Array> array;
+  PARQUET_THROW_NOT_OK(arrow::Concatenate(carray->chunks(), arrow::default_memory_pool(), &array));
+  return array;
+}
+
+template<typename ArrayType>
+int64_t value_at(const std::shared_ptr<ArrayType>& array, int64_t i) {
+    return array->Value(i);
+}
+
+std::string value_at(const std::shared_ptr<arrow::StringArray>& array, int64_t i) {
+    return array->GetString(i);
+}
+
+// Scalar evaluation of a predicate with operands of the type of value. Strings compare as unsigned bytes, as std::string does.
+template<typename T>
+bool fulfils(ptoa::predicate_op op, const std::vector<T>& operands, const T& value) {
+    switch(op) {
+        case ptoa::predicate_op::LESS:
+            return value < operands[0];
+        case ptoa::predicate_op::LESS_EQUAL:
+            return value <= operands[0];
+        case ptoa::predicate_op::EQUAL:
+            return value == operands[0];
+        case ptoa::predicate_op::BETWEEN:
+            return (value >= operands[0]) && (value <= operands[1]);
+        case ptoa::predicate_op::IN:
+            return std::find(operands.begin(), operands.end(), value) != operands.end();
+    }
+    return false;
+}
+
+// Check that the ranges are ascending and do not overlap, and that every row of the reference whose value fulfils the predicate
+// lies in one of them. Pages may only be skipped if none of their rows can match. Returns the amount of errors found.
+template<typename ArrayType, typename T>
+int verify_ranges(const std::shared_ptr<arrow::Array>& reference, ptoa::predicate_op op, const std::vector<T>& operands, const std::vector<ptoa::row_range>& ranges) {
+    auto correct_array = std::static_pointer_cast<ArrayType>(reference);
+    int error_count = 0;
+    int64_t next_row = 0;
+    size_t range = 0;
+
+    for(const ptoa::row_range& r : ranges) {
+        if((r.first_row < next_row) || (r.num_rows <= 0)) {
+            error_count++;
+            std::cout<<"Range of "<<r.num_rows<<" rows from row "<<r.first_row<<" is out of order"<<std::endl;
+        }
+        next_row = r.first_row + r.num_rows;
+    }
+
+    for(int64_t i=0; i<correct_array->length(); i++) {
+        while((range < ranges.size()) && (ranges[range].first_row + ranges[range].num_rows <= i)) {
+            range++;
+        }
+        bool selected = (range < ranges.size()) && (ranges[range].first_row <= i);
+
+        if(!selected && !correct_array->IsNull(i) && fulfils(op, operands, value_at(correct_array, i))) {
+            error_count++;
+            if(error_count<20) {
+                std::cout<<"Row "<<i<<" matches but was skipped"<<std::endl;
+            }
+        }
+    }
+
+    return error_count;
+}
+
+// Compare the rows read from the ranges with the same rows of the reference. Returns the amount of errors found.
+template<typename ArrayType>
+int verify_rows(const std::shared_ptr<arrow::PrimitiveArray>& result, const std::shared_ptr<arrow::Array>& reference, const std::vector<ptoa::row_range>& ranges) {
+    auto result_array = std::static_pointer_cast<ArrayType>(result);
+    auto correct_array = std::static_pointer_cast<ArrayType>(reference);
+    int error_count = 0;
+    int64_t row = 0;
+
+    for(const ptoa::row_range& r : ranges) {
+        for(int64_t i=r.first_row; (i<r.first_row+r.num_rows) && (row<result_array->length()); i++, row++) {
+            bool result_null = result_array->IsNull(row);
+
+            if((result_null != correct_array->IsNull(i)) || (!result_null && (result_array->Value(row) != correct_array->Value(i)))) {
+                error_count++;
+                if(error_count<20) {
+                    std::cout<<"Row "<<i<<std::endl;
+                }
+            }
+        }
+    }
+
+    if(row != result_array->length()) {
+        error_count++;
+        std::cout<<"Read "<<result_array->length()<<" rows, the ranges hold "<<row<<std::endl;
+    }
+
+    return error_count;
+}
+
+int main(int argc, char **argv) {
+    char* hw_input_file_path;
+    char* reference_parquet_file_path;
+    int iterations;
+    bool verify_output;
+    ptoa::predicate_op op;
+
+    Timer t;
+
+    if (argc > 6) {
+      hw_input_file_path = argv[1];
+      reference_parquet_file_path = argv[2];
+      iterations = (uint32_t) std::strtoul(argv[3], nullptr, 10);
+      if(argv[4][0] == 'y') {
+        verify_output = true;
+      } else if (argv[4][0] == 'n') {
+        verify_output = false;
+      } else {
+        std::cerr << "Invalid argument. Option \"verify\" should be \"y\" or \"n\"" << std::endl;
+        return 1;
+      }
+      if(!strcmp(argv[6], "lt")) {
+        op = ptoa::predicate_op::LESS;
+      } else if (!strcmp(argv[6], "le")) {
+        op = ptoa::predicate_op::LESS_EQUAL;
+      } else if (!strcmp(argv[6], "eq")) {
+        op = ptoa::predicate_op::EQUAL;
+      } else if (!strcmp(argv[6], "between")) {
+        op = ptoa::predicate_op::BETWEEN;
+      } else if (!strcmp(argv[6], "in")) {
+        op = ptoa::predicate_op::IN;
+      } else {
+        std::cerr << "Invalid argument. Option \"op\" should be \"lt\", \"le\", \"eq\", \"between\" or \"in\"" << std::endl;
+        return 1;
+      }
+    } else {
+      std::cerr << "Usage: select parquet_hw_input_file_path reference_parquet_file_path iterations verify(y or n) threads op(lt, le, eq, between or in) operand [operand ...]" << std::endl;
+      return 1;
+    }
+
+    ptoa::SWParquetReader reader(hw_input_file_path);
+
+    // Amount of threads for page parallel decoding
+    reader.set_num_threads(std::strtoul(argv[5], nullptr, 10));
+
+    // Locate the first column chunk through the footer, its type tells whether the operands are numbers or strings
+    const ptoa::column_chunk_info* chunk;
+    if(reader.get_column_chunk(0, 0, &chunk) != ptoa::status::OK){
+        return 1;
+    }
+
+    if((chunk->type != ptoa::parquet_type::INT32) && (chunk->type != ptoa::parquet_type::INT64) && (chunk->type != ptoa::parquet_type::BYTE_ARRAY)) {
+        std::cerr << "Invalid input file. Selecting rows requires an INT32, INT64 or BYTE_ARRAY column" << std::endl;
+        return 1;
+    }
+
+    std::vector<int64_t> int_operands;
+    std::vector<std::string> string_operands;
+    for(int i=7; i<argc; i++) {
+        int_operands.push_back(std::strtoll(argv[i], nullptr, 10));
+        string_operands.push_back(argv[i]);
+    }
+    bool on_strings = chunk->type == ptoa::parquet_type::BYTE_ARRAY;
+    ptoa::predicate pred = on_strings ? ptoa::predicate(op, string_operands) : ptoa::predicate(op, int_operands);
+
+    reader.count_pages(chunk->data_page_offset);
+    std::cout << "Page index of the first column chunk: " << (chunk->column_index_offset >= 0 ? "ColumnIndex" : "page header statistics") << std::endl;
+
+    std::vector<ptoa::row_range> ranges;
+
+    for(int i=0; i<iterations; i++){
+        t.start();
+        if(reader.select_rows(0, pred, &ranges) != ptoa::status::OK){
+            return 1;
+        }
+        t.stop();
+        t.record();
+    }
+
+    int64_t num_selected = 0;
+    for(const ptoa::row_range& r : ranges) {
+        num_selected += r.num_rows;
+    }
+
+    std::cout << "Selected " << num_selected << " rows in " << ranges.size() << " ranges" << std::endl;
+    std::cout << "Average time in seconds (select): " << t.average() << std::endl;
+
+    // The rows of the selected pages are read for the values to be filtered, which only works for numbers
+    std::shared_ptr<arrow::PrimitiveArray> array;
+
+    if(!on_strings) {
+        t.clear_history();
+
+        for(int i=0; i<iterations; i++){
+            t.start();
+            if(reader.read_column_rows(0, ranges, &array) != ptoa::status::OK){
+                return 1;
+            }
+            t.stop();
+            t.record();
+        }
+
+        std::cout << "Read " << array->length() << " rows" << std::endl;
+        std::cout << "Average time in seconds (read selected rows): " << t.average() << std::endl;
+    }
+
+    if(verify_output) {
+        std::shared_ptr<arrow::Array> correct_array = readArray(std::string(reference_parquet_file_path));
+
+        // Verify result
+        int error_count;
+
+        if(chunk->type == ptoa::parquet_type::INT32) {
+          error_count = verify_ranges<arrow::Int32Array>(correct_array, op, pred.ints, ranges) + verify_rows<arrow::Int32Array>(array, correct_array, ranges);
+        } else if(chunk->type == ptoa::parquet_type::INT64) {
+          error_count = verify_ranges<arrow::Int64Array>(correct_array, op, pred.ints, ranges) + verify_rows<arrow::Int64Array>(array, correct_array, ranges);
+        } else {
+          error_count = verify_ranges<arrow::StringArray>(correct_array, op, pred.strings, ranges);
+        }
+
+        if(error_count == 0) {
+          std::cout << "Test passed!" << std::endl;
+        } else {
+          std::cout << "Test failed. Found " << error_count << " errors in the selected rows" << std::endl;
+        }
+    }
+
+}
@@ -39,10 +39,11 @@ int main(int argc, char **argv) {
     char* reference_parquet_file_path;
     int iterations;
     bool verify_output;
+    ptoa::encoding enc;
 
     Timer t;
 
-    if (argc > 5) {
+    if (argc > 6) {
       hw_input_file_path = argv[1];
       reference_parquet_file_path = argv[2];
       num_strings = (uint32_t) std::strtoul(argv[3], nullptr, 10);
@@ -55,14 +56,34 @@ int main(int argc, char **argv) {
         std::cerr << "Invalid argument. Option \"verify\" should be \"y\" or \"n\"" << std::endl;
         return 1;
       }
+      if(!strcmp(argv[6], "plain")) {
+        enc = ptoa::encoding::PLAIN;
+      } else if (!strcmp(argv[6], "dictionary")) {
+        enc = ptoa::encoding::DICTIONARY;
+      } else if (!strcmp(argv[6], "delta_length")) {
+        enc = ptoa::encoding::DELTA_LENGTH;
+      } else if (!strcmp(argv[6], "delta_byte_array")) {
+        enc = ptoa::encoding::DELTA_BYTE_ARRAY;
+      } else {
+        std::cerr << "Invalid argument. Option \"encoding\" should be \"plain\", \"dictionary\", \"delta_length\" or \"delta_byte_array\"" << std::endl;
+        return 1;
+      }
     } else {
-      std::cerr << "Usage: str parquet_hw_input_file_path reference_parquet_file_path num_strings iterations verify(y or n)" << std::endl;
+      std::cerr << "Usage: str parquet_hw_input_file_path reference_parquet_file_path num_strings iterations verify(y or n) encoding" << std::endl;
       return 1;
     }
 
     ptoa::SWParquetReader reader(hw_input_file_path);
-    //reader.inspect_metadata(4);
-    reader.count_pages(4);
+
+    // Locate the first column chunk through the footer
+    const ptoa::column_chunk_info* chunk;
+    if(reader.get_column_chunk(0, 0, &chunk) != ptoa::status::OK){
+        return 1;
+    }
+    int64_t file_offset = chunk->data_page_offset;
+
+    //reader.inspect_metadata(file_offset);
+    reader.count_pages(file_offset);
 
     // Read correct array from reference file
     auto correct_array = std::dynamic_pointer_cast<arrow::StringArray>(readArray(std::string(reference_parquet_file_path)));
@@ -77,7 +98,7 @@ int main(int argc, char **argv) {
     for(int i=0; i<iterations; i++){
         t.start();
         // Reading the Parquet file. The interesting bit.
-        if(reader.read_string(num_strings, num_chars, 4, &result_array, ptoa::encoding::DELTA_LENGTH) != ptoa::status::OK){
+        if(reader.read_string(num_strings, num_chars, file_offset, &result_array, enc) != ptoa::status::OK){
             return 1;
         }
         t.stop();
@@ -98,7 +119,7 @@ int main(int argc, char **argv) {
     for(int i=0; i<iterations; i++){
         t.start();
         // Reading the Parquet file. The interesting bit.
-        if(reader.read_string(num_strings, 4, &result_array, off_buffer, val_buffer, ptoa::encoding::DELTA_LENGTH) != ptoa::status::OK){
+        if(reader.read_string(num_strings, file_offset, &result_array, off_buffer, val_buffer, enc) != ptoa::status::OK){
             return 1;
         }
         t.stop();
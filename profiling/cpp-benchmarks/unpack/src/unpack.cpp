@@ -0,0 +1,116 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+
+#include <LemireBitUnpacking.h>
+#include <DeltaKernels.h>
+#include <SimdDispatch.h>
+#include <timer.h>
+
+using ptoa::MINIBLOCK_VALUES;
+
+// Compares the scalar Lemire unpacking with the SIMD kernels fastunpack/int64fastunpack dispatch to, for every bit width.
+// The environment variable PTOA_SIMD caps the SIMD level (scalar, sse4.1 or avx2).
+
+const char* simd_level_name(ptoa::simd_level level) {
+    switch(level) {
+        case ptoa::simd_level::AVX512: return "AVX-512";
+        case ptoa::simd_level::AVX2: return "AVX2";
+        case ptoa::simd_level::SSE4_1: return "SSE4.1";
+        default: return "scalar";
+    }
+}
+
+template<typename T, typename F>
+double time_unpacking(F unpack, const std::vector<T>& packed, std::vector<T>& unpacked, uint32_t bit, int num_miniblocks, int iterations) {
+    Timer t;
+
+    // Miniblocks of bit wide values are bit 32 bit words (or bit/2 64 bit words) long
+    const int64_t miniblock_bits = MINIBLOCK_VALUES*bit;
+
+    for(int i=0; i<iterations; i++){
+        t.start();
+        for(int m=0; m<num_miniblocks; m++){
+            unpack((const T*)((const uint8_t*) packed.data() + m*miniblock_bits/8), unpacked.data() + m*MINIBLOCK_VALUES, bit);
+        }
+        t.stop();
+        t.record();
+    }
+
+    return t.average()*1e9/((double) num_miniblocks*MINIBLOCK_VALUES);
+}
+
+template<typename T, typename F, typename G>
+int benchmark(const char* name, F scalar_unpack, G simd_unpack, uint32_t max_bit, int num_miniblocks, int iterations) {
+    // The scalar 64 bit kernels read up to 8 bytes past a miniblock of odd bit width
+    std::vector<T> packed(num_miniblocks*max_bit*MINIBLOCK_VALUES/(8*sizeof(T)) + 1);
+    std::vector<T> scalar_unpacked(num_miniblocks*MINIBLOCK_VALUES);
+    std::vector<T> simd_unpacked(num_miniblocks*MINIBLOCK_VALUES);
+    int error_count = 0;
+
+    for(size_t i=0; i<packed.size()*sizeof(T); i++){
+        ((uint8_t*) packed.data())[i] = std::rand();
+    }
+
+    std::cout << name << std::endl;
+    std::cout << std::setw(6) << "width" << std::setw(16) << "scalar ns/val" << std::setw(16) << "simd ns/val" << std::setw(10) << "speedup" << std::endl;
+
+    for(uint32_t bit=0; bit<=max_bit; bit++){
+        double scalar_time = time_unpacking<T>(scalar_unpack, packed, scalar_unpacked, bit, num_miniblocks, iterations);
+        double simd_time = time_unpacking<T>(simd_unpack, packed, simd_unpacked, bit, num_miniblocks, iterations);
+
+        if(std::memcmp(scalar_unpacked.data(), simd_unpacked.data(), scalar_unpacked.size()*sizeof(T)) != 0){
+            std::cout << "Bit width " << bit << ": SIMD output differs from the scalar output" << std::endl;
+            error_count++;
+        }
+
+        std::cout << std::setw(6) << bit << std::setw(16) << std::fixed << std::setprecision(3) << scalar_time
+                  << std::setw(16) << simd_time << std::setw(9) << std::setprecision(2) << scalar_time/simd_time << "x" << std::endl;
+    }
+
+    return error_count;
+}
+
+int main(int argc, char **argv) {
+    int iterations;
+    int num_miniblocks = 1 << 14;
+
+    if (argc > 1) {
+      iterations = (uint32_t) std::strtoul(argv[1], nullptr, 10);
+      if(argc > 2) {
+        num_miniblocks = (uint32_t) std::strtoul(argv[2], nullptr, 10);
+      }
+    } else {
+      std::cerr << "Usage: unpack iterations [miniblocks]" << std::endl;
+      return 1;
+    }
+
+    std::cout << "SIMD level: " << simd_level_name(ptoa::detect_simd_level()) << std::endl;
+
+    int error_count = 0;
+    error_count += benchmark<uint32_t>("32 bit values", scalar_fastunpack, fastunpack, 32, num_miniblocks, iterations);
+    error_count += benchmark<uint64_t>("64 bit values", scalar_int64fastunpack, int64fastunpack, 64, num_miniblocks, iterations);
+
+    if(error_count == 0) {
+      std::cout << "Test passed!" << std::endl;
+    } else {
+      std::cout << "Test failed. " << error_count << " bit widths produced different output" << std::endl;
+    }
+
+    return error_count == 0 ? 0 : 1;
+}
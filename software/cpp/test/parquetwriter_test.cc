@@ -123,6 +123,64 @@ std::shared_ptr<arrow::Table> generate_int32_table(int num_values, int nCols, bo
     return arrow::Table::Make(schema, arrays);
 }
 
+// Arithmetic series that start just below the largest value and wrap around it every few thousand values. Delta encoded,
+// every miniblock has bit width 0 and a run of them crosses the wrap, which is what closed form aggregation must catch.
+std::shared_ptr<arrow::Table> generate_int32_series_table(int num_values, int nCols) {
+	//Create the schema
+	std::vector<std::shared_ptr<arrow::Field>> fields;
+    for (int c = 0; c < nCols; c++) {
+    	char name[NAMEBUFSIZE];
+    	snprintf(name, NAMEBUFSIZE, "int%d", c);
+    	fields.push_back(arrow::field(name, arrow::int32(), false));
+    }
+    std::shared_ptr<arrow::Schema> schema = arrow::schema(fields);
+
+    //Generate the values
+    std::vector<std::shared_ptr<arrow::Array>> arrays;
+    for (int c = 0; c < nCols; c++) {
+		arrow::Int32Builder i32builder;
+		uint32_t step = 1000000 + rand() % 1000000;
+		uint32_t number = (uint32_t) INT_MAX - rand() % step;
+		for (int i = 0; i < num_values; i++) {
+			PARQUET_THROW_NOT_OK(i32builder.Append((int32_t) number));
+			number += step;
+		}
+		std::shared_ptr<arrow::Array> i32array;
+		PARQUET_THROW_NOT_OK(i32builder.Finish(&i32array));
+		arrays.push_back(i32array);
+    }
+
+    return arrow::Table::Make(schema, arrays);
+}
+
+std::shared_ptr<arrow::Table> generate_int64_series_table(int num_values, int nCols) {
+	//Create the schema
+	std::vector<std::shared_ptr<arrow::Field>> fields;
+    for (int c = 0; c < nCols; c++) {
+    	char name[NAMEBUFSIZE];
+    	snprintf(name, NAMEBUFSIZE, "int%d", c);
+    	fields.push_back(arrow::field(name, arrow::int64(), false));
+    }
+    std::shared_ptr<arrow::Schema> schema = arrow::schema(fields);
+
+    //Generate the values
+    std::vector<std::shared_ptr<arrow::Array>> arrays;
+    for (int c = 0; c < nCols; c++) {
+		arrow::Int64Builder i64builder;
+		uint64_t step = ((uint64_t) 1 << 50) + (((uint64_t) rand() << 32) | rand());
+		uint64_t number = (uint64_t) LLONG_MAX - (((uint64_t) rand() << 32) | rand()) % step;
+		for (int i = 0; i < num_values; i++) {
+			PARQUET_THROW_NOT_OK(i64builder.Append((int64_t) number));
+			number += step;
+		}
+		std::shared_ptr<arrow::Array> i64array;
+		PARQUET_THROW_NOT_OK(i64builder.Finish(&i64array));
+		arrays.push_back(i64array);
+    }
+
+    return arrow::Table::Make(schema, arrays);
+}
+
 std::shared_ptr<arrow::Table> generate_str_table(int num_values, int nCols, int min_length, int max_length) {
 	//Create the schema
 	std::vector<std::shared_ptr<arrow::Field>> fields;
@@ -182,8 +240,8 @@ int main(int argc, char **argv) {
 	srand(123);
 	int nRows = 100;
 	int nCols = 1;
-	enum Datatype {int32, int64, str};
-	std::string typenames[] = {"int32", "int64", "str"};
+	enum Datatype {int32, int64, str, int32series, int64series};
+	std::string typenames[] = {"int32", "int64", "str", "int32series", "int64series"};
 	Datatype datatype = int64;
 	if (argc >= 2) {
 		if (!strncmp(argv[1], "int32", 5)) {
@@ -195,6 +253,12 @@ int main(int argc, char **argv) {
 		if (!strncmp(argv[1], "str", 3)) {
 			datatype = str;
 		}
+		if (!strncmp(argv[1], "int32series", 11)) {
+			datatype = int32series;
+		}
+		if (!strncmp(argv[1], "int64series", 11)) {
+			datatype = int64series;
+		}
 	}
 	if (argc >= 3) {
 		nRows = strtol(argv[2], 0, 10);
@@ -221,6 +285,14 @@ int main(int argc, char **argv) {
 	  std::shared_ptr<arrow::Table> test_strtable = generate_str_table(nRows, nCols, 1, 12);
 	  write_parquet(test_strtable, "./test_str");
   }
+  if (datatype == int32series) {
+	  std::shared_ptr<arrow::Table> test_int32seriestable = generate_int32_series_table(nRows, nCols);
+	  write_parquet(test_int32seriestable, "./test_int32series");
+  }
+  if (datatype == int64series) {
+	  std::shared_ptr<arrow::Table> test_int64seriestable = generate_int64_series_table(nRows, nCols);
+	  write_parquet(test_int64seriestable, "./test_int64series");
+  }
 
 
   return 0;